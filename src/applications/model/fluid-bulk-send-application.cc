@@ -0,0 +1,291 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/address.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/channel.h"
+#include "ns3/socket.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "fluid-bulk-send-application.h"
+#include "fluid-flow-manager.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FluidBulkSendApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (FluidBulkSendApplication);
+
+TypeId
+FluidBulkSendApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidBulkSendApplication")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<FluidBulkSendApplication> ()
+    .AddAttribute ("Remote", "The address of the destination",
+                   AddressValue (),
+                   MakeAddressAccessor (&FluidBulkSendApplication::m_peer),
+                   MakeAddressChecker ())
+    .AddAttribute ("MaxBytes",
+                   "The total number of bytes to send. "
+                   "Once these bytes are sent, "
+                   "the flow stops. The value zero means "
+                   "that there is no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FluidBulkSendApplication::m_maxBytes),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("MaxRate",
+                   "The highest rate of the flow, e.g., the rate the "
+                   "receive window allows. Zero means no limit.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&FluidBulkSendApplication::m_maxRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("QueueFill",
+                   "The fraction of the transmit queue of its bottleneck "
+                   "the flow keeps occupied. The default is the mean "
+                   "occupancy of a drop-tail queue under the sawtooth "
+                   "of a long-lived TCP flow. The packets crossing the "
+                   "bottleneck are delayed by the transmission time of "
+                   "this fixed fraction of the queue, whatever the load.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&FluidBulkSendApplication::m_queueFill),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("Rate", "The rate of the flow changes",
+                     MakeTraceSourceAccessor (&FluidBulkSendApplication::m_rateTrace),
+                     "ns3::FluidBulkSendApplication::RateTracedCallback")
+  ;
+  return tid;
+}
+
+
+FluidBulkSendApplication::FluidBulkSendApplication ()
+  : m_active (false),
+    m_rate (0),
+    m_totBytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidBulkSendApplication::~FluidBulkSendApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FluidBulkSendApplication::SetMaxBytes (uint64_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxBytes);
+  m_maxBytes = maxBytes;
+}
+
+DataRate
+FluidBulkSendApplication::GetRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_rate;
+}
+
+uint64_t
+FluidBulkSendApplication::GetTotalBytes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  double bytes = m_totBytes + m_rate.GetBitRate () * (Simulator::Now () - m_lastUpdate).GetSeconds () / 8;
+  if (m_maxBytes > 0)
+    {
+      bytes = std::min (bytes, static_cast<double> (m_maxBytes));
+    }
+  return static_cast<uint64_t> (bytes);
+}
+
+const std::vector<Ptr<NetDevice> > &
+FluidBulkSendApplication::GetPath (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_path;
+}
+
+DataRate
+FluidBulkSendApplication::GetMaxRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_maxRate;
+}
+
+double
+FluidBulkSendApplication::GetQueueFill (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_queueFill;
+}
+
+void
+FluidBulkSendApplication::SetRate (DataRate rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  UpdateTotalBytes ();
+  DataRate oldRate = m_rate;
+  m_rate = rate;
+  if (oldRate != rate)
+    {
+      m_rateTrace (oldRate, rate);
+    }
+
+  m_finishEvent.Cancel ();
+  if (m_active && m_maxBytes > 0 && rate.GetBitRate () > 0)
+    {
+      double remaining = m_maxBytes - m_totBytes;
+      Time finish = Seconds (remaining * 8 / rate.GetBitRate ());
+      NS_LOG_LOGIC ("Flow done in " << finish.GetSeconds () << "s");
+      m_finishEvent = Simulator::Schedule (finish, &FluidBulkSendApplication::Finish, this);
+    }
+}
+
+void
+FluidBulkSendApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_active)
+    {
+      FluidFlowManager::RemoveFlow (this);
+      m_active = false;
+    }
+  m_path.clear ();
+  // chain up
+  Application::DoDispose ();
+}
+
+// Application Methods
+void FluidBulkSendApplication::StartApplication (void) // Called at time specified by Start
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_path.empty ())
+    {
+      FindPath ();
+    }
+  m_lastUpdate = Simulator::Now ();
+  if (!m_active && (m_maxBytes == 0 || m_totBytes < m_maxBytes))
+    {
+      m_active = true;
+      FluidFlowManager::AddFlow (this);
+    }
+}
+
+void FluidBulkSendApplication::StopApplication (void) // Called at time specified by Stop
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_active)
+    {
+      m_active = false;
+      SetRate (DataRate (0));
+      FluidFlowManager::RemoveFlow (this);
+    }
+}
+
+
+// Private helpers
+
+void
+FluidBulkSendApplication::FindPath (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ABORT_MSG_UNLESS (InetSocketAddress::IsMatchingType (m_peer),
+                       "FluidBulkSendApplication only supports IPv4 remote addresses");
+  Ipv4Address destination = InetSocketAddress::ConvertFrom (m_peer).GetIpv4 ();
+
+  Ptr<Node> node = GetNode ();
+  for (uint32_t hops = 0; hops < 255; hops++)
+    {
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ABORT_MSG_UNLESS (ipv4 != 0, "Node " << node->GetId () << " has no IPv4 stack");
+      if (ipv4->GetInterfaceForAddress (destination) >= 0)
+        {
+          NS_ABORT_MSG_IF (m_path.empty (), "The fluid flow to " << destination << " is local");
+          return;
+        }
+
+      Ipv4Header header;
+      header.SetDestination (destination);
+      Socket::SocketErrno errno_;
+      Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (0, header, 0, errno_);
+      NS_ABORT_MSG_UNLESS (route != 0, "Node " << node->GetId () << " has no route to " << destination);
+      Ptr<NetDevice> device = route->GetOutputDevice ();
+      NS_ABORT_MSG_IF (device->GetFluidCapacity ().GetBitRate () == 0,
+                       "Device " << device->GetIfIndex () << " of node " << node->GetId () <<
+                       " does not support fluid flows");
+      m_path.push_back (device);
+
+      // Find the next node, which owns the gateway or the destination
+      Ipv4Address next = route->GetGateway ();
+      if (next == Ipv4Address::GetAny ())
+        {
+          next = destination;
+        }
+      Ptr<Channel> channel = device->GetChannel ();
+      node = 0;
+      for (uint32_t i = 0; node == 0 && i < channel->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> peer = channel->GetDevice (i);
+          Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+          if (peer != device && peerIpv4 != 0 && peerIpv4->GetInterfaceForAddress (next) >= 0)
+            {
+              node = peer->GetNode ();
+            }
+        }
+      NS_ABORT_MSG_UNLESS (node != 0, "No node owns " << next << " on the channel of device " <<
+                           device->GetIfIndex () << " of node " << device->GetNode ()->GetId ());
+    }
+  NS_FATAL_ERROR ("Routing loop to " << destination);
+}
+
+void
+FluidBulkSendApplication::UpdateTotalBytes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_totBytes += m_rate.GetBitRate () * (Simulator::Now () - m_lastUpdate).GetSeconds () / 8;
+  if (m_maxBytes > 0)
+    {
+      m_totBytes = std::min (m_totBytes, static_cast<double> (m_maxBytes));
+    }
+  m_lastUpdate = Simulator::Now ();
+}
+
+void
+FluidBulkSendApplication::Finish (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Fluid flow done, " << m_maxBytes << " bytes sent");
+  m_totBytes = m_maxBytes;
+  m_lastUpdate = Simulator::Now ();
+  StopApplication ();
+}
+
+} // namespace ns3
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_BULK_SEND_APPLICATION_H
+#define FLUID_BULK_SEND_APPLICATION_H
+
+#include <vector>
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/net-device.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \defgroup fluidbulksend FluidBulkSendApplication
+ *
+ * This traffic generator models a long-lived bulk transfer, such as
+ * the one of a BulkSendApplication over TCP, as a fluid rate instead of
+ * as packets.  It is meant for the background flows of a simulation,
+ * which load the network but are not measured individually.
+ */
+
+/**
+ * \ingroup fluidbulksend
+ *
+ * \brief Send a bulk transfer as a fluid flow
+ *
+ * When started, the application finds the path of its flow to the
+ * remote address by querying the IPv4 routing of each node, and
+ * registers the flow with the FluidFlowManager.  The manager shares
+ * the capacity of the links among the fluid flows, max-min fairly as
+ * long-lived TCP flows would, and loads the devices of each link with
+ * the rate of the fluid flows crossing it (see
+ * NetDevice::SetFluidLoad).  The packets sent on these devices see the
+ * remaining capacity and the standing queue of the fluid flows.
+ *
+ * No packet and no event is generated between two changes of the
+ * rates, which only happen when a fluid flow starts or stops.
+ *
+ * The model is coarse in two ways.  The packet traffic of each link
+ * always keeps the share of one flow, even when there is none, so that
+ * the fluid flows never fill a link.  The packets crossing a bottleneck
+ * of the fluid flows are delayed by a fixed fraction (QueueFill) of the
+ * device queue: the queue of the fluid flows neither builds up nor
+ * drains, and causes no packet loss.
+ *
+ * All the devices on the path must support fluid flows (see
+ * NetDevice::GetFluidCapacity), and only IPv4 is supported.
+ */
+class FluidBulkSendApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FluidBulkSendApplication ();
+
+  virtual ~FluidBulkSendApplication ();
+
+  /**
+   * \brief Set the upper bound for the total number of bytes to send.
+   *
+   * The value zero means that there is no upper bound; i.e. data is
+   * sent until the application or simulation is stopped.
+   *
+   * \param maxBytes the upper bound of bytes to send
+   */
+  void SetMaxBytes (uint64_t maxBytes);
+
+  /**
+   * \brief Get the rate of the flow
+   * \return the rate allocated to the flow, null when it is not active
+   */
+  DataRate GetRate (void) const;
+
+  /**
+   * \brief Get the number of bytes sent so far
+   * \return the number of bytes sent
+   */
+  uint64_t GetTotalBytes (void) const;
+
+  /**
+   * \brief Get the path of the flow
+   * \return the devices transmitting the flow, from the source
+   */
+  const std::vector<Ptr<NetDevice> > & GetPath (void) const;
+
+  /**
+   * \brief Get the highest rate of the flow
+   * \return the highest rate, null if there is none
+   */
+  DataRate GetMaxRate (void) const;
+
+  /**
+   * \brief Get the fraction of the bottleneck queue the flow occupies
+   * \return the fraction of the queue, between 0 and 1
+   */
+  double GetQueueFill (void) const;
+
+  /**
+   * \brief Set the rate of the flow
+   *
+   * This method is called by the FluidFlowManager when it shares the
+   * capacity of the links again.
+   *
+   * \param rate the new rate of the flow
+   */
+  void SetRate (DataRate rate);
+
+  /**
+   * TracedCallback signature for the rate changes
+   *
+   * \param [in] oldRate the previous rate of the flow
+   * \param [in] newRate the new rate of the flow
+   */
+  typedef void (* RateTracedCallback)(DataRate oldRate, DataRate newRate);
+
+protected:
+  virtual void DoDispose (void);
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);    // Called at time specified by Start
+  virtual void StopApplication (void);     // Called at time specified by Stop
+
+  /**
+   * \brief Find the devices on the path to the remote address
+   */
+  void FindPath (void);
+  /**
+   * \brief Account for the bytes sent since the last rate change
+   */
+  void UpdateTotalBytes (void);
+  /**
+   * \brief Stop the flow once MaxBytes are sent
+   */
+  void Finish (void);
+
+  Address         m_peer;         //!< Peer address
+  uint64_t        m_maxBytes;     //!< Limit total number of bytes sent
+  DataRate        m_maxRate;      //!< Highest rate of the flow
+  double          m_queueFill;    //!< Fraction of the bottleneck queue occupied
+  bool            m_active;       //!< True if registered with the manager
+  DataRate        m_rate;         //!< Rate allocated to the flow
+  double          m_totBytes;     //!< Total bytes sent until m_lastUpdate
+  Time            m_lastUpdate;   //!< Time of the last rate change
+  EventId         m_finishEvent;  //!< Event stopping the flow at MaxBytes
+  std::vector<Ptr<NetDevice> > m_path; //!< Devices transmitting the flow
+
+  /// Traced Callback: rate changes
+  TracedCallback<DataRate, DataRate> m_rateTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLUID_BULK_SEND_APPLICATION_H */
@@ -0,0 +1,280 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/abort.h"
+#include "fluid-flow-manager.h"
+#include "fluid-bulk-send-application.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FluidFlowManager");
+
+/**
+ * \ingroup fluidbulksend
+ *
+ * \brief The state of the FluidFlowManager
+ */
+struct FluidFlowManagerState
+{
+  FluidFlowManagerState ()
+    : sharePending (false),
+      destroyScheduled (false)
+  {
+  }
+  std::vector<Ptr<FluidBulkSendApplication> > flows; //!< Active flows, in order of arrival
+  std::map<Ptr<NetDevice>, DataRate> loads;          //!< Loaded devices
+  bool sharePending;                                 //!< True if Share is scheduled
+  bool destroyScheduled;                             //!< True if Destroy is scheduled
+};
+
+/**
+ * \ingroup fluidbulksend
+ * \brief Get the state of the FluidFlowManager
+ * \return the state
+ */
+static FluidFlowManagerState &
+GetFluidFlowManagerState (void)
+{
+  static FluidFlowManagerState state;
+  return state;
+}
+
+void
+FluidFlowManager::AddFlow (Ptr<FluidBulkSendApplication> flow)
+{
+  NS_LOG_FUNCTION (flow);
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  NS_ASSERT (std::find (state.flows.begin (), state.flows.end (), flow) == state.flows.end ());
+  state.flows.push_back (flow);
+  ScheduleShare ();
+}
+
+void
+FluidFlowManager::RemoveFlow (Ptr<FluidBulkSendApplication> flow)
+{
+  NS_LOG_FUNCTION (flow);
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  std::vector<Ptr<FluidBulkSendApplication> >::iterator it;
+  it = std::find (state.flows.begin (), state.flows.end (), flow);
+  if (it != state.flows.end ())
+    {
+      state.flows.erase (it);
+      ScheduleShare ();
+    }
+}
+
+DataRate
+FluidFlowManager::GetLoad (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (device);
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  std::map<Ptr<NetDevice>, DataRate>::const_iterator it = state.loads.find (device);
+  if (it == state.loads.end ())
+    {
+      return DataRate (0);
+    }
+  return it->second;
+}
+
+void
+FluidFlowManager::ScheduleShare (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  if (!state.destroyScheduled)
+    {
+      NS_ABORT_MSG_IF (Simulator::GetImplementation ()->GetInstanceTypeId ().GetName () == "ns3::MultithreadedSimulatorImpl",
+                       "The fluid flows cannot be used with the MultithreadedSimulatorImpl");
+      state.destroyScheduled = true;
+      Simulator::ScheduleDestroy (&FluidFlowManager::Destroy);
+    }
+  if (!state.sharePending)
+    {
+      state.sharePending = true;
+      Simulator::ScheduleNow (&FluidFlowManager::Share);
+    }
+}
+
+void
+FluidFlowManager::Share (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  state.sharePending = false;
+
+  /// A link, identified by the device transmitting on it
+  struct Link
+  {
+    double capacity;  //!< Capacity, in bit/s
+    double residual;  //!< Capacity not allocated yet, in bit/s
+    uint32_t growing; //!< Number of flows whose rate still grows
+    bool saturated;   //!< True if all the capacity is allocated
+    double queueFill; //!< Fraction of the queue kept by the fluid flows
+    double load;      //!< Aggregate rate of the fluid flows, in bit/s
+  };
+  std::map<Ptr<NetDevice>, Link> links;
+
+  for (uint32_t i = 0; i < state.flows.size (); i++)
+    {
+      const std::vector<Ptr<NetDevice> > &path = state.flows[i]->GetPath ();
+      for (uint32_t j = 0; j < path.size (); j++)
+        {
+          std::map<Ptr<NetDevice>, Link>::iterator it = links.find (path[j]);
+          if (it == links.end ())
+            {
+              Link link;
+              link.capacity = path[j]->GetFluidCapacity ().GetBitRate ();
+              link.residual = link.capacity;
+              link.growing = 0;
+              link.saturated = false;
+              link.queueFill = 0;
+              link.load = 0;
+              it = links.insert (std::make_pair (path[j], link)).first;
+            }
+          it->second.growing++;
+        }
+    }
+
+  //
+  // Progressive filling: the rates of the flows not limited yet grow
+  // together until a link saturates or a flow reaches its MaxRate.  On
+  // each link, the packet-level traffic grows with them as one more
+  // flow.
+  //
+  std::vector<double> rates (state.flows.size (), 0);
+  std::vector<bool> growing (state.flows.size (), true);
+  uint32_t nGrowing = state.flows.size ();
+  while (nGrowing > 0)
+    {
+      double delta = std::numeric_limits<double>::infinity ();
+      for (uint32_t i = 0; i < state.flows.size (); i++)
+        {
+          if (!growing[i])
+            {
+              continue;
+            }
+          const std::vector<Ptr<NetDevice> > &path = state.flows[i]->GetPath ();
+          for (uint32_t j = 0; j < path.size (); j++)
+            {
+              const Link &link = links[path[j]];
+              delta = std::min (delta, link.residual / (link.growing + 1));
+            }
+          uint64_t maxRate = state.flows[i]->GetMaxRate ().GetBitRate ();
+          if (maxRate > 0)
+            {
+              delta = std::min (delta, maxRate - rates[i]);
+            }
+        }
+      NS_ASSERT_MSG (delta < std::numeric_limits<double>::infinity (), "Unbounded fluid flow");
+      delta = std::max (delta, 0.0);
+
+      for (std::map<Ptr<NetDevice>, Link>::iterator it = links.begin (); it != links.end (); it++)
+        {
+          Link &link = it->second;
+          if (link.growing > 0)
+            {
+              link.residual -= delta * (link.growing + 1);
+              if (link.residual <= link.capacity * 1e-9)
+                {
+                  link.saturated = true;
+                }
+            }
+        }
+
+      for (uint32_t i = 0; i < state.flows.size (); i++)
+        {
+          if (!growing[i])
+            {
+              continue;
+            }
+          rates[i] += delta;
+          uint64_t maxRate = state.flows[i]->GetMaxRate ().GetBitRate ();
+          bool limited = (maxRate > 0 && rates[i] >= maxRate * (1 - 1e-9));
+          const std::vector<Ptr<NetDevice> > &path = state.flows[i]->GetPath ();
+          for (uint32_t j = 0; j < path.size (); j++)
+            {
+              Link &link = links[path[j]];
+              if (link.saturated)
+                {
+                  // The flow is limited by this link, its bottleneck
+                  limited = true;
+                  link.queueFill = std::max (link.queueFill, state.flows[i]->GetQueueFill ());
+                }
+            }
+          if (limited)
+            {
+              growing[i] = false;
+              nGrowing--;
+              for (uint32_t j = 0; j < path.size (); j++)
+                {
+                  links[path[j]].growing--;
+                }
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < state.flows.size (); i++)
+    {
+      const std::vector<Ptr<NetDevice> > &path = state.flows[i]->GetPath ();
+      for (uint32_t j = 0; j < path.size (); j++)
+        {
+          links[path[j]].load += rates[i];
+        }
+    }
+
+  // Unload the devices no fluid flow crosses any longer
+  for (std::map<Ptr<NetDevice>, DataRate>::iterator it = state.loads.begin (); it != state.loads.end (); it++)
+    {
+      if (links.find (it->first) == links.end ())
+        {
+          it->first->SetFluidLoad (DataRate (0), 0);
+        }
+    }
+  state.loads.clear ();
+  for (std::map<Ptr<NetDevice>, Link>::iterator it = links.begin (); it != links.end (); it++)
+    {
+      DataRate load (static_cast<uint64_t> (it->second.load));
+      NS_LOG_LOGIC ("Device " << it->first << " load " << load <<
+                    " queue fill " << it->second.queueFill);
+      it->first->SetFluidLoad (load, it->second.queueFill);
+      state.loads[it->first] = load;
+    }
+
+  for (uint32_t i = 0; i < state.flows.size (); i++)
+    {
+      state.flows[i]->SetRate (DataRate (static_cast<uint64_t> (rates[i])));
+    }
+}
+
+void
+FluidFlowManager::Destroy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FluidFlowManagerState &state = GetFluidFlowManagerState ();
+  state.flows.clear ();
+  state.loads.clear ();
+  state.sharePending = false;
+  state.destroyScheduled = false;
+}
+
+} // namespace ns3
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_FLOW_MANAGER_H
+#define FLUID_FLOW_MANAGER_H
+
+#include "ns3/ptr.h"
+#include "ns3/data-rate.h"
+#include "ns3/net-device.h"
+
+namespace ns3 {
+
+class FluidBulkSendApplication;
+
+/**
+ * \ingroup fluidbulksend
+ *
+ * \brief Share the capacity of the links among the fluid flows
+ *
+ * The rates of the active fluid flows are the max-min fair share of
+ * the capacity of the links they cross, limited by their MaxRate, as
+ * computed by progressive filling.  The packet-level traffic of each
+ * link counts as one more flow in this share, so that the fluid flows
+ * never take the whole capacity of a link: a foreground packet flow
+ * gets the share a competing long-lived TCP flow would get.  This
+ * share is always reserved, whether or not packets are sent on the
+ * link: n fluid flows limited by an idle link only use n/(n+1) of its
+ * capacity.
+ *
+ * A fluid flow limited by a link, its bottleneck, keeps a standing
+ * queue there (see FluidBulkSendApplication's QueueFill attribute);
+ * the packets sent on that link wait behind it.  The delay of this
+ * queue is fixed by QueueFill: it does not depend on the number of
+ * flows nor on the packet load.
+ *
+ * The rates are computed again, once for all the changes made at the
+ * same time, whenever a flow is added or removed.
+ *
+ * The flows and the loads of the devices are global static state,
+ * shared by all the nodes: there is a single set of fluid flows in the
+ * process, which Simulator::Destroy clears.  The manager therefore
+ * cannot be used with a simulator executing the events of several
+ * nodes at the same time, such as the MultithreadedSimulatorImpl.
+ */
+class FluidFlowManager
+{
+public:
+  /**
+   * \brief Add a flow and share the capacity again
+   * \param flow the flow
+   */
+  static void AddFlow (Ptr<FluidBulkSendApplication> flow);
+
+  /**
+   * \brief Remove a flow and share the capacity again
+   * \param flow the flow
+   */
+  static void RemoveFlow (Ptr<FluidBulkSendApplication> flow);
+
+  /**
+   * \brief Get the aggregate rate of the fluid flows on a device
+   * \param device the device
+   * \return the rate of the fluid flows transmitted by the device
+   */
+  static DataRate GetLoad (Ptr<NetDevice> device);
+
+private:
+  /**
+   * \brief Schedule the computation of the rates, if not done yet
+   */
+  static void ScheduleShare (void);
+  /**
+   * \brief Compute the rates of the flows and the load of the devices
+   */
+  static void Share (void);
+  /**
+   * \brief Forget all the flows, at the end of the simulation
+   */
+  static void Destroy (void);
+};
+
+} // namespace ns3
+
+#endif /* FLUID_FLOW_MANAGER_H */
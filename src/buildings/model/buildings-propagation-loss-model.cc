@@ -24,6 +24,7 @@
 #include "ns3/log.h"
 #include "ns3/mobility-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include <cmath>
 #include "buildings-propagation-loss-model.h"
@@ -89,7 +90,34 @@ BuildingsPropagationLossModel::GetTypeId (void)
                    "Additional loss for each internal wall [dB]",
                    DoubleValue (5.0),
                    MakeDoubleAccessor (&BuildingsPropagationLossModel::m_lossInternalWall),
-                   MakeDoubleChecker<double> ());
+                   MakeDoubleChecker<double> ())
+
+    .AddAttribute ("ShadowingCacheMaxSize",
+                   "The maximum number of paths for which the shadowing value is kept, "
+                   "the least recently used path being evicted (0 for unbounded)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BuildingsPropagationLossModel::SetShadowingCacheMaxSize,
+                                         &BuildingsPropagationLossModel::GetShadowingCacheMaxSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ShadowingCacheMaxAge",
+                   "The time after which the shadowing value of a path which is not used "
+                   "is evicted (zero for no expiry)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&BuildingsPropagationLossModel::SetShadowingCacheMaxAge,
+                                     &BuildingsPropagationLossModel::GetShadowingCacheMaxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("ShadowingCacheHits",
+                   "The number of times the shadowing value of a path was found in the cache",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BuildingsPropagationLossModel::GetShadowingCacheHits),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("ShadowingCacheMisses",
+                   "The number of times the shadowing value of a path had to be drawn",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BuildingsPropagationLossModel::GetShadowingCacheMisses),
+                   MakeUintegerChecker<uint64_t> ());
 
 
   return tid;
@@ -98,6 +126,50 @@ BuildingsPropagationLossModel::GetTypeId (void)
 BuildingsPropagationLossModel::BuildingsPropagationLossModel ()
 {
   m_randVariable = CreateObject<NormalRandomVariable> ();
+  // the shadowing is drawn independently for each direction
+  m_shadowingLossCache.SetSymmetric (false);
+}
+
+void
+BuildingsPropagationLossModel::SetShadowingCacheMaxSize (uint32_t maxSize)
+{
+  m_shadowingLossCache.SetMaxSize (maxSize);
+}
+
+uint32_t
+BuildingsPropagationLossModel::GetShadowingCacheMaxSize (void) const
+{
+  return m_shadowingLossCache.GetMaxSize ();
+}
+
+void
+BuildingsPropagationLossModel::SetShadowingCacheMaxAge (Time maxAge)
+{
+  m_shadowingLossCache.SetMaxAge (maxAge);
+}
+
+Time
+BuildingsPropagationLossModel::GetShadowingCacheMaxAge (void) const
+{
+  return m_shadowingLossCache.GetMaxAge ();
+}
+
+uint64_t
+BuildingsPropagationLossModel::GetShadowingCacheHits (void) const
+{
+  return m_shadowingLossCache.GetHits ();
+}
+
+uint64_t
+BuildingsPropagationLossModel::GetShadowingCacheMisses (void) const
+{
+  return m_shadowingLossCache.GetMisses ();
+}
+
+uint32_t
+BuildingsPropagationLossModel::GetShadowingCacheSize (void) const
+{
+  return m_shadowingLossCache.GetSize ();
 }
 
 double
@@ -153,33 +225,16 @@ const
     Ptr<MobilityBuildingInfo> b1 = b->GetObject <MobilityBuildingInfo> ();
     NS_ASSERT_MSG ((a1 != 0) && (b1 != 0), "BuildingsPropagationLossModel only works with MobilityBuildingInfo");
   
-  std::map<Ptr<MobilityModel>,  std::map<Ptr<MobilityModel>, ShadowingLoss> >::iterator ait = m_shadowingLossMap.find (a);
-  if (ait != m_shadowingLossMap.end ())
-    {
-      std::map<Ptr<MobilityModel>, ShadowingLoss>::iterator bit = ait->second.find (b);
-      if (bit != ait->second.end ())
-        {
-          return (bit->second.GetLoss ());
-        }
-      else
-        {
-          double sigma = EvaluateSigma (a1, b1);
-          // side effect: will create new entry          
-          // sigma is standard deviation, not variance
-          double shadowingValue = m_randVariable->GetValue (0.0, (sigma*sigma));
-          ait->second[b] = ShadowingLoss (shadowingValue, b);          
-          return (ait->second[b].GetLoss ());
-        }
-    }
-  else
+  Ptr<ShadowingLoss> shadowing = m_shadowingLossCache.GetPathData (a, b, 0);
+  if (shadowing == 0)
     {
       double sigma = EvaluateSigma (a1, b1);
-      // side effect: will create new entries in both maps
       // sigma is standard deviation, not variance
       double shadowingValue = m_randVariable->GetValue (0.0, (sigma*sigma));
-      m_shadowingLossMap[a][b] = ShadowingLoss (shadowingValue, b);  
-      return (m_shadowingLossMap[a][b].GetLoss ());       
+      shadowing = Create<ShadowingLoss> (shadowingValue, b);
+      m_shadowingLossCache.AddPathData (shadowing, a, b, 0);
     }
+  return shadowing->GetLoss ();
 }
 
 
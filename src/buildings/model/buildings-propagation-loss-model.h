@@ -26,6 +26,7 @@
 #include "ns3/nstime.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/propagation-cache.h"
 #include <ns3/building.h>
 #include <ns3/mobility-building-info.h>
 
@@ -52,6 +53,10 @@ class JakesFadingLossModel;
  *  \warning This model works only when MobilityBuildingInfo is aggreegated
  *  to the mobility model
  *
+ *  The shadowing value of each path is kept in a PropagationCache,
+ *  which can be bounded with the ShadowingCacheMaxSize and
+ *  ShadowingCacheMaxAge attributes.
+ *
  */
 
 class BuildingsPropagationLossModel : public PropagationLossModel
@@ -71,6 +76,11 @@ public:
   // inherited from PropagationLossModel
   virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
 
+  /**
+   * \return the number of paths in the cache of shadowing values
+   */
+  uint32_t GetShadowingCacheSize (void) const;
+
 protected:
   double ExternalWallLoss (Ptr<MobilityBuildingInfo> a) const;
   double HeightLoss (Ptr<MobilityBuildingInfo> n) const;
@@ -81,7 +91,7 @@ protected:
   double m_lossInternalWall; // in meters
 
   
-  class ShadowingLoss
+  class ShadowingLoss : public SimpleRefCount<ShadowingLoss>
   {
   public:
     ShadowingLoss ();
@@ -93,7 +103,7 @@ protected:
     Ptr<MobilityModel> m_receiver;
   };
 
-  mutable std::map<Ptr<MobilityModel>,  std::map<Ptr<MobilityModel>, ShadowingLoss> > m_shadowingLossMap;
+  mutable PropagationCache<ShadowingLoss> m_shadowingLossCache;
   double EvaluateSigma (Ptr<MobilityBuildingInfo> a, Ptr<MobilityBuildingInfo> b) const;
 
 
@@ -103,6 +113,14 @@ protected:
   Ptr<NormalRandomVariable> m_randVariable;
 
   virtual int64_t DoAssignStreams (int64_t stream);
+
+private:
+  void SetShadowingCacheMaxSize (uint32_t maxSize);
+  uint32_t GetShadowingCacheMaxSize (void) const;
+  void SetShadowingCacheMaxAge (Time maxAge);
+  Time GetShadowingCacheMaxAge (void) const;
+  uint64_t GetShadowingCacheHits (void) const;
+  uint64_t GetShadowingCacheMisses (void) const;
 };
 
 }
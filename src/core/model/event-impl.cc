@@ -19,8 +19,14 @@
  */
 
 #include "event-impl.h"
+#include "global-value.h"
+#include "boolean.h"
 #include "log.h"
 
+#include <atomic>
+#include <mutex>
+#include <new>
+
 /**
  * \file
  * \ingroup events
@@ -31,6 +37,234 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+/**
+ * \ingroup events
+ * Whether small events are allocated from the per-thread pools.
+ */
+static GlobalValue g_eventPool = GlobalValue
+  ("EventPool",
+   "Allocate small events from per-thread pools rather than from "
+   "the global allocator.  Read when the first event is created.",
+   BooleanValue (true),
+   MakeBooleanChecker ());
+
+namespace {
+
+/** Block size granularity of the pools, which is also their alignment. */
+const std::size_t POOL_GRANULARITY = 16;
+/** Number of pools: events up to 256 bytes are pooled. */
+const std::size_t POOL_CLASSES = 16;
+/** Size of the chunks carved into blocks. */
+const std::size_t POOL_CHUNK_SIZE = 16384;
+
+/** A free block, linked in the pool of its size class. */
+struct FreeBlock
+{
+  FreeBlock *next;  //!< Next free block.
+};
+
+/** Header of a chunk of blocks. */
+struct Chunk
+{
+  Chunk *next;      //!< Previously allocated chunk.
+};
+
+/**
+ * All the chunks ever allocated.  They are never released, since
+ * blocks may be freed by another thread than the one which allocated
+ * them, but the free blocks of the threads which exit are reused
+ * through the shared pool, so that the chunks do not outgrow the peak
+ * number of live events.
+ */
+std::atomic<Chunk *> g_chunks (0);
+
+/** The free blocks of the calling thread, per size class. */
+thread_local FreeBlock *g_freeBlocks[POOL_CLASSES];
+
+/**
+ * Whether the calling thread is exiting and returned its free blocks
+ * to the shared pool: its events are then allocated from, and released
+ * to, the shared pool.
+ */
+thread_local bool g_poolReleased = false;
+
+/** The free blocks returned by the threads which exited, per size class. */
+FreeBlock *g_sharedBlocks[POOL_CLASSES];
+
+/** Mutex protecting g_sharedBlocks. */
+std::mutex g_sharedMutex;
+
+/**
+ * Return the free blocks of a thread to the shared pool when the
+ * thread exits.
+ */
+struct PoolReleaser
+{
+  PoolReleaser ()
+    : active (false)
+  {}
+  ~PoolReleaser ()
+  {
+    std::lock_guard<std::mutex> lock (g_sharedMutex);
+    for (std::size_t sizeClass = 0; sizeClass < POOL_CLASSES; sizeClass++)
+      {
+        FreeBlock *head = g_freeBlocks[sizeClass];
+        if (head == 0)
+          {
+            continue;
+          }
+        FreeBlock *tail = head;
+        while (tail->next != 0)
+          {
+            tail = tail->next;
+          }
+        tail->next = g_sharedBlocks[sizeClass];
+        g_sharedBlocks[sizeClass] = head;
+        g_freeBlocks[sizeClass] = 0;
+      }
+    g_poolReleased = true;
+  }
+  bool active;  //!< Set when the thread first takes blocks from the pools.
+};
+
+/** Releases the free blocks of the calling thread when it exits. */
+thread_local PoolReleaser g_poolReleaser;
+
+/**
+ * Check, once, whether the pools are enabled.
+ * \returns \c true if small events are pooled.
+ */
+bool
+IsPoolEnabled (void)
+{
+  static const bool enabled = []
+  {
+    BooleanValue value (true);
+    GlobalValue::GetValueByNameFailSafe ("EventPool", value);
+    return value.Get ();
+  } ();
+  return enabled;
+}
+
+/**
+ * Carve a new chunk into blocks of a size class.
+ * \param [in] sizeClass The size class.
+ * \returns The list of the blocks.
+ */
+FreeBlock *
+AllocateChunk (std::size_t sizeClass)
+{
+  std::size_t blockSize = (sizeClass + 1) * POOL_GRANULARITY;
+  char *buffer = static_cast<char *> (::operator new (POOL_CHUNK_SIZE));
+  Chunk *chunk = reinterpret_cast<Chunk *> (buffer);
+  chunk->next = g_chunks.load ();
+  while (!g_chunks.compare_exchange_weak (chunk->next, chunk))
+    {
+    }
+  // the chunk header uses the first POOL_GRANULARITY bytes
+  std::size_t nBlocks = (POOL_CHUNK_SIZE - POOL_GRANULARITY) / blockSize;
+  FreeBlock *head = 0;
+  for (std::size_t i = nBlocks; i > 0; i--)
+    {
+      FreeBlock *block = reinterpret_cast<FreeBlock *>
+        (buffer + POOL_GRANULARITY + (i - 1) * blockSize);
+      block->next = head;
+      head = block;
+    }
+  return head;
+}
+
+/**
+ * Refill the pool of a size class of the calling thread, with up to a
+ * chunk of the blocks left by the threads which exited if any, or with
+ * a new chunk.
+ * \param [in] sizeClass The size class.
+ */
+void
+RefillPool (std::size_t sizeClass)
+{
+  // make sure that the blocks are returned when the thread exits
+  g_poolReleaser.active = true;
+  {
+    std::lock_guard<std::mutex> lock (g_sharedMutex);
+    FreeBlock *head = g_sharedBlocks[sizeClass];
+    if (head != 0)
+      {
+        // leave the other blocks to the other threads
+        std::size_t nBlocks = POOL_CHUNK_SIZE / ((sizeClass + 1) * POOL_GRANULARITY);
+        FreeBlock *tail = head;
+        while (--nBlocks > 0 && tail->next != 0)
+          {
+            tail = tail->next;
+          }
+        g_sharedBlocks[sizeClass] = tail->next;
+        tail->next = 0;
+        g_freeBlocks[sizeClass] = head;
+        return;
+      }
+  }
+  g_freeBlocks[sizeClass] = AllocateChunk (sizeClass);
+}
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / POOL_GRANULARITY;
+  if (sizeClass >= POOL_CLASSES || !IsPoolEnabled ())
+    {
+      return ::operator new (size);
+    }
+  if (g_poolReleased)
+    {
+      // the thread is exiting
+      std::lock_guard<std::mutex> lock (g_sharedMutex);
+      if (g_sharedBlocks[sizeClass] == 0)
+        {
+          g_sharedBlocks[sizeClass] = AllocateChunk (sizeClass);
+        }
+      FreeBlock *block = g_sharedBlocks[sizeClass];
+      g_sharedBlocks[sizeClass] = block->next;
+      return block;
+    }
+  FreeBlock *block = g_freeBlocks[sizeClass];
+  if (block == 0)
+    {
+      RefillPool (sizeClass);
+      block = g_freeBlocks[sizeClass];
+    }
+  g_freeBlocks[sizeClass] = block->next;
+  return block;
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / POOL_GRANULARITY;
+  if (sizeClass >= POOL_CLASSES || !IsPoolEnabled ())
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  if (g_poolReleased)
+    {
+      // the thread is exiting
+      std::lock_guard<std::mutex> lock (g_sharedMutex);
+      block->next = g_sharedBlocks[sizeClass];
+      g_sharedBlocks[sizeClass] = block;
+      return;
+    }
+  block->next = g_freeBlocks[sizeClass];
+  if (block->next == 0)
+    {
+      // the thread may not have allocated any event yet
+      g_poolReleaser.active = true;
+    }
+  g_freeBlocks[sizeClass] = block;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
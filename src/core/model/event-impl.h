@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,14 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * The subclasses created by MakeEvent() store the bound object and
+ * arguments inline, so that scheduling an event requires a single
+ * allocation.  Small events are allocated from per-thread pools of
+ * fixed-size blocks rather than from the global allocator, unless the
+ * \c EventPool GlobalValue is \c false at the time the first event is
+ * created.  The free blocks of a thread are returned to a shared pool
+ * when the thread exits, and reused by the other threads.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +75,23 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the storage of an event, from the pool of the calling
+   * thread for small events.
+   *
+   * \param [in] size The size of the event object.
+   * \returns The storage.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the storage of an event, to the pool of the calling thread
+   * for small events.
+   *
+   * \param [in] p The storage.
+   * \param [in] size The size of the event object.
+   */
+  static void operator delete (void *p, std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
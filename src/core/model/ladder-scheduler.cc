@@ -0,0 +1,366 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+const uint32_t LadderScheduler::THRESHOLD;
+const uint32_t LadderScheduler::MAX_RUNGS;
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (UINT64_MAX),
+    m_topMax (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_bottomLimit (THRESHOLD),
+    m_qSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung)
+{
+  return rung.start + rung.current * rung.width;
+}
+
+LadderScheduler::Rung &
+LadderScheduler::CreateRung (uint64_t start, uint64_t width, uint32_t nBuckets)
+{
+  NS_LOG_FUNCTION (this << start << width << nBuckets);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  // m_rungs is never resized, so that references to rungs stay valid
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  if (rung.buckets.size () < nBuckets)
+    {
+      rung.buckets.resize (nBuckets);
+    }
+  rung.nBuckets = nBuckets;
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.count = 0;
+  return rung;
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  Bucket::iterator head = m_bottom.begin () + m_bottomHead;
+  if (m_bottomHead > 0 && ev < *head)
+    {
+      // reuse the slot of the last dequeued event
+      m_bottomHead--;
+      m_bottom[m_bottomHead] = ev;
+      return;
+    }
+  m_bottom.insert (std::upper_bound (head, m_bottom.end (), ev), ev);
+
+  uint32_t n = m_bottom.size () - m_bottomHead;
+  if (n > m_bottomLimit && m_nRungs < MAX_RUNGS)
+    {
+      // Too many events were inserted below the ladder: move the bottom
+      // tier to a new rung rather than paying a linear insertion cost.
+      uint64_t start = m_bottom[m_bottomHead].key.m_ts;
+      uint64_t end = m_nRungs == 0 ? m_topStart : GetCurrentStart (m_rungs[m_nRungs - 1]);
+      uint64_t width = std::max ((end - start) / n, (uint64_t)1);
+      Rung &rung = CreateRung (start, width, (end - start + width - 1) / width);
+      for (Bucket::const_iterator i = m_bottom.begin () + m_bottomHead; i != m_bottom.end (); ++i)
+        {
+          rung.buckets[(i->key.m_ts - start) / width].push_back (*i);
+        }
+      rung.count = n;
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      RefillBottom ();
+    }
+}
+
+void
+LadderScheduler::MoveToBottom (Bucket &bucket)
+{
+  NS_LOG_FUNCTION (this << bucket.size ());
+  NS_ASSERT (m_bottom.empty ());
+  // swap the arrays to recycle the memory of the old bottom tier
+  m_bottom.swap (bucket);
+  m_bottomHead = 0;
+  m_bottomLimit = std::max (2 * (uint32_t)m_bottom.size (), THRESHOLD);
+  std::sort (m_bottom.begin (), m_bottom.end ());
+}
+
+void
+LadderScheduler::RefillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty () && m_qSize > 0);
+
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          NS_ASSERT (!m_top.empty ());
+          uint64_t topMin = m_topMin;
+          uint64_t topMax = m_topMax;
+          m_topStart = topMax + 1;
+          m_topMin = UINT64_MAX;
+          m_topMax = 0;
+          if (m_top.size () <= THRESHOLD)
+            {
+              MoveToBottom (m_top);
+              return;
+            }
+          uint64_t width = std::max ((topMax - topMin) / m_top.size (), (uint64_t)1);
+          Rung &rung = CreateRung (topMin, width, (topMax - topMin) / width + 1);
+          for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+            {
+              rung.buckets[(i->key.m_ts - topMin) / width].push_back (*i);
+            }
+          rung.count = m_top.size ();
+          m_top.clear ();
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      NS_ASSERT (rung.current < rung.nBuckets);
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t bucketStart = GetCurrentStart (rung);
+      uint32_t n = bucket.size ();
+      rung.count -= n;
+      rung.current++;
+      if (n <= THRESHOLD || rung.width == 1 || m_nRungs == MAX_RUNGS)
+        {
+          MoveToBottom (bucket);
+          return;
+        }
+
+      // spawn a finer rung covering exactly the bucket
+      uint64_t width = (rung.width + n - 1) / n;
+      Rung &child = CreateRung (bucketStart, width, (rung.width + width - 1) / width);
+      for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+        {
+          child.buckets[(i->key.m_ts - bucketStart) / width].push_back (*i);
+        }
+      child.count = n;
+      bucket.clear ();
+    }
+}
+
+void
+LadderScheduler::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  // start over: the next events all go to the top tier
+  m_top.clear ();
+  m_topStart = 0;
+  m_topMin = UINT64_MAX;
+  m_topMax = 0;
+  m_nRungs = 0;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_qSize++;
+
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+    }
+  else
+    {
+      uint32_t i;
+      for (i = 0; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= GetCurrentStart (rung))
+            {
+              rung.buckets[(ts - rung.start) / rung.width].push_back (ev);
+              rung.count++;
+              break;
+            }
+        }
+      if (i == m_nRungs)
+        {
+          InsertBottom (ev);
+        }
+    }
+
+  if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+
+  Scheduler::Event ev = m_bottom[m_bottomHead];
+  m_bottomHead++;
+  if (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+    }
+  m_qSize--;
+
+  if (m_qSize == 0)
+    {
+      Reset ();
+    }
+  else if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+
+  // look for the event with the same rules as Insert
+  Bucket *bucket = 0;
+  Rung *rung = 0;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; i++)
+        {
+          if (ts >= GetCurrentStart (m_rungs[i]))
+            {
+              rung = &m_rungs[i];
+              bucket = &rung->buckets[(ts - rung->start) / rung->width];
+              break;
+            }
+        }
+    }
+
+  if (bucket == 0)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      NS_ASSERT (ev.impl == i->impl);
+      m_bottom.erase (i);
+      if (m_bottomHead == m_bottom.size ())
+        {
+          m_bottom.clear ();
+          m_bottomHead = 0;
+        }
+    }
+  else
+    {
+      Bucket::iterator i;
+      for (i = bucket->begin (); i != bucket->end (); ++i)
+        {
+          if (i->key.m_uid == ev.key.m_uid)
+            {
+              break;
+            }
+        }
+      NS_ASSERT (i != bucket->end ());
+      NS_ASSERT (ev.impl == i->impl);
+      // buckets are unsorted
+      *i = bucket->back ();
+      bucket->pop_back ();
+      if (rung != 0)
+        {
+          rung->count--;
+        }
+    }
+  m_qSize--;
+
+  if (m_qSize == 0)
+    {
+      Reset ();
+    }
+  else if (m_bottom.empty ())
+    {
+      RefillBottom ();
+    }
+}
+
+} // namespace ns3
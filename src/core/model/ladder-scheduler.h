@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the Ladder Queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * Events are kept in three tiers:
+ *  - Top: an unsorted array of the events far in the future,
+ *  - Ladder: a few rungs of buckets, each rung splitting one bucket of
+ *    the rung above into finer buckets, unsorted,
+ *  - Bottom: a small sorted array from which events are dequeued.
+ *
+ * Unlike the CalendarScheduler, there is no global resize: the ladder
+ * adapts the bucket width to the event distribution locally, every
+ * time a bucket holding more than a threshold of events has to be
+ * split, which gives an O(1) amortized cost for both Insert and
+ * RemoveNext even with very skewed or bursty timestamp distributions.
+ *
+ * All the tiers store the events by value in std::vector, so that
+ * there is no per-event list node allocation, and the rung and bucket
+ * arrays are recycled rather than freed.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: an unsorted array of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** The buckets; only the first nBuckets ones are in use. */
+    std::vector<Bucket> buckets;
+    /** Number of buckets in use. */
+    uint32_t nBuckets;
+    /** Timestamp of the start of the first bucket. */
+    uint64_t start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t width;
+    /** Index of the first bucket not yet moved to a lower tier. */
+    uint32_t current;
+    /** Number of events in the rung. */
+    uint32_t count;
+  };
+
+  /**
+   * Get the first timestamp still covered by a rung.
+   * \param [in] rung The rung.
+   * \returns The start of the current bucket of the rung.
+   */
+  static uint64_t GetCurrentStart (const Rung &rung);
+  /**
+   * Prepare a rung covering a time range.
+   * \param [in] start The start of the range.
+   * \param [in] width The bucket width.
+   * \param [in] nBuckets The number of buckets.
+   * \returns The new rung.
+   */
+  Rung & CreateRung (uint64_t start, uint64_t width, uint32_t nBuckets);
+  /**
+   * Insert an event in the bottom tier, and move the bottom tier to a
+   * new rung if it grew too large.
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Replace the bottom tier with the content of a bucket, sorted.
+   * \param [in,out] bucket The bucket, which is emptied.
+   */
+  void MoveToBottom (Bucket &bucket);
+  /** Forget the tier boundaries once the queue is empty. */
+  void Reset (void);
+  /** Refill the bottom tier from the ladder or the top tier. */
+  void RefillBottom (void);
+
+  /** Maximum number of events sorted directly in the bottom tier. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /** The top tier. */
+  Bucket m_top;
+  /** Events with a timestamp greater or equal to this go to the top tier. */
+  uint64_t m_topStart;
+  /** Minimum timestamp in the top tier. */
+  uint64_t m_topMin;
+  /** Maximum timestamp in the top tier. */
+  uint64_t m_topMax;
+  /** The rungs; only the first m_nRungs ones are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The bottom tier, sorted by increasing key from m_bottomHead. */
+  Bucket m_bottom;
+  /** Index of the earliest event of the bottom tier. */
+  uint32_t m_bottomHead;
+  /** Size above which the bottom tier is moved back to the ladder. */
+  uint32_t m_bottomLimit;
+  /** Number of events in queue. */
+  uint32_t m_qSize;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
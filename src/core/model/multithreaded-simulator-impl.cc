@@ -0,0 +1,1005 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator.h"
+#include "multithreaded-simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+
+#include "ptr.h"
+#include "pointer.h"
+#include "uinteger.h"
+#include "config.h"
+#include "assert.h"
+#include "abort.h"
+#include "log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Partition index of a thread which is not running simulation events. */
+const uint32_t NO_PARTITION = 0xffffffff;
+
+/** Largest timestamp. */
+const uint64_t MAX_TS = 0x7fffffffffffffffULL;
+
+/** Index of the partition executed by the calling thread. */
+thread_local uint32_t g_currentPartition = NO_PARTITION;
+
+} // unnamed namespace
+
+/**
+ * Window synchronization between the main thread and the workers.
+ *
+ * SystemCondition::Wait() clears the condition on entry and would lose
+ * a window started before the worker begins to wait, hence the use of
+ * a plain condition variable with a generation counter.
+ */
+struct MultithreadedSimulatorImpl::Barrier
+{
+  /** Mutex protecting the fields below. */
+  std::mutex mutex;
+  /** Signaled when a new window starts or the workers must exit. */
+  std::condition_variable start;
+  /** Signaled when the last worker completes its window. */
+  std::condition_variable done;
+  /** Number of windows started so far. */
+  uint64_t generation;
+  /** Number of workers still executing the current window. */
+  uint32_t pending;
+  /** Flag asking the workers to exit. */
+  bool exit;
+};
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of partitions, each executed by its own thread. "
+                   "Zero selects the number of hardware threads.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LookAhead",
+                   "The minimum delay of any event sent from one context to "
+                   "another.  Zero derives it from the Delay attribute of the "
+                   "channels.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_userLookAhead),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  m_threadCount = 0;
+  m_lookAhead = 0;
+  m_windowStart = 0;
+  m_windowEnd = 0;
+  m_stopTs = MAX_TS;
+  m_concurrent = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_uid = 4;
+  m_stop = false;
+  m_eventsWithContextEmpty = true;
+  m_barrier = new Barrier;
+  m_main = SystemThread::Self ();
+  g_currentPartition = NO_PARTITION;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  delete m_barrier;
+  m_barrier = 0;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  MergeEvents ();
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      partition->events = 0;
+      delete partition;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_threadCount == 0)
+    {
+      m_threadCount = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  // one partition per thread, plus one for the events without context
+  for (uint32_t i = 0; i <= m_threadCount; ++i)
+    {
+      Partition *partition = new Partition;
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      partition->uid = m_uid;
+      partition->currentUid = 0;
+      partition->currentTs = 0;
+      partition->currentContext = Simulator::NO_CONTEXT;
+      partition->eventCount = 0;
+      partition->sentCount = 0;
+      partition->unscheduledEvents = 0;
+      partition->stop = false;
+      m_partitions.push_back (partition);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+
+  if (m_partitions.empty ())
+    {
+      CreatePartitions ();
+      return;
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!(*i)->events->IsEmpty ())
+        {
+          Scheduler::Event next = (*i)->events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionIndex (uint32_t context) const
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_threadCount;
+    }
+  if (context < m_nodePartitions.size ())
+    {
+      return m_nodePartitions[context];
+    }
+  return context % m_threadCount;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  if (g_currentPartition < m_partitions.size ())
+    {
+      return m_partitions[g_currentPartition];
+    }
+  // the main thread outside of Run, or a foreign thread
+  return m_partitions.back ();
+}
+
+Scheduler::EventKey
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts,
+                                    uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  // Outside of the parallel windows all uids come from the same
+  // counter, so that events are totally ordered as in the
+  // DefaultSimulatorImpl.
+  if (m_concurrent)
+    {
+      ev.key.m_uid = partition->uid;
+      partition->uid++;
+    }
+  else
+    {
+      ev.key.m_uid = m_uid;
+      m_uid++;
+    }
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return ev.key;
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_userLookAhead.IsStrictlyPositive ())
+    {
+      m_lookAhead = m_userLookAhead.GetTimeStep ();
+      return;
+    }
+
+  // Same rule as DistributedSimulatorImpl::CalculateLookAhead, applied to
+  // every channel since any of them may connect two partitions.
+  bool found = false;
+  m_lookAhead = MAX_TS;
+  Config::MatchContainer channels = Config::LookupMatches ("/ChannelList/*");
+  for (Config::MatchContainer::Iterator i = channels.Begin (); i != channels.End (); ++i)
+    {
+      TimeValue delay;
+      if (!(*i)->GetAttributeFailSafe ("Delay", delay)
+          || !delay.Get ().IsStrictlyPositive ())
+        {
+          NS_LOG_WARN ("channel " << (*i)->GetInstanceTypeId ().GetName ()
+                                  << " has no fixed delay, no lookahead available");
+          found = false;
+          break;
+        }
+      found = true;
+      m_lookAhead = std::min (m_lookAhead, (uint64_t) delay.Get ().GetTimeStep ());
+    }
+  if (!found)
+    {
+      m_lookAhead = 0;
+    }
+  NS_LOG_INFO ("lookahead " << TimeStep (m_lookAhead));
+}
+
+bool
+MultithreadedSimulatorImpl::AssignPartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  // The network module is not visible from here: the node of each device
+  // and the devices of each channel are found through their Config paths.
+  Config::MatchContainer nodeDevices = Config::LookupMatches ("/NodeList/*/DeviceList/*");
+  Config::MatchContainer channelDevices = Config::LookupMatches ("/ChannelList/*/DeviceList/*");
+  uint32_t nNodes = Config::LookupMatches ("/NodeList/*").GetN ();
+  std::map<const Object *, uint32_t> deviceNodes;
+  for (uint32_t i = 0; i < nodeDevices.GetN (); ++i)
+    {
+      uint32_t node;
+      if (std::sscanf (nodeDevices.GetMatchedPath (i).c_str (), "/NodeList/%u/", &node) == 1)
+        {
+          deviceNodes[PeekPointer (nodeDevices.Get (i))] = node;
+        }
+    }
+
+  // union-find of the nodes connected by each channel
+  std::vector<uint32_t> roots (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      roots[i] = i;
+    }
+  uint32_t previousChannel = 0xffffffff;
+  uint32_t previousRoot = 0;
+  for (uint32_t i = 0; i < channelDevices.GetN (); ++i)
+    {
+      uint32_t channel;
+      std::map<const Object *, uint32_t>::const_iterator device =
+        deviceNodes.find (PeekPointer (channelDevices.Get (i)));
+      if (std::sscanf (channelDevices.GetMatchedPath (i).c_str (), "/ChannelList/%u/", &channel) != 1
+          || device == deviceNodes.end () || device->second >= nNodes)
+        {
+          continue;
+        }
+      uint32_t root = device->second;
+      while (roots[root] != root)
+        {
+          roots[root] = roots[roots[root]];
+          root = roots[root];
+        }
+      if (channel == previousChannel && root != previousRoot)
+        {
+          roots[std::max (root, previousRoot)] = std::min (root, previousRoot);
+          root = std::min (root, previousRoot);
+        }
+      previousChannel = channel;
+      previousRoot = root;
+    }
+
+  // the networks, as (-number of nodes, smallest node id), largest first
+  std::vector<uint32_t> sizes (nNodes, 0);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      while (roots[roots[i]] != roots[i])
+        {
+          roots[i] = roots[roots[i]];
+        }
+      sizes[roots[i]]++;
+    }
+  std::vector<std::pair<int64_t, uint32_t> > networks;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      if (roots[i] == i)
+        {
+          networks.push_back (std::make_pair (-(int64_t) sizes[i], i));
+        }
+    }
+  std::sort (networks.begin (), networks.end ());
+
+  // give each network to the partition with the fewest nodes
+  std::vector<uint32_t> loads (m_threadCount, 0);
+  std::vector<uint32_t> networkPartitions (nNodes, 0);
+  uint32_t used = 0;
+  for (uint32_t i = 0; i < networks.size (); ++i)
+    {
+      uint32_t partition = std::min_element (loads.begin (), loads.end ()) - loads.begin ();
+      used += loads[partition] == 0;
+      loads[partition] += -networks[i].first;
+      networkPartitions[networks[i].second] = partition;
+    }
+  m_nodePartitions.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      m_nodePartitions[i] = networkPartitions[roots[i]];
+    }
+  NS_LOG_INFO (networks.size () << " networks of " << nNodes << " nodes over "
+                                << used << " partitions");
+
+  // move the pending events to the partition of their context
+  std::vector<Scheduler::Event> events;
+  for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          events.push_back (partition->events->RemoveNext ());
+          partition->unscheduledEvents--;
+        }
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      Partition *partition = m_partitions[GetPartitionIndex (i->key.m_context)];
+      partition->events->Insert (*i);
+      partition->unscheduledEvents++;
+    }
+  return nNodes == 0 || used > 1;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+Scheduler::EventKey
+MultithreadedSimulatorImpl::Next (const Partition *partition) const
+{
+  if (partition->events->IsEmpty ())
+    {
+      Scheduler::EventKey key;
+      key.m_ts = MAX_TS;
+      key.m_uid = 0xffffffff;
+      key.m_context = Simulator::NO_CONTEXT;
+      return key;
+    }
+  return partition->events->PeekNext ().key;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+  partition->eventCount++;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (uint32_t index)
+{
+  g_currentPartition = index;
+  Partition *partition = m_partitions[index];
+  while (!partition->stop && !partition->events->IsEmpty ())
+    {
+      uint64_t ts = partition->events->PeekNext ().key.m_ts;
+      if (ts >= m_windowEnd || ts > m_stopTs.load (std::memory_order_relaxed))
+        {
+          break;
+        }
+      ProcessOneEvent (partition);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::RemoteEvent::operator < (const RemoteEvent &other) const
+{
+  if (timestamp != other.timestamp)
+    {
+      return timestamp < other.timestamp;
+    }
+  if (source != other.source)
+    {
+      return source < other.source;
+    }
+  return sequence < other.sequence;
+}
+
+void
+MultithreadedSimulatorImpl::MergeEvents (void)
+{
+  uint64_t now = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      now = std::max (now, partition->currentTs);
+      m_uid = std::max (m_uid, partition->uid);
+      m_stop |= partition->stop;
+      if (partition->remoteEvents.empty ())
+        {
+          continue;
+        }
+      std::sort (partition->remoteEvents.begin (), partition->remoteEvents.end ());
+      for (RemoteEvents::const_iterator j = partition->remoteEvents.begin ();
+           j != partition->remoteEvents.end (); ++j)
+        {
+          Insert (partition, j->timestamp, j->context, j->event);
+        }
+      partition->remoteEvents.clear ();
+    }
+
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  // swap queues
+  EventsWithContext eventsWithContext;
+  {
+    CriticalSection cs (m_eventsWithContextMutex);
+    m_eventsWithContext.swap (eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  while (!eventsWithContext.empty ())
+    {
+      EventWithContext event = eventsWithContext.front ();
+      eventsWithContext.pop_front ();
+      Insert (m_partitions[GetPartitionIndex (event.context)],
+              now + event.timestamp, event.context, event.event);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::WorkerLoop (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  g_currentPartition = index;
+  uint64_t generation = 0;
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_barrier->mutex);
+        while (!m_barrier->exit && m_barrier->generation == generation)
+          {
+            m_barrier->start.wait (lock);
+          }
+        if (m_barrier->exit)
+          {
+            return;
+          }
+        generation = m_barrier->generation;
+      }
+      ProcessWindow (index);
+      {
+        std::lock_guard<std::mutex> lock (m_barrier->mutex);
+        m_barrier->pending--;
+        if (m_barrier->pending == 0)
+          {
+            m_barrier->done.notify_one ();
+          }
+      }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::WorkerEntry (std::pair<MultithreadedSimulatorImpl *, uint32_t> worker)
+{
+  worker.first->WorkerLoop (worker.second);
+}
+
+bool
+MultithreadedSimulatorImpl::IsEmpty (void) const
+{
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return IsEmpty () || m_stop;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  Partition *global = m_partitions.back ();
+  g_currentPartition = m_threadCount;
+
+  CalculateLookAhead ();
+  m_stop = false;
+  m_stopTs = MAX_TS;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->stop = false;
+    }
+
+  // partition 0 is executed by the main thread itself
+  bool parallel = m_lookAhead > 0 && m_threadCount > 1;
+  if (parallel && !AssignPartitions ())
+    {
+      NS_LOG_WARN ("all the nodes are connected, no parallel execution");
+      parallel = false;
+    }
+  if (parallel)
+    {
+      m_barrier->generation = 0;
+      m_barrier->pending = 0;
+      m_barrier->exit = false;
+      for (uint32_t i = 1; i < m_threadCount; ++i)
+        {
+          Ptr<SystemThread> worker = Create<SystemThread> (
+              MakeBoundCallback (&MultithreadedSimulatorImpl::WorkerEntry,
+                                 std::make_pair (this, i)));
+          worker->Start ();
+          m_workers.push_back (worker);
+        }
+    }
+
+  while (true)
+    {
+      MergeEvents ();
+      if (m_stop)
+        {
+          break;
+        }
+
+      // find the earliest event with context, and the partition holding it
+      uint32_t first = m_threadCount;
+      Scheduler::EventKey next = Next (global);
+      Scheduler::EventKey nextGlobal = next;
+      uint64_t nextTs = MAX_TS;
+      for (uint32_t i = 0; i < m_threadCount; ++i)
+        {
+          Scheduler::EventKey key = Next (m_partitions[i]);
+          nextTs = std::min (nextTs, key.m_ts);
+          if (key < next)
+            {
+              next = key;
+              first = i;
+            }
+        }
+      if (next.m_ts == MAX_TS)
+        {
+          break;
+        }
+      uint64_t stopTs = m_stopTs;
+      if (next.m_ts > stopTs)
+        {
+          m_stop = true;
+          break;
+        }
+
+      // The window can never cross a pending global event, nor a
+      // pending stop time.
+      m_windowStart = nextTs;
+      m_windowEnd = nextGlobal.m_ts;
+      if (MAX_TS - nextTs > m_lookAhead)
+        {
+          m_windowEnd = std::min (m_windowEnd, nextTs + m_lookAhead);
+        }
+      if (stopTs < m_windowEnd)
+        {
+          m_windowEnd = stopTs + 1;
+        }
+
+      if (!parallel || first == m_threadCount || m_windowEnd <= nextTs)
+        {
+          // Execute the earliest event alone on the main thread.
+          g_currentPartition = first;
+          ProcessOneEvent (m_partitions[first]);
+          g_currentPartition = m_threadCount;
+          continue;
+        }
+
+      m_concurrent = true;
+      for (uint32_t i = 0; i < m_threadCount; ++i)
+        {
+          m_partitions[i]->uid = m_uid;
+        }
+      {
+        std::lock_guard<std::mutex> lock (m_barrier->mutex);
+        m_barrier->pending = m_threadCount - 1;
+        m_barrier->generation++;
+      }
+      m_barrier->start.notify_all ();
+      ProcessWindow (0);
+      {
+        std::unique_lock<std::mutex> lock (m_barrier->mutex);
+        while (m_barrier->pending != 0)
+          {
+            m_barrier->done.wait (lock);
+          }
+      }
+      m_concurrent = false;
+      g_currentPartition = m_threadCount;
+    }
+
+  if (parallel)
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_barrier->mutex);
+        m_barrier->exit = true;
+      }
+      m_barrier->start.notify_all ();
+      for (std::vector<Ptr<SystemThread> >::iterator i = m_workers.begin (); i != m_workers.end (); ++i)
+        {
+          (*i)->Join ();
+        }
+      m_workers.clear ();
+    }
+
+  // the main thread now observes the time reached by the partitions
+  for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+      global->currentTs = std::max (global->currentTs, m_partitions[i]->currentTs);
+    }
+  g_currentPartition = NO_PARTITION;
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+#ifdef NS3_ASSERT_ENABLE
+  int unscheduledEvents = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      unscheduledEvents += (*i)->unscheduledEvents;
+    }
+  NS_ASSERT (!IsEmpty () || unscheduledEvents == 0);
+#endif
+}
+
+void
+MultithreadedSimulatorImpl::StopAfter (uint64_t ts)
+{
+  uint64_t current = m_stopTs;
+  while (ts < current && !m_stopTs.compare_exchange_weak (current, ts))
+    {
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *partition = GetCurrentPartition ();
+  partition->stop = true;
+  if (m_concurrent)
+    {
+      // the other partitions of the window must stop too
+      StopAfter (partition->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  if (g_currentPartition != NO_PARTITION)
+    {
+      // Run() resets the stop time, a stop scheduled before relies
+      // on its global event only
+      StopAfter (GetCurrentPartition ()->currentTs + delay.GetTimeStep ());
+    }
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (g_currentPartition != NO_PARTITION || SystemThread::Equals (m_main),
+                 "Simulator::Schedule Thread-unsafe invocation!");
+
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+  Partition *partition = GetCurrentPartition ();
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+
+  Scheduler::EventKey key = Insert (partition, (uint64_t) tAbsolute.GetTimeStep (),
+                                    partition->currentContext, event);
+  return EventId (event, key.m_ts, key.m_context, key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  if (g_currentPartition == NO_PARTITION && !SystemThread::Equals (m_main))
+    {
+      EventWithContext ev;
+      ev.context = context;
+      // Current time added in MergeEvents()
+      ev.timestamp = delay.GetTimeStep ();
+      ev.event = event;
+      {
+        CriticalSection cs (m_eventsWithContextMutex);
+        m_eventsWithContext.push_back (ev);
+        m_eventsWithContextEmpty = false;
+      }
+      return;
+    }
+
+  Partition *partition = GetCurrentPartition ();
+  Partition *destination = m_partitions[GetPartitionIndex (context)];
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+  uint64_t ts = (uint64_t) tAbsolute.GetTimeStep ();
+
+  if (!m_concurrent || destination == partition)
+    {
+      Insert (destination, ts, context, event);
+      return;
+    }
+
+  NS_ABORT_MSG_IF (ts < m_windowEnd,
+                   "MultithreadedSimulatorImpl: event for context " << context
+                   << " scheduled with a delay of " << delay
+                   << ", lower than the lookahead " << TimeStep (m_lookAhead));
+  RemoteEvent ev;
+  ev.timestamp = ts;
+  ev.context = context;
+  ev.source = g_currentPartition;
+  ev.sequence = partition->sentCount;
+  ev.event = event;
+  partition->sentCount++;
+  {
+    CriticalSection cs (destination->remoteEventsMutex);
+    destination->remoteEvents.push_back (ev);
+  }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_ASSERT_MSG (SystemThread::Equals (m_main) && !m_concurrent,
+                 "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+  EventId id (Ptr<EventImpl> (event, false), GetCurrentPartition ()->currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  m_uid++;
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrentPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+  NS_ASSERT_MSG (!m_concurrent || partition == GetCurrentPartition (),
+                 "Simulator::Remove of an event of another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  const Partition *partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+  if (m_concurrent && partition != GetCurrentPartition ())
+    {
+      // the clock of the other partition moves concurrently, only the
+      // events before the window are known to be expired
+      NS_ABORT_MSG_IF (id.GetTs () >= m_windowStart,
+                       "MultithreadedSimulatorImpl: state of an event of context " << id.GetContext ()
+                       << " queried from context " << GetContext () << " during a parallel window");
+      return true;
+    }
+  if (id.GetTs () < partition->currentTs
+      || (id.GetTs () == partition->currentTs
+          && id.GetUid () <= partition->currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (MAX_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrentPartition ()->currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (void) const
+{
+  uint64_t count = 0;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      count += (*i)->eventCount;
+    }
+  return count;
+}
+
+} // namespace ns3
@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "nstime.h"
+
+#include "ptr.h"
+
+#include <atomic>
+#include <list>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief A shared-memory parallel simulator implementation.
+ *
+ * Events are partitioned by their execution context (normally the
+ * node id), and each partition owns its own Scheduler.  At the start
+ * of Run(), the nodes connected by the channels found under
+ * \c /ChannelList/, directly or through other nodes, are placed in the
+ * same partition, so that the packets, whose buffers, tags and
+ * reference counts are not thread-safe, never cross from one partition
+ * to another; the connected networks are spread over the partitions by
+ * decreasing number of nodes.  The events of the other contexts are
+ * handled by partition <tt>c % ThreadCount</tt>.  If all the nodes are
+ * connected the partitions are executed one event at a time by the main
+ * thread, as without lookahead.  Partitions are executed concurrently by a pool of
+ * SystemThread workers inside conservative time windows, in the
+ * same spirit as the granted time window algorithm of
+ * DistributedSimulatorImpl but without MPI: if \c t is the earliest
+ * pending event time across all partitions and \c L is the lookahead,
+ * every partition may safely process its events with a timestamp
+ * strictly lower than <tt>t + L</tt>.
+ *
+ * The lookahead is either set explicitly with the \c LookAhead
+ * attribute, or derived at the start of Run() as the smallest \c Delay
+ * attribute of all the channels found under \c /ChannelList/.  If a
+ * channel has no fixed \c Delay attribute (e.g. wireless channels,
+ * whose delay is given by a PropagationDelayModel) no safe lookahead
+ * exists and the partitions are executed one event at a time in
+ * timestamp order by the main thread.
+ *
+ * Events without a context (Simulator::NO_CONTEXT, typically scheduled
+ * by the main program) are kept in a global queue and are always
+ * executed by the main thread while the workers are paused; no window
+ * ever crosses the timestamp of a pending global event.
+ *
+ * Events sent from one partition to another during a window are
+ * buffered and merged into the destination Scheduler at the end of the
+ * window in (timestamp, source partition, source order) order, so the
+ * execution is deterministic and does not depend on thread timing.
+ * Within a context the events are executed in the same order as with
+ * DefaultSimulatorImpl; the only possible difference is the relative
+ * order of simultaneous events on one context that were scheduled from
+ * different partitions.
+ *
+ * Simulator::Stop() called by an event during a window stops all the
+ * partitions before their first event later than the time of the call,
+ * but the other partitions may already have executed some events up to
+ * one lookahead later.  A Simulator::Stop(delay) whose delay exceeds the
+ * lookahead is exact: no window crosses the stop time.  During a window,
+ * the state of the events of another partition is only known up to the
+ * start of the window: Simulator::IsExpired, Cancel and Remove abort if
+ * called on a later event of another partition.
+ *
+ * \warning Models executed with this implementation must not share
+ * unprotected mutable state between nodes placed in different
+ * partitions (e.g. a single FlowMonitor probing all the nodes).  The
+ * packet uids are unique, but their values depend on the thread timing.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
+
+  /**
+   * \return The lookahead used by the last call to Run().
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to a partition by another partition during a window. */
+  struct RemoteEvent
+  {
+    /** Absolute event timestamp. */
+    uint64_t timestamp;
+    /** The event context. */
+    uint32_t context;
+    /** Index of the sending partition. */
+    uint32_t source;
+    /** Sequence number of the event within the sending partition. */
+    uint64_t sequence;
+    /** The event implementation. */
+    EventImpl *event;
+    /**
+     * Order the remote events independently of thread timing.
+     * \param [in] other The event to compare to.
+     * \return \c true if this event must be inserted before \p other.
+     */
+    bool operator < (const RemoteEvent &other) const;
+  };
+  /** Container type for remote events. */
+  typedef std::vector<RemoteEvent> RemoteEvents;
+
+  /** The event queue and clock of one partition. */
+  struct Partition
+  {
+    /** The event priority queue. */
+    Ptr<Scheduler> events;
+    /** Events received from other partitions during the current window. */
+    RemoteEvents remoteEvents;
+    /** Mutex to control access to remoteEvents. */
+    SystemMutex remoteEventsMutex;
+    /** Next event unique id. */
+    uint32_t uid;
+    /** Unique id of the current event. */
+    uint32_t currentUid;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** The event count. */
+    uint64_t eventCount;
+    /** Number of events sent to other partitions, used to order them. */
+    uint64_t sentCount;
+    /** Number of inserted but not yet executed events. */
+    int unscheduledEvents;
+    /** Flag set when Simulator::Stop is called from this partition. */
+    bool stop;
+  };
+
+  /** Wrap an event with its execution context, sent by a foreign thread. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp, relative to the time it is merged. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /** Container type for the events from a foreign thread. */
+  typedef std::list<struct EventWithContext> EventsWithContext;
+
+  /** Create the partitions, once the attributes are known. */
+  void CreatePartitions (void);
+  /**
+   * Place the connected nodes in the same partition, and move the
+   * pending events to the partition of their context.
+   * \return \c false if all the nodes are in a single partition.
+   */
+  bool AssignPartitions (void);
+  /**
+   * Stop the partitions before their first event after some time.
+   * \param [in] ts The absolute timestamp.
+   */
+  void StopAfter (uint64_t ts);
+  /**
+   * Find the partition in charge of a context.
+   * \param [in] context The execution context.
+   * \return The partition index.
+   */
+  uint32_t GetPartitionIndex (uint32_t context) const;
+  /** \return The partition of the calling thread. */
+  Partition * GetCurrentPartition (void) const;
+  /**
+   * Insert an event in a partition.
+   * \param [in] partition The destination partition.
+   * \param [in] ts The absolute timestamp.
+   * \param [in] context The event context.
+   * \param [in] event The event.
+   * \return The scheduler key of the new event.
+   */
+  Scheduler::EventKey Insert (Partition *partition, uint64_t ts,
+                              uint32_t context, EventImpl *event);
+  /** Compute m_lookAhead from the attribute or the channel delays. */
+  void CalculateLookAhead (void);
+  /**
+   * Get the key of the earliest event of a partition.
+   * \param [in] partition The partition.
+   * \return The key, with the maximum simulation time if empty.
+   */
+  Scheduler::EventKey Next (const Partition *partition) const;
+  /**
+   * Execute the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /**
+   * Execute the events of a partition up to the end of the current window.
+   * \param [in] index The partition index.
+   */
+  void ProcessWindow (uint32_t index);
+  /** Move remote and foreign events into the partitions' queues. */
+  void MergeEvents (void);
+  /**
+   * Body of the worker threads.
+   * \param [in] index The partition index served by the worker.
+   */
+  void WorkerLoop (uint32_t index);
+  /**
+   * Entry point of the worker threads.
+   * \param [in] worker The simulator and the partition index of the worker.
+   */
+  static void WorkerEntry (std::pair<MultithreadedSimulatorImpl *, uint32_t> worker);
+  /** \return \c true if all the queues are empty. */
+  bool IsEmpty (void) const;
+
+  /** Number of partitions, set by the ThreadCount attribute. */
+  uint32_t m_threadCount;
+  /** The partitions; the last one holds the global events. */
+  std::vector<Partition *> m_partitions;
+  /** The scheduler factory, used to create the partition queues. */
+  ObjectFactory m_schedulerFactory;
+  /** The lookahead set by the user, zero to derive it from the channels. */
+  Time m_userLookAhead;
+  /** The lookahead used by Run(). */
+  uint64_t m_lookAhead;
+  /** Next event unique id, shared by all partitions outside of windows. */
+  uint32_t m_uid;
+  /** Partition of each node, by node id, set by AssignPartitions(). */
+  std::vector<uint32_t> m_nodePartitions;
+  /** Start of the current window. */
+  uint64_t m_windowStart;
+  /** Exclusive end of the current window. */
+  uint64_t m_windowEnd;
+  /** No event later than this timestamp is executed by Run(). */
+  std::atomic<uint64_t> m_stopTs;
+  /** Flag \c true while worker threads execute a window. */
+  bool m_concurrent;
+
+  /** The worker threads. */
+  std::vector<Ptr<SystemThread> > m_workers;
+  /** Opaque synchronization state shared with the workers. */
+  struct Barrier;
+  /** The window barrier. */
+  Barrier *m_barrier;
+
+  /** The container of events from foreign threads. */
+  EventsWithContext m_eventsWithContext;
+  /**
+   * Flag \c true if all events with context have been moved to the
+   * partition queues.
+   */
+  bool m_eventsWithContextEmpty;
+  /** Mutex to control access to the list of events with context. */
+  SystemMutex m_eventsWithContextMutex;
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Flag calling for the end of the simulation. */
+  bool m_stop;
+
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
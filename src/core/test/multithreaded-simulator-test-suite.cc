@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+#define CONTEXTS 8
+
+/**
+ * Exchange tokens between contexts, with a mix of local and remote
+ * events, and check that MultithreadedSimulatorImpl executes exactly
+ * the same events as DefaultSimulatorImpl.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase (uint32_t threads, Time lookAhead);
+
+  /** Trace of one context: (timestamp, token) pairs. */
+  typedef std::vector<std::pair<int64_t, uint32_t> > Trace;
+
+  /**
+   * Handle a token.
+   * \param context The expected context.
+   * \param token The token value.
+   */
+  void Token (uint32_t context, uint32_t token);
+  /**
+   * Run the scenario.
+   * \param simulatorType The simulator implementation.
+   * \param traces Output traces.
+   * \return The number of executed events.
+   */
+  uint64_t RunOne (const std::string &simulatorType, Trace *traces);
+
+  uint32_t m_threads;
+  Time m_lookAhead;
+  Trace *m_traces;
+  bool m_badContext;
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase (uint32_t threads, Time lookAhead)
+  : TestCase ("Check multithreaded simulator with " + std::to_string (threads) +
+              " threads and a lookahead of " + std::to_string (lookAhead.GetMicroSeconds ()) + "us"),
+    m_threads (threads),
+    m_lookAhead (lookAhead),
+    m_traces (0),
+    m_badContext (false)
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Token (uint32_t context, uint32_t token)
+{
+  if (Simulator::GetContext () != context)
+    {
+      m_badContext = true;
+    }
+  m_traces[context].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), token));
+  uint32_t next = token * 1103515245 + 12345;
+  uint32_t r = next >> 16;
+  if (r % 3 == 0)
+    {
+      uint32_t remote = (context + 1 + r % 5) % CONTEXTS;
+      Simulator::ScheduleWithContext (remote, MilliSeconds (1) + MicroSeconds (r % 100),
+                                      &MultithreadedSimulatorTestCase::Token, this, remote, next);
+    }
+  else
+    {
+      Simulator::Schedule (MicroSeconds (r % 500),
+                           &MultithreadedSimulatorTestCase::Token, this, context, next);
+    }
+}
+
+uint64_t
+MultithreadedSimulatorTestCase::RunOne (const std::string &simulatorType, Trace *traces)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  m_traces = traces;
+  for (uint32_t i = 0; i < 2 * CONTEXTS; ++i)
+    {
+      Simulator::ScheduleWithContext (i % CONTEXTS, MicroSeconds (i),
+                                      &MultithreadedSimulatorTestCase::Token, this, i % CONTEXTS, i);
+    }
+  Simulator::Stop (MilliSeconds (200));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MilliSeconds (200), "Bad stop time with " << simulatorType);
+  uint64_t count = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  // simultaneous events scheduled from different partitions may be
+  // executed in a different order
+  for (uint32_t i = 0; i < CONTEXTS; ++i)
+    {
+      std::sort (traces[i].begin (), traces[i].end ());
+    }
+  return count;
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  Trace expected[CONTEXTS];
+  Trace traces[CONTEXTS];
+
+  uint64_t expectedCount = RunOne ("ns3::DefaultSimulatorImpl", expected);
+
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (m_lookAhead));
+  uint64_t count = RunOne ("ns3::MultithreadedSimulatorImpl", traces);
+
+  NS_TEST_EXPECT_MSG_EQ (m_badContext, false, "Event executed in the wrong context");
+  NS_TEST_EXPECT_MSG_EQ (count, expectedCount, "Different number of events");
+  for (uint32_t i = 0; i < CONTEXTS; ++i)
+    {
+      NS_TEST_EXPECT_MSG_GT (expected[i].size (), 0, "Context " << i << " idle");
+      NS_TEST_EXPECT_MSG_EQ ((traces[i] == expected[i]), true, "Different events in context " << i);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (Seconds (0)));
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    // a null lookahead runs all the partitions on the main thread
+    AddTestCase (new MultithreadedSimulatorTestCase (3, Seconds (0)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (1, MilliSeconds (1)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (2, MilliSeconds (1)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (4, MicroSeconds (500)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (CONTEXTS, MilliSeconds (1)), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
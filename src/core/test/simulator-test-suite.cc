@@ -23,6 +23,9 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -461,6 +464,88 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerStressTestCase : public TestCase
+{
+public:
+  SchedulerStressTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint32_t Random (void);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_random;
+};
+
+SchedulerStressTestCase::SchedulerStressTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that a bursty event set is ordered as with MapScheduler with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_random (1)
+{
+}
+
+uint32_t
+SchedulerStressTestCase::Random (void)
+{
+  m_random = m_random * 1103515245 + 12345;
+  return m_random >> 8;
+}
+
+void
+SchedulerStressTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 4;
+
+  for (uint32_t i = 0; i < 50000; i++)
+    {
+      uint32_t r = Random () % 16;
+      if (r < 9 || reference->IsEmpty ())
+        {
+          // mix of simultaneous events, short and very long delays
+          Scheduler::Event ev;
+          uint32_t kind = Random () % 4;
+          uint64_t delay = kind == 0 ? 0 : kind == 1 ? Random () % 10 : kind == 2 ? Random () % 100000 : Random ();
+          ev.key.m_ts = now + delay;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          // never dereferenced by the schedulers
+          ev.impl = reinterpret_cast<EventImpl *> (static_cast<uintptr_t> (ev.key.m_uid) << 4);
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      else if (r < 15)
+        {
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.key.m_uid, "Bad PeekNext at step " << i);
+          Scheduler::Event next = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.key.m_uid, "Bad RemoveNext at step " << i);
+          now = next.key.m_ts;
+        }
+      else
+        {
+          // remove a random pending event, if it was not already dequeued
+          uint32_t index = Random () % pending.size ();
+          Scheduler::Event ev = pending[index];
+          pending[index] = pending.back ();
+          pending.pop_back ();
+          if (ev.key.m_ts > now)
+            {
+              scheduler->Remove (ev);
+              reference->Remove (ev);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), reference->IsEmpty (), "Bad IsEmpty at step " << i);
+    }
+  while (!reference->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, reference->RemoveNext ().key.m_uid, "Bad final RemoveNext");
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "Events left in the scheduler");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -477,5 +562,14 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerStressTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerStressTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerStressTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -30,6 +30,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/tso-tag.h"
 #include "csma-net-device.h"
 #include "csma-channel.h"
 
@@ -72,6 +73,12 @@ CsmaNetDevice::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&CsmaNetDevice::m_receiveEnable),
                    MakeBooleanChecker ())
+    .AddAttribute ("SegmentationOffload",
+                   "Whether the device accepts TCP super-segments larger than its MTU "
+                   "and transmits them as bursts of frames (see ns3::TsoTag)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CsmaNetDevice::m_segmentationOffload),
+                   MakeBooleanChecker ())
     .AddAttribute ("ReceiveErrorModel", 
                    "The receiver error model used to simulate packet loss",
                    PointerValue (),
@@ -374,7 +381,9 @@ CsmaNetDevice::AddHeader (Ptr<Packet> p,   Mac48Address source,  Mac48Address de
             p->AddAtEnd (padd);
           }
 
-        NS_ASSERT_MSG (p->GetSize () <= GetMtu (),
+        TsoTag tsoTag;
+        NS_ASSERT_MSG (p->GetSize () <= GetMtu ()
+                       || (m_segmentationOffload && p->PeekPacketTag (tsoTag)),
                        "CsmaNetDevice::AddHeader(): 802.3 Length/Type field with LLC/SNAP: "
                        "length interpretation must not exceed device frame size minus overhead");
       }
@@ -523,6 +532,17 @@ CsmaNetDevice::TransmitStart (void)
           m_txMachineState = BUSY;
 
           Time tEvent = m_bps.CalculateBytesTxTime (m_currentPkt->GetSize ());
+          TsoTag tsoTag;
+          if (m_segmentationOffload && m_currentPkt->PeekPacketTag (tsoTag))
+            {
+              //
+              // The frames of the super-segment are sent as a burst,
+              // separated by the interframe gap, and the channel stays
+              // busy until the end of the last one.
+              //
+              tEvent = m_bps.CalculateBytesTxTime (tsoTag.GetWireSize (m_currentPkt->GetSize ()))
+                + m_tInterframeGap * (tsoTag.GetSegments () - 1);
+            }
           NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << tEvent.GetSeconds () << "sec");
           Simulator::Schedule (tEvent, &CsmaNetDevice::TransmitCompleteEvent, this);
         }
@@ -1048,6 +1068,16 @@ CsmaNetDevice::SupportsSendFrom () const
   return true;
 }
 
+bool
+CsmaNetDevice::SupportsSegmentationOffload (uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << size);
+  // Only a queue limited in bytes counts the super-segment as its segments
+  QueueSize maxSize = m_queue->GetMaxSize ();
+  return m_segmentationOffload && maxSize.GetUnit () == QueueSizeUnit::BYTES
+         && m_queue->GetNBytes () + size <= maxSize.GetValue ();
+}
+
 int64_t
 CsmaNetDevice::AssignStreams (int64_t stream)
 {
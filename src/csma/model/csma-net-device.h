@@ -326,6 +326,7 @@ public:
 
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
+  virtual bool SupportsSegmentationOffload (uint32_t size) const;
 
  /**
   * Assign a fixed random variable stream number to the random variables
@@ -464,6 +465,12 @@ private:
    */
   bool m_receiveEnable;
 
+  /**
+   * Transmit the TCP super-segments as bursts of frames (see TsoTag).
+   * False by default
+   */
+  bool m_segmentationOffload;
+
   /**
    * Enumeration of the states of the transmit machine of the net device.
    */
@@ -0,0 +1,180 @@
+from __future__ import division, print_function
+import sys
+import argparse
+
+## @file flowmon-parse-stream.py
+#  Reads the statistics written by FlowMonitor::EnableStreaming, and prints
+#  the statistics of each flow, as flowmon-parse-results.py does for the
+#  XML output.  The statistics can be read while the simulation is still
+#  running, or up to a given time.
+
+## Flow
+class Flow(object):
+    ## class variables
+    ## @var flowId
+    #  flow ID
+    ## @var txBytes
+    #  bytes sent
+    ## @var rxBytes
+    #  bytes received
+    ## @var txPackets
+    #  packets sent
+    ## @var rxPackets
+    #  packets received
+    ## @var lostPackets
+    #  packets lost
+    ## @var timesForwarded
+    #  number of forwardings
+    ## @var delaySum
+    #  sum of the delays, in nanoseconds
+    ## @var jitterSum
+    #  sum of the jitters, in nanoseconds
+    ## @var lastDelay
+    #  last delay, in nanoseconds
+    ## @var timeFirstTxPacket
+    #  time of the first packet sent, in nanoseconds
+    ## @var timeLastTxPacket
+    #  time of the last packet sent, in nanoseconds
+    ## @var timeFirstRxPacket
+    #  time of the first packet received, in nanoseconds
+    ## @var timeLastRxPacket
+    #  time of the last packet received, in nanoseconds
+    ## @var packetsDropped
+    #  packets dropped, by reason code
+    ## @var bytesDropped
+    #  bytes dropped, by reason code
+    ## @var histograms
+    #  histograms, by name: (bin width, count) by bin
+    ## @var __slots__
+    #  class variable list
+    __slots__ = ['flowId', 'txBytes', 'rxBytes', 'txPackets', 'rxPackets', 'lostPackets',
+                 'timesForwarded', 'delaySum', 'jitterSum', 'lastDelay',
+                 'timeFirstTxPacket', 'timeLastTxPacket', 'timeFirstRxPacket', 'timeLastRxPacket',
+                 'packetsDropped', 'bytesDropped', 'histograms']
+    ## the counters and sums, which are written as changes
+    counters = ['txBytes', 'rxBytes', 'txPackets', 'rxPackets', 'lostPackets',
+                'timesForwarded', 'delaySum', 'jitterSum']
+    ## the values which are written as they are
+    values = ['lastDelay', 'timeFirstTxPacket', 'timeLastTxPacket', 'timeFirstRxPacket', 'timeLastRxPacket']
+
+    def __init__(self, flowId):
+        '''The initializer.
+        @param self The object pointer.
+        @param flowId The flow ID.
+        '''
+        self.flowId = flowId
+        for name in Flow.counters + Flow.values:
+            setattr(self, name, 0)
+        self.packetsDropped = {}
+        self.bytesDropped = {}
+        self.histograms = {}
+
+    def add(self, fields):
+        '''Add the changes of a F line.
+        @param self The object pointer.
+        @param fields The fields of the line following the flow ID.
+        '''
+        for name, field in zip(Flow.counters, fields):
+            setattr(self, name, getattr(self, name) + int(field))
+        for name, field in zip(Flow.values, fields[len(Flow.counters):]):
+            setattr(self, name, int(field))
+
+    def add_drops(self, reasonCode, packets, nbytes):
+        '''Add the changes of a D line.
+        @param self The object pointer.
+        @param reasonCode The drop reason code.
+        @param packets The packets dropped.
+        @param nbytes The bytes dropped.
+        '''
+        self.packetsDropped[reasonCode] = self.packetsDropped.get(reasonCode, 0) + packets
+        self.bytesDropped[reasonCode] = self.bytesDropped.get(reasonCode, 0) + nbytes
+
+    def add_bin(self, name, index, width, count):
+        '''Add the changes of a H line.
+        @param self The object pointer.
+        @param name The histogram name.
+        @param index The bin index.
+        @param width The bin width.
+        @param count The change of the bin count.
+        '''
+        bins = self.histograms.setdefault(name, {})
+        bins[index] = (width, bins.get(index, (width, 0))[1] + count)
+
+
+def parse(stream, until=None):
+    '''Read the statistics of the flows.
+    @param stream The input file.
+    @param until The time, in seconds, of the last write to read, or None.
+    @return The flows, by flow ID.
+    '''
+    flows = {}
+    for line in stream:
+        if not line.endswith('\n'):
+            # incomplete last line of a simulation still running
+            break
+        if line.startswith('#') or not line.strip():
+            continue
+        fields = line.rstrip('\n').split(',')
+        if until is not None and int(fields[1]) > until * 1e9:
+            break
+        flowId = int(fields[2])
+        flow = flows.get(flowId)
+        if flow is None:
+            flow = flows[flowId] = Flow(flowId)
+        if fields[0] == 'F' and len(fields) == 16:
+            flow.add(fields[3:])
+        elif fields[0] == 'D' and len(fields) == 6:
+            flow.add_drops(int(fields[3]), int(fields[4]), int(fields[5]))
+        elif fields[0] == 'H' and len(fields) == 7:
+            flow.add_bin(fields[3], int(fields[4]), float(fields[5]), int(fields[6]))
+        else:
+            raise ValueError("invalid line: " + line)
+    return flows
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Print the flow statistics streamed by the FlowMonitor")
+    parser.add_argument("file", help="the file written by FlowMonitor::EnableStreaming")
+    parser.add_argument("--until", type=float, default=None,
+                        help="only read the statistics written up to this time, in seconds")
+    parser.add_argument("--histograms", action="store_true", help="print the histograms")
+    args = parser.parse_args(argv[1:])
+
+    with open(args.file) as stream:
+        flows = parse(stream, args.until)
+
+    for flowId in sorted(flows):
+        flow = flows[flowId]
+        print("FlowID: %i" % flowId)
+        if flow.timeLastTxPacket > flow.timeFirstTxPacket:
+            print("\tTX bitrate: %.2f kbit/s" % (flow.txBytes * 8 * 1e9
+                                                 / (flow.timeLastTxPacket - flow.timeFirstTxPacket) / 1e3))
+        else:
+            print("\tTX bitrate: None")
+        if flow.timeLastRxPacket > flow.timeFirstRxPacket:
+            print("\tRX bitrate: %.2f kbit/s" % (flow.rxBytes * 8 * 1e9
+                                                 / (flow.timeLastRxPacket - flow.timeFirstRxPacket) / 1e3))
+        else:
+            print("\tRX bitrate: None")
+        if flow.rxPackets > 0:
+            print("\tMean Delay: %.2f ms" % (flow.delaySum / flow.rxPackets / 1e6))
+        else:
+            print("\tMean Delay: None")
+        if flow.txPackets > 0:
+            print("\tPacket Loss Ratio: %.2f %%" % (flow.lostPackets / flow.txPackets * 100))
+        else:
+            print("\tPacket Loss Ratio: None")
+        for reasonCode in sorted(flow.packetsDropped):
+            print("\tDropped (reason %i): %i packets, %i bytes"
+                  % (reasonCode, flow.packetsDropped[reasonCode], flow.bytesDropped[reasonCode]))
+        if args.histograms:
+            for name in sorted(flow.histograms):
+                print("\t%s:" % name)
+                bins = flow.histograms[name]
+                for index in sorted(bins):
+                    width, count = bins[index]
+                    print("\t\t[%g, %g): %i" % (index * width, (index + 1) * width, count))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
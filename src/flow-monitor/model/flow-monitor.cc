@@ -22,6 +22,9 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/abort.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -69,6 +72,12 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of packets in transit tracked at the same time "
+                                         "(0 for no limit).  When the limit is reached, the packet seen the "
+                                         "longest time ago is considered lost."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -80,7 +89,9 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_maxTrackedPackets (0),
+    m_streamHistograms (false),
+    m_enabled (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -91,6 +102,12 @@ FlowMonitor::DoDispose (void)
   NS_LOG_FUNCTION (this);
   Simulator::Cancel (m_startEvent);
   Simulator::Cancel (m_stopEvent);
+  Simulator::Cancel (m_streamEvent);
+  if (m_stream.is_open ())
+    {
+      FlushStream ();
+      m_stream.close ();
+    }
   for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
       iter != m_classifiers.end ();
       iter ++)
@@ -146,10 +163,7 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
+  AddTrackedPacket (flowId, packetId);
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
@@ -163,6 +177,7 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       stats.timeFirstTxPacket = now;
     }
   stats.timeLastTxPacket = now;
+  NotifyFlowChanged (flowId);
 }
 
 
@@ -175,19 +190,19 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
       NS_LOG_DEBUG ("FlowMonitor not enabled; returning");
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  uint32_t index = FindTrackedPacket (flowId, packetId);
+  if (index == m_trackedPool.size ())
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  TrackedPacket &tracked = m_trackedPool[index];
+  tracked.timesForwarded++;
+  TouchTrackedPacket (index);
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -201,8 +216,8 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
       NS_LOG_DEBUG ("FlowMonitor not enabled; returning");
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  uint32_t index = FindTrackedPacket (flowId, packetId);
+  if (index == m_trackedPool.size ())
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
@@ -210,7 +225,7 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - m_trackedPool[index].firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -249,12 +264,13 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += m_trackedPool[index].timesForwarded;
+  NotifyFlowChanged (flowId);
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (index); // we don't need to track this packet anymore
 }
 
 void
@@ -280,16 +296,126 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   ++stats.packetsDropped[reasonCode];
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
+  NotifyFlowChanged (flowId);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  uint32_t index = FindTrackedPacket (flowId, packetId);
+  if (index != m_trackedPool.size ())
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (index);
+    }
+}
+
+FlowMonitor::TrackedPacket&
+FlowMonitor::AddTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  uint32_t index = FindTrackedPacket (flowId, packetId);
+  if (index == m_trackedPool.size ())
+    {
+      if (m_maxTrackedPackets != 0 && m_trackedPackets.size () >= m_maxTrackedPackets)
+        {
+          // make room by giving up the packet seen the longest time ago
+          while (m_trackedPool[m_expiryQueue.front ().second].lastSeenTime != m_expiryQueue.front ().first)
+            {
+              m_expiryQueue.pop_front ();
+            }
+          NS_LOG_DEBUG ("Too many tracked packets, considering packet (flowId="
+                        << m_trackedPool[m_expiryQueue.front ().second].flowId << ", packetId="
+                        << m_trackedPool[m_expiryQueue.front ().second].packetId << ") lost.");
+          LoseTrackedPacket (m_expiryQueue.front ().second);
+          m_expiryQueue.pop_front ();
+        }
+      if (m_freeTracked.empty ())
+        {
+          index = m_trackedPool.size ();
+          m_trackedPool.push_back (TrackedPacket ());
+          m_trackedPool[index].lastSeenTime = Time::Max ();
+        }
+      else
+        {
+          index = m_freeTracked.back ();
+          m_freeTracked.pop_back ();
+        }
+      m_trackedPackets[GetTrackedPacketKey (flowId, packetId)] = index;
+    }
+  TrackedPacket &tracked = m_trackedPool[index];
+  tracked.firstSeenTime = Simulator::Now ();
+  tracked.timesForwarded = 0;
+  tracked.flowId = flowId;
+  tracked.packetId = packetId;
+  TouchTrackedPacket (index);
+  return tracked;
+}
+
+uint32_t
+FlowMonitor::FindTrackedPacket (FlowId flowId, FlowPacketId packetId) const
+{
+  TrackedPacketMap::const_iterator iter = m_trackedPackets.find (GetTrackedPacketKey (flowId, packetId));
+  if (iter == m_trackedPackets.end ())
+    {
+      return m_trackedPool.size ();
+    }
+  return iter->second;
+}
+
+void
+FlowMonitor::TouchTrackedPacket (uint32_t index)
+{
+  Time now = Simulator::Now ();
+  if (m_trackedPool[index].lastSeenTime == now)
+    {
+      // already queued
+      return;
     }
+  m_trackedPool[index].lastSeenTime = now;
+  // the previous entry of the packet, if any, is now stale
+  m_expiryQueue.push_back (ExpiryEntry (now, index));
+  CompactExpiryQueue ();
+}
+
+void
+FlowMonitor::RemoveTrackedPacket (uint32_t index)
+{
+  TrackedPacket &tracked = m_trackedPool[index];
+  m_trackedPackets.erase (GetTrackedPacketKey (tracked.flowId, tracked.packetId));
+  // no entry of the expiry queue matches a free packet
+  tracked.lastSeenTime = Time::Max ();
+  m_freeTracked.push_back (index);
+}
+
+void
+FlowMonitor::LoseTrackedPacket (uint32_t index)
+{
+  FlowStatsContainerI flow = m_flowStats.find (m_trackedPool[index].flowId);
+  NS_ASSERT (flow != m_flowStats.end ());
+  flow->second.lostPackets++;
+  NotifyFlowChanged (flow->first);
+
+  // we won't track it anymore
+  RemoveTrackedPacket (index);
+}
+
+void
+FlowMonitor::CompactExpiryQueue ()
+{
+  if (m_expiryQueue.size () < 2 * m_trackedPackets.size () + 1024)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Compacting the expiry queue: " << m_expiryQueue.size () << " entries for "
+                << m_trackedPackets.size () << " tracked packets");
+  std::deque<ExpiryEntry>::iterator last = m_expiryQueue.begin ();
+  for (std::deque<ExpiryEntry>::iterator iter = m_expiryQueue.begin (); iter != m_expiryQueue.end (); ++iter)
+    {
+      if (m_trackedPool[iter->second].lastSeenTime == iter->first)
+        {
+          *last++ = *iter;
+        }
+    }
+  m_expiryQueue.erase (last, m_expiryQueue.end ());
 }
 
 const FlowMonitor::FlowStatsContainer&
@@ -305,22 +431,16 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
   NS_LOG_FUNCTION (this << maxDelay.GetSeconds ());
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // the packets are queued when they are seen, hence in increasing order
+  // of their last seen time: only the expired ones are visited
+  while (!m_expiryQueue.empty () && now - m_expiryQueue.front ().first >= maxDelay)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      ExpiryEntry entry = m_expiryQueue.front ();
+      m_expiryQueue.pop_front ();
+      if (m_trackedPool[entry.second].lastSeenTime == entry.first)
         {
           // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
+          LoseTrackedPacket (entry.second);
         }
     }
 }
@@ -407,6 +527,7 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  FlushStream ();
 }
 
 void
@@ -520,6 +641,146 @@ FlowMonitor::SerializeToXmlFile (std::string fileName, bool enableHistograms, bo
   os.close ();
 }
 
+void
+FlowMonitor::EnableStreaming (std::string fileName, Time interval, bool enableHistograms)
+{
+  NS_LOG_FUNCTION (this << fileName << interval.GetSeconds () << enableHistograms);
+  NS_ABORT_MSG_UNLESS (interval.IsStrictlyPositive (), "The interval between two writes must be positive");
+  if (m_stream.is_open ())
+    {
+      FlushStream ();
+      m_stream.close ();
+    }
+  m_stream.open (fileName.c_str (), std::ios::out|std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_stream.is_open (), "Could not open " << fileName);
+  m_streamInterval = interval;
+  m_streamHistograms = enableHistograms;
+  m_streamedStats.clear ();
+  m_changedFlows.clear ();
+
+  m_stream << "# FlowMonitor statistics, times in nanoseconds; the counters and sums are the changes\n"
+           << "# since the previous line of the same flow\n"
+           << "# F,time,flowId,txBytes,rxBytes,txPackets,rxPackets,lostPackets,timesForwarded,"
+           << "delaySum,jitterSum,lastDelay,timeFirstTxPacket,timeLastTxPacket,timeFirstRxPacket,timeLastRxPacket\n"
+           << "# D,time,flowId,reasonCode,packetsDropped,bytesDropped\n";
+  if (m_streamHistograms)
+    {
+      m_stream << "# H,time,flowId,histogram,bin,binWidth,count\n";
+    }
+  m_stream.flush ();
+
+  // the flows seen before are written at the next write
+  for (FlowStatsContainerCI flowI = m_flowStats.begin (); flowI != m_flowStats.end (); flowI++)
+    {
+      NotifyFlowChanged (flowI->first);
+    }
+  Simulator::Cancel (m_streamEvent);
+  m_streamEvent = Simulator::Schedule (m_streamInterval, &FlowMonitor::PeriodicFlushStream, this);
+}
+
+void
+FlowMonitor::FlushStream ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_stream.is_open ())
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Writing " << m_changedFlows.size () << " flows");
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  std::sort (m_changedFlows.begin (), m_changedFlows.end ());
+  for (std::vector<FlowId>::const_iterator iter = m_changedFlows.begin (); iter != m_changedFlows.end (); iter++)
+    {
+      FlowStats &stats = m_flowStats.find (*iter)->second;
+      StreamedStats &streamed = m_streamedStats[*iter];
+      m_stream << "F," << now << "," << *iter
+               << "," << stats.txBytes - streamed.txBytes
+               << "," << stats.rxBytes - streamed.rxBytes
+               << "," << stats.txPackets - streamed.txPackets
+               << "," << stats.rxPackets - streamed.rxPackets
+               << "," << stats.lostPackets - streamed.lostPackets
+               << "," << stats.timesForwarded - streamed.timesForwarded
+               << "," << (stats.delaySum - streamed.delaySum).GetNanoSeconds ()
+               << "," << (stats.jitterSum - streamed.jitterSum).GetNanoSeconds ()
+               << "," << stats.lastDelay.GetNanoSeconds ()
+               << "," << stats.timeFirstTxPacket.GetNanoSeconds ()
+               << "," << stats.timeLastTxPacket.GetNanoSeconds ()
+               << "," << stats.timeFirstRxPacket.GetNanoSeconds ()
+               << "," << stats.timeLastRxPacket.GetNanoSeconds ()
+               << "\n";
+      streamed.txBytes = stats.txBytes;
+      streamed.rxBytes = stats.rxBytes;
+      streamed.txPackets = stats.txPackets;
+      streamed.rxPackets = stats.rxPackets;
+      streamed.lostPackets = stats.lostPackets;
+      streamed.timesForwarded = stats.timesForwarded;
+      streamed.delaySum = stats.delaySum;
+      streamed.jitterSum = stats.jitterSum;
+
+      streamed.packetsDropped.resize (stats.packetsDropped.size (), 0);
+      streamed.bytesDropped.resize (stats.bytesDropped.size (), 0);
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          if (stats.packetsDropped[reasonCode] != streamed.packetsDropped[reasonCode])
+            {
+              m_stream << "D," << now << "," << *iter << "," << reasonCode
+                       << "," << stats.packetsDropped[reasonCode] - streamed.packetsDropped[reasonCode]
+                       << "," << stats.bytesDropped[reasonCode] - streamed.bytesDropped[reasonCode]
+                       << "\n";
+              streamed.packetsDropped[reasonCode] = stats.packetsDropped[reasonCode];
+              streamed.bytesDropped[reasonCode] = stats.bytesDropped[reasonCode];
+            }
+        }
+
+      if (m_streamHistograms)
+        {
+          Histogram *histograms[4] = { &stats.delayHistogram, &stats.jitterHistogram,
+                                       &stats.packetSizeHistogram, &stats.flowInterruptionsHistogram };
+          const char *names[4] = { "delayHistogram", "jitterHistogram",
+                                   "packetSizeHistogram", "flowInterruptionsHistogram" };
+          for (uint32_t h = 0; h < 4; h++)
+            {
+              std::vector<uint32_t> &binCounts = streamed.binCounts[h];
+              binCounts.resize (histograms[h]->GetNBins (), 0);
+              for (uint32_t bin = 0; bin < binCounts.size (); bin++)
+                {
+                  uint32_t count = histograms[h]->GetBinCount (bin);
+                  if (count != binCounts[bin])
+                    {
+                      m_stream << "H," << now << "," << *iter << "," << names[h] << "," << bin
+                               << "," << histograms[h]->GetBinWidth (bin) << "," << count - binCounts[bin] << "\n";
+                      binCounts[bin] = count;
+                    }
+                }
+            }
+        }
+      streamed.changed = false;
+    }
+  m_changedFlows.clear ();
+  m_stream.flush ();
+}
+
+void
+FlowMonitor::NotifyFlowChanged (FlowId flowId)
+{
+  if (!m_stream.is_open ())
+    {
+      return;
+    }
+  StreamedStats &streamed = m_streamedStats[flowId];
+  if (!streamed.changed)
+    {
+      streamed.changed = true;
+      m_changedFlows.push_back (flowId);
+    }
+}
+
+void
+FlowMonitor::PeriodicFlushStream ()
+{
+  FlushStream ();
+  m_streamEvent = Simulator::Schedule (m_streamInterval, &FlowMonitor::PeriodicFlushStream, this);
+}
 
 } // namespace ns3
 
@@ -23,6 +23,9 @@
 
 #include <vector>
 #include <map>
+#include <deque>
+#include <fstream>
+#include <unordered_map>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -258,6 +261,27 @@ public:
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /// Writes the changes of the flow statistics to a file during the
+  /// simulation, every \p interval and when the monitoring stops.
+  ///
+  /// The file is in CSV format, with one line per flow which changed
+  /// since the previous write (the counters and sums being the
+  /// changes since the previous write, and the times being absolute,
+  /// in nanoseconds), one line per drop reason code and, optionally,
+  /// one line per histogram bin which changed.  The header of the file
+  /// describes the columns.  The stream is flushed after each write, so
+  /// that the results up to the last write are available even if the
+  /// simulation does not complete.  The flowmon-parse-stream.py script
+  /// sums the changes to get the statistics of each flow.
+  ///
+  /// \param fileName name or path of the output file that will be created
+  /// \param interval time between two writes
+  /// \param enableHistograms if true, include also the histograms in the output
+  void EnableStreaming (std::string fileName, Time interval, bool enableHistograms);
+
+  /// Writes right now the changes of the flow statistics since the
+  /// previous write, if EnableStreaming was called
+  void FlushStream ();
 
 protected:
 
@@ -272,14 +296,94 @@ private:
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    FlowId flowId; //!< flow identification
+    FlowPacketId packetId; //!< packet identification in the flow
   };
 
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+  /**
+   * \param flowId flow identification
+   * \param packetId packet identification in the flow
+   * \returns the key of the tracked packet
+   */
+  static uint64_t GetTrackedPacketKey (FlowId flowId, FlowPacketId packetId)
+  {
+    return (static_cast<uint64_t> (flowId) << 32) | packetId;
+  }
+
+  /// Hash function of the keys of the tracked packets
+  struct TrackedPacketHash
+  {
+    /**
+     * \param key the key of a tracked packet
+     * \returns the hash of the key
+     */
+    std::size_t operator() (uint64_t key) const
+    {
+      key *= 0x9e3779b97f4a7c15ULL;
+      return static_cast<std::size_t> (key ^ (key >> 32));
+    }
+  };
+
+  /// (FlowId,PacketId) --> index of the TrackedPacket in m_trackedPool
+  typedef std::unordered_map<uint64_t, uint32_t, TrackedPacketHash> TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  std::vector<TrackedPacket> m_trackedPool; //!< Storage of the tracked packets
+  std::vector<uint32_t> m_freeTracked; //!< Unused entries of m_trackedPool
+
+  /**
+   * The last time a packet was seen, and the index of the packet in
+   * m_trackedPool.  An entry is stale if the packet has been seen
+   * again, or is no longer tracked.
+   */
+  typedef std::pair<Time, uint32_t> ExpiryEntry;
+  /// The times when the tracked packets were seen, in increasing order
+  std::deque<ExpiryEntry> m_expiryQueue;
+  uint32_t m_maxTrackedPackets; //!< Maximum number of tracked packets
+
+  /// The statistics of a flow, as of the last write to the stream
+  struct StreamedStats
+  {
+    StreamedStats ()
+      : txBytes (0),
+        rxBytes (0),
+        txPackets (0),
+        rxPackets (0),
+        lostPackets (0),
+        timesForwarded (0),
+        changed (false)
+    {
+    }
+    Time delaySum;                        //!< Sum of the delays
+    Time jitterSum;                       //!< Sum of the jitters
+    uint64_t txBytes;                     //!< Bytes sent
+    uint64_t rxBytes;                     //!< Bytes received
+    uint32_t txPackets;                   //!< Packets sent
+    uint32_t rxPackets;                   //!< Packets received
+    uint32_t lostPackets;                 //!< Packets lost
+    uint32_t timesForwarded;              //!< Number of forwardings
+    std::vector<uint32_t> packetsDropped; //!< Packets dropped, by reason code
+    std::vector<uint64_t> bytesDropped;   //!< Bytes dropped, by reason code
+    std::vector<uint32_t> binCounts[4];   //!< Counts of the histogram bins
+    bool changed;                         //!< True if the flow is in m_changedFlows
+  };
+
+  std::ofstream m_stream; //!< Output of the changes of the statistics
+  Time m_streamInterval; //!< Time between two writes to the stream
+  bool m_streamHistograms; //!< True if the histograms are written to the stream
+  EventId m_streamEvent; //!< Next write to the stream
+  /// FlowId --> statistics written to the stream
+  std::unordered_map<FlowId, StreamedStats> m_streamedStats;
+  std::vector<FlowId> m_changedFlows; //!< Flows changed since the last write
+
+  /// Record that the statistics of a flow changed, if they are streamed
+  /// \param flowId the Flow identification
+  void NotifyFlowChanged (FlowId flowId);
+
+  /// Periodic function writing the changes to the stream
+  void PeriodicFlushStream ();
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -302,6 +406,35 @@ private:
 
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
+
+  /// Start tracking a packet
+  /// \param flowId flow identification
+  /// \param packetId packet identification in the flow
+  /// \returns the tracked packet
+  TrackedPacket& AddTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Find a tracked packet
+  /// \param flowId flow identification
+  /// \param packetId packet identification in the flow
+  /// \returns the index of the tracked packet in m_trackedPool, or
+  /// m_trackedPool.size () if the packet is not tracked
+  uint32_t FindTrackedPacket (FlowId flowId, FlowPacketId packetId) const;
+
+  /// Record that a tracked packet was seen now
+  /// \param index the index of the tracked packet in m_trackedPool
+  void TouchTrackedPacket (uint32_t index);
+
+  /// Stop tracking a packet
+  /// \param index the index of the tracked packet in m_trackedPool
+  void RemoveTrackedPacket (uint32_t index);
+
+  /// Count a tracked packet as lost, and stop tracking it
+  /// \param index the index of the tracked packet in m_trackedPool
+  void LoseTrackedPacket (uint32_t index);
+
+  /// Remove the stale entries of the expiry queue, if they are the
+  /// majority
+  void CompactExpiryQueue ();
 };
 
 
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
@@ -92,12 +94,29 @@ public:
 
 private:
 
+  /// Hash function of the five-tuples
+  struct FiveTupleHash
+  {
+    /**
+     * \param tuple the five-tuple
+     * \returns the hash of the five-tuple
+     */
+    std::size_t operator() (const FiveTuple &tuple) const;
+  };
+
+  /// The state of a flow
+  struct FlowInfo
+  {
+    FiveTuple tuple;           //!< Five-tuple of the flow
+    FlowPacketId lastPacketId; //!< Identifier of the last packet of the flow
+    /// (DSCP value, packet count) pairs
+    std::map<Ipv4Header::DscpType, uint32_t> dscpCounts;
+  };
+
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
-  /// Map FlowIds to (DSCP value, packet count) pairs
-  std::map<FlowId, std::map<Ipv4Header::DscpType, uint32_t> > m_flowDscpMap;
+  std::unordered_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+  /// The flows, indexed by FlowId - 1 (the FlowIds are allocated in sequence)
+  std::vector<FlowInfo> m_flows;
 
 };
 
@@ -0,0 +1,458 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/test.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief A probe reporting the packets of the test directly to the FlowMonitor
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  /**
+   * Constructor
+   * \param monitor the FlowMonitor
+   */
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor lost packets Test
+ *
+ * The packets which are neither received nor dropped are considered lost
+ * once they have not been seen for the given delay, or when too many
+ * packets are tracked.
+ */
+class FlowMonitorLostPacketsTestCase : public TestCase
+{
+public:
+  FlowMonitorLostPacketsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Report the first transmission of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void FirstTx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the forwarding of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Forward (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the reception of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Rx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Check the lost packets
+   * \param maxDelay the delay after which a packet is lost
+   * \param lost1 the expected number of lost packets of the flow 1
+   * \param lost2 the expected number of lost packets of the flow 2
+   */
+  void Check (Time maxDelay, uint32_t lost1, uint32_t lost2);
+
+  Ptr<FlowMonitor> m_monitor; //!< the FlowMonitor
+  Ptr<FlowProbe> m_probe;     //!< the probe
+};
+
+FlowMonitorLostPacketsTestCase::FlowMonitorLostPacketsTestCase ()
+  : TestCase ("Lost packets")
+{
+}
+
+void
+FlowMonitorLostPacketsTestCase::FirstTx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorLostPacketsTestCase::Forward (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportForwarding (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorLostPacketsTestCase::Rx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorLostPacketsTestCase::Check (Time maxDelay, uint32_t lost1, uint32_t lost2)
+{
+  m_monitor->CheckForLostPackets (maxDelay);
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.find (1)->second.lostPackets, lost1,
+                         "wrong number of lost packets in flow 1 at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_ASSERT_MSG_EQ (stats.find (2)->second.lostPackets, lost2,
+                         "wrong number of lost packets in flow 2 at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+FlowMonitorLostPacketsTestCase::DoRun (void)
+{
+  // without limit on the number of tracked packets
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  Simulator::Schedule (Seconds (0.1), &FlowMonitorLostPacketsTestCase::FirstTx, this, 1, 0);
+  Simulator::Schedule (Seconds (0.1), &FlowMonitorLostPacketsTestCase::FirstTx, this, 1, 1);
+  Simulator::Schedule (Seconds (0.2), &FlowMonitorLostPacketsTestCase::FirstTx, this, 2, 0);
+  Simulator::Schedule (Seconds (0.5), &FlowMonitorLostPacketsTestCase::Forward, this, 1, 0);
+  Simulator::Schedule (Seconds (1.0), &FlowMonitorLostPacketsTestCase::Forward, this, 1, 0);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitorLostPacketsTestCase::Rx, this, 1, 1);
+  Simulator::Schedule (Seconds (1.8), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 0, 0);
+  // the packet 0 of the flow 2 was last seen at 0.2 s, the packet 0 of
+  // the flow 1 at 1 s
+  Simulator::Schedule (Seconds (2.5), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 0, 1);
+  Simulator::Schedule (Seconds (3.0), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 1, 1);
+  Simulator::Schedule (Seconds (3.5), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (0), 1, 1);
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStats &flow1 = m_monitor->GetFlowStats ().find (1)->second;
+  NS_TEST_ASSERT_MSG_EQ (flow1.txPackets, 2, "wrong number of packets sent in flow 1");
+  NS_TEST_ASSERT_MSG_EQ (flow1.rxPackets, 1, "wrong number of packets received in flow 1");
+  NS_TEST_ASSERT_MSG_EQ (flow1.delaySum, Seconds (1.5) - Seconds (0.1), "wrong delay in flow 1");
+  m_monitor->Dispose ();
+  Simulator::Destroy ();
+
+  // at most two tracked packets
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxTrackedPackets", UintegerValue (2));
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  Simulator::Schedule (Seconds (0.1), &FlowMonitorLostPacketsTestCase::FirstTx, this, 1, 0);
+  Simulator::Schedule (Seconds (0.2), &FlowMonitorLostPacketsTestCase::FirstTx, this, 2, 0);
+  Simulator::Schedule (Seconds (0.3), &FlowMonitorLostPacketsTestCase::Forward, this, 1, 0);
+  Simulator::Schedule (Seconds (0.4), &FlowMonitorLostPacketsTestCase::FirstTx, this, 1, 1);
+  Simulator::Schedule (Seconds (0.5), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 0, 1);
+  Simulator::Schedule (Seconds (0.6), &FlowMonitorLostPacketsTestCase::Rx, this, 1, 0);
+  Simulator::Schedule (Seconds (0.7), &FlowMonitorLostPacketsTestCase::FirstTx, this, 2, 1);
+  Simulator::Schedule (Seconds (0.8), &FlowMonitorLostPacketsTestCase::FirstTx, this, 2, 2);
+  Simulator::Schedule (Seconds (0.9), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 1, 1);
+  Simulator::Schedule (Seconds (3.0), &FlowMonitorLostPacketsTestCase::Check, this, Seconds (2), 1, 3);
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStats &flow2 = m_monitor->GetFlowStats ().find (2)->second;
+  NS_TEST_ASSERT_MSG_EQ (flow2.txPackets, 3, "wrong number of packets sent in flow 2");
+  NS_TEST_ASSERT_MSG_EQ (m_monitor->GetFlowStats ().find (1)->second.rxPackets, 1,
+                         "wrong number of packets received in flow 1");
+  m_monitor->Dispose ();
+  Simulator::Destroy ();
+  m_probe = 0;
+  m_monitor = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor streaming Test
+ *
+ * The sums of the changes written to the stream are the statistics of
+ * the flows, and each write only contains the flows which changed.
+ */
+class FlowMonitorStreamingTestCase : public TestCase
+{
+public:
+  FlowMonitorStreamingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Report the first transmission of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void FirstTx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the reception of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Rx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the drop of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Drop (FlowId flowId, FlowPacketId packetId);
+
+  Ptr<FlowMonitor> m_monitor; //!< the FlowMonitor
+  Ptr<FlowProbe> m_probe;     //!< the probe
+};
+
+FlowMonitorStreamingTestCase::FlowMonitorStreamingTestCase ()
+  : TestCase ("Streaming")
+{
+}
+
+void
+FlowMonitorStreamingTestCase::FirstTx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100 + packetId);
+}
+
+void
+FlowMonitorStreamingTestCase::Rx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, 100 + packetId);
+}
+
+void
+FlowMonitorStreamingTestCase::Drop (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, 100 + packetId, 2);
+}
+
+void
+FlowMonitorStreamingTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flowmon-stream.csv");
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (3)));
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  m_monitor->EnableStreaming (fileName, Seconds (1), true);
+
+  // the flow 1 sends a packet every 100 ms, one of which is dropped and
+  // one of which is lost, and the flow 2 only sends packets during the
+  // first second
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      Simulator::Schedule (MilliSeconds (100 * i + 10), &FlowMonitorStreamingTestCase::FirstTx, this, 1, i);
+      if (i == 7)
+        {
+          Simulator::Schedule (MilliSeconds (100 * i + 20), &FlowMonitorStreamingTestCase::Drop, this, 1, i);
+        }
+      else if (i != 8)
+        {
+          Simulator::Schedule (MilliSeconds (100 * i + 20 + i), &FlowMonitorStreamingTestCase::Rx, this, 1, i);
+        }
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::Schedule (MilliSeconds (200 * i + 50), &FlowMonitorStreamingTestCase::FirstTx, this, 2, i);
+      Simulator::Schedule (MilliSeconds (200 * i + 60), &FlowMonitorStreamingTestCase::Rx, this, 2, i);
+    }
+  m_monitor->Stop (Seconds (5.5));
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+
+  // sum the changes
+  std::ifstream stream (fileName.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (stream.is_open (), true, "stream not written");
+  std::map<FlowId, std::vector<int64_t> > sums;
+  std::map<FlowId, uint32_t> writes;
+  std::map<FlowId, uint32_t> dropped;
+  std::map<FlowId, uint32_t> delayBins;
+  std::string line;
+  while (std::getline (stream, line))
+    {
+      if (line.empty () || line[0] == '#')
+        {
+          continue;
+        }
+      std::istringstream fields (line);
+      std::string type;
+      std::string field;
+      std::getline (fields, type, ',');
+      std::getline (fields, field, ',');
+      std::getline (fields, field, ',');
+      FlowId flowId = std::stoul (field);
+      if (type == "F")
+        {
+          std::vector<int64_t> &sum = sums[flowId];
+          sum.resize (8, 0);
+          for (uint32_t i = 0; i < 8; i++)
+            {
+              std::getline (fields, field, ',');
+              sum[i] += std::stoll (field);
+            }
+          writes[flowId]++;
+        }
+      else if (type == "D")
+        {
+          std::getline (fields, field, ',');
+          NS_TEST_ASSERT_MSG_EQ (field, "2", "wrong drop reason code");
+          std::getline (fields, field, ',');
+          dropped[flowId] += std::stoul (field);
+        }
+      else if (type == "H")
+        {
+          std::string name;
+          std::getline (fields, name, ',');
+          std::getline (fields, field, ',');
+          std::getline (fields, field, ',');
+          std::getline (fields, field, ',');
+          if (name == "delayHistogram")
+            {
+              delayBins[flowId] += std::stoul (field);
+            }
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (type, "F", "invalid line " << line);
+        }
+    }
+
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (sums.size (), stats.size (), "wrong number of flows");
+  for (FlowMonitor::FlowStatsContainerCI flowI = stats.begin (); flowI != stats.end (); flowI++)
+    {
+      const std::vector<int64_t> &sum = sums[flowI->first];
+      NS_TEST_ASSERT_MSG_EQ (sum.size (), 8, "flow " << flowI->first << " not written");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint64_t> (sum[0]), flowI->second.txBytes, "wrong txBytes");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint64_t> (sum[1]), flowI->second.rxBytes, "wrong rxBytes");
+      NS_TEST_ASSERT_MSG_EQ (sum[2], flowI->second.txPackets, "wrong txPackets");
+      NS_TEST_ASSERT_MSG_EQ (sum[3], flowI->second.rxPackets, "wrong rxPackets");
+      NS_TEST_ASSERT_MSG_EQ (sum[4], flowI->second.lostPackets, "wrong lostPackets");
+      NS_TEST_ASSERT_MSG_EQ (sum[6], flowI->second.delaySum.GetNanoSeconds (), "wrong delaySum");
+      NS_TEST_ASSERT_MSG_EQ (sum[7], flowI->second.jitterSum.GetNanoSeconds (), "wrong jitterSum");
+      NS_TEST_ASSERT_MSG_EQ (delayBins[flowI->first], flowI->second.rxPackets, "wrong delay histogram");
+    }
+  NS_TEST_ASSERT_MSG_EQ (stats.find (1)->second.lostPackets, 2, "wrong number of lost packets");
+  NS_TEST_ASSERT_MSG_EQ (dropped[1], 1, "wrong number of dropped packets");
+  // the flow 1 changes until 5 s, when it is written for the last time
+  NS_TEST_ASSERT_MSG_EQ (writes[1], 5, "wrong number of writes of the flow 1");
+  NS_TEST_ASSERT_MSG_EQ (writes[2], 1, "wrong number of writes of the flow 2");
+
+  m_monitor->Dispose ();
+  Simulator::Destroy ();
+  m_probe = 0;
+  m_monitor = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Ipv4FlowClassifier Test
+ */
+class Ipv4FlowClassifierTestCase : public TestCase
+{
+public:
+  Ipv4FlowClassifierTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4FlowClassifierTestCase::Ipv4FlowClassifierTestCase ()
+  : TestCase ("Ipv4FlowClassifier")
+{
+}
+
+void
+Ipv4FlowClassifierTestCase::DoRun (void)
+{
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  const uint32_t nFlows = 1000;
+
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.0.0.1"));
+  ipHeader.SetProtocol (17);
+  uint8_t ports[4];
+  // each flow sends its packets after the previous flow started
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      for (uint32_t i = 0; i < nFlows; i++)
+        {
+          ipHeader.SetDestination (Ipv4Address (0x0b000000 + i % 100));
+          ipHeader.SetDscp (round == 2 ? Ipv4Header::DSCP_EF : Ipv4Header::DscpDefault);
+          uint16_t srcPort = 49153 + i / 100;
+          ports[0] = srcPort >> 8;
+          ports[1] = srcPort & 0xff;
+          ports[2] = 0;
+          ports[3] = 9;
+          Ptr<Packet> payload = Create<Packet> (ports, 4);
+          FlowId flowId;
+          FlowPacketId packetId;
+          NS_TEST_ASSERT_MSG_EQ (classifier->Classify (ipHeader, payload, &flowId, &packetId), true,
+                                 "packet not classified");
+          NS_TEST_ASSERT_MSG_EQ (flowId, i + 1, "wrong flow");
+          NS_TEST_ASSERT_MSG_EQ (packetId, round, "wrong packet identifier");
+        }
+    }
+
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow (i + 1);
+      NS_TEST_ASSERT_MSG_EQ (tuple.destinationAddress, Ipv4Address (0x0b000000 + i % 100), "wrong destination");
+      NS_TEST_ASSERT_MSG_EQ (tuple.sourcePort, 49153 + i / 100, "wrong source port");
+      NS_TEST_ASSERT_MSG_EQ (tuple.destinationPort, 9, "wrong destination port");
+      std::vector<std::pair<Ipv4Header::DscpType, uint32_t> > dscp = classifier->GetDscpCounts (i + 1);
+      NS_TEST_ASSERT_MSG_EQ (dscp.size (), 2, "wrong number of DSCP values");
+      NS_TEST_ASSERT_MSG_EQ (dscp[0].first, Ipv4Header::DscpDefault, "wrong most frequent DSCP value");
+      NS_TEST_ASSERT_MSG_EQ (dscp[0].second, 2, "wrong number of packets with the default DSCP");
+    }
+
+  // the flows are serialized in the order of their five-tuples
+  std::ostringstream os;
+  classifier->SerializeToXmlStream (os, 0);
+  std::string xml = os.str ();
+  std::string::size_type first = xml.find ("<Flow flowId=\"1\" ");
+  std::string::size_type second = xml.find ("<Flow flowId=\"101\" ");
+  std::string::size_type third = xml.find ("<Flow flowId=\"2\" ");
+  NS_TEST_ASSERT_MSG_NE (first, std::string::npos, "flow 1 not serialized");
+  NS_TEST_ASSERT_MSG_LT (first, second, "flow 101 serialized before flow 1");
+  NS_TEST_ASSERT_MSG_LT (second, third, "flow 2 serialized before flow 101");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor TestSuite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowMonitorLostPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorStreamingTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4FlowClassifierTestCase, TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite; //!< Static variable for test initialization
@@ -66,9 +66,7 @@ Ipv4GlobalRoutingHelper::PopulateRoutingTables (void)
 void 
 Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
 {
-  GlobalRouteManager::DeleteGlobalRoutes ();
-  GlobalRouteManager::BuildGlobalRoutingDatabase ();
-  GlobalRouteManager::InitializeRoutes ();
+  GlobalRouteManager::RecomputeRoutingTables ();
 }
 
 
@@ -72,13 +72,14 @@ public:
    */
   static void PopulateRoutingTables (void);
   /**
-   * \brief Remove all routes that were previously installed in a prior call
-   * to either PopulateRoutingTables() or RecomputeRoutingTables(), and 
-   * add a new set of routes.
+   * \brief Update the routes that were previously installed in a prior call
+   * to either PopulateRoutingTables() or RecomputeRoutingTables().
    * 
    * This method does not change the set of nodes
    * over which GlobalRouting is being used, but it will dynamically update
    * its representation of the global topology before recomputing routes.
+   * Only the routes of the nodes affected by the topology changes are
+   * recomputed: the other nodes keep their routes.
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
@@ -26,10 +26,16 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
+#include <set>
+#include <thread>
+#include "ns3/core-config.h"
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -39,11 +45,22 @@
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
 #include "ipv4-global-routing.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/// The number of threads computing the routes of the global routers
+static GlobalValue g_threadCount = GlobalValue ("GlobalRouteManagerThreadCount",
+                                                "The number of threads computing the routes of "
+                                                "the global routers.  Zero selects the number "
+                                                "of hardware threads.",
+                                                UintegerValue (0),
+                                                MakeUintegerChecker<uint32_t> ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -446,6 +463,7 @@ GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
     }
   NS_LOG_LOGIC ("clear map");
   m_database.clear ();
+  m_transitLinkData.clear ();
 }
 
 void
@@ -468,9 +486,27 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      // index the TransitNetwork link records, keeping the LSA with the
+      // lowest address for each link data
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LinkDataIndex_t::iterator i = m_transitLinkData.find (lr->GetLinkData ());
+          if (i == m_transitLinkData.end ())
+            {
+              m_transitLinkData.insert (std::make_pair (lr->GetLinkData (), LSDBPair_t (addr, lsa)));
+            }
+          else if (addr < i->second.first)
+            {
+              i->second = LSDBPair_t (addr, lsa);
+            }
+        }
     }
 }
 
@@ -495,13 +531,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,26 +544,46 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataIndex_t::const_iterator i = m_transitLinkData.find (addr);
+  if (i != m_transitLinkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return i->second.second;
     }
   return 0;
 }
 
+std::vector<Ipv4Address>
+GlobalRouteManagerLSDB::GetLinkStateIds (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> ids;
+  ids.reserve (m_database.size ());
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      ids.push_back (i->first);
+    }
+  return ids;
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      GlobalRoutingLSA *lsa = m_extdatabase[j];
+      lsdb->Insert (lsa->GetLinkStateId (), new GlobalRoutingLSA (*lsa));
+    }
+  return lsdb;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -539,7 +592,12 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrootNodeId (0),
+    m_routesComputed (false),
+    m_job (0),
+    m_spfTree (0),
+    m_spfStubRank (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -579,18 +637,8 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
           continue;
         }
       Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
       NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (gr);
     }
   if (m_lsdb)
     {
@@ -598,6 +646,22 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_routesComputed = false;
+  m_spfTrees.clear ();
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Ipv4GlobalRouting> routing)
+{
+  NS_LOG_FUNCTION (routing);
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  uint32_t nRoutes = routing->GetNRoutes ();
+  for (uint32_t j = 0; j < nRoutes; j++)
+    {
+      routing->RemoveRoute (0);
+    }
 }
 
 //
@@ -613,6 +677,7 @@ void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase () 
 {
   NS_LOG_FUNCTION (this);
+  m_routesComputed = false;
 //
 // Walk the list of nodes looking for the GlobalRouter Interface.  Nodes with
 // global router interfaces are, not too surprisingly, our routers.
@@ -693,41 +758,691 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // list becomes empty. 
 //
 void
-GlobalRouteManagerImpl::InitializeRoutes ()
+GlobalRouteManagerImpl::InitializeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+//
+// Walk the list of nodes in the system.
+//
+  NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<SPFRoot> roots;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+//
+// Look for the GlobalRouter interface that indicates that the node is
+// participating in routing.
+//
+      Ptr<GlobalRouter> rtr = 
+        node->GetObject<GlobalRouter> ();
+
+      uint32_t systemId = MpiInterface::GetSystemId ();
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId) 
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          roots.push_back (MakeRoot (node, rtr));
+        }
+    }
+  m_spfTrees.clear ();
+  ComputeRoutes (roots);
+  m_routesComputed = true;
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+/**
+ * \brief Compare two Link State Advertisements.
+ * \param a the first LSA
+ * \param b the second LSA
+ * \returns true if both LSAs describe the same links
+ */
+static bool
+IsSameLSA (GlobalRoutingLSA *a, GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief Get the edges of the graph of the routers and transit networks
+ * described by a Link State Advertisement.
+ * \param lsdb the LSDB of the LSA
+ * \param lsa the LSA, or 0
+ * \param edges the metrics of the edges, by vertex ID
+ */
+static void
+GetLSAEdges (const GlobalRouteManagerLSDB *lsdb, GlobalRoutingLSA *lsa,
+             std::map<Ipv4Address, std::vector<uint32_t> > &edges)
+{
+  if (lsa == 0)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (i);
+      if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+          || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+        {
+          edges[lr->GetLinkId ()].push_back (lr->GetMetric ());
+        }
+    }
+  for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+    {
+      GlobalRoutingLSA *router = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+      if (router != 0)
+        {
+          edges[router->GetLinkStateId ()].push_back (0);
+        }
+    }
+  for (std::map<Ipv4Address, std::vector<uint32_t> >::iterator i = edges.begin (); i != edges.end (); i++)
+    {
+      std::sort (i->second.begin (), i->second.end ());
+    }
+}
+
+/**
+ * \brief Get the addresses to which a Link State Advertisement gives
+ * routes.
+ * \param lsa the LSA, or 0
+ * \param hosts the host addresses
+ * \param networks the networks, as (address, mask)
+ */
+static void
+GetLSADestinations (GlobalRoutingLSA *lsa, std::set<uint32_t> &hosts,
+                    std::set<std::pair<uint32_t, uint32_t> > &networks)
+{
+  if (lsa == 0)
+    {
+      return;
+    }
+  if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      Ipv4Mask mask = lsa->GetNetworkLSANetworkMask ();
+      networks.insert (std::make_pair (lsa->GetLinkStateId ().CombineMask (mask).Get (), mask.Get ()));
+      return;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (i);
+      if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+        {
+          hosts.insert (lr->GetLinkData ().Get ());
+        }
+      else if (lr->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+        {
+          Ipv4Mask mask (lr->GetLinkData ().Get ());
+          networks.insert (std::make_pair (lr->GetLinkId ().CombineMask (mask).Get (), mask.Get ()));
+        }
+    }
+}
+
+/**
+ * \brief Insert the elements found in only one of two sets.
+ * \param a the first set
+ * \param b the second set
+ * \param result the set receiving the elements
+ */
+template <typename T>
+static void
+InsertDifference (const std::set<T> &a, const std::set<T> &b, std::set<T> &result)
+{
+  std::set_symmetric_difference (a.begin (), a.end (), b.begin (), b.end (),
+                                 std::inserter (result, result.end ()));
+}
+
+GlobalRouteManagerImpl::LSAChange
+GlobalRouteManagerImpl::CompareLSA (const GlobalRouteManagerLSDB *previous, Ipv4Address id) const
+{
+  NS_LOG_FUNCTION (this << id);
+  LSAChange change;
+  change.id = id;
+  GlobalRoutingLSA *before = previous->GetLSA (id);
+  GlobalRoutingLSA *after = m_lsdb->GetLSA (id);
+
+  std::map<Ipv4Address, std::vector<uint32_t> > edgesBefore;
+  std::map<Ipv4Address, std::vector<uint32_t> > edgesAfter;
+  GetLSAEdges (previous, before, edgesBefore);
+  GetLSAEdges (m_lsdb, after, edgesAfter);
+  for (std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator i = edgesBefore.begin ();
+       i != edgesBefore.end (); i++)
+    {
+      std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator j = edgesAfter.find (i->first);
+      if (j == edgesAfter.end ())
+        {
+          change.edges[i->first] = std::make_pair (i->second.front (), SPF_INFINITY);
+        }
+      else if (i->second != j->second)
+        {
+          change.edges[i->first] = std::make_pair (i->second.front (), j->second.front ());
+        }
+    }
+  for (std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator j = edgesAfter.begin ();
+       j != edgesAfter.end (); j++)
+    {
+      if (edgesBefore.find (j->first) == edgesBefore.end ())
+        {
+          change.edges[j->first] = std::make_pair (SPF_INFINITY, j->second.front ());
+        }
+    }
+
+  std::set<uint32_t> hostsBefore;
+  std::set<uint32_t> hostsAfter;
+  std::set<std::pair<uint32_t, uint32_t> > networksBefore;
+  std::set<std::pair<uint32_t, uint32_t> > networksAfter;
+  GetLSADestinations (before, hostsBefore, networksBefore);
+  GetLSADestinations (after, hostsAfter, networksAfter);
+  InsertDifference (hostsBefore, hostsAfter, change.hosts);
+  InsertDifference (networksBefore, networksAfter, change.networks);
+  return change;
+}
+
+bool
+GlobalRouteManagerImpl::IsTreeAffected (Ipv4Address routerId, const SPFTree &tree,
+                                        const std::vector<LSAChange> &changes) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+//
+// The exit directions of the neighbors of the root, and of the routers on
+// the transit networks of the root, are computed from their own LSAs.
+//
+  std::set<Ipv4Address> neighbors;
+  GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (routerId);
+  for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *lr = rlsa->GetLinkRecord (i);
+      if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+          || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+        {
+          neighbors.insert (lr->GetLinkId ());
+        }
+      GlobalRoutingLSA *nlsa = lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork
+        ? m_lsdb->GetLSA (lr->GetLinkId ()) : 0;
+      for (uint32_t j = 0; nlsa != 0 && j < nlsa->GetNAttachedRouters (); j++)
+        {
+          GlobalRoutingLSA *router = m_lsdb->GetLSAByLinkData (nlsa->GetAttachedRouter (j));
+          if (router != 0)
+            {
+              neighbors.insert (router->GetLinkStateId ());
+            }
+        }
+    }
+
+  for (std::vector<LSAChange>::const_iterator i = changes.begin (); i != changes.end (); i++)
+    {
+      if (neighbors.count (i->id) > 0)
+        {
+          return true;
+        }
+      std::map<Ipv4Address, SPFTreeVertex>::const_iterator u = tree.vertices.find (i->id);
+      if (u == tree.vertices.end ())
+        {
+//
+// A vertex which was not reached can only be reached now through a
+// changed edge from a vertex which was.
+//
+          continue;
+        }
+      for (std::map<Ipv4Address, std::pair<uint32_t, uint32_t> >::const_iterator e = i->edges.begin ();
+           e != i->edges.end (); e++)
+        {
+          std::map<Ipv4Address, SPFTreeVertex>::const_iterator w = tree.vertices.find (e->first);
+          if (w == tree.vertices.end ())
+            {
+              if (e->second.second != SPF_INFINITY)
+                {
+                  return true;
+                }
+              continue;
+            }
+//
+// An edge which was on a shortest path, or which can make a path shorter
+// or add an equal cost path, changes the tree.
+//
+          uint64_t distance = static_cast<uint64_t> (u->second.distance)
+            + std::min (e->second.first, e->second.second);
+          if (distance <= w->second.distance)
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::UpdateRoutes (const SPFRoot &root, const SPFTree &tree,
+                                      const std::vector<const LSAChange *> &changes,
+                                      const std::map<uint32_t, std::vector<Ipv4Address> > &hosts,
+                                      const std::map<std::pair<uint32_t, uint32_t>, std::vector<Ipv4Address> > &networks) const
+{
+  NS_LOG_FUNCTION (this << root.routerId << changes.size ());
+  std::set<uint32_t> changedHosts;
+  std::set<std::pair<uint32_t, uint32_t> > changedNetworks;
+  for (std::vector<const LSAChange *>::const_iterator i = changes.begin (); i != changes.end (); i++)
+    {
+      changedHosts.insert ((*i)->hosts.begin (), (*i)->hosts.end ());
+      changedNetworks.insert ((*i)->networks.begin (), (*i)->networks.end ());
+    }
+
+  Ptr<Ipv4GlobalRouting> gr = root.routing;
+  for (uint32_t i = gr->GetNRoutes (); i > 0; i--)
+    {
+      Ipv4RoutingTableEntry *route = gr->GetRoute (i - 1);
+      if ((route->IsHost () && changedHosts.count (route->GetDest ().Get ()) > 0)
+          || (route->IsNetwork ()
+              && changedNetworks.count (std::make_pair (route->GetDestNetwork ().Get (),
+                                                        route->GetDestNetworkMask ().Get ())) > 0))
+        {
+          gr->RemoveRoute (i - 1);
+        }
+    }
+
+//
+// The routes are added as SPFIntraAddRouter, SPFIntraAddTransit and
+// SPFIntraAddStub do, the transit networks first, then the stubs in the
+// order in which they were processed.
+//
+  for (std::set<uint32_t>::const_iterator i = changedHosts.begin (); i != changedHosts.end (); i++)
+    {
+      std::map<uint32_t, std::vector<Ipv4Address> >::const_iterator advertisers = hosts.find (*i);
+      for (uint32_t j = 0; advertisers != hosts.end () && j < advertisers->second.size (); j++)
+        {
+          std::map<Ipv4Address, SPFTreeVertex>::const_iterator v = tree.vertices.find (advertisers->second[j]);
+          if (v == tree.vertices.end () || v->first == root.routerId)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < v->second.exits.size (); k++)
+            {
+              if (v->second.exits[k].second >= 0)
+                {
+                  gr->AddHostRouteTo (Ipv4Address (*i), v->second.exits[k].first, v->second.exits[k].second);
+                }
+            }
+        }
+    }
+  for (std::set<std::pair<uint32_t, uint32_t> >::const_iterator i = changedNetworks.begin ();
+       i != changedNetworks.end (); i++)
+    {
+      std::map<std::pair<uint32_t, uint32_t>, std::vector<Ipv4Address> >::const_iterator advertisers = networks.find (*i);
+      if (advertisers == networks.end ())
+        {
+          continue;
+        }
+      std::vector<std::pair<uint64_t, const SPFTreeVertex *> > sources;
+      for (uint32_t j = 0; j < advertisers->second.size (); j++)
+        {
+          std::map<Ipv4Address, SPFTreeVertex>::const_iterator v = tree.vertices.find (advertisers->second[j]);
+          if (v == tree.vertices.end () || v->first == root.routerId)
+            {
+              continue;
+            }
+          bool transit = m_lsdb->GetLSA (v->first)->GetLSType () == GlobalRoutingLSA::NetworkLSA;
+          sources.push_back (std::make_pair (transit ? 0 : v->second.stubRank + 1ULL, &v->second));
+        }
+      std::sort (sources.begin (), sources.end ());
+      for (uint32_t j = 0; j < sources.size (); j++)
+        {
+          const std::vector<SPFVertex::NodeExit_t> &exits = sources[j].second->exits;
+          for (uint32_t k = 0; k < exits.size (); k++)
+            {
+              if (exits[k].second >= 0)
+                {
+                  gr->AddNetworkRouteTo (Ipv4Address (i->first), Ipv4Mask (i->second),
+                                         exits[k].first, exits[k].second);
+                }
+            }
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::RecomputeRoutingTables ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_routesComputed)
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+  GlobalRouteManagerLSDB *previous = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+
+//
+// Find the LSAs which were added, removed or modified.  Both lists of IDs
+// are sorted.
+//
+  std::vector<Ipv4Address> ids = m_lsdb->GetLinkStateIds ();
+  std::vector<Ipv4Address> previousIds = previous->GetLinkStateIds ();
+  std::set<Ipv4Address> changed;
+  std::vector<Ipv4Address>::const_iterator i = ids.begin ();
+  std::vector<Ipv4Address>::const_iterator j = previousIds.begin ();
+  while (i != ids.end () || j != previousIds.end ())
+    {
+      if (j == previousIds.end () || (i != ids.end () && *i < *j))
+        {
+          changed.insert (*i++);
+        }
+      else if (i == ids.end () || *j < *i)
+        {
+          changed.insert (*j++);
+        }
+      else
+        {
+          if (!IsSameLSA (m_lsdb->GetLSA (*i), previous->GetLSA (*j)))
+            {
+              changed.insert (*i);
+            }
+          i++;
+          j++;
+        }
+    }
+  bool externalChanged = m_lsdb->GetNumExtLSAs () != previous->GetNumExtLSAs ();
+  for (uint32_t k = 0; k < m_lsdb->GetNumExtLSAs () && !externalChanged; k++)
+    {
+      externalChanged = !IsSameLSA (m_lsdb->GetExtLSA (k), previous->GetExtLSA (k));
+    }
+  NS_LOG_LOGIC (changed.size () << " LSAs changed" << (externalChanged ? ", and external LSAs" : ""));
+
+  std::vector<LSAChange> changes;
+  for (std::set<Ipv4Address>::const_iterator k = changed.begin (); k != changed.end (); k++)
+    {
+      changes.push_back (CompareLSA (previous, *k));
+    }
+  delete previous;
+
+  std::vector<SPFRoot> roots;
+  std::vector<std::pair<SPFRoot, std::vector<const LSAChange *> > > updates;
+  uint32_t nUnaffected = 0;
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator k = NodeList::Begin (); k != listEnd; k++)
+    {
+      Ptr<Node> node = *k;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0 || node->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      Ipv4Address routerId = rtr->GetRouterId ();
+      std::map<Ipv4Address, SPFTree>::const_iterator tree = m_spfTrees.find (routerId);
+      bool affected = changed.count (routerId) > 0 || tree == m_spfTrees.end ();
+      std::vector<const LSAChange *> treeChanges;
+      if (!affected && tree->second.stub)
+        {
+//
+// The routes of a stub router (see CheckForStubNode) only depend on its
+// own LSA and on the LSA of its neighbor.
+//
+          GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (routerId);
+          for (uint32_t l = 0; l < rlsa->GetNLinkRecords () && !affected; l++)
+            {
+              GlobalRoutingLinkRecord *lr = rlsa->GetLinkRecord (l);
+              affected = (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork
+                          || lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                && changed.count (lr->GetLinkId ()) > 0;
+            }
+        }
+      else if (!affected)
+        {
+          affected = externalChanged || IsTreeAffected (routerId, tree->second, changes);
+          for (uint32_t l = 0; l < changes.size () && !affected; l++)
+            {
+              if ((!changes[l].hosts.empty () || !changes[l].networks.empty ())
+                  && tree->second.vertices.count (changes[l].id) > 0)
+                {
+                  treeChanges.push_back (&changes[l]);
+                }
+            }
+//
+// The external routes are not told apart from the network routes of the
+// routing protocol, hence they are all recomputed.
+//
+          affected = affected || (!treeChanges.empty () && m_lsdb->GetNumExtLSAs () > 0);
+        }
+      if (affected)
+        {
+          NS_LOG_LOGIC ("Recomputing the routes of node " << node->GetId ());
+          DeleteRoutes (rtr->GetRoutingProtocol ());
+          if (rtr->GetNumLSAs ())
+            {
+              roots.push_back (MakeRoot (node, rtr));
+            }
+        }
+      else if (!treeChanges.empty ())
+        {
+          updates.push_back (std::make_pair (MakeRoot (node, rtr), treeChanges));
+        }
+      else
+        {
+          nUnaffected++;
+        }
+    }
+
+  if (!updates.empty ())
+    {
+//
+// Find the vertices giving a route to each address added or removed.
+//
+      std::map<uint32_t, std::vector<Ipv4Address> > hosts;
+      std::map<std::pair<uint32_t, uint32_t>, std::vector<Ipv4Address> > networks;
+      for (uint32_t k = 0; k < changes.size (); k++)
+        {
+          for (std::set<uint32_t>::const_iterator l = changes[k].hosts.begin (); l != changes[k].hosts.end (); l++)
+            {
+              hosts[*l];
+            }
+          for (std::set<std::pair<uint32_t, uint32_t> >::const_iterator l = changes[k].networks.begin ();
+               l != changes[k].networks.end (); l++)
+            {
+              networks[*l];
+            }
+        }
+      for (std::vector<Ipv4Address>::const_iterator k = ids.begin (); k != ids.end (); k++)
+        {
+          std::set<uint32_t> lsaHosts;
+          std::set<std::pair<uint32_t, uint32_t> > lsaNetworks;
+          GetLSADestinations (m_lsdb->GetLSA (*k), lsaHosts, lsaNetworks);
+          for (std::set<uint32_t>::const_iterator l = lsaHosts.begin (); l != lsaHosts.end (); l++)
+            {
+              std::map<uint32_t, std::vector<Ipv4Address> >::iterator h = hosts.find (*l);
+              if (h != hosts.end ())
+                {
+                  h->second.push_back (*k);
+                }
+            }
+          for (std::set<std::pair<uint32_t, uint32_t> >::const_iterator l = lsaNetworks.begin ();
+               l != lsaNetworks.end (); l++)
+            {
+              std::map<std::pair<uint32_t, uint32_t>, std::vector<Ipv4Address> >::iterator n = networks.find (*l);
+              if (n != networks.end ())
+                {
+                  n->second.push_back (*k);
+                }
+            }
+        }
+      for (uint32_t k = 0; k < updates.size (); k++)
+        {
+          NS_LOG_LOGIC ("Updating the routes of node " << updates[k].first.nodeId);
+          UpdateRoutes (updates[k].first, m_spfTrees[updates[k].first.routerId], updates[k].second,
+                        hosts, networks);
+        }
+    }
+
+  NS_LOG_INFO ("About to start SPF calculation for " << roots.size () << " nodes, "
+               << updates.size () << " nodes have some routes updated, "
+               << nUnaffected << " nodes are not affected");
+  ComputeRoutes (roots);
+  m_routesComputed = true;
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+GlobalRouteManagerImpl::SPFRoot
+GlobalRouteManagerImpl::MakeRoot (Ptr<Node> node, Ptr<GlobalRouter> rtr) const
+{
+  NS_LOG_FUNCTION (this << node << rtr);
+  SPFRoot root;
+  root.routerId = rtr->GetRouterId ();
+  root.nodeId = node->GetId ();
+  root.ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (root.ipv4, 
+                 "GlobalRouteManagerImpl::MakeRoot (): "
+                 "GetObject for <Ipv4> interface failed");
+  root.routing = rtr->GetRoutingProtocol ();
+  return root;
+}
+
+GlobalRouteManagerImpl::SPFRoot
+GlobalRouteManagerImpl::FindRoot (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+//
+// Walk the list of nodes in the system looking for the one whose router ID
+// is the one of the root of the SPF tree.
+//
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == routerId)
+        {
+          return MakeRoot (node, rtr);
+        }
+    }
+  NS_LOG_LOGIC ("Can't find root node " << routerId);
+  SPFRoot root;
+  root.routerId = routerId;
+  root.nodeId = 0;
+  return root;
+}
+
+void
+GlobalRouteManagerImpl::ComputeRoutes (const std::vector<SPFRoot> &roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  UintegerValue threadCount;
+  g_threadCount.GetValue (threadCount);
+  uint32_t nThreads = threadCount.Get ();
+  if (nThreads == 0)
+    {
+      nThreads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  // a thread copies the whole LSDB, so that it is only worth it for
+  // several roots
+  const uint32_t minRootsPerThread = 8;
+  nThreads = std::max (std::min<uint32_t> (nThreads, roots.size () / minRootsPerThread), 1U);
+
+  std::vector<SPFTree> trees (roots.size ());
+  SPFJob job;
+  job.roots = &roots;
+  job.trees = &trees;
+  job.next = 0;
+  m_job = &job;
+#ifdef HAVE_PTHREAD_H
+  std::vector<GlobalRouteManagerImpl *> workers;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < nThreads; i++)
+    {
+      GlobalRouteManagerImpl *worker = new GlobalRouteManagerImpl ();
+      delete worker->m_lsdb;
+      worker->m_lsdb = m_lsdb->Copy ();
+      worker->m_job = &job;
+      workers.push_back (worker);
+    }
+  for (uint32_t i = 0; i < workers.size (); i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::ProcessSPFJob, workers[i]));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  NS_LOG_LOGIC ("Computing the routes of " << roots.size () << " nodes with " << threads.size () + 1 << " threads");
+#endif /* HAVE_PTHREAD_H */
+  ProcessSPFJob ();
+#ifdef HAVE_PTHREAD_H
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+      delete workers[i];
+    }
+#endif /* HAVE_PTHREAD_H */
+  m_job = 0;
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      SPFTree &tree = m_spfTrees[roots[i].routerId];
+      tree.stub = trees[i].stub;
+      tree.vertices.swap (trees[i].vertices);
+    }
+}
+
+void
+GlobalRouteManagerImpl::ProcessSPFJob (void)
 {
   NS_LOG_FUNCTION (this);
-//
-// Walk the list of nodes in the system.
-//
-  NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  for (uint32_t i = m_job->next++; i < m_job->roots->size (); i = m_job->next++)
     {
-      Ptr<Node> node = *i;
-//
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
-//
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
-        {
-          continue;
-        }
+      m_spfTree = &(*m_job->trees)[i];
+      SPFCalculate ((*m_job->roots)[i]);
+      m_spfTree = 0;
+    }
+}
 
-//
-// if the node has a global router interface, then run the global routing
-// algorithms.
-//
-      if (rtr && rtr->GetNumLSAs () )
-        {
-          SPFCalculate (rtr->GetRouterId ());
-        }
+void
+GlobalRouteManagerImpl::SPFRecordVertex (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+  if (m_spfTree == 0)
+    {
+      return;
+    }
+  SPFTreeVertex &vertex = m_spfTree->vertices[v->GetVertexId ()];
+  vertex.distance = v->GetDistanceFromRoot ();
+  vertex.stubRank = 0;
+  vertex.exits.clear ();
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      vertex.exits.push_back (v->GetRootExitDirection (i));
     }
-  NS_LOG_INFO ("Finished SPF calculation");
 }
 
 //
@@ -1247,7 +1962,7 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
-  SPFCalculate (root);
+  SPFCalculate (FindRoot (root));
 }
 
 //
@@ -1320,9 +2035,12 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  if (m_spfrootIpv4 == 0)
+                    {
+                      NS_LOG_LOGIC ("Can't find root node " << myRouterId);
+                      return true;
+                    }
+                  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1339,12 +2057,20 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 
 // quagga ospf_spf_calculate
 void
-GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
+GlobalRouteManagerImpl::SPFCalculate (const SPFRoot &spfRoot)
 {
-  NS_LOG_FUNCTION (this << root);
+  NS_LOG_FUNCTION (this << spfRoot.routerId);
 
+  Ipv4Address root = spfRoot.routerId;
   SPFVertex *v;
 //
+// The routes are only added to the node at the root of the tree, whose
+// objects have been looked up beforehand.
+//
+  m_spfrootIpv4 = spfRoot.ipv4;
+  m_spfrootRouting = spfRoot.routing;
+  m_spfrootNodeId = spfRoot.nodeId;
+//
 // Initialize the Link State Database.
 //
   m_lsdb->Initialize ();
@@ -1369,6 +2095,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+  m_spfStubRank = 0;
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,13 +2104,22 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  bool stub = NodeList::GetNNodes () > 0 && CheckForStubNode (root);
+  if (m_spfTree != 0)
+    {
+      m_spfTree->stub = stub;
+    }
+  if (stub)
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootIpv4 = 0;
+      m_spfrootRouting = 0;
       return;
     }
 
+  SPFRecordVertex (v);
   for (;;)
     {
 //
@@ -1437,6 +2173,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // to now.
 //
       SPFVertexAddParent (v);
+      SPFRecordVertex (v);
 //
 // Note that when there is a choice of vertices closest to the root, network
 // vertices must be chosen before router vertices in order to necessarily
@@ -1444,12 +2181,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
 // RFC2328 16.1. (4). 
 //
-// This is the method that actually adds the routes.  It'll walk the list
-// of nodes in the system, looking for the node corresponding to the router
-// ID of the root of the tree -- that is the router we're building the routes
-// for.  It looks for the Ipv4 interface of that node and remembers it.  So
-// we are only actually adding routes to that one node at the root of the SPF 
-// tree.
+// This is the method that actually adds the routes, using the routing
+// protocol of the node corresponding to the router ID of the root of the
+// tree -- that is the router we're building the routes for.  So we are only
+// actually adding routes to that one node at the root of the SPF tree.
 //
 // We're going to pop of a pointer to every vertex in the tree except the 
 // root in order of distance from the root.  For each of the vertices, we call
@@ -1502,6 +2237,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootIpv4 = 0;
+  m_spfrootRouting = 0;
 }
 
 void
@@ -1516,6 +2253,10 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
     {
       GlobalRoutingLSA *rlsa = v->GetLSA ();
       NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
+      if (m_spfTree != 0)
+        {
+          m_spfTree->vertices[v->GetVertexId ()].stubRank = m_spfStubRank++;
+        }
       if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
         {
           NS_LOG_LOGIC ("Found advertising router to destination");
@@ -1556,109 +2297,52 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
 
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing information is written to the node at the root of the SPF
+// tree, if it exists.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("Can't find root node " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNodeId);
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+
+//
+// The vertex <v> (corresponding to the router advertising the external
+// network) has the exit directions precalculated for us, that is the next
+// hops to which the root node should send packets to be forwarded to the
+// external network, and the outbound interfaces to use.
+//
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1720,116 +2404,52 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// going to write the actual routing table entries.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("Can't find root node " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNodeId);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// The vertex <v> (corresponding to the node that has the stub network)
+// has the exit directions precalculated for us, that is the next hops to
+// which the root node should send packets to be forwarded to the stub
+// network, and the outbound interfaces to use.
+//
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1844,70 +2464,24 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
+// We have an IP address <a> and a vertex ID of the root of the SPF tree.  
 // The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
+// The answer is found by iterating the interfaces of the Ipv4 of the node
+// at the root of the SPF tree, which was looked up before the SPF
+// calculation.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      // Couldn't find it.
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_spfroot->GetVertexId ());
+      return -1;
+    }
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
-    }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+  return m_spfrootIpv4->GetInterfaceForPrefix (a, amask);
 }
 
 //
@@ -1935,69 +2509,28 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  Its node was looked up
+// before the SPF calculation.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("Can't find root node " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrootNodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2539,20 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << m_spfrootNodeId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  NS_ASSERT (gr);
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,44 +2566,31 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2080,104 +2602,55 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// going to write the actual routing table entries.  Its node was looked up
+// before the SPF calculation.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
+      NS_LOG_LOGIC ("Can't find root node " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << m_spfrootNodeId);
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.  The LSA of a transit network vertex gives the
+// network address and mask.
+//
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  NS_ASSERT (gr);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-      if (rtr == 0)
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrootNodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
         }
-    } 
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
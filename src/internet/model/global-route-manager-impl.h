@@ -26,7 +26,9 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
+#include <atomic>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
@@ -37,6 +39,7 @@ namespace ns3 {
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -674,13 +677,32 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+/**
+ * @brief Get the addresses of the Link State Advertisements, but the
+ * external ones.
+ *
+ * @returns the addresses the LSAs were inserted with, in increasing order.
+ */
+  std::vector<Ipv4Address> GetLinkStateIds (void) const;
+
+/**
+ * @brief Make a deep copy of the Link State Database.
+ *
+ * The copy holds its own copies of the LSAs, so that an SPF calculation
+ * can run on it while another one runs on the original database.
+ *
+ * @returns the new database, to be deleted by the caller.
+ */
+  GlobalRouteManagerLSDB* Copy (void) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
+  typedef std::map<Ipv4Address, LSDBPair_t> LinkDataIndex_t; //!< container of the LSAs by TransitNetwork link data
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  LinkDataIndex_t m_transitLinkData; //!< the first LSA (by address) holding each TransitNetwork link data
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -735,6 +757,27 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database, and recompute the routes of the
+ * nodes whose shortest path tree may be changed by the Link State
+ * Advertisements which changed since the routes were last computed.
+ *
+ * The shortest path tree of each node is kept from the previous
+ * computation.  A tree is recomputed if the LSA of its root, or of a
+ * neighbor of its root, changed, or if a changed link is on a shortest
+ * path of the tree, or could now shorten a path or reach a new vertex.
+ * A node whose tree is not affected but which reaches a changed LSA
+ * only has the routes to the addresses added to or removed from that
+ * LSA replaced, at the end of its routing table; its other routes are
+ * kept as they are.  The routes are then the ones of a full computation,
+ * possibly in a different order.
+ *
+ * If the routes were not computed from the current database (e.g.,
+ * after DeleteGlobalRoutes), this is equivalent to DeleteGlobalRoutes,
+ * BuildGlobalRoutingDatabase and InitializeRoutes.
+ */
+  virtual void RecomputeRoutingTables ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,8 +809,156 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /**
+   * \brief A router whose routes are computed.
+   *
+   * The node objects are looked up before the SPF calculations, which
+   * can then run concurrently on several threads.
+   */
+  struct SPFRoot
+  {
+    Ipv4Address routerId;           //!< the router ID
+    uint32_t nodeId;                //!< the node ID, for logging
+    Ptr<Ipv4> ipv4;                 //!< the Ipv4 of the node, 0 if not found
+    Ptr<Ipv4GlobalRouting> routing; //!< the routing protocol receiving the routes
+  };
+
+  /**
+   * \brief A vertex of a shortest path tree, as last computed.
+   */
+  struct SPFTreeVertex
+  {
+    uint32_t distance;                        //!< the distance from the root
+    uint32_t stubRank;                        //!< the order in which the stubs of the vertex were processed
+    std::vector<SPFVertex::NodeExit_t> exits; //!< the root exit directions
+  };
+
+  /**
+   * \brief The shortest path tree of a root, as last computed.
+   *
+   * The trees of all the roots are kept between the computations, hence
+   * the memory grows with the number of routers times the number of
+   * vertices they reach.
+   */
+  struct SPFTree
+  {
+    bool stub;                                     //!< true if the root is a stub node, without a tree
+    std::map<Ipv4Address, SPFTreeVertex> vertices; //!< the vertices, by vertex ID
+  };
+
+  /**
+   * \brief The differences between two versions of a Link State
+   * Advertisement.
+   */
+  struct LSAChange
+  {
+    Ipv4Address id; //!< the link state ID
+    /**
+     * The least metric of the edges to each vertex, before and after,
+     * SPF_INFINITY if there is none, for the vertices whose edges changed.
+     */
+    std::map<Ipv4Address, std::pair<uint32_t, uint32_t> > edges;
+    std::set<uint32_t> hosts; //!< the host addresses added or removed
+    std::set<std::pair<uint32_t, uint32_t> > networks; //!< the networks (address, mask) added or removed
+  };
+
+  /**
+   * \brief A set of roots shared by the threads computing their routes.
+   */
+  struct SPFJob
+  {
+    const std::vector<SPFRoot> *roots; //!< the roots
+    std::vector<SPFTree> *trees;       //!< the trees computed, by root index
+    std::atomic<uint32_t> next;        //!< the index of the next root to process
+  };
+
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Ipv4> m_spfrootIpv4; //!< the Ipv4 of the root node
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the routing protocol of the root node
+  uint32_t m_spfrootNodeId; //!< the ID of the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_routesComputed; //!< true if the routes of the nodes were computed from m_lsdb
+  SPFJob *m_job; //!< the roots processed by ProcessSPFJob
+  std::map<Ipv4Address, SPFTree> m_spfTrees; //!< the trees of the roots, by router ID
+  SPFTree *m_spfTree; //!< the tree recorded by SPFCalculate, or 0
+  uint32_t m_spfStubRank; //!< the rank of the next vertex whose stubs are processed
+
+  /**
+   * \brief Find the node of a router.
+   * \param routerId the router ID
+   * \returns the root, whose ipv4 is 0 if no node has the router ID
+   */
+  SPFRoot FindRoot (Ipv4Address routerId) const;
+
+  /**
+   * \brief Look up the objects of a router node.
+   * \param node the node
+   * \param rtr the GlobalRouter of the node
+   * \returns the root
+   */
+  SPFRoot MakeRoot (Ptr<Node> node, Ptr<GlobalRouter> rtr) const;
+
+  /**
+   * \brief Compute the routes of several roots.
+   *
+   * The roots are shared by up to GlobalRouteManagerThreadCount threads,
+   * each one working on its own copy of the LSDB.  Each root only
+   * receives its own routes, in the same order as with one thread.
+   *
+   * \param roots the roots
+   */
+  void ComputeRoutes (const std::vector<SPFRoot> &roots);
+
+  /**
+   * \brief Compute the routes of the roots of m_job until none is left.
+   */
+  void ProcessSPFJob (void);
+
+  /**
+   * \brief Compare the versions of a Link State Advertisement.
+   * \param previous the previous LSDB
+   * \param id the link state ID
+   * \returns the changes
+   */
+  LSAChange CompareLSA (const GlobalRouteManagerLSDB *previous, Ipv4Address id) const;
+
+  /**
+   * \brief Test if the previous shortest path tree of a root is changed
+   * by the changes of the LSAs.
+   * \param routerId the router ID of the root, whose LSA did not change
+   * \param tree the previous tree of the root
+   * \param changes the changes of the LSAs
+   * \returns true if the tree must be recomputed
+   */
+  bool IsTreeAffected (Ipv4Address routerId, const SPFTree &tree,
+                       const std::vector<LSAChange> &changes) const;
+
+  /**
+   * \brief Replace the routes of a root to the addresses added to or
+   * removed from some LSAs, using the exits of its previous tree.
+   * \param root the root
+   * \param tree the previous tree of the root, which is not affected
+   * by the changes
+   * \param changes the changes of the LSAs in the tree
+   * \param hosts the IDs of the LSAs having each host address of the changes
+   * \param networks the IDs of the LSAs having each network of the changes
+   */
+  void UpdateRoutes (const SPFRoot &root, const SPFTree &tree,
+                     const std::vector<const LSAChange *> &changes,
+                     const std::map<uint32_t, std::vector<Ipv4Address> > &hosts,
+                     const std::map<std::pair<uint32_t, uint32_t>, std::vector<Ipv4Address> > &networks) const;
+
+  /**
+   * \brief Record a vertex in the tree of the root, if any.
+   * \param v the vertex, whose exit directions are known
+   */
+  void SPFRecordVertex (SPFVertex *v);
+
+  /**
+   * \brief Delete the routes of a node.
+   * \param routing the routing protocol of the node
+   */
+  static void DeleteRoutes (Ptr<Ipv4GlobalRouting> routing);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -787,7 +978,7 @@ private:
    * Equivalent to quagga ospf_spf_calculate
    * \param root the root node
    */
-  void SPFCalculate (Ipv4Address root);
+  void SPFCalculate (const SPFRoot &root);
 
   /**
    * \brief Process Stub nodes
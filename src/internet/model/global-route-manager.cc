@@ -58,6 +58,14 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::RecomputeRoutingTables (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  RecomputeRoutingTables ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
@@ -65,6 +65,16 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes of the
+ * nodes affected by the changes of the topology since the routes were
+ * last computed.
+ *
+ * The routes of the other nodes are kept as they are.  If the routes
+ * were not computed yet, all the routes are computed.
+ */
+  static void RecomputeRoutingTables ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
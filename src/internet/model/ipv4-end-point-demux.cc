@@ -40,23 +40,36 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_listeners.clear ();
+  m_ports.clear ();
+}
+
+bool
+Ipv4EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+std::size_t
+Ipv4EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  std::size_t h = tuple.localAddress.Get ();
+  h = h * 31 + tuple.peerAddress.Get ();
+  h = h * 31 + ((tuple.localPort << 16) | tuple.peerPort);
+  return h ^ (h >> 17);
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
@@ -85,10 +98,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -101,10 +111,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -124,10 +131,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       NS_LOG_WARN ("Duplicated endpoint.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -136,27 +140,90 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  FourTuple tuple = { localAddress, localPort, peerAddress, peerPort };
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPoints::const_iterator i = t->second.begin (); i != t->second.end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0)
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  return Insert (endPoint);
+}
 
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
   return endPoint;
 }
 
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  FourTuple tuple = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                      endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+  m_tuples[tuple].push_back (endPoint);
+  if (tuple.peerAddress == Ipv4Address::GetAny () && tuple.peerPort == 0)
+    {
+      m_listeners[tuple.localPort].push_back (endPoint);
+    }
+  m_ports[tuple.localPort]++;
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  FourTuple tuple = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                      endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+  TupleIndex::iterator t = m_tuples.find (tuple);
+  NS_ASSERT (t != m_tuples.end ());
+  t->second.remove (endPoint);
+  if (t->second.empty ())
+    {
+      m_tuples.erase (t);
+    }
+  if (tuple.peerAddress == Ipv4Address::GetAny () && tuple.peerPort == 0)
+    {
+      PortIndex::iterator l = m_listeners.find (tuple.localPort);
+      NS_ASSERT (l != m_listeners.end ());
+      l->second.remove (endPoint);
+      if (l->second.empty ())
+        {
+          m_listeners.erase (l);
+        }
+    }
+  std::unordered_map<uint16_t, uint32_t>::iterator p = m_ports.find (tuple.localPort);
+  NS_ASSERT (p != m_ports.end ());
+  if (--p->second == 0)
+    {
+      m_ports.erase (p);
+    }
+}
+
+void
+Ipv4EndPointDemux::AddEndPoints (const FourTuple &tuple, EndPoints &endPoints) const
+{
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
+    {
+      endPoints.insert (endPoints.end (), t->second.begin (), t->second.end ());
+    }
+}
+
 void 
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
@@ -165,6 +232,8 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -208,7 +277,44 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+
+  // The only endpoints which can match are the ones with the four-tuple of
+  // the packet, possibly with a wildcard local address, and the ones with
+  // no peer.
+  EndPoints candidates;
+  if (saddr != Ipv4Address::GetAny () || sport != 0)
+    {
+      FourTuple tuple = { daddr, dport, saddr, sport };
+      AddEndPoints (tuple, candidates);
+      if (daddr != Ipv4Address::GetAny ())
+        {
+          tuple.localAddress = Ipv4Address::GetAny ();
+          AddEndPoints (tuple, candidates);
+        }
+      for (uint32_t i = 0; incomingInterface && i < incomingInterface->GetNAddresses (); i++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+          Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+          bool known = addrNetpart == daddr || addrNetpart == Ipv4Address::GetAny ();
+          for (uint32_t j = 0; j < i && !known; j++)
+            {
+              Ipv4InterfaceAddress other = incomingInterface->GetAddress (j);
+              known = other.GetLocal ().CombineMask (other.GetMask ()) == addrNetpart;
+            }
+          if (!known)
+            {
+              tuple.localAddress = addrNetpart;
+              AddEndPoints (tuple, candidates);
+            }
+        }
+    }
+  PortIndex::const_iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates.insert (candidates.end (), listeners->second.begin (), listeners->second.end ());
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -343,6 +449,14 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  FourTuple tuple = { daddr, dport, saddr, sport };
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
+    {
+      /* this is an exact match. */
+      return t->second.front ();
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
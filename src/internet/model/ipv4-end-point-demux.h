@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +41,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by four-tuple, and the endpoints with no peer
+ * are also indexed by local port, so that looking up the endpoint of a
+ * packet does not depend on the number of connections of the node.  The
+ * endpoints notify the demux when their addresses change.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +172,72 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of an end point.
+   */
+  struct FourTuple
+  {
+    Ipv4Address localAddress; //!< The local address
+    uint16_t localPort;       //!< The local port
+    Ipv4Address peerAddress;  //!< The peer address
+    uint16_t peerPort;        //!< The peer port
+
+    /**
+     * \param other the four-tuple to compare to
+     * \returns true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param tuple the four-tuple
+     * \returns the hash of the four-tuple
+     */
+    std::size_t operator() (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief Container of the IPv4 endpoints, by four-tuple.
+   */
+  typedef std::unordered_map<FourTuple, EndPoints, FourTupleHash> TupleIndex;
+
+  /**
+   * \brief Container of the IPv4 endpoints, by local port.
+   */
+  typedef std::unordered_map<uint16_t, EndPoints> PortIndex;
+
+  /**
+   * \brief Add an end point to the demux.
+   * \param endPoint the new end point
+   * \returns the end point
+   */
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indices.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indices.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add the end points with a four-tuple to a list.
+   * \param tuple the four-tuple
+   * \param endPoints the list
+   */
+  void AddEndPoints (const FourTuple &tuple, EndPoints &endPoints) const;
 
   /**
    * \brief Allocate an ephemeral port.
@@ -192,6 +264,21 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by four-tuple.
+   */
+  TupleIndex m_tuples;
+
+  /**
+   * \brief The IPv4 end points with no peer, by local port.
+   */
+  PortIndex m_listeners;
+
+  /**
+   * \brief The number of IPv4 end points, by local port.
+   */
+  std::unordered_map<uint16_t, uint32_t> m_ports;
 };
 
 } // namespace ns3
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <iomanip>
+#include <algorithm>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -59,7 +60,9 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_fibValid (false),
+    m_fibContiguous (true)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +83,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_fibValid = false;
 }
 
 void 
@@ -90,6 +94,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_fibValid = false;
 }
 
 void 
@@ -105,6 +110,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibValid = false;
 }
 
 void 
@@ -118,6 +124,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibValid = false;
 }
 
 void 
@@ -133,6 +140,7 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_fibValid = false;
 }
 
 
@@ -146,71 +154,148 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
-  NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  if (!m_fibValid)
+    {
+      BuildFib ();
+    }
+  if (m_fibContiguous)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      // the forwarding tables hold the indices of the routes in the
+      // lists, so that the routes are considered in the same order as
+      // by a walk of the lists
+      const Ipv4PrefixTrie::Values *matches[33];
+      if (m_hostFib.Lookup (dest, matches) > 0)
         {
-          if (oif != 0)
+          // only host routes, hence only exact matches, in m_hostFib
+          for (Ipv4PrefixTrie::Values::const_iterator i = matches[0]->begin ();
+               i != matches[0]->end (); i++)
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
+              Ipv4RoutingTableEntry *route = m_hostFibRoutes[*i];
+              if (oif != 0 && oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
                   NS_LOG_LOGIC ("Not on requested interface, skipping");
                   continue;
                 }
+              allRoutes.push_back (route);
+              NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << route);
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
-    }
-  if (allRoutes.size () == 0) // if no host route is found
-    {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      if (allRoutes.size () == 0) // if no host route is found
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          // all the matching network routes are eligible, whatever
+          // their prefix length
+          std::vector<uint32_t> indices;
+          uint32_t n = m_networkFib.Lookup (dest, matches);
+          for (uint32_t i = 0; i < n; i++)
             {
-              if (oif != 0)
+              indices.insert (indices.end (), matches[i]->begin (), matches[i]->end ());
+            }
+          std::sort (indices.begin (), indices.end ());
+          for (std::vector<uint32_t>::const_iterator j = indices.begin (); j != indices.end (); j++)
+            {
+              Ipv4RoutingTableEntry *route = m_networkFibRoutes[*j];
+              if (oif != 0 && oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
+                }
+              allRoutes.push_back (route);
+              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << route);
+            }
+        }
+      if (allRoutes.size () == 0)  // consider external if no host/network found
+        {
+          // the first matching external route is used
+          uint32_t first = m_externalFibRoutes.size ();
+          uint32_t n = m_externalFib.Lookup (dest, matches);
+          for (uint32_t i = 0; i < n; i++)
+            {
+              for (Ipv4PrefixTrie::Values::const_iterator k = matches[i]->begin ();
+                   k != matches[i]->end () && *k < first; k++)
+                {
+                  Ipv4RoutingTableEntry *route = m_externalFibRoutes[*k];
+                  if (oif != 0 && oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                     {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
                       continue;
                     }
+                  first = *k;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
+            }
+          if (first < m_externalFibRoutes.size ())
+            {
+              NS_LOG_LOGIC ("Found external route" << m_externalFibRoutes[first]);
+              allRoutes.push_back (m_externalFibRoutes[first]);
             }
         }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  else
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
+      for (HostRoutesCI i = m_hostRoutes.begin (); 
+           i != m_hostRoutes.end (); 
+           i++) 
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          NS_ASSERT ((*i)->IsHost ());
+          if ((*i)->GetDest ().IsEqual (dest)) 
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
               if (oif != 0)
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
+                  if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
                     {
                       NS_LOG_LOGIC ("Not on requested interface, skipping");
                       continue;
                     }
                 }
-              allRoutes.push_back (*k);
-              break;
+              allRoutes.push_back (*i);
+              NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
+            }
+        }
+      if (allRoutes.size () == 0) // if no host route is found
+        {
+          NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
+          for (NetworkRoutesI j = m_networkRoutes.begin (); 
+               j != m_networkRoutes.end (); 
+               j++) 
+            {
+              Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+              Ipv4Address entry = (*j)->GetDestNetwork ();
+              if (mask.IsMatch (dest, entry)) 
+                {
+                  if (oif != 0)
+                    {
+                      if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
+                        {
+                          NS_LOG_LOGIC ("Not on requested interface, skipping");
+                          continue;
+                        }
+                    }
+                  allRoutes.push_back (*j);
+                  NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
+                }
+            }
+        }
+      if (allRoutes.size () == 0)  // consider external if no host/network found
+        {
+          for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
+               k != m_ASexternalRoutes.end ();
+               k++)
+            {
+              Ipv4Mask mask = (*k)->GetDestNetworkMask ();
+              Ipv4Address entry = (*k)->GetDestNetwork ();
+              if (mask.IsMatch (dest, entry))
+                {
+                  NS_LOG_LOGIC ("Found external route" << *k);
+                  if (oif != 0)
+                    {
+                      if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
+                        {
+                          NS_LOG_LOGIC ("Not on requested interface, skipping");
+                          continue;
+                        }
+                    }
+                  allRoutes.push_back (*k);
+                  break;
+                }
             }
         }
     }
@@ -321,6 +406,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
               delete *i;
               m_hostRoutes.erase (i);
+              m_fibValid = false;
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -338,6 +424,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
           delete *j;
           m_networkRoutes.erase (j);
+          m_fibValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -354,6 +441,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
           delete *k;
           m_ASexternalRoutes.erase (k);
+          m_fibValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -362,6 +450,46 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+void
+Ipv4GlobalRouting::BuildFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hostFib.Clear ();
+  m_hostFibRoutes.assign (m_hostRoutes.begin (), m_hostRoutes.end ());
+  for (uint32_t i = 0; i < m_hostFibRoutes.size (); i++)
+    {
+      m_hostFib.Insert (m_hostFibRoutes[i]->GetDest (), Ipv4Mask::GetOnes (), i);
+    }
+  m_fibContiguous = true;
+  m_networkFib.Clear ();
+  m_networkFibRoutes.assign (m_networkRoutes.begin (), m_networkRoutes.end ());
+  for (uint32_t i = 0; i < m_networkFibRoutes.size () && m_fibContiguous; i++)
+    {
+      Ipv4Mask mask = m_networkFibRoutes[i]->GetDestNetworkMask ();
+      m_fibContiguous = Ipv4PrefixTrie::IsContiguous (mask);
+      if (m_fibContiguous)
+        {
+          m_networkFib.Insert (m_networkFibRoutes[i]->GetDestNetwork (), mask, i);
+        }
+    }
+  m_externalFib.Clear ();
+  m_externalFibRoutes.assign (m_ASexternalRoutes.begin (), m_ASexternalRoutes.end ());
+  for (uint32_t i = 0; i < m_externalFibRoutes.size () && m_fibContiguous; i++)
+    {
+      Ipv4Mask mask = m_externalFibRoutes[i]->GetDestNetworkMask ();
+      m_fibContiguous = Ipv4PrefixTrie::IsContiguous (mask);
+      if (m_fibContiguous)
+        {
+          m_externalFib.Insert (m_externalFibRoutes[i]->GetDestNetwork (), mask, i);
+        }
+    }
+  NS_LOG_LOGIC ("Forwarding tables: " << m_hostFib.GetNPrefixes () << " hosts, "
+                << m_networkFib.GetNPrefixes () << " networks, "
+                << m_externalFib.GetNPrefixes () << " external networks"
+                << (m_fibContiguous ? "" : ", not used (non contiguous mask)"));
+  m_fibValid = true;
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -392,6 +520,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_fibValid = false;
+  m_hostFibRoutes.clear ();
+  m_networkFibRoutes.clear ();
+  m_externalFibRoutes.clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +669,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -549,9 +679,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -561,9 +689,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -573,9 +699,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
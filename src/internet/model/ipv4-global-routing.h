@@ -27,6 +27,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 #include "ns3/random-variable-stream.h"
 
 namespace ns3 {
@@ -268,10 +269,27 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Rebuild the forwarding tables from the routes.
+   */
+  void BuildFib (void);
+
+  /// container of the routes indexed by a forwarding table
+  typedef std::vector<Ipv4RoutingTableEntry *> FibRoutes;
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  bool m_fibValid;               //!< true if the forwarding tables reflect the routes
+  bool m_fibContiguous;          //!< false if a route has a non contiguous mask
+  Ipv4PrefixTrie m_hostFib;      //!< Forwarding table of the routes to hosts
+  FibRoutes m_hostFibRoutes;     //!< Routes to hosts, by index in m_hostFib
+  Ipv4PrefixTrie m_networkFib;   //!< Forwarding table of the routes to networks
+  FibRoutes m_networkFibRoutes;  //!< Routes to networks, by index in m_networkFib
+  Ipv4PrefixTrie m_externalFib;  //!< Forwarding table of the external routes
+  FibRoutes m_externalFibRoutes; //!< External routes, by index in m_externalFib
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -32,7 +32,9 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/tso-tag.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/queue-disc.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -41,6 +43,7 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "tcp-l4-protocol.h"
 
 namespace ns3 {
 
@@ -924,12 +927,41 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  TsoTag tsoTag;
+  if (packet->PeekPacketTag (tsoTag))
+    {
+      // A queue disc or a device which cannot take the super-segment as a
+      // whole gets the segments, so that drops and marks hit single segments
+      Ptr<TrafficControlLayer> tc = m_node->GetObject<TrafficControlLayer> ();
+      uint32_t size = tsoTag.GetWireSize (packet->GetSize () + ipHeader.GetSerializedSize ());
+      if (ipHeader.GetProtocol () == TcpL4Protocol::PROT_NUMBER
+          && ((tc != 0 && tc->GetRootQueueDiscOnDevice (outDev) != 0)
+              || !outDev->SupportsSegmentationOffload (size)))
+        {
+          NS_LOG_LOGIC ("Split the TCP super-segment into segments");
+          std::list<Ptr<Packet> > segments = TcpL4Protocol::Segment (packet, ipHeader.GetSource (),
+                                                                     ipHeader.GetDestination ());
+          uint16_t identification = ipHeader.GetIdentification ();
+          for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); it++)
+            {
+              Ipv4Header segmentHeader = ipHeader;
+              segmentHeader.SetPayloadSize ((*it)->GetSize ());
+              segmentHeader.SetIdentification (identification++);
+              SendRealOut (route, *it, segmentHeader);
+            }
+          return;
+        }
+      NS_LOG_LOGIC ("The device segments the TCP super-segment");
+    }
+  bool fragment = !packet->PeekPacketTag (tsoTag)
+    && packet->GetSize () + ipHeader.GetSerializedSize () > outDev->GetMtu ();
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (fragment)
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -956,7 +988,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (fragment)
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ipv4-prefix-trie.h"
+#include <algorithm>
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4PrefixTrie");
+
+Ipv4PrefixTrie::Ipv4PrefixTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+Ipv4PrefixTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nodes.clear ();
+  m_nPrefixes = 0;
+  // the root is the empty prefix, which matches every address
+  NewNode (0, 0);
+}
+
+uint32_t
+Ipv4PrefixTrie::Mask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+uint32_t
+Ipv4PrefixTrie::Bit (uint32_t address, uint8_t position)
+{
+  return (address >> (31 - position)) & 1;
+}
+
+bool
+Ipv4PrefixTrie::IsContiguous (Ipv4Mask mask)
+{
+  return Mask (mask.GetPrefixLength ()) == mask.Get ();
+}
+
+int32_t
+Ipv4PrefixTrie::NewNode (uint32_t prefix, uint8_t length)
+{
+  Node node;
+  node.prefix = prefix;
+  node.length = length;
+  node.child[0] = -1;
+  node.child[1] = -1;
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+void
+Ipv4PrefixTrie::Insert (Ipv4Address network, Ipv4Mask mask, uint32_t value)
+{
+  NS_LOG_FUNCTION (this << network << mask << value);
+  NS_ASSERT_MSG (IsContiguous (mask), "Non contiguous mask " << mask);
+  uint8_t length = mask.GetPrefixLength ();
+  uint32_t prefix = network.Get () & Mask (length);
+
+  int32_t current = 0;
+  while (m_nodes[current].length != length || m_nodes[current].prefix != prefix)
+    {
+      // the current node is a strict prefix of the new one
+      uint32_t bit = Bit (prefix, m_nodes[current].length);
+      int32_t c = m_nodes[current].child[bit];
+      if (c < 0)
+        {
+          int32_t leaf = NewNode (prefix, length);
+          m_nodes[current].child[bit] = leaf;
+          current = leaf;
+          break;
+        }
+      uint8_t childLength = m_nodes[c].length;
+      uint32_t childPrefix = m_nodes[c].prefix;
+      // length of the common prefix of the child and of the new prefix
+      uint8_t common = m_nodes[current].length + 1;
+      uint8_t maxCommon = std::min (childLength, length);
+      while (common < maxCommon && Bit (childPrefix, common) == Bit (prefix, common))
+        {
+          common++;
+        }
+      if (common == childLength)
+        {
+          current = c;
+          continue;
+        }
+      // split the edge to the child
+      int32_t split = NewNode (prefix & Mask (common), common);
+      m_nodes[split].child[Bit (childPrefix, common)] = c;
+      m_nodes[current].child[bit] = split;
+      if (common != length)
+        {
+          int32_t leaf = NewNode (prefix, length);
+          m_nodes[split].child[Bit (prefix, common)] = leaf;
+          current = leaf;
+        }
+      else
+        {
+          current = split;
+        }
+      break;
+    }
+  if (m_nodes[current].values.empty ())
+    {
+      m_nPrefixes++;
+    }
+  m_nodes[current].values.push_back (value);
+}
+
+uint32_t
+Ipv4PrefixTrie::Lookup (Ipv4Address dest, const Values *matches[33]) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  uint32_t address = dest.Get ();
+  const Values *path[33];
+  uint32_t n = 0;
+  int32_t current = 0;
+  while (true)
+    {
+      const Node &node = m_nodes[current];
+      if ((address & Mask (node.length)) != node.prefix)
+        {
+          break;
+        }
+      if (!node.values.empty ())
+        {
+          path[n] = &node.values;
+          n++;
+        }
+      if (node.length == 32)
+        {
+          break;
+        }
+      current = node.child[Bit (address, node.length)];
+      if (current < 0)
+        {
+          break;
+        }
+    }
+  // the walk visits the shortest prefixes first
+  for (uint32_t i = 0; i < n; i++)
+    {
+      matches[i] = path[n - 1 - i];
+    }
+  return n;
+}
+
+uint32_t
+Ipv4PrefixTrie::GetNPrefixes (void) const
+{
+  return m_nPrefixes;
+}
+
+} // namespace ns3
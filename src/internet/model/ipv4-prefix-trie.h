@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief A path-compressed binary trie of IPv4 prefixes, used as the
+ * forwarding table of Ipv4GlobalRouting and Ipv4StaticRouting.
+ *
+ * Each prefix holds the list of the values (typically, the indices of
+ * the routes in the routing table) which were inserted with it, in
+ * insertion order.  A lookup walks at most 33 nodes, whatever the
+ * number of prefixes, and returns the values of all the prefixes
+ * matching an address, from the longest prefix to the shortest one, so
+ * that the routing protocols can apply their own tie-breaking rules.
+ *
+ * The trie does not support the removal of a prefix: the routing
+ * protocols rebuild it after the routing table changes.  Only
+ * contiguous masks can be inserted, see IsContiguous.
+ */
+class Ipv4PrefixTrie
+{
+public:
+  /** The values of a prefix, in insertion order. */
+  typedef std::vector<uint32_t> Values;
+
+  Ipv4PrefixTrie ();
+
+  /**
+   * \brief Remove all the prefixes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Add a value to a prefix.
+   * \param network the network address, bits outside of the mask are ignored
+   * \param mask the network mask, which must be contiguous
+   * \param value the value
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, uint32_t value);
+
+  /**
+   * \brief Find the prefixes matching an address.
+   * \param dest the address
+   * \param [out] matches the values of the matching prefixes, from the
+   * longest prefix to the shortest one; only the prefixes holding
+   * values are reported
+   * \returns the number of matching prefixes
+   */
+  uint32_t Lookup (Ipv4Address dest, const Values *matches[33]) const;
+
+  /**
+   * \returns the number of prefixes holding values
+   */
+  uint32_t GetNPrefixes (void) const;
+
+  /**
+   * \param mask a network mask
+   * \returns true if the mask is made of leading ones only
+   */
+  static bool IsContiguous (Ipv4Mask mask);
+
+private:
+  /** A node of the trie. */
+  struct Node
+  {
+    uint32_t prefix;   //!< The prefix, with the bits beyond length cleared
+    uint8_t length;    //!< The prefix length
+    int32_t child[2];  //!< The indices of the children, -1 if none
+    Values values;     //!< The values of the prefix, if any
+  };
+
+  /**
+   * \param length a prefix length
+   * \returns the mask of the length
+   */
+  static uint32_t Mask (uint8_t length);
+  /**
+   * \param address an address
+   * \param position the position of the bit, 0 for the most significant bit
+   * \returns the bit of the address at the position
+   */
+  static uint32_t Bit (uint32_t address, uint8_t position);
+  /**
+   * \param prefix the prefix
+   * \param length the prefix length
+   * \returns the index of the new node
+   */
+  int32_t NewNode (uint32_t prefix, uint8_t length);
+
+  std::vector<Node> m_nodes; //!< The nodes, the root being the first one
+  uint32_t m_nPrefixes;      //!< The number of prefixes holding values
+};
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
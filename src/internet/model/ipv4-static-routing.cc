@@ -54,7 +54,9 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_fibValid (false),
+    m_fibContiguous (true),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +75,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_fibValid = false;
 }
 
 void 
@@ -87,6 +90,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_fibValid = false;
 }
 
 void 
@@ -144,6 +148,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_fibValid = false;
 }
 
 uint32_t 
@@ -239,54 +244,104 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
-
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
-       i++) 
+  if (!m_fibValid)
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
-      Ipv4Mask mask = (j)->GetDestNetworkMask ();
-      uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      BuildFib ();
+    }
+  if (m_fibContiguous)
+    {
+      // Among the matching routes with the longest mask, select the
+      // first host route, or else the last route with the smallest
+      // metric, as the walk of the list below does
+      const Ipv4PrefixTrie::Values *matches[33];
+      uint32_t n = m_fib.Lookup (dest, matches);
+      for (uint32_t i = 0; i < n && rtentry == 0; i++)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
-          if (oif != 0)
+          Ipv4RoutingTableEntry *route = 0;
+          for (Ipv4PrefixTrie::Values::const_iterator k = matches[i]->begin ();
+               k != matches[i]->end (); k++)
             {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
+              Ipv4RoutingTableEntry *j = m_fibRoutes[*k].first;
+              uint32_t metric = m_fibRoutes[*k].second;
+              if (oif != 0 && oif != m_ipv4->GetNetDevice (j->GetInterface ()))
                 {
                   NS_LOG_LOGIC ("Not on requested interface, skipping");
                   continue;
                 }
+              if (metric > shortest_metric)
+                {
+                  NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+                  continue;
+                }
+              shortest_metric = metric;
+              route = j;
+              if (j->GetDestNetworkMask ().GetPrefixLength () == 32)
+                {
+                  break;
+                }
             }
-          if (masklen < longest_mask) // Not interested if got shorter mask
-            {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
-              continue;
-            }
-          if (masklen > longest_mask) // Reset metric if longer masklen
-            {
-              shortest_metric = 0xffffffff;
-            }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
+          if (route != 0)
             {
-              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
-              continue;
+              uint32_t interfaceIdx = route->GetInterface ();
+              NS_LOG_LOGIC ("Found global network route " << route << ", metric " << shortest_metric);
+              rtentry = Create<Ipv4Route> ();
+              rtentry->SetDestination (route->GetDest ());
+              rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+              rtentry->SetGateway (route->GetGateway ());
+              rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
             }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-          if (masklen == 32)
+        }
+    }
+  else
+    {
+      for (NetworkRoutesI i = m_networkRoutes.begin (); 
+           i != m_networkRoutes.end (); 
+           i++) 
+        {
+          Ipv4RoutingTableEntry *j=i->first;
+          uint32_t metric =i->second;
+          Ipv4Mask mask = (j)->GetDestNetworkMask ();
+          uint16_t masklen = mask.GetPrefixLength ();
+          Ipv4Address entry = (j)->GetDestNetwork ();
+          NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
+          if (mask.IsMatch (dest, entry)) 
             {
-              break;
+              NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+              if (oif != 0)
+                {
+                  if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
+                    {
+                      NS_LOG_LOGIC ("Not on requested interface, skipping");
+                      continue;
+                    }
+                }
+              if (masklen < longest_mask) // Not interested if got shorter mask
+                {
+                  NS_LOG_LOGIC ("Previous match longer, skipping");
+                  continue;
+                }
+              if (masklen > longest_mask) // Reset metric if longer masklen
+                {
+                  shortest_metric = 0xffffffff;
+                }
+              longest_mask = masklen;
+              if (metric > shortest_metric)
+                {
+                  NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+                  continue;
+                }
+              shortest_metric = metric;
+              Ipv4RoutingTableEntry* route = (j);
+              uint32_t interfaceIdx = route->GetInterface ();
+              rtentry = Create<Ipv4Route> ();
+              rtentry->SetDestination (route->GetDest ());
+              rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+              rtentry->SetGateway (route->GetGateway ());
+              rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+              if (masklen == 32)
+                {
+                  break;
+                }
             }
         }
     }
@@ -353,6 +408,27 @@ Ipv4StaticRouting::LookupStatic (
   return mrtentry;
 }
 
+void
+Ipv4StaticRouting::BuildFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_fib.Clear ();
+  m_fibRoutes.assign (m_networkRoutes.begin (), m_networkRoutes.end ());
+  m_fibContiguous = true;
+  for (uint32_t i = 0; i < m_fibRoutes.size () && m_fibContiguous; i++)
+    {
+      Ipv4Mask mask = m_fibRoutes[i].first->GetDestNetworkMask ();
+      m_fibContiguous = Ipv4PrefixTrie::IsContiguous (mask);
+      if (m_fibContiguous)
+        {
+          m_fib.Insert (m_fibRoutes[i].first->GetDestNetwork (), mask, i);
+        }
+    }
+  NS_LOG_LOGIC ("Forwarding table: " << m_fib.GetNPrefixes () << " prefixes"
+                << (m_fibContiguous ? "" : ", not used (non contiguous mask)"));
+  m_fibValid = true;
+}
+
 uint32_t 
 Ipv4StaticRouting::GetNRoutes (void) const
 {
@@ -449,6 +525,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_fibValid = false;
           return;
         }
       tmp++;
@@ -575,6 +652,8 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_fibValid = false;
+  m_fibRoutes.clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -615,6 +694,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_fibValid = false;
         }
       else
         {
@@ -662,6 +742,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_fibValid = false;
         }
       else
         {
@@ -24,6 +24,7 @@
 
 #include <list>
 #include <utility>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -31,6 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -413,11 +415,38 @@ private:
   Ptr<Ipv4MulticastRoute> LookupStatic (Ipv4Address origin, Ipv4Address group,
                                         uint32_t interface);
 
+  /**
+   * \brief Rebuild the longest prefix match table from the routes.
+   */
+  void BuildFib (void);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief true if m_fib reflects m_networkRoutes.
+   */
+  bool m_fibValid;
+
+  /**
+   * \brief false if a route has a non contiguous mask, in which case
+   * m_fib is not used.
+   */
+  bool m_fibContiguous;
+
+  /**
+   * \brief the longest prefix match table of m_networkRoutes, holding
+   * the indices of the routes in m_fibRoutes.
+   */
+  Ipv4PrefixTrie m_fib;
+
+  /**
+   * \brief the routes of m_networkRoutes, in the same order.
+   */
+  std::vector<std::pair <Ipv4RoutingTableEntry *, uint32_t> > m_fibRoutes;
+
   /**
    * \brief the forwarding table for multicast.
    */
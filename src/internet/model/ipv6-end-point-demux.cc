@@ -40,22 +40,34 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_listeners.clear ();
+  m_ports.clear ();
+}
+
+bool Ipv6EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+std::size_t Ipv6EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  Ipv6AddressHash hasher;
+  std::size_t h = hasher (tuple.localAddress);
+  h = h * 31 + hasher (tuple.peerAddress);
+  h = h * 31 + ((tuple.localPort << 16) | tuple.peerPort);
+  return h ^ (h >> 17);
 }
 
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
@@ -82,10 +94,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (Ipv6Address::GetAny (), port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
@@ -97,10 +106,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, uint16_t port)
@@ -118,10 +124,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       NS_LOG_WARN ("Duplicated endpoint.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
@@ -129,27 +132,86 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  FourTuple tuple = { localAddress, localPort, peerAddress, peerPort };
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPoints::const_iterator i = t->second.begin (); i != t->second.end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0)
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  return Insert (endPoint);
+}
 
+Ipv6EndPoint* Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
   return endPoint;
 }
 
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  FourTuple tuple = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                      endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+  m_tuples[tuple].push_back (endPoint);
+  if (tuple.peerAddress == Ipv6Address::GetAny () && tuple.peerPort == 0)
+    {
+      m_listeners[tuple.localPort].push_back (endPoint);
+    }
+  m_ports[tuple.localPort]++;
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  FourTuple tuple = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                      endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+  TupleIndex::iterator t = m_tuples.find (tuple);
+  NS_ASSERT (t != m_tuples.end ());
+  t->second.remove (endPoint);
+  if (t->second.empty ())
+    {
+      m_tuples.erase (t);
+    }
+  if (tuple.peerAddress == Ipv6Address::GetAny () && tuple.peerPort == 0)
+    {
+      PortIndex::iterator l = m_listeners.find (tuple.localPort);
+      NS_ASSERT (l != m_listeners.end ());
+      l->second.remove (endPoint);
+      if (l->second.empty ())
+        {
+          m_listeners.erase (l);
+        }
+    }
+  std::unordered_map<uint16_t, uint32_t>::iterator p = m_ports.find (tuple.localPort);
+  NS_ASSERT (p != m_ports.end ());
+  if (--p->second == 0)
+    {
+      m_ports.erase (p);
+    }
+}
+
+void Ipv6EndPointDemux::AddEndPoints (const FourTuple &tuple, EndPoints &endPoints) const
+{
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
+    {
+      endPoints.insert (endPoints.end (), t->second.begin (), t->second.end ());
+    }
+}
+
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this);
@@ -157,6 +219,8 @@ void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -181,7 +245,28 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* The only endpoints which can match are the ones with the four-tuple of
+     the packet, possibly with a wildcard local address, and the ones with
+     no peer. */
+  EndPoints candidates;
+  if (saddr != Ipv6Address::GetAny () || sport != 0)
+    {
+      FourTuple tuple = { daddr, dport, saddr, sport };
+      AddEndPoints (tuple, candidates);
+      if (daddr != Ipv6Address::GetAny ())
+        {
+          tuple.localAddress = Ipv6Address::GetAny ();
+          AddEndPoints (tuple, candidates);
+        }
+    }
+  PortIndex::const_iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates.insert (candidates.end (), listeners->second.begin (), listeners->second.end ());
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -290,6 +375,14 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  FourTuple tuple = { dst, dport, src, sport };
+  TupleIndex::const_iterator t = m_tuples.find (tuple);
+  if (t != m_tuples.end ())
+    {
+      /* this is an exact match. */
+      return t->second.front ();
+    }
+
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +35,11 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The endpoints are indexed by four-tuple, and the endpoints with no peer
+ * are also indexed by local port, so that looking up the endpoint of a
+ * packet does not depend on the number of connections of the node.  The
+ * endpoints notify the demux when their addresses or port change.
  */
 class Ipv6EndPointDemux
 {
@@ -153,6 +159,73 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple of an end point.
+   */
+  struct FourTuple
+  {
+    Ipv6Address localAddress; //!< The local address
+    uint16_t localPort;       //!< The local port
+    Ipv6Address peerAddress;  //!< The peer address
+    uint16_t peerPort;        //!< The peer port
+
+    /**
+     * \param other the four-tuple to compare to
+     * \returns true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param tuple the four-tuple
+     * \returns the hash of the four-tuple
+     */
+    std::size_t operator() (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief Container of the IPv6 endpoints, by four-tuple.
+   */
+  typedef std::unordered_map<FourTuple, EndPoints, FourTupleHash> TupleIndex;
+
+  /**
+   * \brief Container of the IPv6 endpoints, by local port.
+   */
+  typedef std::unordered_map<uint16_t, EndPoints> PortIndex;
+
+  /**
+   * \brief Add an end point to the demux.
+   * \param endPoint the new end point
+   * \return the end point
+   */
+  Ipv6EndPoint* Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indices.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indices.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add the end points with a four-tuple to a list.
+   * \param tuple the four-tuple
+   * \param endPoints the list
+   */
+  void AddEndPoints (const FourTuple &tuple, EndPoints &endPoints) const;
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -178,6 +251,21 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv6 end points, by four-tuple.
+   */
+  TupleIndex m_tuples;
+
+  /**
+   * \brief The IPv6 end points with no peer, by local port.
+   */
+  PortIndex m_listeners;
+
+  /**
+   * \brief The number of IPv6 end points, by local port.
+   */
+  std::unordered_map<uint16_t, uint32_t> m_ports;
 };
 
 } /* namespace ns3 */
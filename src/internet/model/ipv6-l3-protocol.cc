@@ -31,6 +31,8 @@
 #include "ns3/mac16-address.h"
 #include "ns3/mac64-address.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/queue-disc.h"
+#include "ns3/tso-tag.h"
 
 #include "loopback-net-device.h"
 #include "ipv6-l3-protocol.h"
@@ -44,6 +46,7 @@
 #include "ipv6-option.h"
 #include "icmpv6-l4-protocol.h"
 #include "ndisc-cache.h"
+#include "tcp-l4-protocol.h"
 
 /// Minimum IPv6 MTU, as defined by \RFC{2460}
 #define IPV6_MIN_MTU 1280
@@ -1125,7 +1128,34 @@ void Ipv6L3Protocol::SendRealOut (Ptr<Ipv6Route> route, Ptr<Packet> packet, Ipv6
       targetMtu = dev->GetMtu ();
     }
 
-  if (packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
+  TsoTag tsoTag;
+  if (packet->PeekPacketTag (tsoTag))
+    {
+      // A queue disc or a device which cannot take the super-segment as a
+      // whole gets the segments, so that drops and marks hit single segments
+      Ptr<TrafficControlLayer> tc = m_node->GetObject<TrafficControlLayer> ();
+      uint32_t size = tsoTag.GetWireSize (packet->GetSize () + ipHeader.GetSerializedSize ());
+      if (ipHeader.GetNextHeader () == TcpL4Protocol::PROT_NUMBER
+          && ((tc != 0 && tc->GetRootQueueDiscOnDevice (dev) != 0)
+              || !dev->SupportsSegmentationOffload (size)))
+        {
+          NS_LOG_LOGIC ("Split the TCP super-segment into segments");
+          std::list<Ptr<Packet> > segments = TcpL4Protocol::Segment (packet, ipHeader.GetSourceAddress (),
+                                                                     ipHeader.GetDestinationAddress ());
+          for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); it++)
+            {
+              Ipv6Header segmentHeader = ipHeader;
+              segmentHeader.SetPayloadLength ((*it)->GetSize ());
+              SendRealOut (route, *it, segmentHeader);
+            }
+          return;
+        }
+      NS_LOG_LOGIC ("The device segments the TCP super-segment");
+    }
+  bool fragment = !packet->PeekPacketTag (tsoTag)
+    && packet->GetSize () > targetMtu + 40; /* 40 => size of IPv6 header */
+
+  if (fragment)
     {
       // Router => drop
 
@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/object-vector.h"
 
 #include "ns3/packet.h"
@@ -29,6 +30,9 @@
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv6-route.h"
+#include "ns3/tso-tag.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
 
 #include "tcp-l4-protocol.h"
 #include "tcp-header.h"
@@ -36,6 +40,8 @@
 #include "ipv6-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv6-end-point.h"
+#include "ipv4-interface.h"
+#include "ipv6-interface.h"
 #include "ipv4-l3-protocol.h"
 #include "ipv6-l3-protocol.h"
 #include "ipv6-routing-protocol.h"
@@ -90,6 +96,17 @@ TcpL4Protocol::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&TcpL4Protocol::m_sockets),
                    MakeObjectVectorChecker<TcpSocketBase> ())
+    .AddAttribute ("GroMaxSegments",
+                   "Max number of in-sequence data segments of a connection merged "
+                   "into a single packet before being forwarded up (GRO); 1 disables it",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpL4Protocol::m_groMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("GroFlushTimeout",
+                   "Max time a received segment is held, waiting for the next ones (GRO)",
+                   TimeValue (MicroSeconds (50)),
+                   MakeTimeAccessor (&TcpL4Protocol::m_groFlushTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -162,6 +179,12 @@ TcpL4Protocol::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_sockets.clear ();
 
+  for (std::map<GroKey, GroFlow>::iterator it = m_groFlows.begin (); it != m_groFlows.end (); it++)
+    {
+      it->second.flushEvent.Cancel ();
+    }
+  m_groFlows.clear ();
+
   if (m_endPoints != 0)
     {
       delete m_endPoints;
@@ -487,6 +510,25 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
     }
 
   NS_ASSERT_MSG (endPoints.size () == 1, "Demux returned more than one endpoint");
+
+  if (m_groMaxSegments > 1)
+    {
+      GroKey key (InetSocketAddress (incomingIpHeader.GetSource (), incomingTcpHeader.GetSourcePort ()),
+                  InetSocketAddress (incomingIpHeader.GetDestination (), incomingTcpHeader.GetDestinationPort ()));
+      if (GroMerge (key, packet, incomingTcpHeader, incomingIpHeader.GetEcn ()))
+        {
+          return IpL4Protocol::RX_OK;
+        }
+      if (IsGroCandidate (packet, incomingTcpHeader))
+        {
+          GroFlow &flow = GroStart (key, packet, incomingTcpHeader, incomingIpHeader.GetEcn ());
+          flow.ipv6 = false;
+          flow.ipv4Header = incomingIpHeader;
+          flow.ipv4Interface = incomingInterface;
+          return IpL4Protocol::RX_OK;
+        }
+    }
+
   NS_LOG_LOGIC ("TcpL4Protocol " << this << " received a packet and"
                 " now forwarding it up to endpoint/socket");
 
@@ -542,6 +584,25 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
     }
 
   NS_ASSERT_MSG (endPoints.size () == 1, "Demux returned more than one endpoint");
+
+  if (m_groMaxSegments > 1)
+    {
+      GroKey key (Inet6SocketAddress (incomingIpHeader.GetSourceAddress (), incomingTcpHeader.GetSourcePort ()),
+                  Inet6SocketAddress (incomingIpHeader.GetDestinationAddress (), incomingTcpHeader.GetDestinationPort ()));
+      if (GroMerge (key, packet, incomingTcpHeader, incomingIpHeader.GetEcn ()))
+        {
+          return IpL4Protocol::RX_OK;
+        }
+      if (IsGroCandidate (packet, incomingTcpHeader))
+        {
+          GroFlow &flow = GroStart (key, packet, incomingTcpHeader, incomingIpHeader.GetEcn ());
+          flow.ipv6 = true;
+          flow.ipv6Header = incomingIpHeader;
+          flow.ipv6Interface = interface;
+          return IpL4Protocol::RX_OK;
+        }
+    }
+
   NS_LOG_LOGIC ("TcpL4Protocol " << this << " received a packet and"
                 " now forwarding it up to endpoint/socket");
 
@@ -551,6 +612,124 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
   return IpL4Protocol::RX_OK;
 }
 
+bool
+TcpL4Protocol::IsGroCandidate (Ptr<const Packet> packet, const TcpHeader &tcpHeader) const
+{
+  TsoTag tsoTag;
+  return tcpHeader.GetFlags () == TcpHeader::ACK
+         && packet->GetSize () > tcpHeader.GetSerializedSize ()
+         && !tcpHeader.HasOption (TcpOption::SACK)
+         && !packet->PeekPacketTag (tsoTag);
+}
+
+bool
+TcpL4Protocol::GroMerge (const GroKey &key, Ptr<Packet> packet, const TcpHeader &tcpHeader, uint8_t ecn)
+{
+  NS_LOG_FUNCTION (this << packet << tcpHeader << (uint16_t) ecn);
+
+  std::map<GroKey, GroFlow>::iterator it = m_groFlows.find (key);
+  if (it == m_groFlows.end ())
+    {
+      return false;
+    }
+  GroFlow &flow = it->second;
+  uint32_t size = packet->GetSize () - tcpHeader.GetSerializedSize ();
+  if (IsGroCandidate (packet, tcpHeader)
+      && ecn == flow.ecn
+      && tcpHeader.GetSequenceNumber () == flow.header.GetSequenceNumber () + flow.payload->GetSize ()
+      && tcpHeader.GetAckNumber () == flow.header.GetAckNumber ()
+      && tcpHeader.GetWindowSize () == flow.header.GetWindowSize ()
+      && tcpHeader.GetLength () == flow.header.GetLength ()
+      && size <= flow.segmentSize
+      && flow.payload->GetSize () + size <= 65535)
+    {
+      NS_LOG_LOGIC ("Merge segment " << tcpHeader.GetSequenceNumber () << " with " << flow.segments << " segments");
+      Ptr<Packet> payload = packet->Copy ();
+      TcpHeader header;
+      payload->RemoveHeader (header);
+      flow.payload->AddAtEnd (payload);
+      flow.segments++;
+      if (flow.segments >= m_groMaxSegments || size < flow.segmentSize)
+        {
+          GroFlush (key);
+        }
+      return true;
+    }
+
+  GroFlush (key);
+  return false;
+}
+
+TcpL4Protocol::GroFlow &
+TcpL4Protocol::GroStart (const GroKey &key, Ptr<Packet> packet, const TcpHeader &tcpHeader, uint8_t ecn)
+{
+  NS_LOG_FUNCTION (this << packet << tcpHeader << (uint16_t) ecn);
+
+  GroFlow &flow = m_groFlows[key];
+  flow.payload = packet->Copy ();
+  flow.payload->RemoveHeader (flow.header);
+  flow.segmentSize = flow.payload->GetSize ();
+  flow.segments = 1;
+  flow.ecn = ecn;
+  flow.flushEvent = Simulator::Schedule (m_groFlushTimeout, &TcpL4Protocol::GroFlush, this, key);
+  return flow;
+}
+
+void
+TcpL4Protocol::GroFlush (const GroKey &key)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::map<GroKey, GroFlow>::iterator it = m_groFlows.find (key);
+  NS_ASSERT (it != m_groFlows.end ());
+  GroFlow flow = it->second;
+  m_groFlows.erase (it);
+  flow.flushEvent.Cancel ();
+
+  Ptr<Packet> packet = flow.payload;
+  if (flow.segments > 1)
+    {
+      // The socket counts the packet as all its segments
+      packet->AddPacketTag (TsoTag (flow.segmentSize, packet->GetSize ()));
+    }
+  packet->AddHeader (flow.header);
+  NS_LOG_LOGIC ("Forward up " << flow.segments << " segments from " << flow.header.GetSequenceNumber ());
+
+  // The socket may have been closed while the segments were held
+  if (flow.ipv6)
+    {
+      Ipv6EndPointDemux::EndPoints endPoints =
+        m_endPoints6->Lookup (flow.ipv6Header.GetDestinationAddress (),
+                              flow.header.GetDestinationPort (),
+                              flow.ipv6Header.GetSourceAddress (),
+                              flow.header.GetSourcePort (), flow.ipv6Interface);
+      if (endPoints.empty ())
+        {
+          NoEndPointsFound (flow.header, flow.ipv6Header.GetSourceAddress (),
+                            flow.ipv6Header.GetDestinationAddress ());
+          return;
+        }
+      (*endPoints.begin ())->ForwardUp (packet, flow.ipv6Header,
+                                        flow.header.GetSourcePort (), flow.ipv6Interface);
+    }
+  else
+    {
+      Ipv4EndPointDemux::EndPoints endPoints =
+        m_endPoints->Lookup (flow.ipv4Header.GetDestination (),
+                             flow.header.GetDestinationPort (),
+                             flow.ipv4Header.GetSource (),
+                             flow.header.GetSourcePort (), flow.ipv4Interface);
+      if (endPoints.empty ())
+        {
+          NoEndPointsFound (flow.header, flow.ipv4Header.GetSource (),
+                            flow.ipv4Header.GetDestination ());
+          return;
+        }
+      (*endPoints.begin ())->ForwardUp (packet, flow.ipv4Header,
+                                        flow.header.GetSourcePort (), flow.ipv4Interface);
+    }
+}
+
 void
 TcpL4Protocol::SendPacketV4 (Ptr<Packet> packet, const TcpHeader &outgoing,
                              const Ipv4Address &saddr, const Ipv4Address &daddr,
@@ -656,6 +835,46 @@ TcpL4Protocol::SendPacketV6 (Ptr<Packet> packet, const TcpHeader &outgoing,
     }
 }
 
+std::list<Ptr<Packet> >
+TcpL4Protocol::Segment (Ptr<const Packet> packet, const Address &saddr, const Address &daddr)
+{
+  Ptr<Packet> payload = packet->Copy ();
+  TsoTag tsoTag;
+  bool found = payload->RemovePacketTag (tsoTag);
+  NS_ASSERT_MSG (found, "The packet is not a super-segment");
+  NS_ASSERT (tsoTag.GetSegmentSize () > 0);
+  TcpHeader outgoing;
+  payload->RemoveHeader (outgoing);
+
+  std::list<Ptr<Packet> > segments;
+  uint32_t size = payload->GetSize ();
+  for (uint32_t offset = 0; offset < size; offset += tsoTag.GetSegmentSize ())
+    {
+      uint32_t length = std::min (tsoTag.GetSegmentSize (), size - offset);
+      TcpHeader header = outgoing;
+      header.SetSequenceNumber (outgoing.GetSequenceNumber () + SequenceNumber32 (offset));
+      uint8_t flags = outgoing.GetFlags ();
+      if (offset > 0)
+        {
+          flags &= ~TcpHeader::CWR;
+        }
+      if (offset + length < size)
+        {
+          flags &= ~(TcpHeader::FIN | TcpHeader::PSH);
+        }
+      header.SetFlags (flags);
+      if (Node::ChecksumEnabled ())
+        {
+          header.EnableChecksums ();
+          header.InitializeChecksum (saddr, daddr, PROT_NUMBER);
+        }
+      Ptr<Packet> segment = payload->CreateFragment (offset, length);
+      segment->AddHeader (header);
+      segments.push_back (segment);
+    }
+  return segments;
+}
+
 void
 TcpL4Protocol::SendPacket (Ptr<Packet> pkt, const TcpHeader &outgoing,
                            const Address &saddr, const Address &daddr,
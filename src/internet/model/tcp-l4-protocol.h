@@ -22,21 +22,28 @@
 #define TCP_L4_PROTOCOL_H
 
 #include <stdint.h>
+#include <list>
+#include <map>
 
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/sequence-number.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 #include "ip-l4-protocol.h"
+#include "tcp-header.h"
+#include "ipv4-header.h"
+#include "ipv6-header.h"
 
 
 namespace ns3 {
 
 class Node;
 class Socket;
-class TcpHeader;
 class Ipv4EndPointDemux;
 class Ipv6EndPointDemux;
 class Ipv4Interface;
+class Ipv6Interface;
 class TcpSocketBase;
 class Ipv4EndPoint;
 class Ipv6EndPoint;
@@ -72,6 +79,14 @@ class NetDevice;
  * and SHOULD checksum packets its receives from the socket layer going down
  * the stack, but currently checksumming is disabled.
  *
+ * With the GroMaxSegments attribute, the in-sequence data segments of a
+ * connection received within GroFlushTimeout of the first one are merged
+ * into a single packet before being forwarded up, as the generic receive
+ * offload (GRO) of Linux does.  The socket counts the merged packet as
+ * all its segments (see TsoTag) and acknowledges it at once.  A sender
+ * using TSO grows its window on such stretch ACKs as on the delayed ACKs
+ * they replace; a sender without TSO grows it slower in slow start.
+ *
  * \see CreateSocket
  * \see NotifyNewAggregate
  * \see SendPacket
@@ -218,6 +233,24 @@ public:
                    const Address &saddr, const Address &daddr,
                    Ptr<NetDevice> oif = 0) const;
 
+  /**
+   * \brief Split a super-segment into segments
+   *
+   * This is the software segmentation (as the GSO of Linux) of a packet
+   * carrying a TsoTag, used by the IP layer where the super-segment
+   * cannot be sent as a whole.  Each segment gets a copy of the TCP
+   * header with its own sequence number; only the first one keeps the
+   * CWR flag, and only the last one the FIN and PSH flags.
+   *
+   * \param packet The super-segment, TCP header included
+   * \param saddr The source address (an Ipv4Address or an Ipv6Address)
+   * \param daddr The destination address (an Ipv4Address or an Ipv6Address)
+   * \return the segments, TCP headers included
+   */
+  static std::list<Ptr<Packet> > Segment (Ptr<const Packet> packet,
+                                          const Address &saddr,
+                                          const Address &daddr);
+
   /**
    * \brief Make a socket fully operational
    *
@@ -324,6 +357,33 @@ private:
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
 
+  /**
+   * \brief Connection of the held segments: source and destination socket addresses
+   */
+  typedef std::pair<Address, Address> GroKey;
+
+  /**
+   * \brief Data segments of a connection held by the GRO
+   */
+  struct GroFlow
+  {
+    TcpHeader header;                 //!< TCP header of the first segment
+    Ptr<Packet> payload;              //!< Merged payload of the segments
+    uint32_t segmentSize;             //!< Payload size of the first segment
+    uint32_t segments;                //!< Number of segments merged
+    uint8_t ecn;                      //!< ECN codepoint of the segments
+    bool ipv6;                        //!< Whether the segments were received over IPv6
+    Ipv4Header ipv4Header;            //!< IPv4 header of the first segment
+    Ptr<Ipv4Interface> ipv4Interface; //!< Interface the IPv4 segments were received on
+    Ipv6Header ipv6Header;            //!< IPv6 header of the first segment
+    Ptr<Ipv6Interface> ipv6Interface; //!< Interface the IPv6 segments were received on
+    EventId flushEvent;               //!< Flush of the segments
+  };
+
+  uint32_t m_groMaxSegments;          //!< Max segments merged by the GRO; 1 disables it
+  Time m_groFlushTimeout;             //!< Max time the GRO holds a segment
+  std::map<GroKey, GroFlow> m_groFlows; //!< Segments held by the GRO, by connection
+
   /**
    * \brief Copy constructor
    *
@@ -363,6 +423,51 @@ private:
   void SendPacketV6 (Ptr<Packet> pkt, const TcpHeader &outgoing,
                      const Ipv6Address &saddr, const Ipv6Address &daddr,
                      Ptr<NetDevice> oif = 0) const;
+
+  /**
+   * \brief Check whether the GRO can merge a received segment
+   *
+   * Only the data segments with no other flag than ACK, and without
+   * SACK blocks, are merged.
+   *
+   * \param packet The segment, TCP header included
+   * \param tcpHeader The TCP header of the segment
+   * \return true if the segment can be merged
+   */
+  bool IsGroCandidate (Ptr<const Packet> packet, const TcpHeader &tcpHeader) const;
+
+  /**
+   * \brief Merge a received segment with the segments held for its connection
+   *
+   * The segment is merged if it follows the held segments in sequence,
+   * with the same acknowledgment, window, options size and ECN codepoint,
+   * and is not larger than the first one.  Otherwise the held segments
+   * are flushed, so that the segment is forwarded up after them.
+   *
+   * \param key The connection of the segment
+   * \param packet The segment, TCP header included
+   * \param tcpHeader The TCP header of the segment
+   * \param ecn The ECN codepoint of the segment
+   * \return true if the segment was merged
+   */
+  bool GroMerge (const GroKey &key, Ptr<Packet> packet, const TcpHeader &tcpHeader, uint8_t ecn);
+
+  /**
+   * \brief Hold a received segment, waiting for the next ones of its connection
+   *
+   * \param key The connection of the segment
+   * \param packet The segment, TCP header included
+   * \param tcpHeader The TCP header of the segment
+   * \param ecn The ECN codepoint of the segment
+   * \return the held segments, whose IP header and interface are to be set
+   */
+  GroFlow &GroStart (const GroKey &key, Ptr<Packet> packet, const TcpHeader &tcpHeader, uint8_t ecn);
+
+  /**
+   * \brief Forward up the segments held for a connection, as a single packet
+   * \param key The connection of the segments
+   */
+  void GroFlush (const GroKey &key);
 };
 
 } // namespace ns3
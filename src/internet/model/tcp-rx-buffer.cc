@@ -155,8 +155,14 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The stored packets do not overlap
+  // each other, so only the last one starting before headSeq can overlap
+  // the head of the new packet.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -185,7 +191,7 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       NS_LOG_LOGIC ("Nothing to buffer");
       return false; // Nothing to buffer anyway
     }
-  else
+  else if (headSeq != tcph.GetSequenceNumber () || tailSeq != headSeq + SequenceNumber32 (pktSize))
     {
       uint32_t start = static_cast<uint32_t> (headSeq - tcph.GetSequenceNumber ());
       uint32_t length = static_cast<uint32_t> (tailSeq - headSeq);
@@ -194,31 +200,26 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
     }
   // Insert packet into buffer
   NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-
-  if (headSeq > m_nextRxSeq)
-    {
-      // Generate a new SACK block
-      UpdateSackList (headSeq, tailSeq);
-    }
+  m_data.emplace_hint (i, headSeq, p);
 
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (i = m_data.begin (); i != m_data.end (); ++i)
+  std::map<SequenceNumber32, SequenceNumber32>::iterator block = AddBlock (headSeq, tailSeq);
+  if (block->first == m_nextRxSeq)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      // The packet fills the head of the out-of-order data: the whole
+      // contiguous block becomes available
+      m_availBytes += block->second - m_nextRxSeq;
+      m_nextRxSeq = block->second;
+      m_blocks.erase (block);
       ClearSackList (m_nextRxSeq);
     }
+  else
+    {
+      // Generate a new SACK block
+      UpdateSackList (block->first, block->second);
+    }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
     { // Account for the FIN packet
@@ -235,6 +236,34 @@ TcpRxBuffer::GetSackListSize () const
   return static_cast<uint32_t> (m_sackList.size ());
 }
 
+std::map<SequenceNumber32, SequenceNumber32>::iterator
+TcpRxBuffer::AddBlock (const SequenceNumber32 &head, const SequenceNumber32 &tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+
+  SequenceNumber32 blockHead = head;
+  SequenceNumber32 blockTail = tail;
+
+  // The stored data do not overlap, so the blocks can only be adjacent
+  std::map<SequenceNumber32, SequenceNumber32>::iterator next = m_blocks.lower_bound (head);
+  if (next != m_blocks.end () && next->first == tail)
+    {
+      blockTail = next->second;
+      next = m_blocks.erase (next);
+    }
+  if (next != m_blocks.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator previous = std::prev (next);
+      NS_ASSERT (previous->second <= head);
+      if (previous->second == head)
+        {
+          previous->second = blockTail;
+          return previous;
+        }
+    }
+  return m_blocks.emplace_hint (next, blockHead, blockTail);
+}
+
 void
 TcpRxBuffer::UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail)
 {
@@ -271,65 +300,32 @@ TcpRxBuffer::UpdateSackList (const SequenceNumber32 &head, const SequenceNumber3
   //     following SACK blocks in the SACK option may be listed in
   //     arbitrary order.
 
-  m_sackList.push_front (current);
-
-  // We have inserted the block at the beginning of the list. Now, we should
-  // check if any existing blocks overlap with that.
-  bool updated = false;
+  // The block "current" is the contiguous block containing the segment
+  // which triggered this ACK, so the blocks previously reported that are
+  // subsets of it have been merged with it.
   TcpOptionSack::SackList::iterator it = m_sackList.begin ();
-  TcpOptionSack::SackBlock begin = *it;
-  TcpOptionSack::SackBlock merged;
-  ++it;
-
-  // Iterates until we examined all blocks in the list (maximum 4)
   while (it != m_sackList.end ())
     {
-      current = *it;
-
-      // This is a left merge:
-      // [current_first; current_second] [beg_first; beg_second]
-      if (begin.first == current.second)
+      NS_ASSERT (it->second <= current.first || it->first >= current.second
+                 || (it->first >= current.first && it->second <= current.second));
+      if (it->first >= current.first && it->second <= current.second)
         {
-          NS_ASSERT (current.first < begin.second);
-          merged = TcpOptionSack::SackBlock (current.first, begin.second);
-          updated = true;
-        }
-      // while this is a right merge
-      // [begin_first; begin_second] [current_first; current_second]
-      else if (begin.second == current.first)
-        {
-          NS_ASSERT (begin.first < current.second);
-          merged = TcpOptionSack::SackBlock (begin.first, current.second);
-          updated = true;
+          it = m_sackList.erase (it);
         }
-
-      // If we have merged the blocks (and the result is in merged) we should
-      // delete the current block (it), the first block, and insert the merged
-      // one at the beginning.
-      if (updated)
+      else
         {
-          m_sackList.erase (it);
-          m_sackList.pop_front ();
-          m_sackList.push_front (merged);
-          it = m_sackList.begin ();
-          begin = *it;
-          updated = false;
+          ++it;
         }
-
-      ++it;
     }
 
+  m_sackList.push_front (current);
+
   // Since the maximum blocks that fits into a TCP header are 4, there's no
   // point on maintaining the others.
   if (m_sackList.size () > 4)
     {
       m_sackList.pop_back ();
     }
-
-  // Please note that, if a block b is discarded and then a block contiguous
-  // to b is received, only that new block (without the b part) is reported.
-  // This is perfectly fine for the RFC point (a), given that we do not report any
-  // overlapping blocks shortly after.
 }
 
 void
@@ -369,7 +365,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return nullptr;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
+  Ptr<Packet> outPkt = nullptr; // The packet that contains all the data to return
   BufIterator i;
   while (extractSize)
     { // Check the buffered data for delivery
@@ -377,9 +373,10 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
       // Check if we send the whole pkt or just a partial
       uint32_t pktSize = i->second->GetSize ();
+      Ptr<Packet> extracted;
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
+          extracted = i->second;
           m_data.erase (i);
           m_size -= pktSize;
           m_availBytes -= pktSize;
@@ -387,13 +384,23 @@ TcpRxBuffer::Extract (uint32_t maxSize)
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
+          extracted = i->second->CreateFragment (0, extractSize);
           m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
           m_data.erase (i);
           m_size -= extractSize;
           m_availBytes -= extractSize;
           extractSize = 0;
         }
+      // The packets are concatenated only now. The first one is copied,
+      // because the buffered packets are shared with their sender
+      if (outPkt == nullptr)
+        {
+          outPkt = extracted->Copy ();
+        }
+      else
+        {
+          outPkt->AddAtEnd (extracted);
+        }
     }
   if (outPkt->GetSize () == 0)
     {
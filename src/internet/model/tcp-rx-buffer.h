@@ -53,6 +53,16 @@ class Packet;
  * To store data, use Add; for retrieving a certain amount of ordered data, use
  * the method Extract.
  *
+ * The segments are stored as they are received, in a map indexed by their
+ * first sequence number: only the parts of a segment overlapping data
+ * already stored are trimmed away, and the segments are concatenated only
+ * when the application extracts them. Next to the segments, the buffer
+ * keeps the contiguous blocks of out-of-order data (above NextRxSequence)
+ * in another map, which is updated when a segment arrives. Storing a
+ * segment, advancing NextRxSequence, and finding the SACK block which
+ * contains the segment are therefore logarithmic in the number of segments
+ * stored, whatever the reordering.
+ *
  * SACK list
  * ---------
  *
@@ -143,6 +153,9 @@ public:
    * removing data from the buffer that overlaps the tail of the inputted
    * packet
    *
+   * The buffer keeps a reference to the packet, which should not be
+   * modified afterwards.
+   *
    * \param p packet
    * \param tcph packet's TCP header
    * \return True when success, false otherwise.
@@ -182,6 +195,18 @@ public:
   bool GotFin () const { return m_gotFin; }
 
 private:
+  /**
+   * \brief Add a block of data to the out-of-order blocks
+   *
+   * The block is merged with the blocks which are adjacent to it.
+   *
+   * \param head sequence number of the beginning of the block
+   * \param tail sequence number of the end of the block
+   * \return the out-of-order block which contains the block added
+   */
+  std::map<SequenceNumber32, SequenceNumber32>::iterator
+  AddBlock (const SequenceNumber32 &head, const SequenceNumber32 &tail);
+
   /**
    * \brief Update the sack list, with the block seq starting at the beginning
    *
@@ -197,8 +222,10 @@ private:
    * (or other) options, it is even less. For more detail about this function,
    * please see the source code and in-line comments.
    *
-   * \param head sequence number of the block at the beginning
-   * \param tail sequence number of the block at the end
+   * \param head sequence number of the beginning of the contiguous block
+   * containing the segment received
+   * \param tail sequence number of the end of the contiguous block
+   * containing the segment received
    */
   void UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail);
 
@@ -226,6 +253,7 @@ private:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::map<SequenceNumber32, SequenceNumber32> m_blocks; //!< Contiguous blocks of out-of-order data (head to tail)
 };
 
 } //namespace ns3
@@ -42,6 +42,7 @@
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/data-rate.h"
+#include "ns3/tso-tag.h"
 #include "ns3/object.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
@@ -141,6 +142,13 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("TsoMaxSegments",
+                   "Maximum number of segments of new data sent at once, as a "
+                   "super-segment segmented by the device or, where it cannot be "
+                   "sent as a whole, by the IP layer (TSO); 1 disables it",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_tsoMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("EcnMode", "Determines the mode of ECN",
                    EnumValue (EcnMode_t::NoEcn),
                    MakeEnumAccessor (&TcpSocketBase::m_ecnMode),
@@ -329,6 +337,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_tsoMaxSegments (sock.m_tsoMaxSegments),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
@@ -1964,6 +1973,29 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
               NS_LOG_DEBUG ("Leaving Fast Recovery; BytesInFlight() = " <<
                             BytesInFlight () << "; cWnd = " << m_tcb->m_cWnd);
             }
+          else if (m_tsoMaxSegments > 1 && segsAcked > m_delAckMaxCount)
+            {
+              // With TSO, the receiver acknowledges each super-segment
+              // with a single stretch ACK.  Grow the window as if it had
+              // sent the delayed ACKs of the segments, one per DelAckCount
+              // segments, assuming it uses the same DelAckCount as we do.
+              uint32_t segments = segsAcked;
+              while (segments > 0)
+                {
+                  uint32_t acked = std::min (segments, std::max (m_delAckMaxCount, 1U));
+                  m_congestionControl->IncreaseWindow (m_tcb, acked);
+                  segments -= acked;
+                }
+
+              m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+
+              NS_LOG_LOGIC ("Congestion control called for a stretch ACK: " <<
+                            " cWnd: " << m_tcb->m_cWnd <<
+                            " ssTh: " << m_tcb->m_ssThresh <<
+                            " segsAcked: " << segsAcked);
+
+              NewAck (ackNumber, true);
+            }
           else
             {
               m_congestionControl->IncreaseWindow (m_tcb, segsAcked);
@@ -2840,7 +2872,27 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       isRetransmission = true;
     }
 
-  Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
+  Ptr<Packet> p;
+  if (!isRetransmission && maxSize > m_tcb->m_segmentSize)
+    {
+      // The scoreboard keeps the segments of a super-segment apart, so
+      // that they can be SACKed and retransmitted one by one
+      p = Create<Packet> ();
+      while (p->GetSize () < maxSize)
+        {
+          Ptr<Packet> segment = m_txBuffer->CopyFromSequence (std::min (m_tcb->m_segmentSize, maxSize - p->GetSize ()),
+                                                              seq + SequenceNumber32 (p->GetSize ()));
+          if (segment->GetSize () == 0)
+            {
+              break;
+            }
+          p->AddAtEnd (segment);
+        }
+    }
+  else
+    {
+      p = m_txBuffer->CopyFromSequence (maxSize, seq);
+    }
   uint32_t sz = p->GetSize (); // Size of packet
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
@@ -2888,6 +2940,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   AddSocketTags (p);
 
+  if (sz > m_tcb->m_segmentSize)
+    {
+      p->AddPacketTag (TsoTag (m_tcb->m_segmentSize, sz));
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -3077,6 +3134,20 @@ TcpSocketBase::SendPendingData (bool withAck)
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
 
+          // With TSO, the full segments of new data which fit in the window
+          // are sent at once, as long as the sender is not recovering from
+          // a loss or reacting to a congestion signal, where each segment
+          // matters.  The super-segment must fit in an IP datagram.
+          if (m_tsoMaxSegments > 1 && s == m_tcb->m_segmentSize
+              && next == m_tcb->m_highTxMark
+              && m_tcb->m_congState == TcpSocketState::CA_OPEN)
+            {
+              uint32_t segments = std::min (availableWindow, availableData) / m_tcb->m_segmentSize;
+              segments = std::min (segments, m_tsoMaxSegments);
+              segments = std::min (segments, (65535 - 80) / m_tcb->m_segmentSize);
+              s = std::max (segments, 1U) * m_tcb->m_segmentSize;
+            }
+
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
           //       retransmitted segment unless NextSeg () rule (4) was
@@ -3283,7 +3354,10 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      // A super-segment counts as all the segments it aggregates
+      TsoTag tsoTag;
+      m_delAckCount += p->PeekPacketTag (tsoTag) ? tsoTag.GetSegments () : 1;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
@@ -294,7 +294,7 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   NS_ASSERT (it != m_appList.end ());
 
   m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
+  Index (m_sentList.insert (m_sentList.end (), item));
   m_sentSize += item->m_packet->GetSize ();
 
   return item;
@@ -308,40 +308,50 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
   NS_ASSERT (numBytes <= m_sentSize);
   NS_ASSERT (m_sentList.size () >= 1);
 
-  auto it = m_sentList.begin ();
   bool listEdited = false;
   uint32_t s = numBytes;
 
   // Avoid to merge different packet for this retransmission if flags are
   // different.
-  for (; it != m_sentList.end(); ++it)
+  auto found = m_sentIndex.find (seq);
+  if (found != m_sentIndex.end ())
     {
-      if ((*it)->m_startSeq == seq)
+      auto it = found->second;
+      auto next = it;
+      next++;
+      if (next != m_sentList.end ())
         {
-          auto next = it;
-          next++;
-          if (next != m_sentList.end ())
+          // Next is not sacked... there is the possibility to merge
+          if (! (*next)->m_sacked)
             {
-              // Next is not sacked... there is the possibility to merge
-              if (! (*next)->m_sacked)
-                {
-                  s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
-                }
-              else
-                {
-                  // Next is sacked... better to retransmit only the first segment
-                  s = std::min(s, (*it)->m_packet->GetSize ());
-                }
+              s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
             }
           else
             {
+              // Next is sacked... better to retransmit only the first segment
               s = std::min(s, (*it)->m_packet->GetSize ());
             }
-          break;
         }
+      else
+        {
+          s = std::min(s, (*it)->m_packet->GetSize ());
+        }
+    }
+
+  // Move the items which overlap the requested block into a list of their
+  // own, so that GetPacketFromList does not walk the whole sent list
+  PacketList::iterator first = FindSent (seq);
+  PacketList::iterator last = FindSent (seq + s - 1);
+  ++last;
+  SequenceNumber32 startingSeq = (*first)->m_startSeq;
+  for (auto it = first; it != last; ++it)
+    {
+      Unindex (it);
     }
+  PacketList block;
+  block.splice (block.end (), m_sentList, first, last);
 
-  TcpTxItem *item = GetPacketFromList (m_sentList, m_firstByteSeq, s, seq, &listEdited);
+  TcpTxItem *item = GetPacketFromList (block, startingSeq, s, seq, &listEdited);
 
   if (! item->m_retrans)
     {
@@ -349,6 +359,13 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
       item->m_retrans = true;
     }
 
+  first = block.begin ();
+  m_sentList.splice (last, block);
+  for (auto it = first; it != last; ++it)
+    {
+      Index (it);
+    }
+
   return item;
 }
 
@@ -357,21 +374,13 @@ TcpTxBuffer::FindHighestSacked () const
 {
   NS_LOG_FUNCTION (this);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
-  auto ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
-
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  if (m_states[SACKED].empty ())
     {
-      const TcpTxItem *item = *it;
-      if (item->m_sacked)
-        {
-          ret = std::make_pair (it, beginOfCurrentPacket);
-        }
-      beginOfCurrentPacket += item->m_packet->GetSize ();
+      return std::make_pair (m_sentList.cend (), SequenceNumber32 (0));
     }
 
-  return ret;
+  SequenceNumber32 highest = *m_states[SACKED].rbegin ();
+  return std::make_pair (PacketList::const_iterator (FindSent (highest)), highest);
 }
 
 
@@ -693,6 +702,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
           RemoveFromCounts (item, pktSize);
 
+          Unindex (i);
           i = m_sentList.erase (i);
           NS_LOG_INFO ("Removed " << *item << " lost: " << m_lostOut <<
                        " retrans: " << m_retrans << " sacked: " << m_sackedOut <<
@@ -703,6 +713,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
         { // Part of the packet is behind the seqnum. Fragment
           pktSize -= offset;
           NS_LOG_INFO (*item);
+          Unindex (i);
           // PacketTags are preserved when fragmenting
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
           item->m_startSeq += offset;
@@ -711,6 +722,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           m_firstByteSeq += offset;
 
           RemoveFromCounts (item, offset);
+          Index (i);
 
           NS_LOG_INFO ("Fragmented one packet by size " << offset <<
                        ", new size=" << pktSize << " resulting item is " <<
@@ -733,8 +745,10 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           // It is not possible to have the UNA sacked; otherwise, it would
           // have been ACKed. This is, most likely, our wrong guessing
           // when adding Reno dupacks in the count.
+          Unindex (m_sentList.begin ());
           head->m_sacked = false;
           m_sackedOut -= head->m_packet->GetSize ();
+          Index (m_sentList.begin ());
           NS_LOG_INFO ("Moving the SACK flag from the HEAD to another segment");
           AddRenoSack ();
           MarkHeadAsLost ();
@@ -768,15 +782,21 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
   for (auto option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
       if (m_firstByteSeq + m_sentSize < (*option_it).first && !modified)
         {
           NS_LOG_INFO ("Not updating scoreboard, the option block is outside the sent list");
           return false;
         }
 
+      // Start from the first segment which can be covered by the block
+      SentIndex::const_iterator index_it = m_sentIndex.lower_bound ((*option_it).first);
+      if (index_it == m_sentIndex.end ())
+        {
+          continue;
+        }
+      PacketList::iterator item_it = index_it->second;
+      SequenceNumber32 beginOfCurrentPacket = index_it->first;
+
       while (item_it != m_sentList.end ())
         {
           uint32_t pktSize = (*item_it)->m_packet->GetSize ();
@@ -798,6 +818,7 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
                 }
               else
                 {
+                  Unindex (item_it);
                   if ((*item_it)->m_lost)
                     {
                       (*item_it)->m_lost = false;
@@ -806,6 +827,7 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
                   (*item_it)->m_sacked = true;
                   m_sackedOut += (*item_it)->m_packet->GetSize ();
+                  Index (item_it);
 
                   if (m_highestSack.first == m_sentList.end()
                       || m_highestSack.second <= beginOfCurrentPacket + pktSize)
@@ -852,47 +874,36 @@ void
 TcpTxBuffer::UpdateLostCount ()
 {
   NS_LOG_FUNCTION (this);
-  uint32_t sacked = 0;
-  SequenceNumber32 beginOfCurrentPacket = m_highestSack.second;
-  if (m_highestSack.first == m_sentList.end ())
-    {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from the latest sent item");
-    }
-  else
+  NS_LOG_INFO ("Status before the update: " << *this);
+
+  // A segment is lost when at least "Dupack thresh" sacked segments are
+  // above it. Find the lowest of the m_dupAckThresh highest sacked segments:
+  // all the segments below it, which are neither sacked nor already lost,
+  // are lost.
+  const std::set<SequenceNumber32> &sacked = m_states[SACKED];
+  uint32_t dupAckThresh = std::max (m_dupAckThresh, 1U);
+  if (sacked.size () < dupAckThresh)
     {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from item " << *(*m_highestSack.first));
+      NS_LOG_INFO ("Only " << sacked.size () << " sacked segments, nothing is lost");
+      return;
     }
 
-  for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
-    {
-      TcpTxItem *item = *it;
-      if (item->m_sacked)
-        {
-          sacked++;
-        }
-
-      if (sacked >= m_dupAckThresh)
-        {
-          if (!item->m_sacked && !item->m_lost)
-            {
-              item->m_lost = true;
-              m_lostOut += item->m_packet->GetSize ();
-            }
-        }
-      beginOfCurrentPacket -= item->m_packet->GetSize ();
-    }
+  auto thresh_it = sacked.end ();
+  std::advance (thresh_it, -static_cast<int32_t> (dupAckThresh));
+  SequenceNumber32 threshSeq = *thresh_it;
 
-  if (sacked >= m_dupAckThresh)
+  for (ScoreboardState state : {RETRANS, PENDING})
     {
-      TcpTxItem *item = *m_sentList.begin ();
-      if (!item->m_lost)
+      while (!m_states[state].empty () && *m_states[state].begin () < threshSeq)
         {
-          item->m_lost = true;
-          m_lostOut += item->m_packet->GetSize ();
+          PacketList::iterator it = FindSent (*m_states[state].begin ());
+          Unindex (it);
+          (*it)->m_lost = true;
+          m_lostOut += (*it)->m_packet->GetSize ();
+          Index (it);
         }
     }
+
   NS_LOG_INFO ("Status after the update: " << *this);
   ConsistencyCheck ();
 }
@@ -902,37 +913,28 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
 {
   NS_LOG_FUNCTION (this << seq);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
   if (seq >= m_highestSack.second)
     {
       return false;
     }
 
-  // In theory, using a map and hints when inserting elements can improve
-  // performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // The first segment, starting at or after seq, which is either lost or
+  // sacked decides
+  SequenceNumber32 startSeq;
+  ScoreboardState state = FindFirst (seq, (1 << LOST) | (1 << LOST_RETRANS) | (1 << SACKED),
+                                     &startSeq);
+  if (state == N_STATES)
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          if ((*it)->m_lost == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-              return true;
-            }
-
-          if ((*it)->m_sacked == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-              return false;
-            }
-        }
+      return false;
+    }
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+  if (state != SACKED || (*FindSent (startSeq))->m_lost)
+    {
+      NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
+      return true;
     }
 
+  NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
   return false;
 }
 
@@ -954,35 +956,11 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *
    *     (1.c) IsLost (S2) returns true.
    */
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  SequenceNumber32 seqPerRule3;
-  bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
-
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  if (!m_states[LOST].empty ())
     {
-      item = *it;
-
-      // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
-        {
-          if (item->m_lost)
-            {
-              NS_LOG_INFO("IsLost, returning" << beginOfCurrentPkt);
-              *seq = beginOfCurrentPkt;
-              return true;
-            }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
-            {
-              NS_LOG_INFO ("Saving for rule 3 the seq " << beginOfCurrentPkt);
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
-            }
-        }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
+      NS_LOG_INFO ("IsLost, returning" << *m_states[LOST].begin ());
+      *seq = *m_states[LOST].begin ();
+      return true;
     }
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
@@ -1008,10 +986,10 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *     (specifically excluding step (1.c)), then one segment of up to
    *     SMSS octets starting with S3 SHOULD be returned.
    */
-  if (isSeqPerRule3Valid)
+  if (isRecovery && !m_states[PENDING].empty ())
     {
-      NS_LOG_INFO ("Rule3 valid. " << seqPerRule3);
-      *seq = seqPerRule3;
+      NS_LOG_INFO ("Rule3 valid. " << *m_states[PENDING].begin ());
+      *seq = *m_states[PENDING].begin ();
       return true;
     }
 
@@ -1180,9 +1158,12 @@ TcpTxBuffer::ResetRenoSack ()
   NS_LOG_FUNCTION (this);
 
   m_sackedOut = 0;
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  while (!m_states[SACKED].empty ())
     {
+      PacketList::iterator it = FindSent (*m_states[SACKED].begin ());
+      Unindex (it);
       (*it)->m_sacked = false;
+      Index (it);
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
@@ -1208,6 +1189,7 @@ TcpTxBuffer::ResetSentList ()
   m_retrans = 0;
   m_sackedOut = 0;
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  Reindex ();
 }
 
 void
@@ -1218,6 +1200,7 @@ TcpTxBuffer::ResetLastSegmentSent ()
     {
       TcpTxItem *item = m_sentList.back ();
 
+      Unindex (--m_sentList.end ());
       m_sentList.pop_back ();
       m_sentSize -= item->m_packet->GetSize ();
       if (item->m_retrans)
@@ -1270,6 +1253,7 @@ TcpTxBuffer::SetSentListLost (bool resetSack)
 
       (*it)->m_retrans = false;
     }
+  Reindex ();
 
   NS_LOG_INFO ("Set sent list lost, status: " << *this);
   NS_ASSERT_MSG (m_sentSize >= m_sackedOut + m_lostOut, *this);
@@ -1301,8 +1285,10 @@ TcpTxBuffer::DeleteRetransmittedFlagFromHead ()
 
   if (m_sentList.front ()->m_retrans)
     {
+      Unindex (m_sentList.begin ());
       m_sentList.front ()->m_retrans = false;
       m_retrans -= m_sentList.front ()->m_packet->GetSize ();
+      Index (m_sentList.begin ());
     }
   ConsistencyCheck ();
 }
@@ -1312,6 +1298,8 @@ TcpTxBuffer::MarkHeadAsLost ()
 {
   if (m_sentList.size () > 0)
     {
+      Unindex (m_sentList.begin ());
+
       // If the head is sacked (reneging by the receiver the previously sent
       // information) we revert the sacked flag.
       // A sacked head means that we should advance SND.UNA.. so it's an error.
@@ -1332,6 +1320,8 @@ TcpTxBuffer::MarkHeadAsLost ()
           m_sentList.front()->m_lost = true;
           m_lostOut += m_sentList.front ()->m_packet->GetSize ();
         }
+
+      Index (m_sentList.begin ());
     }
   ConsistencyCheck ();
 }
@@ -1345,19 +1335,19 @@ TcpTxBuffer::AddRenoSack (void)
   m_renoSack = true;
 
   // We can _never_ SACK the head, so start from the second segment sent
-  auto it = ++m_sentList.begin ();
+  SequenceNumber32 startSeq = (*(++m_sentList.begin ()))->m_startSeq;
 
   // Find the "highest sacked" point, that is SND.UNA + m_sackedOut
-  while (it != m_sentList.end () && (*it)->m_sacked)
-    {
-      ++it;
-    }
+  ScoreboardState state = FindFirst (startSeq, ~(1U << SACKED), &startSeq);
 
   // Add to the sacked size the size of the first "not sacked" segment
-  if (it != m_sentList.end ())
+  if (state != N_STATES)
     {
+      PacketList::iterator it = FindSent (startSeq);
+      Unindex (it);
       (*it)->m_sacked = true;
       m_sackedOut += (*it)->m_packet->GetSize ();
+      Index (it);
       m_highestSack = std::make_pair (it, (*it)->m_startSeq);
       NS_LOG_INFO ("Added a Reno SACK, status: " << *this);
     }
@@ -1406,6 +1396,109 @@ TcpTxBuffer::ConsistencyCheck () const
                  " stored lost: " << m_lostOut);
   NS_ASSERT_MSG (retrans == m_retrans, " Counted retrans: " << retrans <<
                  " stored retrans: " << m_retrans);
+
+  uint32_t indexed = 0;
+  for (uint32_t state = 0; state < N_STATES; ++state)
+    {
+      indexed += m_states[state].size ();
+    }
+  NS_ASSERT_MSG (m_sentIndex.size () == m_sentList.size () && indexed == m_sentList.size (),
+                 "Indexed " << m_sentIndex.size () << " items, " << indexed <<
+                 " states, for " << m_sentList.size () << " items");
+  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      auto index_it = m_sentIndex.find ((*it)->m_startSeq);
+      NS_ASSERT_MSG (index_it != m_sentIndex.end () && index_it->second == it,
+                     "Item " << **it << " is not indexed");
+      NS_ASSERT_MSG (m_states[GetState (*it)].count ((*it)->m_startSeq) == 1,
+                     "Item " << **it << " is not indexed with its state");
+    }
+}
+
+TcpTxBuffer::ScoreboardState
+TcpTxBuffer::GetState (const TcpTxItem *item)
+{
+  if (item->m_sacked)
+    {
+      return SACKED;
+    }
+  if (item->m_lost)
+    {
+      return item->m_retrans ? LOST_RETRANS : LOST;
+    }
+  return item->m_retrans ? RETRANS : PENDING;
+}
+
+void
+TcpTxBuffer::Index (PacketList::iterator it)
+{
+  TcpTxItem *item = *it;
+  // Most of the items are appended to the sent list
+  auto inserted = m_sentIndex.emplace_hint (m_sentIndex.end (), item->m_startSeq, it);
+  NS_ASSERT_MSG (inserted->second == it, "Item " << *item << " already indexed");
+  NS_UNUSED (inserted);
+  m_states[GetState (item)].insert (item->m_startSeq);
+}
+
+void
+TcpTxBuffer::Unindex (PacketList::iterator it)
+{
+  TcpTxItem *item = *it;
+  auto index_it = m_sentIndex.find (item->m_startSeq);
+  NS_ASSERT_MSG (index_it != m_sentIndex.end () && index_it->second == it,
+                 "Item " << *item << " not indexed");
+  m_sentIndex.erase (index_it);
+  size_t erased = m_states[GetState (item)].erase (item->m_startSeq);
+  NS_ASSERT_MSG (erased == 1, "Item " << *item << " not indexed with its state");
+  NS_UNUSED (erased);
+}
+
+void
+TcpTxBuffer::Reindex ()
+{
+  NS_LOG_FUNCTION (this);
+  m_sentIndex.clear ();
+  for (uint32_t state = 0; state < N_STATES; ++state)
+    {
+      m_states[state].clear ();
+    }
+  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      Index (it);
+    }
+}
+
+TcpTxBuffer::PacketList::iterator
+TcpTxBuffer::FindSent (const SequenceNumber32 &seq) const
+{
+  auto index_it = m_sentIndex.upper_bound (seq);
+  NS_ASSERT_MSG (index_it != m_sentIndex.begin (), "Sequence " << seq <<
+                 " is not in the sent list");
+  --index_it;
+  NS_ASSERT_MSG (seq < index_it->first + (*index_it->second)->m_packet->GetSize (),
+                 "Sequence " << seq << " is not in the sent list");
+  return index_it->second;
+}
+
+TcpTxBuffer::ScoreboardState
+TcpTxBuffer::FindFirst (const SequenceNumber32 &seq, uint32_t states,
+                        SequenceNumber32 *startSeq) const
+{
+  ScoreboardState found = N_STATES;
+  for (uint32_t state = 0; state < N_STATES; ++state)
+    {
+      if ((states & (1U << state)) == 0)
+        {
+          continue;
+        }
+      auto it = m_states[state].lower_bound (seq);
+      if (it != m_states[state].end () && (found == N_STATES || *it < *startSeq))
+        {
+          *startSeq = *it;
+          found = static_cast<ScoreboardState> (state);
+        }
+    }
+  return found;
 }
 
 std::ostream &
@@ -29,6 +29,9 @@
 #include "ns3/tcp-option-sack.h"
 #include "ns3/packet.h"
 
+#include <map>
+#include <set>
+
 namespace ns3 {
 class Packet;
 
@@ -102,8 +105,20 @@ public:
  * associated with every segment sent. This is done through the use of the
  * class TcpTxItem: instead of storing a list of packets, we store a list of
  * TcpTxItem. Each item has different flags (check the corresponding
- * documentation) and maintaining the scoreboard is a matter of travelling the
- * list and set the SACK flag on the corresponding segment sent.
+ * documentation) and maintaining the scoreboard is a matter of finding the
+ * corresponding segments sent and setting their SACK flag.
+ *
+ * To avoid walking the list of sent segments, which can hold tens of
+ * thousands of segments on a long fat network, the sent segments are also
+ * indexed by their starting sequence number, and the starting sequence
+ * numbers of the segments are kept in one ordered set per scoreboard state
+ * (sacked, lost, lost and retransmitted, retransmitted, none of them).
+ * Processing a SACK block, checking if a sequence is lost, and finding the
+ * next segment to transmit are therefore logarithmic in the number of
+ * segments sent, and marking the segments as lost costs a logarithmic
+ * time per segment newly marked. Every change of the flags or of the
+ * starting sequence of a sent item must remove the item from the index
+ * (Unindex) before the change, and add it back (Index) after it.
  *
  * Item properties
  * ---------------
@@ -426,8 +441,9 @@ private:
    * The {New}Reno cases, for now, are managed in TcpSocketBase through the
    * call to MarkHeadAsLost.
    * This function is, therefore, called after a SACK option has been received,
-   * and updates the lost count. It can be probably optimized by not walking
-   * the entire list, but a subset.
+   * and updates the lost count. The segments to mark are found in the index
+   * of the segments neither sacked nor lost, so that each call costs a
+   * logarithmic time per segment newly marked as lost.
    *
    */
   void UpdateLostCount ();
@@ -599,6 +615,69 @@ private:
   std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
   FindHighestSacked () const;
 
+  /**
+   * \brief The states of a sent item in the scoreboard
+   */
+  enum ScoreboardState
+  {
+    SACKED = 0,    //!< Sacked by the receiver
+    LOST,          //!< Lost, and not retransmitted
+    LOST_RETRANS,  //!< Lost, and retransmitted
+    RETRANS,       //!< Retransmitted, neither sacked nor lost
+    PENDING,       //!< Neither sacked, lost, nor retransmitted
+    N_STATES       //!< Number of states
+  };
+
+  /**
+   * \brief Get the scoreboard state of an item
+   * \param item the item
+   * \return the state of the item
+   */
+  static ScoreboardState GetState (const TcpTxItem *item);
+
+  /**
+   * \brief Add a sent item to the index
+   * \param it the item, in m_sentList
+   */
+  void Index (PacketList::iterator it);
+
+  /**
+   * \brief Remove a sent item from the index
+   * \param it the item, in m_sentList
+   */
+  void Unindex (PacketList::iterator it);
+
+  /**
+   * \brief Rebuild the index from the whole sent list
+   */
+  void Reindex ();
+
+  /**
+   * \brief Find the sent item which contains a sequence
+   * \param seq the sequence, which must be in the sent list
+   * \return the item, in m_sentList
+   */
+  PacketList::iterator FindSent (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Find the first sent item, starting at or after a sequence, which
+   * is in one of a set of states
+   * \param seq the sequence
+   * \param states the states, as a bitmask of (1 << ScoreboardState)
+   * \param [out] startSeq the starting sequence of the item found
+   * \return the state of the item found, or N_STATES if there is none
+   */
+  ScoreboardState FindFirst (const SequenceNumber32 &seq, uint32_t states,
+                             SequenceNumber32 *startSeq) const;
+
+  /**
+   * \brief Sent items, by starting sequence
+   *
+   * The sequences of the sent items span less than half of the sequence
+   * space, so they are totally ordered by SequenceNumber32::operator<.
+   */
+  typedef std::map<SequenceNumber32, PacketList::iterator> SentIndex;
+
   PacketList m_appList;  //!< Buffer for application data
   PacketList m_sentList; //!< Buffer for sent (but not acked) data
   uint32_t m_maxBuffer;  //!< Max number of data bytes in buffer (SND.WND)
@@ -608,6 +687,9 @@ private:
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
 
+  SentIndex m_sentIndex; //!< Index of m_sentList, by starting sequence
+  std::set<SequenceNumber32> m_states[N_STATES]; //!< Starting sequences of the sent items, by scoreboard state
+
   uint32_t m_lostOut   {0}; //!< Number of lost bytes
   uint32_t m_sackedOut {0}; //!< Number of sacked bytes
   uint32_t m_retrans   {0}; //!< Number of retransmitted bytes
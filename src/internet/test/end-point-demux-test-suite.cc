@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-end-point-demux.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux Test: the most specific endpoint matches a
+ * packet, including after the endpoints change.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Look up the endpoint of a packet.
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \returns the endpoint matching the packet, 0 if none
+   */
+  Ipv4EndPoint *Lookup (const char *daddr, uint16_t dport, const char *saddr, uint16_t sport);
+
+  Ipv4EndPointDemux m_demux;           //!< The demux
+  Ptr<Ipv4Interface> m_interface;      //!< The incoming interface
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux lookups")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (const char *daddr, uint16_t dport, const char *saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = m_demux.Lookup (Ipv4Address (daddr), dport,
+                                                           Ipv4Address (saddr), sport,
+                                                           m_interface);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("/24")));
+
+  Ipv4EndPoint *any = m_demux.Allocate (0, 80);
+  Ipv4EndPoint *local = m_demux.Allocate (0, Ipv4Address ("10.0.0.1"), 80);
+  Ipv4EndPoint *anyConnected = m_demux.Allocate (0, Ipv4Address::GetAny (), 80, Ipv4Address ("10.0.0.3"), 1000);
+  Ipv4EndPoint *connected = m_demux.Allocate (0, Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1000);
+  Ipv4EndPoint *subnet = m_demux.Allocate (0, Ipv4Address ("10.0.0.0"), 90);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (0, Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1000), 0,
+                         "Duplicated endpoint allocated");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (0, Ipv4Address ("10.0.0.1"), 80), 0, "Duplicated endpoint allocated");
+
+  // the most specific endpoint wins
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 80, "10.0.0.2", 1000), connected, "Full match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 80, "10.0.0.3", 1000), anyConnected, "Match but local address not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 80, "10.0.0.2", 1001), local, "Local address and port match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.5", 80, "10.0.0.2", 1000), any, "Local port match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.255", 90, "10.0.0.2", 1000), subnet, "Subnet-directed match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.1.255", 90, "10.0.0.2", 1000), 0, "Unexpected subnet-directed match");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 81, "10.0.0.2", 1000), 0, "Unexpected match");
+
+  // endpoints which can not receive are skipped
+  connected->SetRxEnabled (false);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 80, "10.0.0.2", 1000), local, "Disabled endpoint matched");
+  connected->SetRxEnabled (true);
+
+  // an endpoint connecting after its allocation, as a TCP socket does
+  Ipv4EndPoint *client = m_demux.Allocate (Ipv4Address ("10.0.0.1"));
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", client->GetLocalPort (), "10.0.0.9", 22), client, "Unconnected endpoint not found");
+  client->SetPeer (Ipv4Address ("10.0.0.2"), 22);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", client->GetLocalPort (), "10.0.0.9", 22), 0, "Connected endpoint matched another peer");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", client->GetLocalPort (), "10.0.0.2", 22), client, "Connected endpoint not found");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.SimpleLookup (Ipv4Address ("10.0.0.1"), client->GetLocalPort (), Ipv4Address ("10.0.0.2"), 22),
+                         client, "Connected endpoint not found");
+  client->SetLocalAddress (Ipv4Address ("10.0.0.7"));
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", client->GetLocalPort (), "10.0.0.2", 22), 0, "Endpoint found at its former address");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.7", client->GetLocalPort (), "10.0.0.2", 22), client, "Endpoint not found at its new address");
+
+  // the ephemeral ports in use are skipped
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_ASSERT_MSG_NE (m_demux.Allocate (0, port + 1), 0, "Free port not allocated");
+  Ipv4EndPoint *next = m_demux.Allocate ();
+  NS_TEST_ASSERT_MSG_EQ (next->GetLocalPort (), port + 2, "Ephemeral port in use allocated");
+
+  m_demux.DeAllocate (connected);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("10.0.0.1", 80, "10.0.0.2", 1000), local, "Removed endpoint matched");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (80), true, "Port in use not found");
+  m_demux.DeAllocate (any);
+  m_demux.DeAllocate (local);
+  m_demux.DeAllocate (anyConnected);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (80), false, "Free port found");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.GetAllEndPoints ().size (), 4, "Wrong number of endpoints");
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv6EndPointDemux Test: the most specific endpoint matches a
+ * packet, including after the endpoints change.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Look up the endpoint of a packet.
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \returns the endpoint matching the packet, 0 if none
+   */
+  Ipv6EndPoint *Lookup (const char *daddr, uint16_t dport, const char *saddr, uint16_t sport);
+
+  Ipv6EndPointDemux m_demux; //!< The demux
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux lookups")
+{
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::Lookup (const char *daddr, uint16_t dport, const char *saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints endPoints = m_demux.Lookup (Ipv6Address (daddr), dport,
+                                                           Ipv6Address (saddr), sport, 0);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPoint *any = m_demux.Allocate (0, 80);
+  Ipv6EndPoint *local = m_demux.Allocate (0, Ipv6Address ("2001::1"), 80);
+  Ipv6EndPoint *anyConnected = m_demux.Allocate (0, Ipv6Address::GetAny (), 80, Ipv6Address ("2001::3"), 1000);
+  Ipv6EndPoint *connected = m_demux.Allocate (0, Ipv6Address ("2001::1"), 80, Ipv6Address ("2001::2"), 1000);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (0, Ipv6Address ("2001::1"), 80, Ipv6Address ("2001::2"), 1000), 0,
+                         "Duplicated endpoint allocated");
+
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 80, "2001::2", 1000), connected, "Full match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 80, "2001::3", 1000), anyConnected, "Match but local address not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 80, "2001::2", 1001), local, "Local address and port match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::5", 80, "2001::2", 1000), any, "Local port match not found");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 81, "2001::2", 1000), 0, "Unexpected match");
+
+  // an endpoint connecting after its allocation, as a TCP socket does
+  Ipv6EndPoint *client = m_demux.Allocate (Ipv6Address ("2001::1"));
+  client->SetPeer (Ipv6Address ("2001::2"), 22);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", client->GetLocalPort (), "2001::9", 22), 0, "Connected endpoint matched another peer");
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", client->GetLocalPort (), "2001::2", 22), client, "Connected endpoint not found");
+  client->SetLocalPort (8080);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 8080, "2001::2", 22), client, "Endpoint not found at its new port");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.SimpleLookup (Ipv6Address ("2001::1"), 8080, Ipv6Address ("2001::2"), 22),
+                         client, "Connected endpoint not found");
+
+  m_demux.DeAllocate (connected);
+  NS_TEST_ASSERT_MSG_EQ (Lookup ("2001::1", 80, "2001::2", 1000), local, "Removed endpoint matched");
+  m_demux.DeAllocate (any);
+  m_demux.DeAllocate (local);
+  m_demux.DeAllocate (anyConnected);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (80), false, "Free port found");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (8080), true, "Port in use not found");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
@@ -14,6 +14,9 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <sstream>
+#include <string>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -42,6 +45,7 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/global-route-manager.h"
 
 using namespace ns3;
 
@@ -1244,6 +1248,192 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting incremental and parallel route computation test
+ *
+ * A ring of routers with chords, each router serving a host, and a
+ * separate LAN of routers.  The routes recomputed after a link
+ * goes down, or after a stub network is added, must be the ones of a
+ * full computation, the routes of the nodes which are not affected must
+ * be kept, and the routes computed by several threads must be the ones
+ * computed by a single thread.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  /**
+   * \brief Full computation of the routes.
+   */
+  void ComputeAllRoutes (void);
+  /**
+   * \returns the routes of all the nodes, as text, in the order of the
+   * text of the routes
+   */
+  std::string DumpRoutes (void) const;
+  /**
+   * \param node a node
+   * \returns the global routing protocol of the node
+   */
+  static Ptr<Ipv4GlobalRouting> GetGlobalRouting (Ptr<Node> node);
+
+  NodeContainer m_routers;   //!< Routers of the ring.
+  NodeContainer m_hosts;     //!< Hosts, one per router of the ring.
+  NodeContainer m_island;    //!< Routers of a LAN disconnected from the ring.
+  NetDeviceContainer m_link; //!< The link going down, between two routers.
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Incremental and parallel global routing computation")
+{
+}
+
+Ptr<Ipv4GlobalRouting>
+Ipv4GlobalRoutingIncrementalTestCase::GetGlobalRouting (Ptr<Node> node)
+{
+  return node->GetObject<Ipv4> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoSetup (void)
+{
+  const uint32_t nRouters = 24;
+  m_routers.Create (nRouters);
+  m_hosts.Create (nRouters);
+  m_island.Create (3);
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_routers);
+  internet.Install (m_hosts);
+  internet.Install (m_island);
+
+  SimpleNetDeviceHelper p2pHelper;
+  p2pHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i < nRouters; i++)
+    {
+      NetDeviceContainer ring = p2pHelper.Install (NodeContainer (m_routers.Get (i), m_routers.Get ((i + 1) % nRouters)));
+      ipv4.Assign (ring);
+      ipv4.NewNetwork ();
+      if (i == 3)
+        {
+          m_link = ring;
+        }
+      if (i % 6 == 0)
+        {
+          ipv4.Assign (p2pHelper.Install (NodeContainer (m_routers.Get (i), m_routers.Get ((i + nRouters / 2 - 1) % nRouters))));
+          ipv4.NewNetwork ();
+        }
+      ipv4.Assign (p2pHelper.Install (NodeContainer (m_routers.Get (i), m_hosts.Get (i))));
+      ipv4.NewNetwork ();
+    }
+
+  SimpleNetDeviceHelper lanHelper;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  ipv4.Assign (lanHelper.Install (m_island));
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::ComputeAllRoutes (void)
+{
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+}
+
+std::string
+Ipv4GlobalRoutingIncrementalTestCase::DumpRoutes (void) const
+{
+  std::ostringstream oss;
+  NodeContainer nodes (m_routers, m_hosts, m_island);
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = GetGlobalRouting (nodes.Get (i));
+      oss << "node " << nodes.Get (i)->GetId () << std::endl;
+      std::vector<std::string> routes;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream route;
+          route << *routing->GetRoute (j);
+          routes.push_back (route.str ());
+        }
+      std::sort (routes.begin (), routes.end ());
+      for (uint32_t j = 0; j < routes.size (); j++)
+        {
+          oss << routes[j] << std::endl;
+        }
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string before = DumpRoutes ();
+
+  // the routes of a host far from the link, and of the island, are kept
+  Ptr<Ipv4GlobalRouting> host = GetGlobalRouting (m_hosts.Get (16));
+  Ptr<Ipv4GlobalRouting> island = GetGlobalRouting (m_island.Get (0));
+  NS_TEST_ASSERT_MSG_GT (host->GetNRoutes (), 0, "Error-- no route");
+  NS_TEST_ASSERT_MSG_GT (island->GetNRoutes (), 0, "Error-- no route");
+  Ipv4RoutingTableEntry *hostRoute = host->GetRoute (0);
+  Ipv4RoutingTableEntry *islandRoute = island->GetRoute (0);
+
+  Ptr<Ipv4> ipv4 = m_link.Get (0)->GetNode ()->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->GetInterfaceForDevice (m_link.Get (0));
+  ipv4->SetDown (interface);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string incremental = DumpRoutes ();
+  NS_TEST_ASSERT_MSG_EQ ((incremental != before), true, "Error-- the routes did not change");
+  NS_TEST_ASSERT_MSG_EQ (host->GetRoute (0), hostRoute, "Error-- the routes of an unaffected host were recomputed");
+  NS_TEST_ASSERT_MSG_EQ (island->GetRoute (0), islandRoute, "Error-- the routes of an unaffected router were recomputed");
+  ComputeAllRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (DumpRoutes (), incremental, "Error-- the incremental routes differ from the full computation");
+
+  ipv4->SetUp (interface);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ (DumpRoutes (), before, "Error-- the routes were not restored");
+
+  // compute the routes with several threads
+  Config::SetGlobal ("GlobalRouteManagerThreadCount", UintegerValue (4));
+  ComputeAllRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (DumpRoutes (), before, "Error-- the routes computed by several threads differ");
+  ipv4->SetDown (interface);
+  ComputeAllRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (DumpRoutes (), incremental, "Error-- the routes computed by several threads differ");
+  Config::SetGlobal ("GlobalRouteManagerThreadCount", UintegerValue (0));
+
+  // a new stub network does not change the shortest path trees: the other
+  // routers only receive the routes to it
+  Ptr<Ipv4GlobalRouting> router = GetGlobalRouting (m_routers.Get (16));
+  Ipv4RoutingTableEntry *routerRoute = router->GetRoute (0);
+  uint32_t nRoutes = router->GetNRoutes ();
+  hostRoute = host->GetRoute (0);
+  SimpleNetDeviceHelper stubHelper;
+  Ipv4AddressHelper stubAddress ("10.2.0.0", "255.255.255.0");
+  stubAddress.Assign (stubHelper.Install (m_routers.Get (8)));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string stub = DumpRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (router->GetRoute (0), routerRoute, "Error-- the routes of a router were recomputed for a stub network");
+  NS_TEST_ASSERT_MSG_GT (router->GetNRoutes (), nRoutes, "Error-- no route to the stub network");
+  NS_TEST_ASSERT_MSG_EQ (host->GetRoute (0), hostRoute, "Error-- the routes of an unaffected host were recomputed");
+  ComputeAllRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (DumpRoutes (), stub, "Error-- the updated routes differ from the full computation");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1457,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
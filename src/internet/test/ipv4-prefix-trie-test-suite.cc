@@ -0,0 +1,296 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-prefix-trie.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4PrefixTrie Test: compare the lookups with a walk of all
+ * the prefixes.
+ */
+class Ipv4PrefixTrieTestCase : public TestCase
+{
+public:
+  Ipv4PrefixTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4PrefixTrieTestCase::Ipv4PrefixTrieTestCase ()
+  : TestCase ("Longest prefix match")
+{
+}
+
+void
+Ipv4PrefixTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+
+  // prefixes clustered in a few networks, so that they overlap
+  std::vector<std::pair<uint32_t, uint32_t> > prefixes;
+  Ipv4PrefixTrie trie;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      uint32_t length = rand->GetInteger (0, 32);
+      uint32_t address = (rand->GetInteger (0, 3) << 24) | rand->GetInteger (0, 0xffffff);
+      uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+      prefixes.push_back (std::make_pair (address & mask, length));
+      trie.Insert (Ipv4Address (address), Ipv4Mask (mask), i);
+    }
+
+  for (uint32_t k = 0; k < 5000; k++)
+    {
+      uint32_t dest = (rand->GetInteger (0, 4) << 24) | rand->GetInteger (0, 0xffffff);
+      if (k % 2 == 0)
+        {
+          // an address of one of the prefixes
+          uint32_t i = rand->GetInteger (0, prefixes.size () - 1);
+          uint32_t length = prefixes[i].second;
+          uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+          dest = prefixes[i].first | (dest & ~mask);
+        }
+      // the values of the matching prefixes, by decreasing length
+      std::vector<std::vector<uint32_t> > expected (33);
+      for (uint32_t i = 0; i < prefixes.size (); i++)
+        {
+          uint32_t length = prefixes[i].second;
+          uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+          if ((dest & mask) == prefixes[i].first)
+            {
+              expected[32 - length].push_back (i);
+            }
+        }
+      const Ipv4PrefixTrie::Values *matches[33];
+      uint32_t n = trie.Lookup (Ipv4Address (dest), matches);
+      uint32_t m = 0;
+      for (uint32_t length = 0; length <= 32; length++)
+        {
+          if (expected[length].empty ())
+            {
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_LT (m, n, "Missing match for " << Ipv4Address (dest));
+          NS_TEST_ASSERT_MSG_EQ ((*matches[m] == expected[length]), true,
+                                 "Wrong match for " << Ipv4Address (dest) << " /" << 32 - length);
+          m++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (m, n, "Too many matches for " << Ipv4Address (dest));
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the routes selected by Ipv4StaticRouting and
+ * Ipv4GlobalRouting with their forwarding tables are the ones selected
+ * by a walk of the routes.
+ *
+ * The walk of the routes is used when a route has a non contiguous
+ * mask, so each routing protocol is compared with a copy holding an
+ * additional route with a non contiguous mask, which matches none of
+ * the destinations.
+ */
+class Ipv4RoutingFibTestCase : public TestCase
+{
+public:
+  Ipv4RoutingFibTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare two routes.
+   * \param a the first route
+   * \param b the second route
+   * \param dest the destination
+   */
+  void CheckRoutes (Ptr<Ipv4Route> a, Ptr<Ipv4Route> b, Ipv4Address dest);
+};
+
+Ipv4RoutingFibTestCase::Ipv4RoutingFibTestCase ()
+  : TestCase ("Route selection with the forwarding tables")
+{
+}
+
+void
+Ipv4RoutingFibTestCase::CheckRoutes (Ptr<Ipv4Route> a, Ptr<Ipv4Route> b, Ipv4Address dest)
+{
+  NS_TEST_ASSERT_MSG_EQ ((a == 0), (b == 0), "Route found only once for " << dest);
+  if (a != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (a->GetGateway (), b->GetGateway (), "Different gateways for " << dest);
+      NS_TEST_EXPECT_MSG_EQ (a->GetOutputDevice (), b->GetOutputDevice (), "Different devices for " << dest);
+      NS_TEST_EXPECT_MSG_EQ (a->GetSource (), b->GetSource (), "Different sources for " << dest);
+    }
+}
+
+void
+Ipv4RoutingFibTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (0x0a000001 + (i << 8)), Ipv4Mask ("/24")));
+      ipv4->SetUp (interface);
+    }
+
+  Ptr<Ipv4StaticRouting> staticFib = CreateObject<Ipv4StaticRouting> ();
+  Ptr<Ipv4StaticRouting> staticWalk = CreateObject<Ipv4StaticRouting> ();
+  Ptr<Ipv4GlobalRouting> globalFib = CreateObject<Ipv4GlobalRouting> ();
+  Ptr<Ipv4GlobalRouting> globalWalk = CreateObject<Ipv4GlobalRouting> ();
+  staticFib->SetIpv4 (ipv4);
+  staticWalk->SetIpv4 (ipv4);
+  globalFib->SetIpv4 (ipv4);
+  globalWalk->SetIpv4 (ipv4);
+  // the random choices among equal cost routes are the same if the
+  // candidate routes are the same
+  globalFib->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  globalWalk->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  globalFib->AssignStreams (2);
+  globalWalk->AssignStreams (2);
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (3);
+  std::vector<Ipv4Address> destinations;
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      // routes in 172.16.0.0/16, with a few distinct lengths and
+      // metrics to exercise the tie-breaking rules
+      static const uint32_t lengths[] = { 0, 16, 20, 24, 24, 28, 32, 32 };
+      uint32_t length = lengths[rand->GetInteger (0, 7)];
+      Ipv4Mask mask (length == 0 ? 0 : 0xffffffff << (32 - length));
+      Ipv4Address address (0xac100000 | rand->GetInteger (0, 0x3ff));
+      Ipv4Address network = address.CombineMask (mask);
+      Ipv4Address gateway (0x0a000002 + rand->GetInteger (0, 200));
+      uint32_t interface = rand->GetInteger (1, 4);
+      uint32_t metric = rand->GetInteger (0, 2);
+      staticFib->AddNetworkRouteTo (network, mask, gateway, interface, metric);
+      staticWalk->AddNetworkRouteTo (network, mask, gateway, interface, metric);
+      if (length == 32)
+        {
+          globalFib->AddHostRouteTo (address, gateway, interface);
+          globalWalk->AddHostRouteTo (address, gateway, interface);
+        }
+      else if (rand->GetInteger (0, 3) == 0)
+        {
+          globalFib->AddASExternalRouteTo (network, mask, gateway, interface);
+          globalWalk->AddASExternalRouteTo (network, mask, gateway, interface);
+        }
+      else
+        {
+          globalFib->AddNetworkRouteTo (network, mask, gateway, interface);
+          globalWalk->AddNetworkRouteTo (network, mask, gateway, interface);
+        }
+      destinations.push_back (address);
+    }
+  staticWalk->AddNetworkRouteTo (Ipv4Address ("1.0.1.0"), Ipv4Mask ("255.0.255.0"), 1);
+  globalWalk->AddNetworkRouteTo (Ipv4Address ("1.0.1.0"), Ipv4Mask ("255.0.255.0"), 1);
+  // and some destinations with no specific route
+  destinations.push_back (Ipv4Address ("172.17.0.1"));
+  destinations.push_back (Ipv4Address ("10.0.2.7"));
+  destinations.push_back (Ipv4Address ("192.168.0.1"));
+
+  for (std::vector<Ipv4Address>::const_iterator i = destinations.begin (); i != destinations.end (); i++)
+    {
+      Ipv4Header header;
+      header.SetDestination (*i);
+      for (uint32_t interface = 0; interface <= 4; interface++)
+        {
+          Ptr<NetDevice> oif = interface == 0 ? 0 : ipv4->GetNetDevice (interface);
+          Socket::SocketErrno err = Socket::ERROR_NOTERROR;
+          CheckRoutes (staticFib->RouteOutput (0, header, oif, err),
+                       staticWalk->RouteOutput (0, header, oif, err), *i);
+          CheckRoutes (globalFib->RouteOutput (0, header, oif, err),
+                       globalWalk->RouteOutput (0, header, oif, err), *i);
+        }
+    }
+
+  // the tables follow the removal of the routes
+  while (staticFib->GetNRoutes () > 300)
+    {
+      staticFib->RemoveRoute (0);
+      staticWalk->RemoveRoute (0);
+    }
+  while (globalFib->GetNRoutes () > 300)
+    {
+      globalFib->RemoveRoute (0);
+      globalWalk->RemoveRoute (0);
+    }
+  for (std::vector<Ipv4Address>::const_iterator i = destinations.begin (); i != destinations.end (); i++)
+    {
+      Ipv4Header header;
+      header.SetDestination (*i);
+      Socket::SocketErrno err = Socket::ERROR_NOTERROR;
+      CheckRoutes (staticFib->RouteOutput (0, header, 0, err),
+                   staticWalk->RouteOutput (0, header, 0, err), *i);
+      CheckRoutes (globalFib->RouteOutput (0, header, 0, err),
+                   globalWalk->RouteOutput (0, header, 0, err), *i);
+    }
+
+  staticFib->Dispose ();
+  staticWalk->Dispose ();
+  globalFib->Dispose ();
+  globalWalk->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4PrefixTrie TestSuite
+ */
+class Ipv4PrefixTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4PrefixTrieTestSuite ();
+};
+
+Ipv4PrefixTrieTestSuite::Ipv4PrefixTrieTestSuite ()
+  : TestSuite ("ipv4-prefix-trie", UNIT)
+{
+  AddTestCase (new Ipv4PrefixTrieTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4RoutingFibTestCase, TestCase::QUICK);
+}
+
+static Ipv4PrefixTrieTestSuite g_ipv4PrefixTrieTestSuite; //!< Static variable for test initialization
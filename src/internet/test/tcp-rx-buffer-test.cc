@@ -20,6 +20,7 @@
 #include "ns3/log.h"
 
 #include "ns3/tcp-rx-buffer.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -44,6 +45,11 @@ private:
    * \brief Test the SACK list update.
    */
   void TestUpdateSACKList ();
+
+  /**
+   * \brief Test the reassembly of heavily reordered segments.
+   */
+  void TestReordering ();
 };
 
 TcpRxBufferTestCase::TcpRxBufferTestCase ()
@@ -55,6 +61,7 @@ void
 TcpRxBufferTestCase::DoRun ()
 {
   TestUpdateSACKList ();
+  TestReordering ();
 }
 
 void
@@ -338,6 +345,74 @@ TcpRxBufferTestCase::TestUpdateSACKList ()
                          "SACK list should contain no element");
 }
 
+void
+TcpRxBufferTestCase::TestReordering ()
+{
+  const uint32_t segments = 1000;
+  const uint32_t segmentSize = 100;
+  TcpRxBuffer rxBuf;
+  rxBuf.SetNextRxSequence (SequenceNumber32 (1));
+  rxBuf.SetMaxBufferSize (segments * segmentSize);
+  std::vector<bool> received (segments, false);
+  uint32_t next = 0;
+  TcpHeader h;
+
+  // 7919 is prime, so that the segments arrive in a scrambled order
+  for (uint32_t n = 0; n < segments; ++n)
+    {
+      uint32_t k = (n * 7919) % segments;
+      h.SetSequenceNumber (SequenceNumber32 (1 + k * segmentSize));
+      NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (Create<Packet> (segmentSize), h), true,
+                             "Segment " << k << " not buffered");
+      received[k] = true;
+      while (next < segments && received[next])
+        {
+          ++next;
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (1 + next * segmentSize),
+                             "Sequence number differs from expected");
+      NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), next * segmentSize,
+                             "Available data differs from expected");
+      if (k > next)
+        {
+          // The first block is the whole contiguous block containing the segment
+          uint32_t head = k;
+          while (received[head - 1])
+            {
+              --head;
+            }
+          uint32_t tail = k + 1;
+          while (tail < segments && received[tail])
+            {
+              ++tail;
+            }
+          TcpOptionSack::SackList sackList = rxBuf.GetSackList ();
+          NS_TEST_ASSERT_MSG_EQ (sackList.empty (), false, "SACK list should not be empty");
+          NS_TEST_ASSERT_MSG_EQ (sackList.front ().first, SequenceNumber32 (1 + head * segmentSize),
+                                 "SACK block different than expected");
+          NS_TEST_ASSERT_MSG_EQ (sackList.front ().second, SequenceNumber32 (1 + tail * segmentSize),
+                                 "SACK block different than expected");
+          NS_TEST_ASSERT_MSG_LT_OR_EQ (sackList.size (), 4, "Too many SACK blocks");
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.GetSackListSize (), 0, "SACK list should be empty");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), segments * segmentSize,
+                         "Buffer occupancy differs from expected");
+
+  // Extract the data in chunks which are not aligned with the segments
+  uint32_t extracted = 0;
+  Ptr<Packet> p;
+  while ((p = rxBuf.Extract (1500)) != nullptr)
+    {
+      extracted += p->GetSize ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (extracted, segments * segmentSize,
+                         "Extracted data differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 0, "Buffer should be empty");
+}
+
 void
 TcpRxBufferTestCase::DoTeardown ()
 {
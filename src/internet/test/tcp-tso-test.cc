@@ -0,0 +1,677 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/queue.h"
+#include "ns3/queue-size.h"
+#include "ns3/tso-tag.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/net-device-queue-interface.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/socket.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpTsoTest");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Base class of the TCP segmentation offload tests
+ *
+ * It builds chains of nodes linked by SimpleNetDevices, and runs a bulk
+ * transfer from the first node to the last one.
+ */
+class TcpTsoTestBase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param name the name of the test case
+   */
+  TcpTsoTestBase (std::string name);
+
+protected:
+  /**
+   * \brief Link two nodes
+   * \param a the first node
+   * \param b the second node
+   * \param rate the data rate of the link
+   * \param offload whether the devices support segmentation offload
+   * \param queueSize the size of the queues of the devices, in bytes
+   * \param flowControl whether the devices stop the traffic control layer
+   *                    when their queue is full, rather than dropping packets
+   * \return the devices
+   */
+  NetDeviceContainer Link (Ptr<Node> a, Ptr<Node> b, DataRate rate, bool offload, uint32_t queueSize,
+                           bool flowControl = true);
+  /**
+   * \brief Run a transfer from a node to another
+   * \param sender the sending node
+   * \param receiver the receiving node
+   * \param address the address of the receiver
+   * \param tsoMaxSegments the TsoMaxSegments attribute of the sender
+   * \param ecn whether the sockets use ECN
+   */
+  void RunTransfer (Ptr<Node> sender, Ptr<Node> receiver, Ipv4Address address,
+                    uint32_t tsoMaxSegments, bool ecn = false);
+  /**
+   * \brief Trace the packets sent by TCP
+   * \param header the IP header
+   * \param packet the packet
+   * \param interface the interface
+   */
+  void SendOutgoing (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+  const uint32_t m_totalBytes = 2000000; //!< Bytes to transfer
+  const uint32_t m_segmentSize = 1400;   //!< TCP segment size
+  uint32_t m_sentBytes;       //!< Bytes sent by the application
+  uint32_t m_receivedBytes;   //!< Bytes received by the application
+  uint32_t m_maxSentSize;     //!< Largest packet sent by TCP, IP header included
+  Time m_lastRx;              //!< Time the last byte was received
+
+private:
+  /**
+   * \brief Send data, as long as the Tx buffer has room
+   * \param socket the sending socket
+   * \param available the room in the Tx buffer
+   */
+  void SendData (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Accept a connection
+   * \param socket the new socket
+   * \param from the address of the peer
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+  /**
+   * \brief Receive data
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+};
+
+TcpTsoTestBase::TcpTsoTestBase (std::string name)
+  : TestCase (name)
+{
+}
+
+NetDeviceContainer
+TcpTsoTestBase::Link (Ptr<Node> a, Ptr<Node> b, DataRate rate, bool offload, uint32_t queueSize,
+                      bool flowControl)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (5)));
+  NetDeviceContainer devices;
+  Ptr<Node> nodes[] = {a, b};
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetMtu (1500);
+      device->SetAttribute ("DataRate", DataRateValue (rate));
+      device->SetAttribute ("SegmentationOffload", BooleanValue (offload));
+      // A super-segment is a single packet: limit the queue in bytes
+      device->GetQueue ()->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (QueueSizeUnit::BYTES, queueSize)));
+      device->SetChannel (channel);
+      nodes[i]->AddDevice (device);
+      if (flowControl)
+        {
+          Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface> ();
+          ndqi->GetTxQueue (0)->ConnectQueueTraces (device->GetQueue ());
+          device->AggregateObject (ndqi);
+        }
+      devices.Add (device);
+    }
+  return devices;
+}
+
+void
+TcpTsoTestBase::SendData (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sentBytes < m_totalBytes && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (socket->GetTxAvailable (), m_totalBytes - m_sentBytes);
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_sentBytes += sent;
+    }
+}
+
+void
+TcpTsoTestBase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpTsoTestBase::Receive, this));
+}
+
+void
+TcpTsoTestBase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_receivedBytes += packet->GetSize ();
+      m_lastRx = Simulator::Now ();
+    }
+}
+
+void
+TcpTsoTestBase::SendOutgoing (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  m_maxSentSize = std::max (m_maxSentSize, packet->GetSize () + header.GetSerializedSize ());
+}
+
+void
+TcpTsoTestBase::RunTransfer (Ptr<Node> sender, Ptr<Node> receiver, Ipv4Address address,
+                             uint32_t tsoMaxSegments, bool ecn)
+{
+  m_sentBytes = 0;
+  m_receivedBytes = 0;
+  m_maxSentSize = 0;
+  m_lastRx = Seconds (0);
+
+  sender->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&TcpTsoTestBase::SendOutgoing, this));
+
+  Ptr<Socket> server = Socket::CreateSocket (receiver, TcpSocketFactory::GetTypeId ());
+  server->SetAttribute ("RcvBufSize", UintegerValue (1 << 20));
+  if (ecn)
+    {
+      server->SetAttribute ("EcnMode", EnumValue (TcpSocketBase::ClassicEcn));
+    }
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpTsoTestBase::Accept, this));
+
+  Ptr<Socket> client = Socket::CreateSocket (sender, TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SegmentSize", UintegerValue (m_segmentSize));
+  client->SetAttribute ("SndBufSize", UintegerValue (1 << 20));
+  client->SetAttribute ("TsoMaxSegments", UintegerValue (tsoMaxSegments));
+  if (ecn)
+    {
+      client->SetAttribute ("EcnMode", EnumValue (TcpSocketBase::ClassicEcn));
+    }
+  client->Connect (InetSocketAddress (address, 9));
+  client->SetSendCallback (MakeCallback (&TcpTsoTestBase::SendData, this));
+  Simulator::ScheduleWithContext (sender->GetId (), MilliSeconds (1),
+                                  &TcpTsoTestBase::SendData, this, client, 0);
+
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_sentBytes, m_totalBytes, "The application could not send all its data");
+  NS_TEST_ASSERT_MSG_EQ (m_receivedBytes, m_totalBytes, "The receiver did not receive all the data");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload test
+ *
+ * The same bulk transfer is run three times: without TSO, with TSO on
+ * devices which support segmentation offload, and with TSO on devices
+ * which do not (where the IP layer segments the super-segments).  All
+ * the data must be received, the super-segments must only reach the
+ * devices which support them, and the transfer must take about the same
+ * time, as the devices transmit the super-segments as bursts of
+ * segments.
+ */
+class TcpTsoTestCase : public TcpTsoTestBase
+{
+public:
+  TcpTsoTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Run a transfer over a single link without queue disc
+   * \param tsoMaxSegments the TsoMaxSegments attribute of the sender
+   * \param offload whether the devices support segmentation offload
+   */
+  void RunTransfer (uint32_t tsoMaxSegments, bool offload);
+  /**
+   * \brief Trace the packets sent by the sender's IP layer
+   * \param packet the packet
+   * \param ipv4 the IP layer
+   * \param interface the interface
+   */
+  void IpTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  uint32_t m_ipPackets;       //!< Packets sent by the sender's IP layer
+  uint32_t m_maxIpPacketSize; //!< Largest packet sent by the sender's IP layer
+};
+
+TcpTsoTestCase::TcpTsoTestCase ()
+  : TcpTsoTestBase ("TCP segmentation offload")
+{
+}
+
+void
+TcpTsoTestCase::IpTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_ipPackets++;
+  m_maxIpPacketSize = std::max (m_maxIpPacketSize, packet->GetSize ());
+}
+
+void
+TcpTsoTestCase::RunTransfer (uint32_t tsoMaxSegments, bool offload)
+{
+  m_ipPackets = 0;
+  m_maxIpPacketSize = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer devices = Link (nodes.Get (0), nodes.Get (1), DataRate ("1Gbps"), offload, 150000);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  // A queue disc only gets segments
+  TrafficControlHelper tch;
+  tch.Uninstall (devices);
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpTsoTestCase::IpTx, this));
+
+  TcpTsoTestBase::RunTransfer (nodes.Get (0), nodes.Get (1), interfaces.GetAddress (1), tsoMaxSegments);
+}
+
+void
+TcpTsoTestCase::DoRun (void)
+{
+  RunTransfer (1, false);
+  Time reference = m_lastRx;
+  uint32_t packets = m_ipPackets;
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxIpPacketSize, 1500, "Packet larger than the MTU without TSO");
+
+  RunTransfer (16, true);
+  NS_TEST_ASSERT_MSG_GT (m_maxIpPacketSize, 1500, "No super-segment sent");
+  NS_TEST_ASSERT_MSG_LT (m_ipPackets, packets / 2, "The super-segments do not reduce the packets sent");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_lastRx.GetSeconds (), reference.GetSeconds (), reference.GetSeconds () / 10,
+                             "The super-segments change the transfer time");
+
+  RunTransfer (16, false);
+  NS_TEST_ASSERT_MSG_GT (m_maxSentSize, 1500, "No super-segment sent by TCP");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxIpPacketSize, 1500, "Super-segment sent to a device without segmentation offload");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_lastRx.GetSeconds (), reference.GetSeconds (), reference.GetSeconds () / 10,
+                             "The software segmentation changes the transfer time");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload over several hops
+ *
+ * The sender's link supports segmentation offload, and the router's
+ * link to the receiver does not: the router must forward real TCP
+ * segments, no IP fragments, and the receiver must get all the data.
+ */
+class TcpTsoMultiHopTestCase : public TcpTsoTestBase
+{
+public:
+  TcpTsoMultiHopTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Trace the packets sent by the router's IP layer
+   * \param packet the packet, IP header included
+   * \param ipv4 the IP layer
+   * \param interface the interface
+   */
+  void RouterTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  uint32_t m_routerPackets;   //!< Packets forwarded by the router
+  uint32_t m_routerFragments; //!< IP fragments sent by the router
+  uint32_t m_maxRouterSize;   //!< Largest packet sent by the router
+};
+
+TcpTsoMultiHopTestCase::TcpTsoMultiHopTestCase ()
+  : TcpTsoTestBase ("TCP segmentation offload over several hops")
+{
+}
+
+void
+TcpTsoMultiHopTestCase::RouterTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ipv4Header header;
+  packet->PeekHeader (header);
+  if (header.GetDestination () != Ipv4Address ("10.1.2.2"))
+    {
+      return;
+    }
+  m_routerPackets++;
+  m_maxRouterSize = std::max (m_maxRouterSize, packet->GetSize ());
+  if (!header.IsLastFragment () || header.GetFragmentOffset () != 0)
+    {
+      m_routerFragments++;
+    }
+}
+
+void
+TcpTsoMultiHopTestCase::DoRun (void)
+{
+  m_routerPackets = 0;
+  m_routerFragments = 0;
+  m_maxRouterSize = 0;
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  NetDeviceContainer first = Link (nodes.Get (0), nodes.Get (1), DataRate ("1Gbps"), true, 150000);
+  NetDeviceContainer second = Link (nodes.Get (1), nodes.Get (2), DataRate ("1Gbps"), false, 150000);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  address.Assign (first);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (second);
+  // The router splits the super-segments for its device, not for a queue disc
+  TrafficControlHelper tch;
+  tch.Uninstall (first);
+  tch.Uninstall (second);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpTsoMultiHopTestCase::RouterTx, this));
+
+  RunTransfer (nodes.Get (0), nodes.Get (2), interfaces.GetAddress (1), 16);
+
+  NS_TEST_ASSERT_MSG_GT (m_maxSentSize, 1500, "No super-segment sent");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxRouterSize, 1500, "Super-segment forwarded to a device without segmentation offload");
+  NS_TEST_ASSERT_MSG_EQ (m_routerFragments, 0, "Super-segment forwarded as IP fragments");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (m_routerPackets, m_totalBytes / m_segmentSize, "The router did not forward segments");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload with queue drops
+ *
+ * The queue of the sender's device, which supports segmentation
+ * offload, overflows: it must only drop single segments, never a whole
+ * super-segment, and the receiver must get all the data.
+ */
+class TcpTsoQueueDropTestCase : public TcpTsoTestBase
+{
+public:
+  TcpTsoQueueDropTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Trace the packets dropped by the queue of the sender's device
+   * \param packet the packet
+   */
+  void Drop (Ptr<const Packet> packet);
+
+  uint32_t m_drops;           //!< Packets dropped
+  uint32_t m_dropsTso;        //!< Super-segments dropped
+};
+
+TcpTsoQueueDropTestCase::TcpTsoQueueDropTestCase ()
+  : TcpTsoTestBase ("TCP segmentation offload with queue drops")
+{
+}
+
+void
+TcpTsoQueueDropTestCase::Drop (Ptr<const Packet> packet)
+{
+  TsoTag tsoTag;
+  m_drops++;
+  if (packet->PeekPacketTag (tsoTag) || packet->GetSize () > 1500)
+    {
+      m_dropsTso++;
+    }
+}
+
+void
+TcpTsoQueueDropTestCase::DoRun (void)
+{
+  m_drops = 0;
+  m_dropsTso = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  // Without flow control, no queue disc is installed and the device queue drops the packets
+  NetDeviceContainer devices = Link (nodes.Get (0), nodes.Get (1), DataRate ("100Mbps"), true, 30000, false);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  DynamicCast<SimpleNetDevice> (devices.Get (0))->GetQueue ()->TraceConnectWithoutContext ("Drop", MakeCallback (&TcpTsoQueueDropTestCase::Drop, this));
+
+  RunTransfer (nodes.Get (0), nodes.Get (1), interfaces.GetAddress (1), 16);
+
+  NS_TEST_ASSERT_MSG_GT (m_maxSentSize, 1500, "No super-segment sent");
+  NS_TEST_ASSERT_MSG_GT (m_drops, 0, "The queue did not overflow");
+  NS_TEST_ASSERT_MSG_EQ (m_dropsTso, 0, "Super-segment dropped by the queue");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload with ECN marks
+ *
+ * A RED queue disc marks the packets of the sender's device, which
+ * supports segmentation offload: it must only get, and mark, single
+ * segments, and the receiver must get all the data.
+ */
+class TcpTsoEcnTestCase : public TcpTsoTestBase
+{
+public:
+  TcpTsoEcnTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Trace the packets enqueued in the queue disc
+   * \param item the packet
+   */
+  void Enqueue (Ptr<const QueueDiscItem> item);
+  /**
+   * \brief Trace the packets marked by the queue disc
+   * \param item the packet
+   * \param reason the reason of the mark
+   */
+  void Mark (Ptr<const QueueDiscItem> item, const char *reason);
+
+  uint32_t m_maxEnqueuedSize; //!< Largest packet enqueued in the queue disc
+  uint32_t m_marks;           //!< Packets marked
+  uint32_t m_maxMarkedSize;   //!< Largest packet marked
+};
+
+TcpTsoEcnTestCase::TcpTsoEcnTestCase ()
+  : TcpTsoTestBase ("TCP segmentation offload with ECN marks")
+{
+}
+
+void
+TcpTsoEcnTestCase::Enqueue (Ptr<const QueueDiscItem> item)
+{
+  m_maxEnqueuedSize = std::max (m_maxEnqueuedSize, item->GetSize ());
+}
+
+void
+TcpTsoEcnTestCase::Mark (Ptr<const QueueDiscItem> item, const char *reason)
+{
+  m_marks++;
+  m_maxMarkedSize = std::max (m_maxMarkedSize, item->GetSize ());
+}
+
+void
+TcpTsoEcnTestCase::DoRun (void)
+{
+  m_maxEnqueuedSize = 0;
+  m_marks = 0;
+  m_maxMarkedSize = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer devices = Link (nodes.Get (0), nodes.Get (1), DataRate ("100Mbps"), true, 150000);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::RedQueueDisc",
+                        "UseEcn", BooleanValue (true),
+                        "LinkBandwidth", StringValue ("100Mbps"),
+                        "LinkDelay", StringValue ("5ms"),
+                        "MeanPktSize", UintegerValue (1500),
+                        "MinTh", DoubleValue (5),
+                        "MaxTh", DoubleValue (15),
+                        "MaxSize", QueueSizeValue (QueueSize ("100p")));
+  QueueDiscContainer queueDiscs = tch.Install (devices.Get (0));
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  queueDiscs.Get (0)->TraceConnectWithoutContext ("Enqueue", MakeCallback (&TcpTsoEcnTestCase::Enqueue, this));
+  queueDiscs.Get (0)->TraceConnectWithoutContext ("Mark", MakeCallback (&TcpTsoEcnTestCase::Mark, this));
+
+  RunTransfer (nodes.Get (0), nodes.Get (1), interfaces.GetAddress (1), 16, true);
+
+  NS_TEST_ASSERT_MSG_GT (m_maxSentSize, 1500, "No super-segment sent");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxEnqueuedSize, 1500, "Super-segment enqueued in the queue disc");
+  NS_TEST_ASSERT_MSG_GT (m_marks, 0, "No packet marked");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxMarkedSize, 1500, "Super-segment marked");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP generic receive offload test
+ *
+ * The same bulk transfer, with TSO over devices without segmentation
+ * offload, is run with and without GRO at the receiver.  The GRO must
+ * merge the segments split by the sender's IP layer, and so reduce the
+ * acknowledgments the receiver sends, without changing the data
+ * received and the transfer time.  The sender uses TSO, which grows the
+ * window on the stretch ACKs as on the delayed ACKs they replace.
+ */
+class TcpGroTestCase : public TcpTsoTestBase
+{
+public:
+  TcpGroTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Run a transfer over a single link
+   * \param groMaxSegments the GroMaxSegments attribute of the receiver
+   */
+  void RunTransfer (uint32_t groMaxSegments);
+  /**
+   * \brief Trace the packets sent by the receiver's IP layer
+   * \param packet the packet
+   * \param ipv4 the IP layer
+   * \param interface the interface
+   */
+  void ReceiverTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  uint32_t m_acks;            //!< Packets sent by the receiver
+};
+
+TcpGroTestCase::TcpGroTestCase ()
+  : TcpTsoTestBase ("TCP generic receive offload")
+{
+}
+
+void
+TcpGroTestCase::ReceiverTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_acks++;
+}
+
+void
+TcpGroTestCase::RunTransfer (uint32_t groMaxSegments)
+{
+  m_acks = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer devices = Link (nodes.Get (0), nodes.Get (1), DataRate ("1Gbps"), false, 150000);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  nodes.Get (1)->GetObject<TcpL4Protocol> ()->SetAttribute ("GroMaxSegments", UintegerValue (groMaxSegments));
+  nodes.Get (1)->GetObject<TcpL4Protocol> ()->SetAttribute ("GroFlushTimeout", TimeValue (MicroSeconds (100)));
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpGroTestCase::ReceiverTx, this));
+
+  TcpTsoTestBase::RunTransfer (nodes.Get (0), nodes.Get (1), interfaces.GetAddress (1), 16);
+}
+
+void
+TcpGroTestCase::DoRun (void)
+{
+  RunTransfer (1);
+  Time reference = m_lastRx;
+  uint32_t acks = m_acks;
+
+  RunTransfer (16);
+  NS_TEST_ASSERT_MSG_LT (m_acks, acks / 2, "The GRO does not reduce the acknowledgments");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_lastRx.GetSeconds (), reference.GetSeconds (), reference.GetSeconds () / 10,
+                             "The GRO changes the transfer time");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload TestSuite
+ */
+class TcpTsoTestSuite : public TestSuite
+{
+public:
+  TcpTsoTestSuite ()
+    : TestSuite ("tcp-tso", UNIT)
+  {
+    AddTestCase (new TcpTsoTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTsoMultiHopTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTsoQueueDropTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTsoEcnTestCase, TestCase::QUICK);
+    AddTestCase (new TcpGroTestCase, TestCase::QUICK);
+  }
+};
+
+static TcpTsoTestSuite g_tcpTsoTestSuite; //!< Static variable for test initialization
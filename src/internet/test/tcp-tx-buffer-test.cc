@@ -49,6 +49,8 @@ private:
   void TestTransmittedBlock ();
   /** \brief Test the generation of the "next" block */
   void TestNextSeg ();
+  /** \brief Test the scoreboard with a large window */
+  void TestLargeWindow ();
 };
 
 TcpTxBufferTestCase::TcpTxBufferTestCase ()
@@ -81,6 +83,8 @@ TcpTxBufferTestCase::DoRun ()
                        &TcpTxBufferTestCase::TestTransmittedBlock, this);
   Simulator::Schedule (Seconds (0.0),
                        &TcpTxBufferTestCase::TestNextSeg, this);
+  Simulator::Schedule (Seconds (0.0),
+                       &TcpTxBufferTestCase::TestLargeWindow, this);
 
   Simulator::Run ();
   Simulator::Destroy ();
@@ -342,6 +346,90 @@ TcpTxBufferTestCase::TestTransmittedBlock ()
 {
 }
 
+void
+TcpTxBufferTestCase::TestLargeWindow ()
+{
+  // A window of 2000 segments, in which one segment every ten is lost
+  const uint32_t segmentSize = 1000;
+  const uint32_t segments = 2000;
+  TcpTxBuffer txBuf;
+  SequenceNumber32 head (1);
+  txBuf.SetHeadSequence (head);
+  txBuf.SetSegmentSize (segmentSize);
+  txBuf.SetDupAckThresh (3);
+  txBuf.SetMaxBufferSize (segments * segmentSize);
+
+  txBuf.Add (Create<Packet> (segments * segmentSize));
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + i * segmentSize);
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), segments * segmentSize,
+                         "TxBuf miscalculates size of in flight segments");
+
+  // The receiver reports the three most recent blocks with each ACK
+  for (uint32_t i = 1; i < segments; ++i)
+    {
+      if (i % 10 == 0)
+        {
+          continue;
+        }
+      TcpOptionSack::SackList sackList;
+      for (uint32_t block = i / 10; block + 3 > i / 10; --block)
+        {
+          SequenceNumber32 start = head + (block * 10 + 1) * segmentSize;
+          SequenceNumber32 end = head + std::min (block * 10 + 10, i + 1) * segmentSize;
+          sackList.push_back (TcpOptionSack::SackBlock (start, end));
+          if (block == 0)
+            {
+              break;
+            }
+        }
+      txBuf.Update (sackList);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetSacked (), (segments - segments / 10) * segmentSize,
+                         "Wrong number of sacked bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetLost (), segments / 10 * segmentSize,
+                         "Wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + i * segmentSize), (i % 10 == 0),
+                             "Wrong lost status of segment " << i);
+    }
+
+  // Retransmit the lost segments, in order
+  SequenceNumber32 next;
+  for (uint32_t i = 0; i < segments; i += 10)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&next, true), true,
+                             "No next segment found");
+      NS_TEST_ASSERT_MSG_EQ (next, head + i * segmentSize,
+                             "Wrong next segment");
+      txBuf.CopyFromSequence (segmentSize, next);
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&next, true), false,
+                         "Next segment found, but all have been retransmitted");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), segments / 10 * segmentSize,
+                         "TxBuf miscalculates size of in flight segments");
+
+  // The first half is acknowledged
+  txBuf.DiscardUpTo (head + segments / 2 * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetSacked (), (segments - segments / 10) / 2 * segmentSize,
+                         "Wrong number of sacked bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetLost (), segments / 20 * segmentSize,
+                         "Wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), segments / 20 * segmentSize,
+                         "TxBuf miscalculates size of in flight segments");
+
+  txBuf.DiscardUpTo (head + segments * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Size (), 0, "Data inside the buffer");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+}
+
 void
 TcpTxBufferTestCase::DoTeardown ()
 {
@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/lte-module.h"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Measure the run time of a scenario of several cells, whose UEs have
+ * saturated downlink and uplink bearers, with the sequential scheduling
+ * and with the ParallelScheduling attribute of the eNB MACs, for each
+ * number of threads given.
+ *
+ * The schedulers of the cells run concurrently on up to as many cores as
+ * threads, so that the speedup is bounded by the share of the schedulers
+ * in the run time, and by the number of cores.  Use an optimized build:
+ *
+ *   ./waf --run "lena-parallel-scheduling --nEnb=16 --nUe=10 --threads=1,2,4"
+ */
+
+NS_LOG_COMPONENT_DEFINE ("LenaParallelScheduling");
+
+/**
+ * Run the scenario once
+ * \param nEnb the number of cells
+ * \param nUe the number of UEs per cell
+ * \param simTime the simulated time
+ * \param scheduler the type of the schedulers
+ * \param parallel whether the schedulers of the cells run concurrently
+ * \param nThreads the number of threads running the schedulers
+ * \return the wall clock time of the run, in milliseconds
+ */
+static int64_t
+RunScenario (uint32_t nEnb, uint32_t nUe, double simTime, std::string scheduler,
+             bool parallel, uint32_t nThreads)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::LteEnbMac::ParallelScheduling", BooleanValue (parallel));
+  Config::SetGlobal ("FfMacSchedulerThreadCount", UintegerValue (nThreads));
+
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetSchedulerType (scheduler);
+
+  NodeContainer enbNodes;
+  enbNodes.Create (nEnb);
+  NodeContainer ueNodes;
+  ueNodes.Create (nEnb * nUe);
+
+  // the cells on a square grid, and their UEs on a circle around the eNB
+  double distance = 500;
+  uint32_t nColumns = std::ceil (std::sqrt (nEnb));
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nEnb; i++)
+    {
+      positions->Add (Vector (distance * (i % nColumns), distance * (i / nColumns), 30));
+    }
+  for (uint32_t i = 0; i < nEnb; i++)
+    {
+      for (uint32_t j = 0; j < nUe; j++)
+        {
+          double angle = 2 * M_PI * j / nUe;
+          double radius = 50 + 100.0 * j / nUe;
+          positions->Add (Vector (distance * (i % nColumns) + radius * std::cos (angle),
+                                  distance * (i / nColumns) + radius * std::sin (angle), 1.5));
+        }
+    }
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positions);
+  mobility.Install (enbNodes);
+  mobility.Install (ueNodes);
+
+  NetDeviceContainer enbDevs = lteHelper->InstallEnbDevice (enbNodes);
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  // the streams are allocated from the same counter by all the runs
+  int64_t stream = lteHelper->AssignStreams (enbDevs, 1);
+  lteHelper->AssignStreams (ueDevs, 1 + stream);
+  for (uint32_t i = 0; i < nEnb; i++)
+    {
+      for (uint32_t j = 0; j < nUe; j++)
+        {
+          lteHelper->Attach (ueDevs.Get (i * nUe + j), enbDevs.Get (i));
+        }
+    }
+  // without EPC, the RLC of the bearers is saturated
+  lteHelper->ActivateDataRadioBearer (ueDevs, EpsBearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT));
+
+  Simulator::Stop (Seconds (simTime));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+  Simulator::Destroy ();
+  return elapsed;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nEnb = 16;
+  uint32_t nUe = 10;
+  double simTime = 0.5;
+  std::string scheduler = "ns3::PfFfMacScheduler";
+  std::string threads = "1,2,4";
+
+  CommandLine cmd;
+  cmd.AddValue ("nEnb", "Number of cells", nEnb);
+  cmd.AddValue ("nUe", "Number of UEs per cell", nUe);
+  cmd.AddValue ("simTime", "Simulated time of each run (in seconds)", simTime);
+  cmd.AddValue ("scheduler", "Type of the schedulers", scheduler);
+  cmd.AddValue ("threads", "Comma-separated numbers of threads of the parallel runs", threads);
+  cmd.Parse (argc, argv);
+
+  std::vector<uint32_t> threadCounts;
+  std::istringstream list (threads);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      threadCounts.push_back (std::stoul (item));
+    }
+
+  std::cout << nEnb << " cells of " << nUe << " UEs, " << simTime << " s, "
+            << scheduler << ", " << std::thread::hardware_concurrency ()
+            << " hardware threads" << std::endl;
+
+  int64_t sequential = RunScenario (nEnb, nUe, simTime, scheduler, false, 1);
+  std::cout << std::setw (12) << "sequential" << std::setw (10) << sequential << " ms" << std::endl;
+  for (std::vector<uint32_t>::const_iterator it = threadCounts.begin (); it != threadCounts.end (); ++it)
+    {
+      int64_t parallel = RunScenario (nEnb, nUe, simTime, scheduler, true, *it);
+      std::ostringstream label;
+      label << *it << (*it == 1 ? " thread" : " threads");
+      std::cout << std::setw (12) << label.str () << std::setw (10) << parallel << " ms"
+                << "  speedup " << std::fixed << std::setprecision (2)
+                << (parallel > 0 ? (double) sequential / parallel : 0) << std::endl;
+    }
+
+  return 0;
+}
@@ -0,0 +1,294 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ns3/core-config.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#ifdef HAVE_PTHREAD_H
+#include <condition_variable>
+#include <mutex>
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+#include "ff-mac-scheduler-executor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FfMacSchedulerExecutor");
+
+/// The number of threads running the schedulers of the cells
+static GlobalValue g_threadCount = GlobalValue ("FfMacSchedulerThreadCount",
+                                                "The number of threads running the schedulers "
+                                                "of the eNB MACs with the ParallelScheduling "
+                                                "attribute. Zero selects the number of hardware "
+                                                "threads.",
+                                                UintegerValue (0),
+                                                MakeUintegerChecker<uint32_t> ());
+
+/**
+ * \ingroup lte
+ *
+ * \brief The state of the FfMacSchedulerExecutor
+ *
+ * The worker threads wait for a new batch of tasks with a generation
+ * counter rather than a SystemCondition, whose Wait () would miss a
+ * batch started before the worker begins to wait.
+ */
+struct FfMacSchedulerExecutorState
+{
+  FfMacSchedulerExecutorState ()
+    : next (0),
+      destroyScheduled (false),
+      serial (false)
+#ifdef HAVE_PTHREAD_H
+    , generation (0),
+      busy (0),
+      exit (false)
+#endif /* HAVE_PTHREAD_H */
+  {
+  }
+  ~FfMacSchedulerExecutorState ()
+  {
+#ifdef HAVE_PTHREAD_H
+    StopWorkers ();
+#endif /* HAVE_PTHREAD_H */
+  }
+#ifdef HAVE_PTHREAD_H
+  /// Ask the worker threads to exit, and wait for them
+  void StopWorkers (void)
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      exit = true;
+    }
+    start.notify_all ();
+    for (std::vector<Ptr<SystemThread> >::iterator it = workers.begin (); it != workers.end (); ++it)
+      {
+        (*it)->Join ();
+      }
+    workers.clear ();
+    exit = false;
+  }
+#endif /* HAVE_PTHREAD_H */
+
+  std::vector<Callback<void> > pending;  //!< Tasks submitted and not run yet
+  std::vector<Callback<void> > running;  //!< Tasks of the batch being run
+  std::atomic<uint32_t> next;            //!< Index of the next task of the batch to run
+  bool destroyScheduled;                 //!< True if Destroy is scheduled
+  bool serial;                           //!< True if the tasks must run on the calling thread
+#ifdef HAVE_PTHREAD_H
+  std::vector<Ptr<SystemThread> > workers; //!< The worker threads
+  std::mutex mutex;                      //!< Mutex protecting the fields below
+  std::condition_variable start;         //!< Signaled when a batch starts or the workers must exit
+  std::condition_variable done;          //!< Signaled when the last worker completes a batch
+  uint64_t generation;                   //!< Number of batches started so far
+  uint32_t busy;                         //!< Number of workers still running the batch
+  bool exit;                             //!< True if the workers must exit
+#endif /* HAVE_PTHREAD_H */
+};
+
+/**
+ * \ingroup lte
+ * \brief Check if any log component is enabled
+ *
+ * The log output is not thread-safe, and the schedulers log from their
+ * trigger requests, so that the tasks must then run one after the other.
+ *
+ * \return true if any log component is enabled
+ */
+static bool
+IsAnyLogEnabled (void)
+{
+#ifdef NS3_LOG_ENABLE
+  LogComponent::ComponentList *components = LogComponent::GetComponentList ();
+  for (LogComponent::ComponentList::const_iterator it = components->begin (); it != components->end (); ++it)
+    {
+      if (!it->second->IsNoneEnabled ())
+        {
+          return true;
+        }
+    }
+#endif /* NS3_LOG_ENABLE */
+  return false;
+}
+
+/**
+ * \ingroup lte
+ * \brief Get the state of the FfMacSchedulerExecutor
+ * \return the state
+ */
+static FfMacSchedulerExecutorState &
+GetFfMacSchedulerExecutorState (void)
+{
+  static FfMacSchedulerExecutorState state;
+  return state;
+}
+
+void
+FfMacSchedulerExecutor::Submit (Callback<void> task)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+  if (!state.destroyScheduled)
+    {
+      NS_ABORT_MSG_IF (Simulator::GetImplementation ()->GetInstanceTypeId ().GetName () == "ns3::MultithreadedSimulatorImpl",
+                       "The parallel scheduling of the eNB MACs cannot be used with the MultithreadedSimulatorImpl");
+      Simulator::ScheduleDestroy (&FfMacSchedulerExecutor::Destroy);
+      state.destroyScheduled = true;
+      state.serial = IsAnyLogEnabled ();
+      if (state.serial)
+        {
+          NS_LOG_WARN ("Logging is enabled: the schedulers of the cells run one after the other");
+        }
+    }
+  state.pending.push_back (task);
+}
+
+void
+FfMacSchedulerExecutor::RunPending (void)
+{
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+  if (state.pending.empty ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (state.pending.size ());
+  state.running.swap (state.pending);
+  state.next = 0;
+
+  UintegerValue threadCount;
+  g_threadCount.GetValue (threadCount);
+  uint32_t nThreads = threadCount.Get ();
+  if (nThreads == 0)
+    {
+      nThreads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  nThreads = std::min<uint32_t> (nThreads, state.running.size ());
+  if (state.serial)
+    {
+      nThreads = 1;
+    }
+
+#ifdef HAVE_PTHREAD_H
+  bool parallel = nThreads > 1;
+  if (parallel)
+    {
+      // the calling thread runs tasks too
+      StartWorkers (nThreads - 1);
+      {
+        std::lock_guard<std::mutex> lock (state.mutex);
+        state.busy = state.workers.size ();
+        state.generation++;
+      }
+      state.start.notify_all ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  RunTasks ();
+#ifdef HAVE_PTHREAD_H
+  if (parallel)
+    {
+      std::unique_lock<std::mutex> lock (state.mutex);
+      while (state.busy != 0)
+        {
+          state.done.wait (lock);
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
+  state.running.clear ();
+}
+
+void
+FfMacSchedulerExecutor::RunTasks (void)
+{
+  // no logging here, since the workers run this concurrently
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+  uint32_t nTasks = state.running.size ();
+  for (uint32_t i = state.next++; i < nTasks; i = state.next++)
+    {
+      // calling a callback does not touch its reference count
+      state.running[i] ();
+    }
+}
+
+void
+FfMacSchedulerExecutor::StartWorkers (uint32_t nWorkers)
+{
+#ifdef HAVE_PTHREAD_H
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+  while (state.workers.size () < nWorkers)
+    {
+      NS_LOG_LOGIC ("Starting worker thread " << state.workers.size () + 1);
+      // only the calling thread changes the generation
+      Ptr<SystemThread> worker = Create<SystemThread> (MakeBoundCallback (&FfMacSchedulerExecutor::WorkerEntry,
+                                                                          state.generation));
+      worker->Start ();
+      state.workers.push_back (worker);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+FfMacSchedulerExecutor::WorkerEntry (uint64_t generation)
+{
+#ifdef HAVE_PTHREAD_H
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (state.mutex);
+        while (state.generation == generation && !state.exit)
+          {
+            state.start.wait (lock);
+          }
+        if (state.exit)
+          {
+            return;
+          }
+        generation = state.generation;
+      }
+      RunTasks ();
+      {
+        std::lock_guard<std::mutex> lock (state.mutex);
+        if (--state.busy == 0)
+          {
+            state.done.notify_one ();
+          }
+      }
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+FfMacSchedulerExecutor::Destroy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FfMacSchedulerExecutorState &state = GetFfMacSchedulerExecutorState ();
+#ifdef HAVE_PTHREAD_H
+  state.StopWorkers ();
+#endif /* HAVE_PTHREAD_H */
+  state.pending.clear ();
+  state.destroyScheduled = false;
+  state.serial = false;
+}
+
+} // namespace ns3
@@ -0,0 +1,93 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FF_MAC_SCHEDULER_EXECUTOR_H
+#define FF_MAC_SCHEDULER_EXECUTOR_H
+
+#include <ns3/callback.h>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * \brief Run the schedulers of several cells concurrently
+ *
+ * The eNB MACs whose ParallelScheduling attribute is set submit the
+ * requests of a subframe to their scheduler as a task, instead of
+ * calling the scheduler at once, and schedule their completion as an
+ * event at the same time.  The first completion of a subframe runs all
+ * the tasks submitted so far, on up to FfMacSchedulerThreadCount
+ * threads (a global value, 0 meaning the number of hardware threads),
+ * and each MAC then applies the indications of its scheduler in its own
+ * completion event.  The schedulers of the cells are independent within
+ * a subframe, and the indications are applied in the order of the
+ * events, so that the results do not depend on the number of threads.
+ *
+ * A task must only access the objects of its own cell, and must not
+ * schedule events nor copy the Ptr of objects shared with other cells,
+ * since the reference counts are not atomic (see FfMacScheduler for the
+ * methods of the schedulers and of the frequency reuse algorithms which
+ * run in a task).  Since the log output is not thread-safe either, the
+ * tasks run one after the other on the calling thread when any log
+ * component is enabled at the first submission of the simulation.
+ *
+ * The tasks are run by the thread calling RunPending, so that the
+ * executor cannot be used with a simulator executing several events at
+ * the same time, such as the MultithreadedSimulatorImpl.
+ */
+class FfMacSchedulerExecutor
+{
+public:
+  /**
+   * \brief Add a task to run with the other ones of the same subframe
+   * \param task the task
+   */
+  static void Submit (Callback<void> task);
+
+  /**
+   * \brief Run all the tasks submitted so far, and wait for them to
+   * complete
+   */
+  static void RunPending (void);
+
+private:
+  /**
+   * \brief Run the tasks not yet claimed by another thread
+   */
+  static void RunTasks (void);
+  /**
+   * \brief Start the worker threads which are missing
+   * \param nWorkers the number of workers needed
+   */
+  static void StartWorkers (uint32_t nWorkers);
+  /**
+   * \brief The loop of a worker thread
+   * \param generation the number of the last batch of tasks started
+   * before the worker
+   */
+  static void WorkerEntry (uint64_t generation);
+  /**
+   * \brief Stop the worker threads and drop the pending tasks, at the end
+   * of the simulation
+   */
+  static void Destroy (void);
+};
+
+} // namespace ns3
+
+#endif /* FF_MAC_SCHEDULER_EXECUTOR_H */
@@ -48,7 +48,23 @@ class LteFfrSapUser;
  * the helper object can plug on the MAC a scheduler implementation based on the
  * FF MAC Sched API.
  *
+ * When the ParallelScheduling attribute of the LteEnbMac is set, the
+ * following methods of the FfMacSchedSapProvider run on the threads of
+ * the FfMacSchedulerExecutor, concurrently with the schedulers of the
+ * other cells:
+ * - SchedDlTriggerReq,
+ * - SchedUlCqiInfoReq,
+ * - SchedUlMacCtrlInfoReq,
+ * - SchedUlTriggerReq.
  *
+ * They must be reentrant across cells: they must only access the state of
+ * their own scheduler and of the frequency reuse algorithm of their cell
+ * (see LteFfrSapProvider), and must not schedule events, draw from random
+ * variables shared with other cells, or copy the Ptr of shared objects.
+ * Their calls to the FfMacSchedSapUser and to
+ * FfMacCschedSapUser::CschedUeConfigUpdateInd are recorded, and applied
+ * by the MAC afterwards.  The other methods always run in the simulation
+ * thread.
  */
 class FfMacScheduler : public Object
 {
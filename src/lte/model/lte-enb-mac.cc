@@ -27,6 +27,7 @@
 #include <ns3/pointer.h>
 #include <ns3/packet.h>
 #include <ns3/simulator.h>
+#include <ns3/boolean.h>
 
 #include "lte-amc.h"
 #include "lte-control-messages.h"
@@ -40,6 +41,7 @@
 #include "ns3/lte-mac-sap.h"
 #include "ns3/lte-enb-cmac-sap.h"
 #include <ns3/lte-common.h>
+#include <ns3/ff-mac-scheduler-executor.h>
 
 
 namespace ns3 {
@@ -171,6 +173,11 @@ EnbMacMemberFfMacSchedSapUser::EnbMacMemberFfMacSchedSapUser (LteEnbMac* mac)
 void
 EnbMacMemberFfMacSchedSapUser::SchedDlConfigInd (const struct SchedDlConfigIndParameters& params)
 {
+  if (m_mac->m_schedulerRequests.deferIndications)
+    {
+      m_mac->m_schedulerRequests.dlConfigInd.push_back (params);
+      return;
+    }
   m_mac->DoSchedDlConfigInd (params);
 }
 
@@ -179,6 +186,11 @@ EnbMacMemberFfMacSchedSapUser::SchedDlConfigInd (const struct SchedDlConfigIndPa
 void
 EnbMacMemberFfMacSchedSapUser::SchedUlConfigInd (const struct SchedUlConfigIndParameters& params)
 {
+  if (m_mac->m_schedulerRequests.deferIndications)
+    {
+      m_mac->m_schedulerRequests.ulConfigInd.push_back (params);
+      return;
+    }
   m_mac->DoSchedUlConfigInd (params);
 }
 
@@ -245,6 +257,12 @@ EnbMacMemberFfMacCschedSapUser::CschedUeReleaseCnf (const struct CschedUeRelease
 void
 EnbMacMemberFfMacCschedSapUser::CschedUeConfigUpdateInd (const struct CschedUeConfigUpdateIndParameters& params)
 {
+  if (m_mac->m_schedulerRequests.deferIndications)
+    {
+      // it reaches the RRC, which must not run on a worker thread
+      m_mac->m_schedulerRequests.ueConfigUpdateInd.push_back (params);
+      return;
+    }
   m_mac->DoCschedUeConfigUpdateInd (params);
 }
 
@@ -368,6 +386,15 @@ LteEnbMac::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&LteEnbMac::m_componentCarrierId),
                    MakeUintegerChecker<uint8_t> (0,4))
+    .AddAttribute ("ParallelScheduling",
+                   "If true, the scheduler handles the trigger requests of a subframe "
+                   "concurrently with the schedulers of the other cells, on the threads "
+                   "of the FfMacSchedulerExecutor (see the FfMacSchedulerThreadCount global "
+                   "value), and the MAC applies its indications afterwards, at the same "
+                   "simulation time.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LteEnbMac::m_parallelScheduling),
+                   MakeBooleanChecker ())
   ;
 
   return tid;
@@ -378,6 +405,9 @@ LteEnbMac::LteEnbMac ():
 m_ccmMacSapUser (0)
 {
   NS_LOG_FUNCTION (this);
+  m_schedulerRequests.pending = false;
+  m_schedulerRequests.deferIndications = false;
+  m_runScheduler = MakeCallback (&LteEnbMac::RunScheduler, this);
   m_macSapProvider = new EnbMacMemberLteMacSapProvider<LteEnbMac> (this);
   m_cmacSapProvider = new EnbMacMemberLteEnbCmacSapProvider (this);
   m_schedSapUser = new EnbMacMemberFfMacSchedSapUser (this);
@@ -580,7 +610,7 @@ LteEnbMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
       m_dlInfoListReceived.clear ();
     }
 
-  m_schedSapProvider->SchedDlTriggerReq (dlparams);
+  m_schedulerRequests.dlTrigger = dlparams;
 
 
   // --- UPLINK ---
@@ -595,18 +625,19 @@ LteEnbMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
         {
           m_ulCqiReceived.at (i).m_sfnSf = ((0x3FF & (frameNo - 1)) << 4) | (0xF & 10);
         }
-      m_schedSapProvider->SchedUlCqiInfoReq (m_ulCqiReceived.at (i));
     }
+    m_schedulerRequests.ulCqi.swap (m_ulCqiReceived);
     m_ulCqiReceived.clear ();
   
   // Send BSR reports to the scheduler
+  m_schedulerRequests.ulMacCtrl.clear ();
   if (m_ulCeReceived.size () > 0)
     {
       FfMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters ulMacReq;
       ulMacReq.m_sfnSf = ((0x3FF & frameNo) << 4) | (0xF & subframeNo);
       ulMacReq.m_macCeList.insert (ulMacReq.m_macCeList.begin (), m_ulCeReceived.begin (), m_ulCeReceived.end ());
       m_ulCeReceived.erase (m_ulCeReceived.begin (), m_ulCeReceived.end ());
-      m_schedSapProvider->SchedUlMacCtrlInfoReq (ulMacReq);
+      m_schedulerRequests.ulMacCtrl.push_back (ulMacReq);
     }
 
 
@@ -634,8 +665,67 @@ LteEnbMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
       m_ulInfoListReceived.clear ();
     }
 
-  m_schedSapProvider->SchedUlTriggerReq (ulparams);
+  m_schedulerRequests.ulTrigger = ulparams;
+
+  m_schedulerRequests.pending = true;
+  if (m_parallelScheduling)
+    {
+      // the requests of the cells are handled together, before the
+      // first completion at this time
+      m_schedulerRequests.deferIndications = true;
+      FfMacSchedulerExecutor::Submit (m_runScheduler);
+      Simulator::ScheduleNow (&LteEnbMac::CompleteScheduling, this);
+    }
+  else
+    {
+      RunScheduler ();
+      m_schedulerRequests.ulCqi.clear ();
+    }
+}
+
+void
+LteEnbMac::RunScheduler (void)
+{
+  // no logging here, since this may run concurrently with other cells
+  m_schedSapProvider->SchedDlTriggerReq (m_schedulerRequests.dlTrigger);
+  for (uint16_t i = 0; i < m_schedulerRequests.ulCqi.size (); i++)
+    {
+      m_schedSapProvider->SchedUlCqiInfoReq (m_schedulerRequests.ulCqi.at (i));
+    }
+  for (uint16_t i = 0; i < m_schedulerRequests.ulMacCtrl.size (); i++)
+    {
+      m_schedSapProvider->SchedUlMacCtrlInfoReq (m_schedulerRequests.ulMacCtrl.at (i));
+    }
+  m_schedSapProvider->SchedUlTriggerReq (m_schedulerRequests.ulTrigger);
+  m_schedulerRequests.pending = false;
+}
 
+void
+LteEnbMac::CompleteScheduling (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_schedulerRequests.pending)
+    {
+      FfMacSchedulerExecutor::RunPending ();
+    }
+  NS_ASSERT (!m_schedulerRequests.pending);
+  m_schedulerRequests.deferIndications = false;
+  m_schedulerRequests.ulCqi.clear ();
+  for (uint16_t i = 0; i < m_schedulerRequests.dlConfigInd.size (); i++)
+    {
+      DoSchedDlConfigInd (m_schedulerRequests.dlConfigInd.at (i));
+    }
+  for (uint16_t i = 0; i < m_schedulerRequests.ulConfigInd.size (); i++)
+    {
+      DoSchedUlConfigInd (m_schedulerRequests.ulConfigInd.at (i));
+    }
+  for (uint16_t i = 0; i < m_schedulerRequests.ueConfigUpdateInd.size (); i++)
+    {
+      DoCschedUeConfigUpdateInd (m_schedulerRequests.ueConfigUpdateInd.at (i));
+    }
+  m_schedulerRequests.dlConfigInd.clear ();
+  m_schedulerRequests.ulConfigInd.clear ();
+  m_schedulerRequests.ueConfigUpdateInd.clear ();
 }
 
 
@@ -332,6 +332,19 @@ private:
   */
   void DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo);
   /**
+  * \brief Send the requests of the current subframe to the scheduler
+  *
+  * With ParallelScheduling, this runs on a thread of the
+  * FfMacSchedulerExecutor and the indications of the scheduler are
+  * recorded, to be applied by CompleteScheduling.
+  */
+  void RunScheduler (void);
+  /**
+  * \brief Apply the indications recorded while the scheduler ran
+  * concurrently with the ones of the other cells
+  */
+  void CompleteScheduling (void);
+  /**
   * \brief Receive RACH Preamble function
   * \param prachId PRACH ID number
   */
@@ -465,6 +478,24 @@ private:
 
   /// component carrier Id used to address sap
   uint8_t m_componentCarrierId;
+
+  /// The requests to the scheduler at a subframe, and its indications
+  struct SchedulerRequests
+  {
+    FfMacSchedSapProvider::SchedDlTriggerReqParameters dlTrigger; ///< DL trigger request
+    std::vector<FfMacSchedSapProvider::SchedUlCqiInfoReqParameters> ulCqi; ///< UL-CQI info requests
+    std::vector<FfMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters> ulMacCtrl; ///< UL MAC control info request, if any
+    FfMacSchedSapProvider::SchedUlTriggerReqParameters ulTrigger; ///< UL trigger request
+    bool pending; ///< true if the scheduler has not run the requests yet
+    bool deferIndications; ///< true if the indications are recorded instead of being applied
+    std::vector<FfMacSchedSapUser::SchedDlConfigIndParameters> dlConfigInd; ///< DL config indications recorded
+    std::vector<FfMacSchedSapUser::SchedUlConfigIndParameters> ulConfigInd; ///< UL config indications recorded
+    std::vector<FfMacCschedSapUser::CschedUeConfigUpdateIndParameters> ueConfigUpdateInd; ///< UE config update indications recorded
+  };
+
+  bool m_parallelScheduling; ///< true if the scheduler runs concurrently with the ones of the other cells
+  SchedulerRequests m_schedulerRequests; ///< the requests of the current subframe
+  Callback<void> m_runScheduler; ///< the task submitted to the FfMacSchedulerExecutor
  
 };
 
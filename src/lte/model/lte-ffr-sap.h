@@ -35,6 +35,14 @@ namespace ns3 {
  * This is the *LteFfrSapProvider*, i.e., the part of the SAP
  * that contains the Frequency Reuse algorithm methods called by the MAC Scheduler
  * instance.
+ *
+ * When the ParallelScheduling attribute of the LteEnbMac is set, the
+ * scheduler calls these methods from its trigger requests on the threads
+ * of the FfMacSchedulerExecutor (see FfMacScheduler), concurrently with
+ * the algorithms of the other cells.  Their implementations must then
+ * only access the state of their own algorithm, and must not schedule
+ * events nor call the LteFfrRrcSapUser; the bundled algorithms only
+ * update their per-UE maps there.
  */
 class LteFfrSapProvider
 {
@@ -29,6 +29,7 @@
 *      Marco Miozzo <marco.miozzo@cttc.es>
 */ 
 
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <ns3/log.h>
@@ -331,86 +332,115 @@ static const double cEcrTable [9][38] = {
 };
 
 
-double 
-LteMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+/// The MI map of a modulation, uniformly spaced in linear SINR
+struct MiMap
 {
-  NS_LOG_FUNCTION (sinr << &map << (uint32_t) mcs);
-  
-  double MI;
-  double MIsum = 0.0;
-  SpectrumValue sinrCopy = sinr;
-  
-  for (uint32_t i = 0; i < map.size (); i++)
+  const double *mi;    ///< the MI values
+  const double *axis;  ///< the SINR values
+  uint16_t size;       ///< the number of values
+  double scalingCoeff; ///< the number of SINR bins per unit of SINR
+};
+
+/// MI maps of QPSK, 16QAM and 64QAM
+static const MiMap MiMaps[3] = {
+  { MI_map_qpsk, MI_map_qpsk_axis, MI_MAP_QPSK_SIZE,
+    (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]) },
+  { MI_map_16qam, MI_map_16qam_axis, MI_MAP_16QAM_SIZE,
+    (MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]) },
+  { MI_map_64qam, MI_map_64qam_axis, MI_MAP_64QAM_SIZE,
+    (MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]) }
+};
+
+/**
+ * \brief Get the MI map of the modulation of an MCS
+ * \param mcs the MCS
+ * \return the MI map
+ */
+static const MiMap &
+GetMiMap (uint8_t mcs)
+{
+  if (mcs <= MI_QPSK_MAX_ID)
     {
-      double sinrLin = sinrCopy[map.at (i)];
-      if (mcs <= MI_QPSK_MAX_ID) // QPSK
-        {
+      return MiMaps[0];
+    }
+  if (mcs <= MI_16QAM_MAX_ID)
+    {
+      return MiMaps[1];
+    }
+  return MiMaps[2];
+}
 
-          if (sinrLin > MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1])
-            {
-              MI = 1;
-            }
-          else 
-            { 
-              // since the values in MI_map_qpsk_axis are uniformly spaced, we have
-              // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-              // the scaling coefficient is always the same, so we use a static const
-              // to speed up the calculation
-              static const double scalingCoeffQpsk = 
-                (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
-              double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
-              uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-              NS_ASSERT_MSG (sinrIndex < MI_MAP_QPSK_SIZE, "MI map out of data");
-              MI = MI_map_qpsk[sinrIndex];
-            }
-        }
-      else
+/**
+ * \brief Get the MI of an RB
+ * \param map the MI map of the modulation
+ * \param sinrLin the SINR of the RB
+ * \return the MI
+ */
+static inline double
+GetMi (const MiMap &map, double sinrLin)
+{
+  if (sinrLin > map.axis[map.size - 1])
+    {
+      return 1;
+    }
+  // since the values of the axis are uniformly spaced, we have
+  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
+  double sinrIndexDouble = (sinrLin - map.axis[0]) * map.scalingCoeff + 1;
+  uint32_t sinrIndex = std::max (0.0, std::floor (sinrIndexDouble));
+  NS_ASSERT_MSG (sinrIndex < map.size, "MI map out of data");
+  return map.mi[sinrIndex];
+}
+
+/// The parameters of the BLER curves, by CB size and ECR, where the
+/// curves missing for a CB size are taken from the next larger one
+struct BlerCurves
+{
+  BlerCurves ();
+  double b[9][38]; ///< the b parameters
+  double c[9][38]; ///< the c parameters
+};
+
+BlerCurves::BlerCurves ()
+{
+  for (int ecrId = 0; ecrId < 38; ecrId++)
+    {
+      for (int cbIndex = 0; cbIndex < 9; cbIndex++)
         {
-          if (mcs > MI_QPSK_MAX_ID && mcs <= MI_16QAM_MAX_ID )	// 16-QAM
+          //take the lowest CB size including this CB for removing CB size
+          //quatization errors
+          int i = cbIndex;
+          do
             {
-              if (sinrLin > MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1])
-                {
-                  MI = 1;
-                }
-              else 
-                {
-                  // since the values in MI_map_16QAM_axis are uniformly spaced, we have
-                  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                  // the scaling coefficient is always the same, so we use a static const
-                  // to speed up the calculation
-                  static const double scalingCoeff16qam = 
-                    (MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]);
-                  double sinrIndexDouble = (sinrLin -  MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
-                  uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                  NS_ASSERT_MSG (sinrIndex < MI_MAP_16QAM_SIZE, "MI map out of data");
-                  MI = MI_map_16qam[sinrIndex];
-                }
+              b[cbIndex][ecrId] = bEcrTable[i++][ecrId];
             }
-          else // 64-QAM
+          while ((i < 9) && (b[cbIndex][ecrId] < 0));
+          i = cbIndex;
+          do
             {
-              if (sinrLin > MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1])
-                {
-                  MI = 1;
-                }
-              else
-                {
-                  // since the values in MI_map_64QAM_axis are uniformly spaced, we have
-                  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                  // the scaling coefficient is always the same, so we use a static const
-                  // to speed up the calculation
-                  static const double scalingCoeff64qam = 
-                    (MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]);
-                  double sinrIndexDouble = (sinrLin -  MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
-                  uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                  NS_ASSERT_MSG (sinrIndex < MI_MAP_64QAM_SIZE, "MI map out of data");
-                  MI = MI_map_64qam[sinrIndex];
-                }
+              c[cbIndex][ecrId] = cEcrTable[i++][ecrId];
             }
+          while ((i < 9) && (c[cbIndex][ecrId] < 0));
         }
-      NS_LOG_LOGIC (" RB " << map.at (i) << "Minimum SNR = " << 10 * std::log10 (sinrLin) << " dB, " << sinrLin << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI);
+    }
+}
+
+
+double 
+LteMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+{
+  NS_LOG_FUNCTION (sinr << &map << (uint32_t) mcs);
+  
+  const MiMap &miMap = GetMiMap (mcs);
+  Values::const_iterator sinrValues = sinr.ConstValuesBegin ();
+  double MIsum = 0.0;
+  for (uint32_t i = 0; i < map.size (); i++)
+    {
+      double sinrLin = sinrValues[map[i]];
+      double MI = GetMi (miMap, sinrLin);
+      NS_LOG_LOGIC (" RB " << map[i] << "Minimum SNR = " << 10 * std::log10 (sinrLin) << " dB, " << sinrLin << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI);
       MIsum += MI;
     }
-  MI = MIsum / map.size ();
+  double MI = MIsum / map.size ();
   NS_LOG_LOGIC (" MI = " << MI);
   return MI;
 }
@@ -420,40 +450,15 @@ double
 LteMiErrorModel::MappingMiBler (double mib, uint8_t ecrId, uint16_t cbSize)
 {
   NS_LOG_FUNCTION (mib << (uint32_t) ecrId << (uint32_t) cbSize);
-  double b = 0;
-  double c = 0;
+  static const BlerCurves curves;
 
   NS_ASSERT_MSG (ecrId <= MI_64QAM_BLER_MAX_ID, "ECR out of range [0..37]: " << (uint16_t) ecrId);
-  int cbIndex = 1;
-  while ((cbIndex < 9)&&(cbMiSizeTable[cbIndex]<= cbSize))
-    {
-      cbIndex++;
-    }
-  cbIndex--;
+  // the largest CB size of the curves not above cbSize, or the smallest one
+  int cbIndex = std::upper_bound (cbMiSizeTable + 1, cbMiSizeTable + 9, cbSize) - cbMiSizeTable - 1;
   NS_LOG_LOGIC (" ECRid " << (uint16_t)ecrId << " ECR " << BlerCurvesEcrMap[ecrId] << " CB size " << cbSize << " CB size curve " << cbMiSizeTable[cbIndex]);
 
-  b = bEcrTable[cbIndex][ecrId];
-  if (b<0.0)
-    {
-      //take the lowest CB size including this CB for removing CB size
-      //quatization errors
-      int i = cbIndex;
-      while ((i<9)&&(b<0))
-        {
-          b = bEcrTable[i++][ecrId];
-        }
-    }
-  c = cEcrTable[cbIndex][ecrId];
-  if (c<0.0)
-    {
-      //take the lowest CB size including this CB for removing CB size
-      //quatization errors
-      int i = cbIndex;
-      while ((i<9)&&(c<0))
-        {
-          c = cEcrTable[i++][ecrId];
-        }
-    }
+  double b = curves.b[cbIndex][ecrId];
+  double c = curves.c[cbIndex][ecrId];
   // see IEEE802.16m EMD formula 55 of section 4.3.2.1
   double bler = 0.5*( 1 - erf((mib-b)/(sqrt(2)*c)) );
   NS_LOG_LOGIC ("MIB: " << mib << " BLER:" << bler << " b:" << b << " c:" << c);
@@ -466,44 +471,19 @@ double
 LteMiErrorModel::GetPcfichPdcchError (const SpectrumValue& sinr)
 {
   NS_LOG_FUNCTION (sinr);
-  double MI;
+  const MiMap &qpsk = MiMaps[0];
   double MIsum = 0.0;
-  SpectrumValue sinrCopy = sinr;
-  Values::iterator sinrIt = sinrCopy.ValuesBegin ();
   uint16_t rb = 0;
-  NS_ASSERT (sinrIt!=sinrCopy.ValuesEnd ());
-  while (sinrIt!=sinrCopy.ValuesEnd ())
+  NS_ASSERT (sinr.ConstValuesBegin () != sinr.ConstValuesEnd ());
+  for (Values::const_iterator sinrIt = sinr.ConstValuesBegin (); sinrIt != sinr.ConstValuesEnd (); sinrIt++)
     {
-      double sinrLin = *sinrIt;
-      if (sinrLin > MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1])
-        {
-          MI = 1;
-        }
-      else 
-        { 
-          // since the values in MI_map_qpsk_axis are uniformly spaced, we have
-          // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-              // the scaling coefficient is always the same, so we use a static const
-              // to speed up the calculation
-          static const double scalingCoeffQpsk = 
-            (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
-          double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
-          uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-          NS_ASSERT_MSG (sinrIndex < MI_MAP_QPSK_SIZE, "MI map out of data");
-          MI = MI_map_qpsk[sinrIndex];
-        }
-      MIsum += MI;
-      sinrIt++;
+      MIsum += GetMi (qpsk, *sinrIt);
       rb++;
     }
-  MI = MIsum / rb;
-  // return to the effective SINR value
-  int j = 0;
+  double MI = MIsum / rb;
+  // return to the effective SINR value: the first MI not below MI
+  int j = std::lower_bound (MI_map_qpsk, MI_map_qpsk + MI_MAP_QPSK_SIZE, MI) - MI_map_qpsk;
   double esinr = 0.0;
-  while ((j<MI_MAP_QPSK_SIZE)&&(MI_map_qpsk[j] < MI))
-    {
-      j++;
-    }
   if (MI > MI_map_qpsk[MI_MAP_QPSK_SIZE-1])
     {
       esinr = MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1];
@@ -531,18 +511,15 @@ LteMiErrorModel::GetPcfichPdcchError (const SpectrumValue& sinr)
 
   double esirnDb = 10*log10 (esinr); 
 //   NS_LOG_DEBUG ("Effective SINR " << esirnDb << " max " << 10*log10 (MI_map_qpsk [MI_MAP_QPSK_SIZE-1]));
-  uint16_t i = 0;
   double errorRate = 0.0;
-  while ((i<PDCCH_PCFICH_CURVE_SIZE)&&(PdcchPcfichBlerCurveXaxis[i] < esirnDb))
-    {
-      i++;
-    }
   if (esirnDb > PdcchPcfichBlerCurveXaxis[PDCCH_PCFICH_CURVE_SIZE-1])
     {
       errorRate = 0.0;
     }
   else 
     {
+      // the first point of the curve not below the effective SINR
+      uint16_t i = std::lower_bound (PdcchPcfichBlerCurveXaxis, PdcchPcfichBlerCurveXaxis + PDCCH_PCFICH_CURVE_SIZE, esirnDb) - PdcchPcfichBlerCurveXaxis;
       NS_ASSERT_MSG (i<PDCCH_PCFICH_CURVE_SIZE, "PDCCH-PCFICH map out of data");
       errorRate = PdcchPcfichBlerCurveYaxis[i];
     }  
@@ -554,7 +531,7 @@ LteMiErrorModel::GetPcfichPdcchError (const SpectrumValue& sinr)
 
 
 TbStats_t
-LteMiErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint16_t size, uint8_t mcs, HarqProcessInfoList_t miHistory)
+LteMiErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint16_t size, uint8_t mcs, const HarqProcessInfoList_t& miHistory)
 {
   NS_LOG_FUNCTION (sinr << &map << (uint32_t) size << (uint32_t) mcs);
 
@@ -176,6 +176,7 @@ public:
   // inherited from LtePhySapUser
   virtual void ReceivePhyPdu (Ptr<Packet> p);
   virtual void SubframeIndication (uint32_t frameNo, uint32_t subframeNo);
+  virtual void UpdateSubframe (uint32_t frameNo, uint32_t subframeNo);
   virtual void ReceiveLteControlMessage (Ptr<LteControlMessage> msg);
 
 private:
@@ -200,6 +201,12 @@ UeMemberLteUePhySapUser::SubframeIndication (uint32_t frameNo, uint32_t subframe
   m_mac->DoSubframeIndication (frameNo, subframeNo);
 }
 
+void
+UeMemberLteUePhySapUser::UpdateSubframe (uint32_t frameNo, uint32_t subframeNo)
+{
+  m_mac->DoUpdateSubframe (frameNo, subframeNo);
+}
+
 void
 UeMemberLteUePhySapUser::ReceiveLteControlMessage (Ptr<LteControlMessage> msg)
 {
@@ -232,6 +239,8 @@ LteUeMac::LteUeMac ()
      m_harqProcessId (0),
      m_rnti (0),
      m_rachConfigured (false),
+     m_frameNo (0),
+     m_subframeNo (0),
      m_waitingForRaResponse (false)
   
 {
@@ -338,6 +347,8 @@ LteUeMac::DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusParameters
       m_ulBsrReceived.insert (std::pair<uint8_t, LteMacSapProvider::ReportBufferStatusParameters> (params.lcid, params));
     }
   m_freshUlBsr = true;
+  // the BSR is sent at the next subframe
+  m_uePhySapProvider->WakeUp ();
 }
 
 
@@ -414,6 +425,7 @@ LteUeMac::SendRaPreamble (bool contention)
   // bypass the m_ulConfigured flag. This is reasonable, since In fact
   // the RACH preamble is sent on 6RB bandwidth so the uplink
   // bandwidth does not need to be configured. 
+  m_uePhySapProvider->WakeUp ();
   NS_ASSERT (m_subframeNo > 0); // sanity check for subframe starting at 1
   m_raRnti = m_subframeNo - 1;
   m_uePhySapProvider->SendRachPreamble (m_raPreambleId, m_raRnti);
@@ -776,6 +788,7 @@ LteUeMac::DoReceiveLteControlMessage (Ptr<LteControlMessage> msg)
                             {
                               // resend BSR info for updating eNB peer MAC
                               m_freshUlBsr = true;
+                              m_uePhySapProvider->WakeUp ();
                             }
                         }
                       NS_LOG_LOGIC (this << "\t" << bytesPerActiveLc << "\t new queues " << (uint32_t)(*it).first << " statusQueue " << (*itBsr).second.statusPduSize << " retxQueue" << (*itBsr).second.retxQueueSize << " txQueue" <<  (*itBsr).second.txQueueSize);
@@ -829,13 +842,13 @@ LteUeMac::DoReceiveLteControlMessage (Ptr<LteControlMessage> msg)
 }
 
 void
-LteUeMac::RefreshHarqProcessesPacketBuffer (void)
+LteUeMac::RefreshHarqProcessesPacketBuffer (uint32_t nSubframes)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << nSubframes);
 
   for (uint16_t i = 0; i < m_miUlHarqProcessesPacketTimer.size (); i++)
     {
-      if (m_miUlHarqProcessesPacketTimer.at (i) == 0)
+      if (m_miUlHarqProcessesPacketTimer.at (i) < nSubframes)
         {
           if (m_miUlHarqProcessesPacket.at (i)->GetSize () > 0)
             {
@@ -844,22 +857,42 @@ LteUeMac::RefreshHarqProcessesPacketBuffer (void)
               Ptr<PacketBurst> emptyPb = CreateObject <PacketBurst> ();
               m_miUlHarqProcessesPacket.at (i) = emptyPb;
             }
+          m_miUlHarqProcessesPacketTimer.at (i) = 0;
         }
       else
         {
-          m_miUlHarqProcessesPacketTimer.at (i)--;
+          m_miUlHarqProcessesPacketTimer.at (i) -= nSubframes;
         }
     }
 }
 
 
 void
-LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
+LteUeMac::DoUpdateSubframe (uint32_t frameNo, uint32_t subframeNo)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << frameNo << subframeNo);
+  // a dormant Phy does not indicate every subframe
+  uint32_t nSubframes = 1;
+  if (m_frameNo > 0)
+    {
+      nSubframes = (frameNo * 10 + subframeNo) - (m_frameNo * 10 + m_subframeNo);
+    }
+  if (nSubframes == 0)
+    {
+      return;
+    }
   m_frameNo = frameNo;
   m_subframeNo = subframeNo;
-  RefreshHarqProcessesPacketBuffer ();
+  RefreshHarqProcessesPacketBuffer (nSubframes);
+  m_harqProcessId = (m_harqProcessId + nSubframes) % HARQ_PERIOD;
+}
+
+
+void
+LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
+{
+  NS_LOG_FUNCTION (this);
+  DoUpdateSubframe (frameNo, subframeNo);
   if ((Simulator::Now () >= m_bsrLast + m_bsrPeriodicity) && (m_freshUlBsr == true))
     {
       if (m_componentCarrierId == 0)
@@ -870,8 +903,6 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
       m_bsrLast = Simulator::Now ();
       m_freshUlBsr = false;
     }
-  m_harqProcessId = (m_harqProcessId + 1) % HARQ_PERIOD;
-
 }
 
 int64_t
@@ -102,6 +102,18 @@ public:
   */
   void DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo);
 
+  /**
+  * \brief Forwarded from LteUePhySapUser: catch up with the subframes
+  * skipped by a dormant Phy
+  *
+  * The HARQ processes advance by the number of subframes since the last
+  * update, as if each of them had been indicated.
+  *
+  * \param frameNo frame number
+  * \param subframeNo subframe number
+  */
+  void DoUpdateSubframe (uint32_t frameNo, uint32_t subframeNo);
+
  /**
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
@@ -208,8 +220,11 @@ private:
   void RaResponseTimeout (bool contention);
   /// Send report buffer status
   void SendReportBufferStatus (void);
-  /// Refresh HARQ processes packet buffer function
-  void RefreshHarqProcessesPacketBuffer (void);
+  /**
+   * Refresh HARQ processes packet buffer function
+   * \param nSubframes the number of subframes since the last refresh
+   */
+  void RefreshHarqProcessesPacketBuffer (uint32_t nSubframes);
 
   /// component carrier Id --> used to address sap
   uint8_t m_componentCarrierId;
@@ -61,6 +61,14 @@ public:
    */
   virtual void SendRachPreamble (uint32_t prachId, uint32_t raRnti) = 0;
 
+  /**
+   * \brief Wake up the PHY if it is dormant (see the EnableDormancy
+   * attribute of LteUePhy), so that the next subframe is indicated
+   *
+   * The MAC is first brought up to date with the current subframe.
+   */
+  virtual void WakeUp (void) = 0;
+
 };
 
 
@@ -90,6 +98,14 @@ public:
   */
   virtual void SubframeIndication (uint32_t frameNo, uint32_t subframeNo) = 0;
 
+  /**
+  * \brief Bring the MAC up to date with a subframe whose indication was
+  * skipped by a dormant Phy, without triggering any transmission
+  * \param frameNo frame number
+  * \param subframeNo subframe number
+  */
+  virtual void UpdateSubframe (uint32_t frameNo, uint32_t subframeNo) = 0;
+
   /**
   * \brief Receive SendLteControlMessage (PDCCH map, CQI feedbacks) using the ideal control channel
   * \param msg the Ideal Control Message to receive
@@ -85,6 +85,7 @@ public:
   virtual void SendMacPdu (Ptr<Packet> p);
   virtual void SendLteControlMessage (Ptr<LteControlMessage> msg);
   virtual void SendRachPreamble (uint32_t prachId, uint32_t raRnti);
+  virtual void WakeUp (void);
 
 private:
   LteUePhy* m_phy; ///< the Phy
@@ -113,6 +114,12 @@ UeMemberLteUePhySapProvider::SendRachPreamble (uint32_t prachId, uint32_t raRnti
   m_phy->DoSendRachPreamble (prachId, raRnti);
 }
 
+void
+UeMemberLteUePhySapProvider::WakeUp (void)
+{
+  m_phy->WakeUp ();
+}
+
 
 ////////////////////////////////////////
 // LteUePhy methods
@@ -156,7 +163,8 @@ LteUePhy::LteUePhy (Ptr<LteSpectrumPhy> dlPhy, Ptr<LteSpectrumPhy> ulPhy)
     m_pssReceived (false),
     m_ueMeasurementsFilterPeriod (MilliSeconds (200)),
     m_ueMeasurementsFilterLast (MilliSeconds (0)),
-    m_rsrpSinrSampleCounter (0)
+    m_rsrpSinrSampleCounter (0),
+    m_dormant (false)
 {
   m_amc = CreateObject <LteAmc> ();
   m_powerControl = CreateObject <LteUePowerControl> ();
@@ -303,6 +311,18 @@ LteUePhy::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&LteUePhy::m_enableUplinkPowerControl),
                    MakeBooleanChecker ())
+    .AddAttribute ("EnableDormancy",
+                   "If true, the subframes are not indicated while the UE "
+                   "has nothing to transmit, except for its SRS. The UE "
+                   "wakes up as soon as a transmission is queued, e.g., a "
+                   "BSR, a CQI or an UL grant. Only the subframe indications "
+                   "are saved: the UE still receives the downlink control "
+                   "frame of every subframe, and the work of the eNB is "
+                   "unchanged. Useful with many UEs that are idle, or whose "
+                   "DownlinkCqiPeriodicity is larger than one subframe.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LteUePhy::m_enableDormancy),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -413,6 +433,7 @@ LteUePhy::DoSendMacPdu (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this);
 
+  WakeUp ();
   SetMacPdu (p);
 }
 
@@ -856,6 +877,7 @@ LteUePhy::DoSendLteControlMessage (Ptr<LteControlMessage> msg)
 {
   NS_LOG_FUNCTION (this << msg);
 
+  WakeUp ();
   SetControlMessages (msg);
 }
 
@@ -864,6 +886,7 @@ LteUePhy::DoSendRachPreamble (uint32_t raPreambleId, uint32_t raRnti)
 {
   NS_LOG_FUNCTION (this << raPreambleId);
 
+  WakeUp ();
   // unlike other control messages, RACH preamble is sent ASAP
   Ptr<RachPreambleLteControlMessage> msg = Create<RachPreambleLteControlMessage> ();
   msg->SetRapId (raPreambleId);
@@ -1084,6 +1107,7 @@ LteUePhy::ReceivePss (uint16_t cellId, Ptr<SpectrumValue> p)
 void
 LteUePhy::QueueSubChannelsForTransmission (std::vector <int> rbMap)
 {
+  WakeUp ();
   m_subChannelsForTransmissionQueue.at (m_macChTtiDelay - 1) = rbMap;
 }
 
@@ -1094,6 +1118,7 @@ LteUePhy::SubframeIndication (uint32_t frameNo, uint32_t subframeNo)
   NS_LOG_FUNCTION (this << frameNo << subframeNo);
 
   NS_ASSERT_MSG (frameNo > 0, "the SRS index check code assumes that frameNo starts at 1");
+  m_dormant = false;
 
   // refresh internal variables
   m_rsReceivedPowerUpdated = false;
@@ -1174,8 +1199,92 @@ LteUePhy::SubframeIndication (uint32_t frameNo, uint32_t subframeNo)
       subframeNo = 1;
     }
 
+  if (m_enableDormancy && m_state == SYNCHRONIZED && !HasQueuedTransmissions ())
+    {
+      ScheduleDormantSubframe (frameNo, subframeNo);
+      return;
+    }
+
   // schedule next subframe indication
-  Simulator::Schedule (Seconds (GetTti ()), &LteUePhy::SubframeIndication, this, frameNo, subframeNo);
+  m_subframeEvent = Simulator::Schedule (Seconds (GetTti ()), &LteUePhy::SubframeIndication, this, frameNo, subframeNo);
+}
+
+
+bool
+LteUePhy::HasQueuedTransmissions (void) const
+{
+  if (!m_ulConfigured)
+    {
+      // the queues are only served once the uplink is configured
+      return false;
+    }
+  for (uint8_t i = 0; i < m_macChTtiDelay; i++)
+    {
+      if (m_packetBurstQueue.at (i)->GetSize () > 0
+          || !m_controlMessagesQueue.at (i).empty ()
+          || !m_subChannelsForTransmissionQueue.at (i).empty ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+
+void
+LteUePhy::ScheduleDormantSubframe (uint32_t frameNo, uint32_t subframeNo)
+{
+  NS_LOG_FUNCTION (this << frameNo << subframeNo);
+  Time tti = Seconds (GetTti ());
+  m_dormant = true;
+  m_dormantSubframe = (frameNo - 1) * 10 + (subframeNo - 1);
+  m_dormantStart = Simulator::Now () + tti;
+
+  if (m_ulConfigured && m_srsConfigured)
+    {
+      // the SRS are sent even without data: wake up at the next one
+      uint32_t skipped = (m_srsSubframeOffset + m_srsPeriodicity - m_dormantSubframe % m_srsPeriodicity) % m_srsPeriodicity;
+      uint32_t srsSubframe = m_dormantSubframe + skipped;
+      m_subframeEvent = Simulator::Schedule (tti * static_cast<int64_t> (skipped + 1),
+                                             &LteUePhy::SubframeIndication, this,
+                                             srsSubframe / 10 + 1, srsSubframe % 10 + 1);
+    }
+}
+
+
+void
+LteUePhy::WakeUp (void)
+{
+  if (!m_dormant)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_dormant = false;
+  m_subframeEvent.Cancel ();
+
+  // the subframes which started before now are skipped, the next one
+  // starts now or later: an event at the start of a subframe is assumed
+  // to precede its indication, as when it was scheduled before the
+  // previous subframe
+  Time tti = Seconds (GetTti ());
+  int64_t elapsed = (Simulator::Now () - m_dormantStart).GetTimeStep ();
+  uint32_t nSkipped = 0;
+  if (elapsed > 0)
+    {
+      nSkipped = (elapsed + tti.GetTimeStep () - 1) / tti.GetTimeStep ();
+    }
+  if (nSkipped > 0)
+    {
+      uint32_t last = m_dormantSubframe + nSkipped - 1;
+      m_subframeNo = last % 10 + 1;
+      m_uePhySapUser->UpdateSubframe (last / 10 + 1, last % 10 + 1);
+    }
+  uint32_t next = m_dormantSubframe + nSkipped;
+  Time start = m_dormantStart + tti * static_cast<int64_t> (nSkipped);
+  NS_LOG_LOGIC (this << " skipped " << nSkipped << " subframes, next one at " << start.GetSeconds ());
+  m_subframeEvent = Simulator::Schedule (start - Simulator::Now (), &LteUePhy::SubframeIndication, this,
+                                         next / 10 + 1, next % 10 + 1);
 }
 
 
@@ -1206,6 +1315,7 @@ LteUePhy::DoReset ()
 {
   NS_LOG_FUNCTION (this);
 
+  WakeUp ();
   m_rnti = 0;
   m_transmissionMode = 0;
   m_srsPeriodicity = 0;
@@ -1312,6 +1422,7 @@ LteUePhy::DoSetDlBandwidth (uint8_t dlBandwidth)
 void 
 LteUePhy::DoConfigureUplink (uint32_t ulEarfcn, uint8_t ulBandwidth)
 {
+  WakeUp ();
   m_ulEarfcn = ulEarfcn;
   m_ulBandwidth = ulBandwidth;
   m_ulConfigured = true;
@@ -1346,6 +1457,7 @@ void
 LteUePhy::DoSetSrsConfigurationIndex (uint16_t srcCi)
 {
   NS_LOG_FUNCTION (this << srcCi);
+  WakeUp ();
   m_srsPeriodicity = GetSrsPeriodicity (srcCi);
   m_srsSubframeOffset = GetSrsSubframeOffset (srcCi);
   m_srsConfigured = true;
@@ -1472,6 +1584,7 @@ void
 LteUePhy::SwitchToState (State newState)
 {
   NS_LOG_FUNCTION (this << newState);
+  WakeUp ();
   State oldState = m_state;
   m_state = newState;
   NS_LOG_INFO (this << " cellId=" << m_cellId << " rnti=" << m_rnti
@@ -387,6 +387,23 @@ private:
    * \param s the destination state
    */
   void SwitchToState (State s);
+  /**
+   * \return true if a transmission is queued for one of the next subframes
+   */
+  bool HasQueuedTransmissions (void) const;
+  /**
+   * Schedule the indication of the next subframe needed by a dormant UE,
+   * i.e., its next SRS, or none.
+   *
+   * \param frameNo the frame number of the first skipped subframe
+   * \param subframeNo the subframe number of the first skipped subframe
+   */
+  void ScheduleDormantSubframe (uint32_t frameNo, uint32_t subframeNo);
+  /**
+   * Leave the dormancy: the MAC is brought up to date with the last
+   * skipped subframe, and the next subframe is indicated.
+   */
+  void WakeUp (void);
 
   // UE CPHY SAP methods
   /// Reset function
@@ -606,6 +623,17 @@ private:
 
   EventId m_sendSrsEvent; ///< send SRS event
 
+  /**
+   * The `EnableDormancy` attribute. If true, the subframes are not
+   * indicated while the UE has nothing to transmit. The downlink control
+   * frames are still received.
+   */
+  bool m_enableDormancy;
+  bool m_dormant; ///< true if the subframes are not indicated
+  uint32_t m_dormantSubframe; ///< index, since the first subframe, of the first skipped subframe
+  Time m_dormantStart; ///< start time of the first skipped subframe
+  EventId m_subframeEvent; ///< next subframe indication event
+
   /**
    * The `UlPhyTransmission` trace source. Contains trace information regarding
    * PHY stats from UL Tx perspective. Exporting a structure with type
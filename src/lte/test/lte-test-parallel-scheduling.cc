@@ -0,0 +1,212 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/config.h"
+#include "ns3/lte-helper.h"
+#include "ns3/lte-enb-net-device.h"
+#include "ns3/lte-enb-mac.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/rng-seed-manager.h"
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LteParallelSchedulingTest");
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Check that the schedulers of several cells make the same
+ * decisions, whether they run one after the other or concurrently, and
+ * whatever the number of threads.
+ *
+ * Each of the cells serves UEs at various distances with saturating
+ * traffic in both directions, and the allocations traced by the eNB
+ * MACs are compared.
+ */
+class LteParallelSchedulingTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param schedulerType the type of the scheduler
+   */
+  LteParallelSchedulingTestCase (std::string schedulerType);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the simulation
+   * \param parallel whether the schedulers run concurrently
+   * \param nThreads the number of threads running the schedulers
+   * \return the allocations of all the cells
+   */
+  std::string RunSimulation (bool parallel, uint32_t nThreads);
+
+  /**
+   * Record a DL allocation
+   * \param os the record
+   * \param cell the index of the cell
+   * \param info the allocation
+   */
+  static void DlScheduling (std::ostringstream *os, uint32_t cell, DlSchedulingCallbackInfo info);
+
+  /**
+   * Record an UL allocation
+   * \param os the record
+   * \param cell the index of the cell
+   * \param frameNo the frame number
+   * \param subframeNo the subframe number
+   * \param rnti the RNTI of the UE
+   * \param mcs the MCS of the TB
+   * \param size the size of the TB
+   * \param componentCarrierId the component carrier
+   */
+  static void UlScheduling (std::ostringstream *os, uint32_t cell, uint32_t frameNo, uint32_t subframeNo,
+                            uint16_t rnti, uint8_t mcs, uint16_t size, uint8_t componentCarrierId);
+
+  std::string m_schedulerType; ///< the type of the scheduler
+};
+
+LteParallelSchedulingTestCase::LteParallelSchedulingTestCase (std::string schedulerType)
+  : TestCase ("Parallel scheduling with the " + schedulerType),
+    m_schedulerType (schedulerType)
+{
+}
+
+void
+LteParallelSchedulingTestCase::DlScheduling (std::ostringstream *os, uint32_t cell, DlSchedulingCallbackInfo info)
+{
+  *os << Simulator::Now ().GetMilliSeconds () << " DL " << cell << " " << info.rnti << " "
+      << (uint16_t) info.mcsTb1 << " " << info.sizeTb1 << std::endl;
+}
+
+void
+LteParallelSchedulingTestCase::UlScheduling (std::ostringstream *os, uint32_t cell, uint32_t frameNo, uint32_t subframeNo,
+                                             uint16_t rnti, uint8_t mcs, uint16_t size, uint8_t componentCarrierId)
+{
+  *os << Simulator::Now ().GetMilliSeconds () << " UL " << cell << " " << rnti << " "
+      << (uint16_t) mcs << " " << size << std::endl;
+}
+
+std::string
+LteParallelSchedulingTestCase::RunSimulation (bool parallel, uint32_t nThreads)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::LteEnbMac::ParallelScheduling", BooleanValue (parallel));
+  Config::SetGlobal ("FfMacSchedulerThreadCount", UintegerValue (nThreads));
+
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetSchedulerType (m_schedulerType);
+
+  const uint32_t nCells = 4;
+  const uint32_t nUesPerCell = 3;
+  NodeContainer enbNodes;
+  enbNodes.Create (nCells);
+  NodeContainer ueNodes;
+  ueNodes.Create (nCells * nUesPerCell);
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (uint32_t c = 0; c < nCells; ++c)
+    {
+      positions->Add (Vector (1000.0 * c, 0, 0));
+    }
+  for (uint32_t c = 0; c < nCells; ++c)
+    {
+      for (uint32_t u = 0; u < nUesPerCell; ++u)
+        {
+          positions->Add (Vector (1000.0 * c + 50.0 + 100.0 * u, 30.0 * c, 0));
+        }
+    }
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positions);
+  mobility.Install (enbNodes);
+  mobility.Install (ueNodes);
+
+  NetDeviceContainer enbDevs = lteHelper->InstallEnbDevice (enbNodes);
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  // the streams of the random variables are allocated from the same
+  // counter by all the simulations
+  int64_t stream = lteHelper->AssignStreams (enbDevs, 1);
+  lteHelper->AssignStreams (ueDevs, 1 + stream);
+
+  std::ostringstream allocations;
+  for (uint32_t c = 0; c < nCells; ++c)
+    {
+      NetDeviceContainer cellUeDevs;
+      for (uint32_t u = 0; u < nUesPerCell; ++u)
+        {
+          cellUeDevs.Add (ueDevs.Get (c * nUesPerCell + u));
+        }
+      lteHelper->Attach (cellUeDevs, enbDevs.Get (c));
+      Ptr<LteEnbMac> mac = enbDevs.Get (c)->GetObject<LteEnbNetDevice> ()->GetMac ();
+      mac->TraceConnectWithoutContext ("DlScheduling", MakeBoundCallback (&LteParallelSchedulingTestCase::DlScheduling, &allocations, c));
+      mac->TraceConnectWithoutContext ("UlScheduling", MakeBoundCallback (&LteParallelSchedulingTestCase::UlScheduling, &allocations, c));
+    }
+  lteHelper->ActivateDataRadioBearer (ueDevs, EpsBearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT));
+
+  Simulator::Stop (Seconds (0.4));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::LteEnbMac::ParallelScheduling", BooleanValue (false));
+  Config::SetGlobal ("FfMacSchedulerThreadCount", UintegerValue (0));
+  return allocations.str ();
+}
+
+void
+LteParallelSchedulingTestCase::DoRun (void)
+{
+  std::string sequential = RunSimulation (false, 1);
+  std::string oneThread = RunSimulation (true, 1);
+  std::string fourThreads = RunSimulation (true, 4);
+
+  NS_TEST_ASSERT_MSG_NE (sequential.find (" DL "), std::string::npos, "no DL allocation");
+  NS_TEST_ASSERT_MSG_NE (sequential.find (" UL "), std::string::npos, "no UL allocation");
+  NS_TEST_ASSERT_MSG_EQ (oneThread, fourThreads, "the allocations depend on the number of threads");
+  NS_TEST_ASSERT_MSG_EQ (oneThread, sequential, "the allocations of the parallel schedulers differ");
+}
+
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test suite of the parallel scheduling of the cells
+ */
+class LteParallelSchedulingTestSuite : public TestSuite
+{
+public:
+  LteParallelSchedulingTestSuite ();
+};
+
+LteParallelSchedulingTestSuite::LteParallelSchedulingTestSuite ()
+  : TestSuite ("lte-parallel-scheduling", SYSTEM)
+{
+  AddTestCase (new LteParallelSchedulingTestCase ("ns3::PfFfMacScheduler"), TestCase::QUICK);
+  AddTestCase (new LteParallelSchedulingTestCase ("ns3::RrFfMacScheduler"), TestCase::QUICK);
+  AddTestCase (new LteParallelSchedulingTestCase ("ns3::PssFfMacScheduler"), TestCase::EXTENSIVE);
+}
+
+static LteParallelSchedulingTestSuite g_lteParallelSchedulingTestSuite; ///< the test suite
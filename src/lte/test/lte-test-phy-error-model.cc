@@ -49,6 +49,8 @@
 #include <ns3/integer.h>
 #include <ns3/unused.h>
 #include <ns3/ff-mac-scheduler.h>
+#include <ns3/lte-mi-error-model.h>
+#include <ns3/spectrum-model.h>
 #include <ns3/buildings-helper.h>
 
 #include "lte-test-phy-error-model.h"
@@ -61,6 +63,8 @@ LenaTestPhyErrorModelSuite::LenaTestPhyErrorModelSuite ()
   : TestSuite ("lte-phy-error-model", SYSTEM)
 {
   NS_LOG_INFO ("creating LenaTestPhyErrorModelTestCase");
+
+  AddTestCase (new LteMiErrorModelTestCase, TestCase::QUICK);
   
   
   for (uint32_t rngRun = 1; rngRun <= 3; ++rngRun)
@@ -438,3 +442,194 @@ LenaDlCtrlPhyErrorModelTestCase::DoRun (void)
   
   Simulator::Destroy ();
 }
+
+
+/// Reference MI and BLER of the first transmission, and BLER of a retransmission
+static const double MiErrorModelTbReference[99][3] = {
+  { 0.12742342105263157, 0.92922933402286412, 0.88155896204377815 },
+  { 0.12742342105263157, 0.59560925526169251, 0.28307622281401557 },
+  { 0.12742342105263157, 0.038099318459951848, 1 },
+  { 0.17201242105263156, 0.56604093544063383, 0.43614917393203889 },
+  { 0.17201242105263156, 0.00035833177179528386, 6.55190643317205e-06 },
+  { 0.17201242105263156, 0, 1.6179946271677181e-11 },
+  { 0.23012394736842104, 0.062654688942892889, 0.023674428334470587 },
+  { 0.23012394736842104, 2.7755575615628914e-16, 0 },
+  { 0.23012394736842104, 0, 0 },
+  { 0.21682363157894735, 0.84934693850760434, 0.99032049475786099 },
+  { 0.21682363157894735, 0.67596049041185047, 0.99608338233858995 },
+  { 0.21682363157894735, 0.25192140055256451, 0.64184485569858762 },
+  { 0.2869583684210526, 0.12341691692722828, 0.69073822029859189 },
+  { 0.2869583684210526, 0.0021735549382633779, 0.44424999608645277 },
+  { 0.2869583684210526, 0, 0 },
+  { 0.37160631578947373, 7.1384187602496763e-05, 0.034525453773175951 },
+  { 0.37160631578947373, 3.833489081728203e-12, 0.00012480360065081353 },
+  { 0.37160631578947373, 0, 0 },
+  { 0.35408089473684212, 0.89802273200482363, 0.96235065192442837 },
+  { 0.35408089473684212, 0.89802273200482363, 0.96699410901383098 },
+  { 0.35408089473684212, 0.99992068478361407, 0.99999999999432809 },
+  { 0.44965900000000003, 0.030489250098942544, 0.31833186787261591 },
+  { 0.44965900000000003, 0.030489250098942544, 0.17688147738245535 },
+  { 0.44965900000000003, 0, 8.985789889948137e-11 },
+  { 0.55627589473684225, 3.7080654602394958e-08, 0.00077379975394903378 },
+  { 0.55627589473684225, 3.7080654602394958e-08, 1.1361166198986528e-05 },
+  { 0.55627589473684225, 0, 0 },
+  { 0.53434452631578955, 0.99422943022966082, 0.16871917579143431 },
+  { 0.53434452631578955, 0.99422943022966082, 0.067203340298701841 },
+  { 0.53434452631578955, 0.99999999999996469, 0 },
+  { 0.65828268421052638, 0.042844975553026965, 9.5527998606570463e-05 },
+  { 0.65828268421052638, 0.042844975553026965, 1.150786751835664e-06 },
+  { 0.65828268421052638, 3.8025582682621462e-11, 0 },
+  { 0.77311378947368425, 7.9685640308468919e-09, 2.3838930829356286e-11 },
+  { 0.77311378947368425, 7.9685640308468919e-09, 4.4408920985006262e-16 },
+  { 0.77311378947368425, 0, 0 },
+  { 0.29490647368421058, 0.99998173458358297, 0.9971968171308343 },
+  { 0.29490647368421058, 0.99998173458358297, 0.99733730924287967 },
+  { 0.29490647368421058, 1, 1 },
+  { 0.36552468421052636, 0.73645074772084351, 0.19280300903466308 },
+  { 0.36552468421052636, 0.73645074772084351, 0.19866794451128311 },
+  { 0.36552468421052636, 0.99986468591238364, 0.84273446046599765 },
+  { 0.4432511578947369, 0.00065130560526371895, 2.405315464582003e-07 },
+  { 0.4432511578947369, 0.00065130560526371895, 2.7597168417159423e-07 },
+  { 0.4432511578947369, 6.4315663905745168e-10, 0 },
+  { 0.42718510526315789, 0.99861477774043816, 3.8499371538547322e-06 },
+  { 0.42718510526315789, 0.99861477774043816, 4.1459002700361403e-06 },
+  { 0.42718510526315789, 1, 9.3169916226543137e-13 },
+  { 0.50962747368421046, 0.30290530568169505, 0 },
+  { 0.50962747368421046, 0.30290530568169505, 0 },
+  { 0.50962747368421046, 0.012274822450676903, 0 },
+  { 0.61945205263157899, 1.0545860262833884e-07, 0 },
+  { 0.61945205263157899, 1.0545860262833884e-07, 0 },
+  { 0.61945205263157899, 0, 0 },
+  { 0.57852005263157891, 0.99999539859856279, 0 },
+  { 0.57852005263157891, 0.99999539859856279, 0 },
+  { 0.57852005263157891, 1, 0 },
+  { 0.71595615789473688, 0.0020180427875246543, 0 },
+  { 0.71595615789473688, 0.0020180427875246543, 0 },
+  { 0.71595615789473688, 6.169953437051845e-12, 0 },
+  { 0.81022342105263156, 1.4988010832439613e-15, 0 },
+  { 0.81022342105263156, 1.4988010832439613e-15, 0 },
+  { 0.81022342105263156, 0, 0 },
+  { 0.41897868421052625, 0.99999993413356791, 0.039243094969041881 },
+  { 0.41897868421052625, 0.99999993413356791, 0.039243094969041881 },
+  { 0.41897868421052625, 1, 9.8906926844888332e-05 },
+  { 0.48583389473684208, 0.89460956715268214, 1.8503880094833391e-09 },
+  { 0.48583389473684208, 0.89460956715268214, 1.8503880094833391e-09 },
+  { 0.48583389473684208, 0.99978533163235717, 0 },
+  { 0.55211147368421054, 0.0030831904321659831, 0 },
+  { 0.55211147368421054, 0.0030831904321659831, 0 },
+  { 0.55211147368421054, 7.3940475964207053e-10, 0 },
+  { 0.53887752631578956, 0.99998288592717943, 0 },
+  { 0.53887752631578956, 0.99998288592717943, 0 },
+  { 0.53887752631578956, 1, 0 },
+  { 0.60730078947368415, 0.53769478274627192, 0 },
+  { 0.60730078947368415, 0.53769478274627192, 0 },
+  { 0.60730078947368415, 0.48880063268349072, 0 },
+  { 0.67881236842105275, 1.7607105606665119e-05, 0 },
+  { 0.67881236842105275, 1.7607105606665119e-05, 0 },
+  { 0.67881236842105275, 0, 0 },
+  { 0.70743684210526314, 0.99999999997205902, 0 },
+  { 0.70743684210526314, 0.99999999997205902, 0 },
+  { 0.70743684210526314, 1, 0 },
+  { 0.77720947368421056, 0.79822250723233201, 0 },
+  { 0.77720947368421056, 0.79822250723233201, 0 },
+  { 0.77720947368421056, 0.97850634716883644, 0 },
+  { 0.84240389473684207, 3.2641329165694621e-06, 0 },
+  { 0.84240389473684207, 3.2641329165694621e-06, 0 },
+  { 0.84240389473684207, 9.4682681694990833e-09, 0 },
+  { 0.86595736842105275, 1, 0 },
+  { 0.86595736842105275, 1, 0 },
+  { 0.86595736842105275, 1, 0 },
+  { 0.91781089473684196, 0.98764085526079892, 0 },
+  { 0.91781089473684196, 0.98764085526079892, 0 },
+  { 0.91781089473684196, 0.99986255923753586, 0 },
+  { 0.95531221052631565, 0.015150152955085372, 0 },
+  { 0.95531221052631565, 0.015150152955085372, 0 },
+  { 0.95531221052631565, 0.0025613439856873033, 0 }
+};
+
+/// Reference PCFICH+PDCCH error rates
+static const double MiErrorModelPdcchReference[9] = {
+  0.92260200000000003,
+  0.82333999999999996,
+  0.44086900000000001,
+  0.15978700000000001,
+  0.0310472,
+  0.0053228299999999997,
+  0,
+  0,
+  0
+};
+
+LteMiErrorModelTestCase::LteMiErrorModelTestCase ()
+  : TestCase ("MI error model against reference values")
+{
+}
+
+void
+LteMiErrorModelTestCase::DoRun (void)
+{
+  std::vector<double> centerFrequencies;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      centerFrequencies.push_back (2.1e9 + i * 180e3);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (centerFrequencies);
+  // SINR over 7 dB around a mean, in Watt
+  SpectrumValue sinr (model);
+  std::vector<int> map;
+  for (int rb = 3; rb < 40; rb += 2)
+    {
+      map.push_back (rb);
+    }
+
+  const uint8_t mcsValues[] = {0, 3, 6, 9, 10, 13, 16, 17, 20, 24, 28};
+  const uint16_t sizes[] = {10, 40, 1500};
+  uint32_t n = 0;
+  for (uint8_t mcs : mcsValues)
+    {
+      for (int delta = -1; delta <= 1; delta++)
+        {
+          for (uint16_t size : sizes)
+            {
+              double meanDb = -6 + mcs * 0.9 + delta * 1.5;
+              for (int rb = 0; rb < 50; rb++)
+                {
+                  sinr[rb] = std::pow (10, (meanDb + (rb % 7) - 3) / 10);
+                }
+              HarqProcessInfoList_t harq;
+              TbStats_t stats = LteMiErrorModel::GetTbDecodificationStats (sinr, map, size, mcs, harq);
+              NS_TEST_ASSERT_MSG_EQ_TOL (stats.mi, MiErrorModelTbReference[n][0], 1e-12,
+                                         "wrong MI for MCS " << (uint16_t) mcs << " at " << meanDb << " dB");
+              NS_TEST_ASSERT_MSG_EQ_TOL (stats.tbler, MiErrorModelTbReference[n][1], 1e-12,
+                                         "wrong BLER for MCS " << (uint16_t) mcs << " at " << meanDb << " dB, TB of " << size << " bytes");
+
+              HarqProcessInfoElement_t first;
+              first.m_mi = stats.mi * 0.8;
+              first.m_rv = 0;
+              first.m_infoBits = size * 8;
+              first.m_codeBits = size * 8 * 1.7;
+              harq.push_back (first);
+              for (int rb = 0; rb < 50; rb++)
+                {
+                  sinr[rb] = std::pow (10, (meanDb - 3 + (rb % 7) - 3) / 10);
+                }
+              stats = LteMiErrorModel::GetTbDecodificationStats (sinr, map, size, mcs, harq);
+              NS_TEST_ASSERT_MSG_EQ_TOL (stats.tbler, MiErrorModelTbReference[n][2], 1e-12,
+                                         "wrong retransmission BLER for MCS " << (uint16_t) mcs << " at " << meanDb << " dB, TB of " << size << " bytes");
+              n++;
+            }
+        }
+    }
+
+  n = 0;
+  for (int meanDb = -12; meanDb <= 4; meanDb += 2)
+    {
+      for (int rb = 0; rb < 50; rb++)
+        {
+          sinr[rb] = std::pow (10, (meanDb + (rb % 7) - 3) / 10.0);
+        }
+      NS_TEST_ASSERT_MSG_EQ_TOL (LteMiErrorModel::GetPcfichPdcchError (sinr), MiErrorModelPdcchReference[n], 1e-12,
+                                 "wrong PCFICH+PDCCH error rate at " << meanDb << " dB");
+      n++;
+    }
+}
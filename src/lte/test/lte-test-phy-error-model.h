@@ -123,6 +123,25 @@ private:
 
 
 
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Check the MI, the TB BLER and the PCFICH+PDCCH error rate of the
+ * LteMiErrorModel against reference values, for all the modulations, for
+ * TBs of one and two CBs, and for HARQ retransmissions
+ */
+class LteMiErrorModelTestCase : public TestCase
+{
+public:
+  LteMiErrorModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+
+
 /**
  * \ingroup lte-test
  * \ingroup tests
@@ -0,0 +1,226 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/config.h"
+#include "ns3/lte-helper.h"
+#include "ns3/point-to-point-epc-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/udp-client-server-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/rng-seed-manager.h"
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LteUePhyDormancyTest");
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Check that the dormancy of the UEs changes neither the uplink
+ * nor the downlink traffic, and that it saves events.
+ *
+ * One of the UEs of a cell exchanges UDP packets with a remote host,
+ * while the other UEs are connected but idle.
+ */
+class LteUePhyDormancyTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param cqiPeriodicity the downlink CQI periodicity
+   */
+  LteUePhyDormancyTestCase (Time cqiPeriodicity);
+
+private:
+  virtual void DoRun (void);
+
+  /// The outcome of a simulation
+  struct Outcome
+  {
+    std::vector<Time> dlRx; ///< Reception times of the downlink packets
+    std::vector<Time> ulRx; ///< Reception times of the uplink packets
+    uint64_t nEvents;       ///< Number of events executed
+  };
+
+  /**
+   * Run the simulation
+   * \param dormancy whether the dormancy of the UEs is enabled
+   * \return the outcome of the simulation
+   */
+  Outcome RunSimulation (bool dormancy);
+
+  /**
+   * Record the reception of a packet
+   * \param times the reception times
+   * \param p the packet
+   * \param from the sender
+   */
+  static void Receive (std::vector<Time> *times, Ptr<const Packet> p, const Address &from);
+
+  Time m_cqiPeriodicity; ///< the downlink CQI periodicity
+};
+
+LteUePhyDormancyTestCase::LteUePhyDormancyTestCase (Time cqiPeriodicity)
+  : TestCase ("UE dormancy with a CQI periodicity of " + std::to_string (cqiPeriodicity.GetMilliSeconds ()) + " ms"),
+    m_cqiPeriodicity (cqiPeriodicity)
+{
+}
+
+void
+LteUePhyDormancyTestCase::Receive (std::vector<Time> *times, Ptr<const Packet> p, const Address &from)
+{
+  times->push_back (Simulator::Now ());
+}
+
+LteUePhyDormancyTestCase::Outcome
+LteUePhyDormancyTestCase::RunSimulation (bool dormancy)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::LteUePhy::EnableDormancy", BooleanValue (dormancy));
+  Config::SetDefault ("ns3::LteUePhy::DownlinkCqiPeriodicity", TimeValue (m_cqiPeriodicity));
+  Config::SetDefault ("ns3::LteHelper::UseIdealRrc", BooleanValue (true));
+
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
+  lteHelper->SetEpcHelper (epcHelper);
+
+  Ptr<Node> pgw = epcHelper->GetPgwNode ();
+  NodeContainer remoteHostContainer;
+  remoteHostContainer.Create (1);
+  Ptr<Node> remoteHost = remoteHostContainer.Get (0);
+  InternetStackHelper internet;
+  internet.Install (remoteHostContainer);
+  PointToPointHelper p2ph;
+  NetDeviceContainer internetDevices = p2ph.Install (pgw, remoteHost);
+  Ipv4AddressHelper ipv4h;
+  ipv4h.SetBase ("1.0.0.0", "255.0.0.0");
+  Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign (internetDevices);
+  Ipv4Address remoteHostAddr = internetIpIfaces.GetAddress (1);
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ptr<Ipv4StaticRouting> remoteHostStaticRouting = ipv4RoutingHelper.GetStaticRouting (remoteHost->GetObject<Ipv4> ());
+  remoteHostStaticRouting->AddNetworkRouteTo (Ipv4Address ("7.0.0.0"), Ipv4Mask ("255.0.0.0"), 1);
+
+  NodeContainer enbNodes;
+  enbNodes.Create (1);
+  NodeContainer ueNodes;
+  ueNodes.Create (4);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (enbNodes);
+  mobility.Install (ueNodes);
+  NetDeviceContainer enbDevs = lteHelper->InstallEnbDevice (enbNodes);
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+
+  internet.Install (ueNodes);
+  Ipv4InterfaceContainer ueIpIfaces = epcHelper->AssignUeIpv4Address (ueDevs);
+  for (uint32_t u = 0; u < ueNodes.GetN (); ++u)
+    {
+      Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting (ueNodes.Get (u)->GetObject<Ipv4> ());
+      ueStaticRouting->SetDefaultRoute (epcHelper->GetUeDefaultGatewayAddress (), 1);
+    }
+  lteHelper->Attach (ueDevs, enbDevs.Get (0));
+
+  Outcome outcome;
+  uint16_t port = 1234;
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinks = sinkHelper.Install (ueNodes.Get (0));
+  sinks.Add (sinkHelper.Install (remoteHost));
+  sinks.Get (0)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&LteUePhyDormancyTestCase::Receive, &outcome.dlRx));
+  sinks.Get (1)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&LteUePhyDormancyTestCase::Receive, &outcome.ulRx));
+
+  UdpClientHelper dlClient (ueIpIfaces.GetAddress (0), port);
+  dlClient.SetAttribute ("Interval", TimeValue (MilliSeconds (37)));
+  dlClient.SetAttribute ("MaxPackets", UintegerValue (1000000));
+  dlClient.SetAttribute ("PacketSize", UintegerValue (500));
+  ApplicationContainer clients = dlClient.Install (remoteHost);
+  UdpClientHelper ulClient (remoteHostAddr, port);
+  ulClient.SetAttribute ("Interval", TimeValue (MicroSeconds (53500)));
+  ulClient.SetAttribute ("MaxPackets", UintegerValue (1000000));
+  ulClient.SetAttribute ("PacketSize", UintegerValue (300));
+  clients.Add (ulClient.Install (ueNodes.Get (0)));
+  // the packets are not sent at the start of a subframe, where a dormant
+  // UE may not order the events as an active one
+  clients.Start (Seconds (0.5004));
+
+  Simulator::Stop (Seconds (1.5));
+  Simulator::Run ();
+  outcome.nEvents = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::LteUePhy::EnableDormancy", BooleanValue (false));
+  return outcome;
+}
+
+void
+LteUePhyDormancyTestCase::DoRun (void)
+{
+  Outcome reference = RunSimulation (false);
+  Outcome dormant = RunSimulation (true);
+
+  NS_TEST_ASSERT_MSG_GT (reference.dlRx.size (), 0, "no downlink packet received");
+  NS_TEST_ASSERT_MSG_GT (reference.ulRx.size (), 0, "no uplink packet received");
+  NS_TEST_ASSERT_MSG_EQ (dormant.dlRx.size (), reference.dlRx.size (), "wrong number of downlink packets");
+  NS_TEST_ASSERT_MSG_EQ (dormant.ulRx.size (), reference.ulRx.size (), "wrong number of uplink packets");
+  for (uint32_t i = 0; i < reference.dlRx.size () && i < dormant.dlRx.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dormant.dlRx[i], reference.dlRx[i], "wrong reception time of downlink packet " << i);
+    }
+  for (uint32_t i = 0; i < reference.ulRx.size () && i < dormant.ulRx.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dormant.ulRx[i], reference.ulRx[i], "wrong reception time of uplink packet " << i);
+    }
+  NS_LOG_INFO ("events: " << reference.nEvents << " without dormancy, " << dormant.nEvents << " with dormancy");
+  if (m_cqiPeriodicity > MilliSeconds (1))
+    {
+      // otherwise, the connected UEs send a CQI at every subframe
+      NS_TEST_ASSERT_MSG_LT (dormant.nEvents, reference.nEvents, "the dormancy does not save events");
+    }
+}
+
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test suite of the dormancy of the UE PHY
+ */
+class LteUePhyDormancyTestSuite : public TestSuite
+{
+public:
+  LteUePhyDormancyTestSuite ();
+};
+
+LteUePhyDormancyTestSuite::LteUePhyDormancyTestSuite ()
+  : TestSuite ("lte-ue-phy-dormancy", SYSTEM)
+{
+  AddTestCase (new LteUePhyDormancyTestCase (MilliSeconds (1)), TestCase::QUICK);
+  AddTestCase (new LteUePhyDormancyTestCase (MilliSeconds (10)), TestCase::QUICK);
+}
+
+static LteUePhyDormancyTestSuite g_lteUePhyDormancyTestSuite; ///< the test suite
@@ -0,0 +1,282 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "spatial-grid-index.h"
+#include "mobility-model.h"
+#include "ns3/assert.h"
+#include "ns3/callback.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SpatialGridIndex");
+
+SpatialGridIndex::SpatialGridIndex ()
+  : m_cellSize (100),
+    m_maxSpeed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SpatialGridIndex::~SpatialGridIndex ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+SpatialGridIndex::SetCellSize (double size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size > 0);
+  if (size == m_cellSize)
+    {
+      return;
+    }
+  m_cellSize = size;
+  // spread the motionless entries over the new cells
+  m_cells.clear ();
+  for (uint32_t id = 0; id < m_entries.size (); id++)
+    {
+      Entry &entry = m_entries[id];
+      if (entry.mobility != 0 && !entry.moving)
+        {
+          entry.cell = GetKey (GetCellIndex (entry.position.x), GetCellIndex (entry.position.y));
+          m_cells[entry.cell].push_back (id);
+        }
+    }
+  PlaceMoving ();
+}
+
+double
+SpatialGridIndex::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+uint32_t
+SpatialGridIndex::Add (Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  uint32_t id = m_entries.size ();
+  Entry entry;
+  entry.mobility = mobility;
+  entry.cell = 0;
+  entry.moving = false;
+  entry.speed = 0;
+  entry.movingIndex = 0;
+  m_entries.push_back (entry);
+  if (mobility == 0)
+    {
+      m_unlocated.push_back (id);
+      return id;
+    }
+  if (m_models.find (PeekPointer (mobility)) == m_models.end ())
+    {
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&SpatialGridIndex::CourseChanged, this));
+    }
+  m_models.insert (std::make_pair (PeekPointer (mobility), id));
+  Link (id);
+  return id;
+}
+
+uint32_t
+SpatialGridIndex::GetN (void) const
+{
+  return m_entries.size ();
+}
+
+void
+SpatialGridIndex::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::multimap<const MobilityModel *, uint32_t>::const_iterator i = m_models.begin ();
+       i != m_models.end (); i = m_models.upper_bound (i->first))
+    {
+      m_entries[i->second].mobility->TraceDisconnectWithoutContext ("CourseChange",
+                                                                    MakeCallback (&SpatialGridIndex::CourseChanged, this));
+    }
+  m_models.clear ();
+  m_entries.clear ();
+  m_cells.clear ();
+  m_movingCells.clear ();
+  m_moving.clear ();
+  m_maxSpeed = 0;
+  m_unlocated.clear ();
+}
+
+void
+SpatialGridIndex::GetInRange (const Vector &position, double range, std::vector<uint32_t> &ids) const
+{
+  NS_LOG_FUNCTION (this << position << range);
+  ids = m_unlocated;
+  Collect (m_cells, position, range, 0, ids);
+  if (!m_moving.empty ())
+    {
+      Time now = Simulator::Now ();
+      double slack = m_maxSpeed * (now - m_placed).GetSeconds ();
+      if (now < m_placed || slack > m_cellSize / 2)
+        {
+          PlaceMoving ();
+          slack = 0;
+        }
+      Collect (m_movingCells, position, range, slack, ids);
+    }
+  std::sort (ids.begin (), ids.end ());
+}
+
+void
+SpatialGridIndex::Collect (const Cells &cells, const Vector &position, double range, double slack,
+                           std::vector<uint32_t> &ids) const
+{
+  double reach = range + slack;
+  int64_t xMin = GetCellIndex (position.x - reach);
+  int64_t xMax = GetCellIndex (position.x + reach);
+  int64_t yMin = GetCellIndex (position.y - reach);
+  int64_t yMax = GetCellIndex (position.y + reach);
+  if ((double)(xMax - xMin + 1) * (yMax - yMin + 1) <= cells.size ())
+    {
+      for (int64_t x = xMin; x <= xMax; x++)
+        {
+          for (int64_t y = yMin; y <= yMax; y++)
+            {
+              Cells::const_iterator cell = cells.find (GetKey (x, y));
+              if (cell != cells.end ())
+                {
+                  CollectCell (cell->second, position, range, slack, ids);
+                }
+            }
+        }
+    }
+  else
+    {
+      // the range covers more cells than there are non-empty ones
+      for (Cells::const_iterator cell = cells.begin (); cell != cells.end (); cell++)
+        {
+          CollectCell (cell->second, position, range, slack, ids);
+        }
+    }
+}
+
+void
+SpatialGridIndex::CollectCell (const std::vector<uint32_t> &cell, const Vector &position,
+                               double range, double slack, std::vector<uint32_t> &ids) const
+{
+  for (std::vector<uint32_t>::const_iterator i = cell.begin (); i != cell.end (); i++)
+    {
+      const Entry &entry = m_entries[*i];
+      // a moving model is at most slack meters away from its stored position
+      if (CalculateDistance (entry.position, position) <= range + slack
+          && (!entry.moving || CalculateDistance (entry.mobility->GetPosition (), position) <= range))
+        {
+          ids.push_back (*i);
+        }
+    }
+}
+
+void
+SpatialGridIndex::PlaceMoving (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_movingCells.clear ();
+  m_maxSpeed = 0;
+  m_placed = Simulator::Now ();
+  for (std::vector<uint32_t>::const_iterator i = m_moving.begin (); i != m_moving.end (); i++)
+    {
+      Entry &entry = m_entries[*i];
+      entry.position = entry.mobility->GetPosition ();
+      entry.cell = GetKey (GetCellIndex (entry.position.x), GetCellIndex (entry.position.y));
+      m_movingCells[entry.cell].push_back (*i);
+      m_maxSpeed = std::max (m_maxSpeed, entry.speed);
+    }
+}
+
+int64_t
+SpatialGridIndex::GetKey (int64_t x, int64_t y)
+{
+  return (int64_t)(((uint64_t)x << 32) ^ ((uint64_t)y & 0xffffffff));
+}
+
+int64_t
+SpatialGridIndex::GetCellIndex (double v) const
+{
+  return (int64_t)std::floor (v / m_cellSize);
+}
+
+void
+SpatialGridIndex::Link (uint32_t id)
+{
+  Entry &entry = m_entries[id];
+  Vector velocity = entry.mobility->GetVelocity ();
+  entry.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+  entry.position = entry.mobility->GetPosition ();
+  entry.cell = GetKey (GetCellIndex (entry.position.x), GetCellIndex (entry.position.y));
+  if (!entry.moving)
+    {
+      m_cells[entry.cell].push_back (id);
+      return;
+    }
+  if (m_moving.empty ())
+    {
+      m_placed = Simulator::Now ();
+      m_maxSpeed = 0;
+    }
+  // placed after m_placed, the entry moves less than m_maxSpeed allows
+  entry.speed = velocity.GetLength ();
+  entry.movingIndex = m_moving.size ();
+  m_moving.push_back (id);
+  m_movingCells[entry.cell].push_back (id);
+  m_maxSpeed = std::max (m_maxSpeed, entry.speed);
+}
+
+void
+SpatialGridIndex::Unlink (uint32_t id)
+{
+  Entry &entry = m_entries[id];
+  Cells &cells = entry.moving ? m_movingCells : m_cells;
+  if (entry.moving)
+    {
+      m_moving[entry.movingIndex] = m_moving.back ();
+      m_entries[m_moving.back ()].movingIndex = entry.movingIndex;
+      m_moving.pop_back ();
+    }
+  Cells::iterator cell = cells.find (entry.cell);
+  NS_ASSERT (cell != cells.end ());
+  cell->second.erase (std::find (cell->second.begin (), cell->second.end (), id));
+  if (cell->second.empty ())
+    {
+      cells.erase (cell);
+    }
+}
+
+void
+SpatialGridIndex::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  typedef std::multimap<const MobilityModel *, uint32_t>::const_iterator Iterator;
+  std::pair<Iterator, Iterator> range = m_models.equal_range (PeekPointer (mobility));
+  for (Iterator i = range.first; i != range.second; i++)
+    {
+      Unlink (i->second);
+      Link (i->second);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SPATIAL_GRID_INDEX_H
+#define SPATIAL_GRID_INDEX_H
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup mobility
+ *
+ * \brief Index of mobility models by position, to find quickly the
+ * models within some distance of a point.
+ *
+ * The motionless models are stored in the square cells of a regular
+ * grid over the x and y coordinates, so that a query only looks at the
+ * models of the cells which intersect the range.  The moving models
+ * are stored in a second grid, by their position at the time they were
+ * last placed in it, and a query widens its range by the largest
+ * distance any of them can have covered since, computed from their
+ * speed; their actual positions are only computed for the models of
+ * the cells which intersect the widened range.  When that distance
+ * exceeds half a cell, the next query places all the moving models
+ * again, at their current position.
+ *
+ * The index listens to the CourseChange trace source of the models to
+ * move them from one cell to another, so it relies on the models
+ * notifying every change of their position or velocity when it happens
+ * (which is not the case of a WaypointMobilityModel with LazyNotify, nor
+ * of a ConstantAccelerationMobilityModel).  The index disconnects from
+ * the trace sources in Clear and in its destructor, so it can be
+ * destroyed before the models.
+ *
+ * The models are identified by consecutive integers, in the order in
+ * which they were added, and a query returns the identifiers in
+ * increasing order, so that callers iterating over the result keep
+ * the order of their own container.
+ */
+class SpatialGridIndex
+{
+public:
+  SpatialGridIndex ();
+  ~SpatialGridIndex ();
+
+  /**
+   * Set the size of the cells.  A size close to the usual query range
+   * is a good trade-off between the number of cells and the number of
+   * models looked at.
+   *
+   * \param size the length of the side of a cell, in meters
+   */
+  void SetCellSize (double size);
+  /**
+   * \returns the length of the side of a cell, in meters
+   */
+  double GetCellSize (void) const;
+  /**
+   * Add a mobility model.  A null model has no position: it is
+   * returned by every query.
+   *
+   * \param mobility the mobility model, or zero
+   * \returns the identifier of the model
+   */
+  uint32_t Add (Ptr<MobilityModel> mobility);
+  /**
+   * \returns the number of models added
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Remove all the models.
+   */
+  void Clear (void);
+  /**
+   * Find the models within some distance of a point.
+   *
+   * \param position the point
+   * \param range the distance, in meters
+   * \param ids the identifiers of the models at most \p range meters
+   * away from \p position, and of the models without position, in
+   * increasing order
+   */
+  void GetInRange (const Vector &position, double range, std::vector<uint32_t> &ids) const;
+
+private:
+  /** A mobility model and its location in the index. */
+  struct Entry
+  {
+    Ptr<MobilityModel> mobility; //!< the model
+    Vector position;             //!< position when placed in its cell
+    int64_t cell;                //!< cell of the model
+    bool moving;                 //!< whether the cell is in m_movingCells
+    double speed;                //!< speed of a moving model, in m/s
+    uint32_t movingIndex;        //!< index of a moving model in m_moving
+  };
+  /** The entries of each non-empty cell, by cell key. */
+  typedef std::map<int64_t, std::vector<uint32_t> > Cells;
+
+  /**
+   * Copy constructor, disabled: the index is connected to trace sources.
+   * \param o the index to copy
+   */
+  SpatialGridIndex (const SpatialGridIndex &o);
+  /**
+   * Assignment, disabled: the index is connected to trace sources.
+   * \param o the index to copy
+   * \returns this index
+   */
+  SpatialGridIndex &operator = (const SpatialGridIndex &o);
+
+  /**
+   * \param x the cell index along the x axis
+   * \param y the cell index along the y axis
+   * \returns the key of the cell
+   */
+  static int64_t GetKey (int64_t x, int64_t y);
+  /**
+   * \param v a coordinate
+   * \returns the index of the cell containing \p v along an axis
+   */
+  int64_t GetCellIndex (double v) const;
+  /**
+   * Find the entries of a grid within some distance of a point.
+   *
+   * \param cells the grid
+   * \param position the point
+   * \param range the distance, in meters
+   * \param slack the distance the entries may have moved from the
+   * position stored in their entry, in meters
+   * \param ids the identifiers of the entries found, appended
+   */
+  void Collect (const Cells &cells, const Vector &position, double range, double slack,
+                std::vector<uint32_t> &ids) const;
+  /**
+   * Find the entries of a cell within some distance of a point.
+   *
+   * \param cell the entries of the cell
+   * \param position the point
+   * \param range the distance, in meters
+   * \param slack the distance the entries may have moved from the
+   * position stored in their entry, in meters
+   * \param ids the identifiers of the entries found, appended
+   */
+  void CollectCell (const std::vector<uint32_t> &cell, const Vector &position,
+                    double range, double slack, std::vector<uint32_t> &ids) const;
+  /**
+   * Place all the moving entries in the cells of their current position.
+   */
+  void PlaceMoving (void) const;
+  /**
+   * Store an entry in the cell matching the current state of its model.
+   * \param id the identifier of the entry
+   */
+  void Link (uint32_t id);
+  /**
+   * Remove an entry from its cell or list.
+   * \param id the identifier of the entry
+   */
+  void Unlink (uint32_t id);
+  /**
+   * Update the entries of a model which changed its course.
+   * \param mobility the model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  double m_cellSize;                 //!< length of the side of a cell
+  /** The entries, by identifier; a query can place the moving ones again. */
+  mutable std::vector<Entry> m_entries;
+  Cells m_cells;                     //!< the cells of the motionless entries
+  mutable Cells m_movingCells;       //!< the cells of the moving entries
+  std::vector<uint32_t> m_moving;    //!< the moving entries
+  mutable Time m_placed;             //!< when the moving entries were all placed
+  mutable double m_maxSpeed;         //!< largest speed of a moving entry since then
+  std::vector<uint32_t> m_unlocated; //!< the entries without model
+  /** The entries of each model, several entries can share a model. */
+  std::multimap<const MobilityModel *, uint32_t> m_models;
+};
+
+} // namespace ns3
+
+#endif /* SPATIAL_GRID_INDEX_H */
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/spatial-grid-index.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check the SpatialGridIndex queries against an exhaustive search,
+ * with motionless, moving, teleported and position-less models, between
+ * and after the placements of the moving models in their cells.
+ */
+class SpatialGridIndexTestCase : public TestCase
+{
+public:
+  SpatialGridIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Compare random queries with an exhaustive search. */
+  void Check (void);
+  /** Teleport some motionless models, stop or start some others. */
+  void Move (void);
+
+  SpatialGridIndex m_index;                   //!< the index
+  std::vector<Ptr<MobilityModel> > m_models;  //!< the models, by identifier
+  Ptr<UniformRandomVariable> m_random;        //!< random positions and ranges
+};
+
+SpatialGridIndexTestCase::SpatialGridIndexTestCase ()
+  : TestCase ("Check the spatial grid index queries")
+{
+}
+
+void
+SpatialGridIndexTestCase::Check (void)
+{
+  for (uint32_t query = 0; query < 50; query++)
+    {
+      Vector position (m_random->GetValue (-600, 600), m_random->GetValue (-600, 600), 0);
+      double range = m_random->GetValue (0, 400);
+      if (query == 0)
+        {
+          // a range covering everything
+          range = 1e6;
+        }
+      std::vector<uint32_t> expected;
+      for (uint32_t id = 0; id < m_models.size (); id++)
+        {
+          if (m_models[id] == 0
+              || CalculateDistance (m_models[id]->GetPosition (), position) <= range)
+            {
+              expected.push_back (id);
+            }
+        }
+      std::vector<uint32_t> ids;
+      m_index.GetInRange (position, range, ids);
+      NS_TEST_ASSERT_MSG_EQ (ids.size (), expected.size (),
+                             "number of models within " << range << "m of " << position
+                             << " at " << Simulator::Now ().GetSeconds () << "s");
+      for (uint32_t i = 0; i < ids.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (ids[i], expected[i], "model within " << range << "m of " << position);
+        }
+    }
+}
+
+void
+SpatialGridIndexTestCase::Move (void)
+{
+  for (uint32_t id = 0; id < m_models.size (); id += 7)
+    {
+      if (m_models[id] == 0)
+        {
+          continue;
+        }
+      Ptr<ConstantVelocityMobilityModel> cv = DynamicCast<ConstantVelocityMobilityModel> (m_models[id]);
+      if (cv != 0)
+        {
+          // stop or start
+          Vector velocity = cv->GetVelocity ();
+          if (velocity.x == 0 && velocity.y == 0)
+            {
+              cv->SetVelocity (Vector (m_random->GetValue (-20, 20), m_random->GetValue (-20, 20), 0));
+            }
+          else
+            {
+              cv->SetVelocity (Vector (0, 0, 0));
+            }
+        }
+      else
+        {
+          m_models[id]->SetPosition (Vector (m_random->GetValue (-500, 500), m_random->GetValue (-500, 500), 0));
+        }
+    }
+}
+
+void
+SpatialGridIndexTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_index.SetCellSize (100);
+
+  for (uint32_t id = 0; id < 500; id++)
+    {
+      Ptr<MobilityModel> model;
+      Vector position (m_random->GetValue (-500, 500), m_random->GetValue (-500, 500), m_random->GetValue (0, 30));
+      if (id % 50 == 0)
+        {
+          // no position
+        }
+      else if (id % 5 == 0)
+        {
+          Ptr<ConstantVelocityMobilityModel> cv = CreateObject<ConstantVelocityMobilityModel> ();
+          cv->SetPosition (position);
+          cv->SetVelocity (Vector (m_random->GetValue (-20, 20), m_random->GetValue (-20, 20), 0));
+          model = cv;
+        }
+      else if (id % 13 == 0)
+        {
+          // two entries for the same model
+          model = m_models[id - 1];
+        }
+      else
+        {
+          model = CreateObject<ConstantPositionMobilityModel> ();
+          model->SetPosition (position);
+        }
+      m_models.push_back (model);
+      NS_TEST_ASSERT_MSG_EQ (m_index.Add (model), id, "identifier of a new model");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_index.GetN (), 500, "number of models");
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (i), &SpatialGridIndexTestCase::Check, this);
+      Simulator::Schedule (Seconds (i + 0.25), &SpatialGridIndexTestCase::Check, this);
+      Simulator::Schedule (Seconds (i + 0.5), &SpatialGridIndexTestCase::Move, this);
+    }
+  Simulator::Schedule (Seconds (5.7), &SpatialGridIndex::SetCellSize, &m_index, 37.0);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  m_index.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (m_index.GetN (), 0, "number of models after Clear");
+  // no more notifications after Clear
+  m_models[1]->SetPosition (Vector (0, 0, 0));
+
+  // nor after the destruction of an index which was not cleared
+  SpatialGridIndex *index = new SpatialGridIndex ();
+  index->Add (m_models[1]);
+  index->Add (m_models[2]);
+  delete index;
+  m_models[1]->SetPosition (Vector (1, 0, 0));
+  m_models[2]->SetPosition (Vector (2, 0, 0));
+}
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Spatial grid index TestSuite
+ */
+class SpatialGridIndexTestSuite : public TestSuite
+{
+public:
+  SpatialGridIndexTestSuite ();
+};
+
+SpatialGridIndexTestSuite::SpatialGridIndexTestSuite ()
+  : TestSuite ("spatial-grid-index", UNIT)
+{
+  AddTestCase (new SpatialGridIndexTestCase, TestCase::QUICK);
+}
+
+static SpatialGridIndexTestSuite g_spatialGridIndexTestSuite; ///< the test suite
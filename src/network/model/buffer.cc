@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include <algorithm>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -50,7 +52,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -75,9 +77,9 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+thread_local uint32_t Buffer::g_maxSize = 0;
+thread_local Buffer::FreeList *Buffer::g_freeList = 0;
+thread_local struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
@@ -123,6 +125,8 @@ Buffer::Create (uint32_t dataSize)
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
+      // the first use registers the destruction of the list at thread exit
+      (void) &g_localStaticDestructor;
     }
   else if (IS_INITIALIZED (g_freeList))
     {
@@ -198,6 +202,7 @@ Buffer::Buffer (uint32_t dataSize)
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_fragments (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -245,6 +250,7 @@ Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
   m_data = Buffer::Create (0);
+  m_fragments = 0;
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -259,16 +265,20 @@ Buffer &
 Buffer::operator = (Buffer const&o)
 {
   NS_ASSERT (CheckInternalState ());
-  if (m_data != o.m_data) 
+  if (m_data != o.m_data || m_fragments != o.m_fragments)
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      Unref ();
+      m_data = o.m_data;
+      m_fragments = o.m_fragments;
+      if (m_fragments == 0)
         {
-          Recycle (m_data);
+          m_data->m_count++;
+        }
+      else
+        {
+          m_fragments->m_count++;
         }
-      m_data = o.m_data;
-      m_data->m_count++;
     }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
@@ -285,11 +295,88 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  Unref ();
+}
+
+void
+Buffer::Unref (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_fragments == 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0)
+        {
+          Recycle (m_data);
+        }
+    }
+  else
+    {
+      m_fragments->m_count--;
+      if (m_fragments->m_count == 0)
+        {
+          delete m_fragments;
+        }
+    }
+}
+
+void
+Buffer::CreateFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_fragments == 0);
+  struct Buffer::Fragments *fragments = new Buffer::Fragments ();
+  fragments->m_count = 1;
+  fragments->m_buffers.push_back (*this);
+  Unref ();
+  m_data = 0;
+  m_fragments = fragments;
+  m_maxZeroAreaStart = 0;
+  m_zeroAreaStart = 0;
+  m_zeroAreaEnd = 0;
+  m_end = m_end - m_start;
+  m_start = 0;
+  fragments->m_offsets.push_back (0);
+}
+
+void
+Buffer::UnshareFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_fragments != 0);
+  if (m_fragments->m_count > 1)
+    {
+      // the fragments only hold references to the data
+      struct Buffer::Fragments *fragments = new Buffer::Fragments (*m_fragments);
+      fragments->m_count = 1;
+      m_fragments->m_count--;
+      m_fragments = fragments;
+    }
+}
+
+void
+Buffer::UpdateFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_fragments != 0 && m_fragments->m_count == 1);
+  std::vector<Buffer> &buffers = m_fragments->m_buffers;
+  if (buffers.size () == 1)
     {
-      Recycle (m_data);
+      // copy the last fragment before releasing the list which holds it
+      Buffer contiguous = buffers.front ();
+      *this = contiguous;
+      return;
     }
+  m_fragments->m_offsets.resize (buffers.size ());
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < buffers.size (); i++)
+    {
+      NS_ASSERT (buffers[i].m_fragments == 0 && buffers[i].GetSize () > 0);
+      m_fragments->m_offsets[i] = offset;
+      offset += buffers[i].GetSize ();
+    }
+  m_start = 0;
+  m_end = offset;
 }
 
 uint32_t
@@ -310,6 +397,13 @@ Buffer::AddAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      UnshareFragments ();
+      m_fragments->m_buffers.front ().AddAtStart (start);
+      UpdateFragments ();
+      return;
+    }
   bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
   if (m_start >= start && !isDirty)
     {
@@ -355,6 +449,13 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      UnshareFragments ();
+      m_fragments->m_buffers.back ().AddAtEnd (end);
+      UpdateFragments ();
+      return;
+    }
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
@@ -400,7 +501,8 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (m_fragments == 0 && o.m_fragments == 0 &&
+      m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
@@ -426,11 +528,38 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
-  *this = CreateFullCopy ();
-  AddAtEnd (o.GetSize ());
-  Buffer::Iterator destStart = End ();
-  destStart.Prev (o.GetSize ());
-  destStart.Write (o.Begin (), o.End ());
+  if (o.GetSize () == 0)
+    {
+      return;
+    }
+  if (GetSize () == 0)
+    {
+      *this = o;
+      return;
+    }
+
+  // append the fragments of o by reference: o may be this buffer, and
+  // its fragments are not modified, only shared.
+  Buffer tail = o;
+  if (m_fragments == 0)
+    {
+      CreateFragments ();
+    }
+  else
+    {
+      UnshareFragments ();
+    }
+  std::vector<Buffer> &buffers = m_fragments->m_buffers;
+  if (tail.m_fragments == 0)
+    {
+      buffers.push_back (tail);
+    }
+  else
+    {
+      buffers.insert (buffers.end (), tail.m_fragments->m_buffers.begin (),
+                      tail.m_fragments->m_buffers.end ());
+    }
+  UpdateFragments ();
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -439,6 +568,21 @@ Buffer::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      UnshareFragments ();
+      std::vector<Buffer> &buffers = m_fragments->m_buffers;
+      std::vector<Buffer>::iterator i = buffers.begin ();
+      while (i + 1 != buffers.end () && start >= i->GetSize ())
+        {
+          start -= i->GetSize ();
+          ++i;
+        }
+      buffers.erase (buffers.begin (), i);
+      buffers.front ().RemoveAtStart (start);
+      UpdateFragments ();
+      return;
+    }
   uint32_t newStart = m_start + start;
   if (newStart <= m_zeroAreaStart)
     {
@@ -484,6 +628,19 @@ Buffer::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      UnshareFragments ();
+      std::vector<Buffer> &buffers = m_fragments->m_buffers;
+      while (buffers.size () > 1 && end >= buffers.back ().GetSize ())
+        {
+          end -= buffers.back ().GetSize ();
+          buffers.pop_back ();
+        }
+      buffers.back ().RemoveAtEnd (end);
+      UpdateFragments ();
+      return;
+    }
   uint32_t newEnd = m_end - std::min (end, m_end - m_start);
   if (newEnd > m_zeroAreaEnd)
     {
@@ -520,6 +677,31 @@ Buffer::CreateFragment (uint32_t start, uint32_t length) const
 {
   NS_LOG_FUNCTION (this << start << length);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      NS_ASSERT (start + length <= GetSize ());
+      const std::vector<uint32_t> &offsets = m_fragments->m_offsets;
+      const std::vector<Buffer> &buffers = m_fragments->m_buffers;
+      // the fragments holding the first and the last byte
+      uint32_t first = std::upper_bound (offsets.begin (), offsets.end (), start) - offsets.begin () - 1;
+      uint32_t last = first;
+      while (last + 1 < offsets.size () && offsets[last + 1] < start + length)
+        {
+          last++;
+        }
+      if (first == last)
+        {
+          return buffers[first].CreateFragment (start - offsets[first], length);
+        }
+      Buffer tmp;
+      tmp.CreateFragments ();
+      std::vector<Buffer> &fragment = tmp.m_fragments->m_buffers;
+      fragment.assign (buffers.begin () + first, buffers.begin () + last + 1);
+      fragment.front ().RemoveAtStart (start - offsets[first]);
+      fragment.back ().RemoveAtEnd (offsets[last] + buffers[last].GetSize () - (start + length));
+      tmp.UpdateFragments ();
+      return tmp;
+    }
   Buffer tmp = *this;
   tmp.RemoveAtStart (start);
   tmp.RemoveAtEnd (GetSize () - (start + length));
@@ -532,6 +714,13 @@ Buffer::CreateFullCopy (void) const
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
+  if (m_fragments != 0)
+    {
+      Buffer tmp;
+      tmp.AddAtStart (GetSize ());
+      tmp.Begin ().Write (Begin (), End ());
+      return tmp;
+    }
   if (m_zeroAreaEnd - m_zeroAreaStart != 0) 
     {
       Buffer tmp;
@@ -556,6 +745,10 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_fragments != 0)
+    {
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -576,6 +769,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_fragments != 0)
+    {
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -715,6 +912,17 @@ void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &os << size);
+  if (m_fragments != 0)
+    {
+      const std::vector<Buffer> &buffers = m_fragments->m_buffers;
+      for (uint32_t i = 0; i < buffers.size () && size > 0; i++)
+        {
+          uint32_t tmpsize = std::min (buffers[i].GetSize (), size);
+          buffers[i].CopyData (os, tmpsize);
+          size -= tmpsize;
+        }
+      return;
+    }
   if (size > 0)
     {
       uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
@@ -745,6 +953,17 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &buffer << size);
   uint32_t originalSize = size;
+  if (m_fragments != 0)
+    {
+      const std::vector<Buffer> &buffers = m_fragments->m_buffers;
+      for (uint32_t i = 0; i < buffers.size () && size > 0; i++)
+        {
+          uint32_t tmpsize = buffers[i].CopyData (buffer, size);
+          buffer += tmpsize;
+          size -= tmpsize;
+        }
+      return originalSize - size;
+    }
   if (size > 0)
     {
       uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
@@ -783,7 +1002,7 @@ uint32_t
 Buffer::Iterator::GetDistanceFrom (Iterator const &o) const
 {
   NS_LOG_FUNCTION (this << &o);
-  NS_ASSERT (m_data == o.m_data);
+  NS_ASSERT (m_fragments == o.m_fragments && (m_fragments != 0 || m_data == o.m_data));
   int32_t diff = m_current - o.m_current;
   if (diff < 0)
     {
@@ -812,12 +1031,29 @@ bool
 Buffer::Iterator::CheckNoZero (uint32_t start, uint32_t end) const
 {
   NS_LOG_FUNCTION (this << &start << &end);
-  for (uint32_t i = start; i < end; i++)
+  if (start == end)
+    {
+      return true;
+    }
+  if (m_fragments == 0)
+    {
+      return start >= m_dataStart && end <= m_dataEnd + 1 &&
+             (end <= m_zeroStart || start >= m_zeroEnd);
+    }
+  if (start < m_dataStart || end > m_dataEnd)
+    {
+      return false;
+    }
+  Iterator tmp = *this;
+  tmp.m_current = start;
+  while (tmp.m_current < end)
     {
-      if (!Check (i))
+      uint32_t size = end - tmp.m_current;
+      if (tmp.GetReadRun (&size) == 0)
         {
           return false;
         }
+      tmp.m_current += size;
     }
   return true;
 }
@@ -825,45 +1061,118 @@ bool
 Buffer::Iterator::Check (uint32_t i) const
 {
   NS_LOG_FUNCTION (this << &i);
+  if (m_fragments != 0 && i >= m_dataStart && i < m_dataEnd)
+    {
+      Iterator tmp = *this;
+      tmp.m_current = i;
+      tmp.SelectFragment ();
+      return !(i >= tmp.m_zeroStart && i < tmp.m_zeroEnd);
+    }
   return i >= m_dataStart && 
-         !(i >= m_zeroStart && i < m_zeroEnd) &&
+         !(m_fragments == 0 && i >= m_zeroStart && i < m_zeroEnd) &&
          i <= m_dataEnd;
 }
 
+void
+Buffer::Iterator::SelectFragment (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_fragments == 0)
+    {
+      return;
+    }
+  const std::vector<uint32_t> &offsets = m_fragments->m_offsets;
+  uint32_t index = std::upper_bound (offsets.begin (), offsets.end (), m_current) - offsets.begin ();
+  NS_ASSERT (index > 0);
+  index--;
+  const Buffer &fragment = m_fragments->m_buffers[index];
+  m_fragmentStart = offsets[index];
+  m_fragmentEnd = m_fragmentStart + fragment.GetSize ();
+  m_shift = fragment.m_start - m_fragmentStart;
+  m_zeroStart = fragment.m_zeroAreaStart - m_shift;
+  m_zeroEnd = fragment.m_zeroAreaEnd - m_shift;
+  if (m_zeroStart == m_zeroEnd)
+    {
+      m_zeroStart = m_fragmentEnd;
+      m_zeroEnd = m_fragmentEnd;
+    }
+  m_data = fragment.m_data->m_data;
+}
+
+uint8_t *
+Buffer::Iterator::GetWriteRun (uint32_t *size)
+{
+  NS_LOG_FUNCTION (this << *size);
+  if (m_current < m_fragmentStart || m_current >= m_fragmentEnd)
+    {
+      SelectFragment ();
+    }
+  if (m_current < m_zeroStart)
+    {
+      *size = std::min (*size, m_zeroStart - m_current);
+      return &m_data[m_current + m_shift];
+    }
+  NS_ABORT_MSG_UNLESS (m_current >= m_zeroEnd && m_current < m_fragmentEnd,
+                       GetWriteErrorMessage ());
+  *size = std::min (*size, m_fragmentEnd - m_current);
+  return &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
+}
+
+uint8_t const *
+Buffer::Iterator::GetReadRun (uint32_t *size)
+{
+  NS_LOG_FUNCTION (this << *size);
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current < m_dataEnd,
+                 GetReadErrorMessage ());
+  if (m_current < m_fragmentStart || m_current >= m_fragmentEnd)
+    {
+      SelectFragment ();
+    }
+  if (m_current < m_zeroStart)
+    {
+      *size = std::min (*size, m_zeroStart - m_current);
+      return &m_data[m_current + m_shift];
+    }
+  else if (m_current < m_zeroEnd)
+    {
+      *size = std::min (*size, m_zeroEnd - m_current);
+      return 0;
+    }
+  *size = std::min (*size, m_fragmentEnd - m_current);
+  return &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
+}
+
 
 void 
 Buffer::Iterator::Write (Iterator start, Iterator end)
 {
   NS_LOG_FUNCTION (this << &start << &end);
-  NS_ASSERT (start.m_data == end.m_data);
+  NS_ASSERT (start.m_fragments == end.m_fragments);
+  NS_ASSERT (start.m_fragments != 0 || start.m_data == end.m_data);
   NS_ASSERT (start.m_current <= end.m_current);
-  NS_ASSERT (start.m_zeroStart == end.m_zeroStart);
-  NS_ASSERT (start.m_zeroEnd == end.m_zeroEnd);
-  NS_ASSERT (m_data != start.m_data);
+  NS_ASSERT (m_fragments != 0 || start.m_fragments != 0 || m_data != start.m_data);
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
-  if (start.m_current <= start.m_zeroStart)
-    {
-      uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
-      start.m_current += toCopy;
-      m_current += toCopy;
-      size -= toCopy;
-    }
-  if (start.m_current <= start.m_zeroEnd)
+  while (size > 0)
     {
-      uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      // copy the longest run which is contiguous in both buffers
+      uint32_t toCopy = size;
+      uint8_t const *from = start.GetReadRun (&toCopy);
+      uint8_t *to = GetWriteRun (&toCopy);
+      if (from != 0)
+        {
+          memcpy (to, from, toCopy);
+        }
+      else
+        {
+          memset (to, 0, toCopy);
+        }
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
     }
-  uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
-  uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
-  memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
@@ -953,19 +1262,17 @@ void
 Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
-  NS_ASSERT_MSG (CheckNoZero (m_current, size),
+  NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
-  uint8_t *to;
-  if (m_current <= m_zeroStart)
-    {
-      to = &m_data[m_current];
-    }
-  else
+  while (size > 0)
     {
-      to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      uint32_t toCopy = size;
+      uint8_t *to = GetWriteRun (&toCopy);
+      memcpy (to, buffer, toCopy);
+      buffer += toCopy;
+      m_current += toCopy;
+      size -= toCopy;
     }
-  memcpy (to, buffer, size);
-  m_current += size;
 }
 
 uint32_t 
@@ -1123,9 +1430,21 @@ void
 Buffer::Iterator::Read (uint8_t *buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
-  for (uint32_t i = 0; i < size; i++)
+  while (size > 0)
     {
-      buffer[i] = ReadU8 ();
+      uint32_t toCopy = size;
+      uint8_t const *from = GetReadRun (&toCopy);
+      if (from != 0)
+        {
+          memcpy (buffer, from, toCopy);
+        }
+      else
+        {
+          memset (buffer, 0, toCopy);
+        }
+      buffer += toCopy;
+      m_current += toCopy;
+      size -= toCopy;
     }
 }
 
@@ -1203,7 +1522,6 @@ Buffer::Iterator::GetWriteErrorMessage (void) const
     }
   else
     {
-      NS_ASSERT (m_current >= m_zeroStart && m_current < m_zeroEnd);
       str = "You have attempted to write inside the payload area of the "
         "buffer. This usually indicates that your Serialize method uses more "
         "buffer space than what your GetSerialized method returned.";
@@ -88,9 +88,25 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * Appending a Buffer to another one with AddAtEnd (Buffer const &)
+ * does not copy any byte: the result is made of fragments, each of
+ * them being a contiguous Buffer as described above which shares its
+ * BufferData with the original Buffer, so the virtual zero areas of
+ * both buffers stay virtual. The fragment list itself is shared
+ * between copies of a Buffer, and copied on write. When a Buffer is
+ * made of several fragments, m_data is null and the offsets are
+ * counted from the start of the first fragment. Adding data at the
+ * start (resp. the end) of a fragmented buffer follows the rules above
+ * on the first (resp. last) fragment; removing data drops or trims the
+ * fragments, and a Buffer left with a single fragment becomes
+ * contiguous again.
  */
 class Buffer 
 {
+private:
+  struct Fragments;
+
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -418,6 +434,32 @@ private:
      * \returns true if not in the "virtual zero area".
      */
     bool Check (uint32_t i) const;
+    /**
+     * \brief Update the cached fragment to the one holding the current
+     * position.
+     *
+     * This does nothing for contiguous buffers.
+     */
+    void SelectFragment (void);
+    /**
+     * \brief Get the bytes which can be written contiguously from the
+     * current position.
+     *
+     * \param [in,out] size the number of bytes to write, reduced to the
+     * number of bytes which can be written contiguously
+     * \returns a pointer to the bytes
+     */
+    uint8_t * GetWriteRun (uint32_t *size);
+    /**
+     * \brief Get the bytes which can be read contiguously from the
+     * current position.
+     *
+     * \param [in,out] size the number of bytes to read, reduced to the
+     * number of bytes which can be read contiguously
+     * \returns a pointer to the bytes, or zero if they are in a
+     * "virtual zero area"
+     */
+    uint8_t const * GetReadRun (uint32_t *size);
     /**
      * \return the two bytes read in the buffer.
      *
@@ -454,14 +496,29 @@ private:
 
     /**
      * offset in virtual bytes from the start of the data buffer to the
-     * start of the "virtual zero area".
+     * start of the "virtual zero area" of the current fragment.
      */
     uint32_t m_zeroStart;
     /**
      * offset in virtual bytes from the start of the data buffer to the
-     * end of the "virtual zero area".
+     * end of the "virtual zero area" of the current fragment.
      */
     uint32_t m_zeroEnd;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * start of the current fragment.
+     */
+    uint32_t m_fragmentStart;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * end of the current fragment.
+     */
+    uint32_t m_fragmentEnd;
+    /**
+     * difference, modulo 2^32, between the offsets in the byte buffer
+     * of the current fragment and the offsets in virtual bytes.
+     */
+    uint32_t m_shift;
     /**
      * offset in virtual bytes from the start of the data buffer to the
      * start of the data which can be read by this iterator
@@ -478,10 +535,14 @@ private:
      */
     uint32_t m_current;
     /**
-     * a pointer to the underlying byte buffer. All offsets are relative
-     * to this pointer.
+     * a pointer to the underlying byte buffer of the current fragment.
+     * All offsets, once shifted, are relative to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the fragments of the buffer, or zero if it is contiguous.
+     */
+    const Buffer::Fragments *m_fragments;
   };
 
   /**
@@ -697,6 +758,26 @@ private:
    * \brief Transform a "Virtual byte buffer" into a "Real byte buffer"
    */
   void TransformIntoRealBuffer (void) const;
+  /**
+   * \brief Turn a contiguous buffer into a buffer made of a single
+   * fragment, to append other fragments to it.
+   */
+  void CreateFragments (void);
+  /**
+   * \brief Make sure that the fragment list is not shared with other
+   * buffers, before modifying it.
+   */
+  void UnshareFragments (void);
+  /**
+   * \brief Update the fragment offsets and the buffer size after a
+   * change of the fragments, and make the buffer contiguous if a single
+   * fragment is left.
+   */
+  void UpdateFragments (void);
+  /**
+   * \brief Release a reference to the storage of the buffer.
+   */
+  void Unref (void);
   /**
    * \brief Checks the internal buffer structures consistency
    *
@@ -749,7 +830,7 @@ private:
    */
   static void Deallocate (struct Buffer::Data *data);
 
-  struct Data *m_data; //!< the buffer data storage
+  struct Data *m_data; //!< the buffer data storage, zero if fragmented
 
   /**
    * keep track of the maximum value of m_zeroAreaStart across
@@ -765,9 +846,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value.  Per thread, as the free lists below.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -789,6 +870,10 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
+  /**
+   * the fragments of this Buffer, or zero if it is contiguous.
+   */
+  struct Fragments *m_fragments;
 
 #ifdef BUFFER_FREE_LIST
   /// Container for buffer data
@@ -798,12 +883,29 @@ private:
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  // per thread, for the partitions of a MultithreadedSimulatorImpl
+  static thread_local uint32_t g_maxSize; //!< Max observed data size
+  static thread_local FreeList *g_freeList; //!< Buffer data container
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
+/**
+ * \brief The fragments of a Buffer which is not contiguous.
+ *
+ * The fragments are shared by the copies of a Buffer, and copied
+ * before being modified if they are shared.
+ */
+struct Buffer::Fragments
+{
+  /** The number of Buffer instances which reference this list. */
+  uint32_t m_count;
+  /** The fragments, which are contiguous and not empty. */
+  std::vector<Buffer> m_buffers;
+  /** The offset of each fragment from the start of the Buffer. */
+  std::vector<uint32_t> m_offsets;
+};
+
 } // namespace ns3
 
 #include "ns3/assert.h"
@@ -814,10 +916,14 @@ namespace ns3 {
 Buffer::Iterator::Iterator ()
   : m_zeroStart (0),
     m_zeroEnd (0),
+    m_fragmentStart (0),
+    m_fragmentEnd (0),
+    m_shift (0),
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_fragments (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -834,11 +940,33 @@ Buffer::Iterator::Iterator (Buffer const*buffer, bool dummy)
 void
 Buffer::Iterator::Construct (const Buffer *buffer)
 {
-  m_zeroStart = buffer->m_zeroAreaStart;
-  m_zeroEnd = buffer->m_zeroAreaEnd;
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
-  m_data = buffer->m_data->m_data;
+  m_fragments = buffer->m_fragments;
+  m_shift = 0;
+  if (m_fragments == 0)
+    {
+      // a contiguous buffer is its own single fragment
+      m_fragmentStart = m_dataStart;
+      m_fragmentEnd = m_dataEnd;
+      m_zeroStart = buffer->m_zeroAreaStart;
+      m_zeroEnd = buffer->m_zeroAreaEnd;
+      if (m_zeroStart == m_zeroEnd)
+        {
+          m_zeroStart = m_fragmentEnd;
+          m_zeroEnd = m_fragmentEnd;
+        }
+      m_data = buffer->m_data->m_data;
+    }
+  else
+    {
+      // the fragment is selected on first access
+      m_fragmentStart = 0;
+      m_fragmentEnd = 0;
+      m_zeroStart = 0;
+      m_zeroEnd = 0;
+      m_data = 0;
+    }
 }
 
 void 
@@ -871,14 +999,18 @@ Buffer::Iterator::WriteU8 (uint8_t data)
   NS_ASSERT_MSG (Check (m_current),
                  GetWriteErrorMessage ());
 
+  if (m_current < m_fragmentStart || m_current >= m_fragmentEnd)
+    {
+      SelectFragment ();
+    }
   if (m_current < m_zeroStart)
     {
-      m_data[m_current] = data;
+      m_data[m_current + m_shift] = data;
       m_current++;
     }
   else
     {
-      m_data[m_current - (m_zeroEnd-m_zeroStart)] = data;
+      m_data[m_current + m_shift - (m_zeroEnd-m_zeroStart)] = data;
       m_current++;
     }
 }
@@ -888,17 +1020,29 @@ Buffer::Iterator::WriteU8 (uint8_t  data, uint32_t len)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + len),
                  GetWriteErrorMessage ());
-  if (m_current <= m_zeroStart)
+  if (m_current >= m_fragmentStart && m_current + len <= m_zeroStart)
     {
-      std::memset (&(m_data[m_current]), data, len);
+      std::memset (&(m_data[m_current + m_shift]), data, len);
       m_current += len;
     }
-  else
+  else if (m_current >= m_zeroEnd && m_current + len <= m_fragmentEnd)
     {
-      uint8_t *buffer = &m_data[m_current - (m_zeroEnd-m_zeroStart)];
+      uint8_t *buffer = &m_data[m_current + m_shift - (m_zeroEnd-m_zeroStart)];
       std::memset (buffer, data, len);
       m_current += len;
     }
+  else
+    {
+      // the bytes span several fragments
+      while (len > 0)
+        {
+          uint32_t size = len;
+          uint8_t *buffer = GetWriteRun (&size);
+          std::memset (buffer, data, size);
+          m_current += size;
+          len -= size;
+        }
+    }
 }
 
 void 
@@ -907,13 +1051,20 @@ Buffer::Iterator::WriteHtonU16 (uint16_t data)
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 2),
                  GetWriteErrorMessage ());
   uint8_t *buffer;
-  if (m_current + 2 <= m_zeroStart)
+  if (m_current >= m_fragmentStart && m_current + 2 <= m_zeroStart)
+    {
+      buffer = &m_data[m_current + m_shift];
+    }
+  else if (m_current >= m_zeroEnd && m_current + 2 <= m_fragmentEnd)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      // the bytes span several fragments
+      uint8_t bytes[2] = { (uint8_t)(data >> 8), (uint8_t)data };
+      Write (bytes, 2);
+      return;
     }
   buffer[0] = (data >> 8)& 0xff;
   buffer[1] = (data >> 0)& 0xff;
@@ -925,15 +1076,22 @@ Buffer::Iterator::WriteHtonU32 (uint32_t data)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 4),
                  GetWriteErrorMessage ());
-
   uint8_t *buffer;
-  if (m_current + 4 <= m_zeroStart)
+  if (m_current >= m_fragmentStart && m_current + 4 <= m_zeroStart)
+    {
+      buffer = &m_data[m_current + m_shift];
+    }
+  else if (m_current >= m_zeroEnd && m_current + 4 <= m_fragmentEnd)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      // the bytes span several fragments
+      uint8_t bytes[4] = { (uint8_t)(data >> 24), (uint8_t)(data >> 16),
+                           (uint8_t)(data >> 8), (uint8_t)data };
+      Write (bytes, 4);
+      return;
     }
   buffer[0] = (data >> 24)& 0xff;
   buffer[1] = (data >> 16)& 0xff;
@@ -946,13 +1104,13 @@ uint16_t
 Buffer::Iterator::ReadNtohU16 (void)
 {
   uint8_t *buffer;
-  if (m_current + 2 <= m_zeroStart)
+  if (m_current >= m_fragmentStart && m_current + 2 <= m_zeroStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current + m_shift];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 2 <= m_fragmentEnd)
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
@@ -970,13 +1128,13 @@ uint32_t
 Buffer::Iterator::ReadNtohU32 (void)
 {
   uint8_t *buffer;
-  if (m_current + 4 <= m_zeroStart)
+  if (m_current >= m_fragmentStart && m_current + 4 <= m_zeroStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current + m_shift];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 4 <= m_fragmentEnd)
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current + m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
@@ -1001,9 +1159,13 @@ Buffer::Iterator::PeekU8 (void)
                  m_current < m_dataEnd,
                  GetReadErrorMessage ());
 
+  if (m_current < m_fragmentStart || m_current >= m_fragmentEnd)
+    {
+      SelectFragment ();
+    }
   if (m_current < m_zeroStart)
     {
-      uint8_t data = m_data[m_current];
+      uint8_t data = m_data[m_current + m_shift];
       return data;
     }
   else if (m_current < m_zeroEnd)
@@ -1012,7 +1174,7 @@ Buffer::Iterator::PeekU8 (void)
     }
   else
     {
-      uint8_t data = m_data[m_current - (m_zeroEnd-m_zeroStart)];
+      uint8_t data = m_data[m_current + m_shift - (m_zeroEnd-m_zeroStart)];
       return data;
     }
 }
@@ -1053,9 +1215,17 @@ Buffer::Buffer (Buffer const&o)
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
     m_start (o.m_start),
-    m_end (o.m_end)
+    m_end (o.m_end),
+    m_fragments (o.m_fragments)
 {
-  m_data->m_count++;
+  if (m_fragments == 0)
+    {
+      m_data->m_count++;
+    }
+  else
+    {
+      m_fragments->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
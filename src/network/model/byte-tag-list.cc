@@ -31,6 +31,8 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("ByteTagList");
 
+const uint32_t ByteTagList::INLINE_SIZE;
+
 /**
  * \ingroup packet
  *
@@ -53,12 +55,17 @@ struct ByteTagListData {
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static thread_local class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+} g_freeList; //!< Container for struct ByteTagListData, per thread
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+/**
+ * The free list of the thread was destroyed: the packets which outlive
+ * it, e.g., those held by static objects, are deallocated directly.
+ */
+static thread_local bool g_freeListDestroyed = false;
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -69,6 +76,7 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
+  g_freeListDestroyed = true;
 }
 #endif /* USE_FREE_LIST */
 
@@ -159,6 +167,10 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -178,6 +190,10 @@ ByteTagList::operator = (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -194,21 +210,30 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   NS_LOG_FUNCTION (this << tid << bufferSize << start << end);
   uint32_t spaceNeeded = m_used + bufferSize + 4 + 4 + 4 + 4;
   NS_ASSERT (m_used <= spaceNeeded);
-  if (m_data == 0)
+  uint8_t *data;
+  if (m_data == 0 && spaceNeeded <= INLINE_SIZE)
     {
-      m_data = Allocate (spaceNeeded);
-      m_used = 0;
-    } 
-  else if (m_data->size < spaceNeeded ||
-           (m_data->count != 1 && m_data->dirty != m_used))
+      data = m_inline;
+    }
+  else
     {
-      struct ByteTagListData *newData = Allocate (spaceNeeded);
-      std::memcpy (&newData->data, &m_data->data, m_used);
-      Deallocate (m_data);
-      m_data = newData;
+      if (m_data == 0)
+        {
+          m_data = Allocate (spaceNeeded);
+          std::memcpy (&m_data->data, m_inline, m_used);
+        }
+      else if (m_data->size < spaceNeeded ||
+               (m_data->count != 1 && m_data->dirty != m_used))
+        {
+          struct ByteTagListData *newData = Allocate (spaceNeeded);
+          std::memcpy (&newData->data, &m_data->data, m_used);
+          Deallocate (m_data);
+          m_data = newData;
+        }
+      m_data->dirty = spaceNeeded;
+      data = m_data->data;
     }
-  TagBuffer tag = TagBuffer (&m_data->data[m_used], 
-                             &m_data->data[spaceNeeded]);
+  TagBuffer tag = TagBuffer (&data[m_used], &data[spaceNeeded]);
   tag.WriteU32 (tid.GetUid ());
   tag.WriteU32 (bufferSize);
   tag.WriteU32 (start - m_adjustment);
@@ -222,7 +247,6 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_maxEnd = end - m_adjustment;
     }
   m_used = spaceNeeded;
-  m_data->dirty = m_used;
   return tag;
 }
 
@@ -264,14 +288,12 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
+  if (m_used == 0)
     {
       return Iterator (0, 0, offsetStart, offsetEnd, 0);
     }
-  else
-    {
-      return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd, m_adjustment);
-    }
+  uint8_t *data = m_data != 0 ? m_data->data : const_cast<uint8_t *> (m_inline);
+  return Iterator (data, &data[m_used], offsetStart, offsetEnd, m_adjustment);
 }
 
 void 
@@ -345,7 +367,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!g_freeListDestroyed && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -379,7 +401,8 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_freeListDestroyed ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
@@ -49,6 +49,11 @@ struct ByteTagListData;
  *     is shared and, thus, reference-counted. This data structure is unshared
  *     as-needed to emulate COW semantics.
  *
+ *   - As long as the tags fit in INLINE_SIZE bytes, the byte buffer is
+ *     stored inside the ByteTagList and copied with it, which saves the
+ *     allocation of a ByteTagListData for the common case of a packet
+ *     with one or two small byte tags.
+ *
  *   - Each tag tags a unique set of bytes identified by the pair of offsets
  *     (start,end). These offsets are relative to the start of the packet
  *     Whenever the origin of the offset changes, the Packet adjusts all
@@ -252,11 +257,15 @@ private:
    */
   void Deallocate (struct ByteTagListData *data);
 
+  /** Size of the byte buffer stored inside the list. */
+  static const uint32_t INLINE_SIZE = 48;
+
   int32_t m_minStart; //!< minimal start offset
   int32_t m_maxEnd; //!< maximal end offset
   int32_t m_adjustment; //!< adjustment to byte tag offsets
   uint32_t m_used; //!< the number of used bytes in the buffer
-  struct ByteTagListData *m_data; //!< the ByteTagListData structure
+  struct ByteTagListData *m_data; //!< the ByteTagListData structure, or zero if the buffer is m_inline
+  uint8_t m_inline[INLINE_SIZE]; //!< the byte buffer, when the tags are small enough
 };
 
 void
@@ -21,6 +21,7 @@
 #include "net-device.h"
 
 #include "ns3/log.h"
+#include "ns3/object-vector.h"
 #include "ns3/uinteger.h"
 
 namespace ns3 {
@@ -39,7 +40,12 @@ Channel::GetTypeId (void)
                    TypeId::ATTR_GET,
                    UintegerValue (0),
                    MakeUintegerAccessor (&Channel::m_id),
-                   MakeUintegerChecker<uint32_t> ());
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DeviceList", "The list of devices connected to this Channel.",
+                   TypeId::ATTR_GET,
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&Channel::GetNDevices, &Channel::GetDevice),
+                   MakeObjectVectorChecker<NetDevice> ());
   return tid;
 }
 
@@ -41,4 +41,22 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+bool
+NetDevice::SupportsSegmentationOffload (uint32_t size) const
+{
+  return false;
+}
+
+DataRate
+NetDevice::GetFluidCapacity (void) const
+{
+  return DataRate (0);
+}
+
+void
+NetDevice::SetFluidLoad (DataRate rate, double queueFill)
+{
+  NS_LOG_FUNCTION (this << rate << queueFill);
+}
+
 } // namespace ns3
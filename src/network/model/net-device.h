@@ -29,6 +29,7 @@
 #include "address.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/data-rate.h"
 
 namespace ns3 {
 
@@ -359,6 +360,50 @@ public:
    */
   virtual bool SupportsSendFrom (void) const = 0;
 
+  /**
+   * \brief Check whether the device can take a TCP super-segment as a whole
+   *
+   * A device which supports segmentation offload accepts packets
+   * larger than its MTU when they carry a TsoTag, and transmits them as
+   * a burst of segments (see TsoTag).  It only takes a super-segment
+   * when its queue has room for all of its segments, so that a queue
+   * overflow drops the same segments as without segmentation offload;
+   * otherwise the IP layer splits the super-segment into segments.  The
+   * default implementation returns false.
+   *
+   * \param size the bytes of all the segments of the super-segment,
+   *             IP and TCP headers included
+   * \return true if this interface takes the super-segment, false otherwise.
+   */
+  virtual bool SupportsSegmentationOffload (uint32_t size) const;
+
+  /**
+   * \brief Get the capacity of the transmitter available to fluid flows
+   *
+   * Fluid flows are background flows modeled as rates rather than as
+   * packets (see FluidBulkSendApplication).  A device which can carry
+   * them returns the rate of its transmitter.  The default
+   * implementation returns a null rate, i.e., the device cannot carry
+   * fluid flows.
+   *
+   * \return the capacity of the transmitter
+   */
+  virtual DataRate GetFluidCapacity (void) const;
+
+  /**
+   * \brief Set the load of the fluid flows on the transmitter
+   *
+   * The packets sent by the device share the transmitter with the
+   * fluid flows, and wait behind the standing queue they keep, whose
+   * size is a fixed fraction of the transmit queue.  The default
+   * implementation does nothing.
+   *
+   * \param rate the aggregate rate of the fluid flows
+   * \param queueFill the fraction of the transmit queue occupied by
+   *        the fluid flows, between 0 and 1
+   */
+  virtual void SetFluidLoad (DataRate rate, double queueFill);
+
 };
 
 } // namespace ns3
@@ -33,10 +33,14 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+bool PacketMetadata::m_enableLazy = false;
+std::atomic<uint64_t> PacketMetadata::m_logSeq (0);
+thread_local bool PacketMetadata::m_metadataSkipped = false;
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
+thread_local uint16_t PacketMetadata::m_chunkUid = 0;
+thread_local PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+thread_local PacketMetadata::LogFreeList PacketMetadata::m_logFreeList;
+thread_local bool PacketMetadata::m_freeListsDestroyed = false;
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -45,7 +49,17 @@ PacketMetadata::DataFreeList::~DataFreeList ()
     {
       PacketMetadata::Deallocate (*i);
     }
-  PacketMetadata::m_enable = false;
+  PacketMetadata::m_freeListsDestroyed = true;
+}
+
+PacketMetadata::LogFreeList::~LogFreeList ()
+{
+  NS_LOG_FUNCTION (this);
+  for (iterator i = begin (); i != end (); i++)
+    {
+      delete *i;
+    }
+  PacketMetadata::m_freeListsDestroyed = true;
 }
 
 void 
@@ -68,6 +82,35 @@ PacketMetadata::EnableChecking (void)
   NS_LOG_FUNCTION_NOARGS ();
   Enable ();
   m_enableChecking = true;
+  m_enableLazy = false;
+}
+
+void
+PacketMetadata::EnableLazy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Enable ();
+  m_enableLazy = !m_enableChecking;
+}
+
+void
+PacketMetadata::DisableLazy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enableLazy = false;
+}
+
+PacketMetadata::PacketMetadata ()
+  : m_data (PacketMetadata::Create (10)),
+    m_head (0xffff),
+    m_tail (0xffff),
+    m_used (0),
+    m_packetUid (0),
+    m_log (0),
+    m_logSize (0)
+{
+  NS_LOG_FUNCTION (this);
+  memset (m_data->m_data, 0xff, 4);
 }
 
 void
@@ -133,6 +176,11 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      // lazy metadata whose items were not reconstructed
+      return m_log != 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -504,7 +552,8 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
    */
 
   // create a copy of the packet without its tail.
-  PacketMetadata h (m_packetUid, 0);
+  PacketMetadata h;
+  h.m_packetUid = m_packetUid;
   uint16_t current = m_head;
   while (current != 0xffff && current != m_tail)
     {
@@ -575,7 +624,7 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (!m_freeListsDestroyed && !m_freeList.empty ())
     {
       struct PacketMetadata::Data *data = m_freeList.back ();
       m_freeList.pop_back ();
@@ -596,11 +645,11 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  if (!m_enable || m_freeListsDestroyed)
     {
       PacketMetadata::Deallocate (data);
       return;
-    } 
+    }
   NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
   if (m_freeList.size () > 1000 ||
@@ -640,6 +689,227 @@ PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 }
 
 
+struct PacketMetadata::Log *
+PacketMetadata::AllocateLog (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  struct PacketMetadata::Log *log;
+  if (m_freeListsDestroyed || m_logFreeList.empty ())
+    {
+      log = new struct PacketMetadata::Log;
+    }
+  else
+    {
+      // the recycled log keeps the capacity of its arrays
+      log = m_logFreeList.back ();
+      m_logFreeList.pop_back ();
+    }
+  log->m_count = 1;
+  log->m_seq = m_logSeq.fetch_add (1, std::memory_order_relaxed);
+  log->m_parent = 0;
+  log->m_parentSize = 0;
+  return log;
+}
+
+void
+PacketMetadata::CreateLog (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_log = PacketMetadata::AllocateLog ();
+  m_log->m_packetUid = m_packetUid;
+  m_logSize = 0;
+  if (size > 0)
+    {
+      Record (LOG_ADD_HEADER, 0, size, m_chunkUid);
+      m_chunkUid++;
+    }
+}
+
+void
+PacketMetadata::ForkLog (void)
+{
+  NS_LOG_FUNCTION (this);
+  struct PacketMetadata::Log *log = PacketMetadata::AllocateLog ();
+  log->m_packetUid = m_log->m_packetUid;
+  // our reference to the current log is transferred to the new one
+  log->m_parent = m_log;
+  log->m_parentSize = m_logSize;
+  m_log = log;
+  m_logSize = 0;
+}
+
+void
+PacketMetadata::PrepareLog (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0)
+    {
+      // the reconstructed items are obsolete
+      m_data->m_count--;
+      if (m_data->m_count == 0)
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+      m_data = 0;
+      m_head = 0xffff;
+      m_tail = 0xffff;
+      m_used = 0;
+    }
+  if (m_logSize != m_log->m_entries.size ())
+    {
+      // another metadata recorded other operations after ours
+      ForkLog ();
+    }
+}
+
+void
+PacketMetadata::Record (enum LogOp op, uint32_t value, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << op << value << size << chunkUid);
+  PrepareLog ();
+  struct PacketMetadata::LogEntry entry;
+  entry.value = value;
+  entry.size = size;
+  entry.chunkUid = chunkUid;
+  entry.op = op;
+  m_log->m_entries.push_back (entry);
+  m_logSize++;
+}
+
+bool
+PacketMetadata::CancelLast (enum LogOp op, uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << op << uid << size);
+  if (m_logSize == 0 || m_log->m_count != 1 ||
+      m_logSize != m_log->m_entries.size ())
+    {
+      return false;
+    }
+  const struct PacketMetadata::LogEntry &last = m_log->m_entries.back ();
+  if (last.op != op || last.value != uid || last.size != size)
+    {
+      return false;
+    }
+  PrepareLog ();
+  m_log->m_entries.pop_back ();
+  m_logSize--;
+  return true;
+}
+
+void
+PacketMetadata::Materialize (void) const
+{
+  if (m_data != 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_log != 0);
+  PacketMetadata metadata = Replay (m_log, m_logSize);
+  // the items are cached until the next operation, which does not
+  // change the logical value of this metadata
+  PacketMetadata *self = const_cast<PacketMetadata *> (this);
+  self->m_data = metadata.m_data;
+  self->m_data->m_count++;
+  self->m_head = metadata.m_head;
+  self->m_tail = metadata.m_tail;
+  self->m_used = metadata.m_used;
+}
+
+void
+PacketMetadata::DropLog (void)
+{
+  NS_LOG_FUNCTION (this);
+  Materialize ();
+  PacketMetadata::ReleaseLog (m_log);
+  m_log = 0;
+  m_logSize = 0;
+}
+
+PacketMetadata
+PacketMetadata::Replay (const struct PacketMetadata::Log *log, uint32_t size)
+{
+  NS_LOG_FUNCTION (log << size);
+  std::vector<std::pair<const struct PacketMetadata::Log *, uint32_t> > chain;
+  while (log != 0)
+    {
+      chain.push_back (std::make_pair (log, size));
+      size = log->m_parentSize;
+      log = log->m_parent;
+    }
+  PacketMetadata metadata;
+  metadata.m_packetUid = chain.back ().first->m_packetUid;
+  for (std::vector<std::pair<const struct PacketMetadata::Log *, uint32_t> >::reverse_iterator i = chain.rbegin ();
+       i != chain.rend (); ++i)
+    {
+      for (uint32_t j = 0; j < i->second; j++)
+        {
+          const struct PacketMetadata::LogEntry &entry = i->first->m_entries[j];
+          switch (entry.op)
+            {
+            case LOG_ADD_HEADER:
+              metadata.InsertItem (entry.value, entry.size, entry.chunkUid, true);
+              break;
+            case LOG_ADD_TRAILER:
+              metadata.InsertItem (entry.value, entry.size, entry.chunkUid, false);
+              break;
+            case LOG_REMOVE_HEADER:
+              metadata.DoRemoveHeader (entry.value, entry.size);
+              break;
+            case LOG_REMOVE_TRAILER:
+              metadata.DoRemoveTrailer (entry.value, entry.size);
+              break;
+            case LOG_REMOVE_AT_START:
+              metadata.RemoveAtStart (entry.size);
+              break;
+            case LOG_REMOVE_AT_END:
+              metadata.RemoveAtEnd (entry.size);
+              break;
+            case LOG_ADD_AT_END:
+              metadata.AddAtEnd (Replay (i->first->m_appended[entry.value], entry.size));
+              break;
+            default:
+              NS_ASSERT (false);
+              break;
+            }
+        }
+    }
+  return metadata;
+}
+
+void
+PacketMetadata::ReleaseLog (struct PacketMetadata::Log *log)
+{
+  NS_LOG_FUNCTION (log);
+  // release the parents iteratively, the chains can be long
+  while (log != 0)
+    {
+      NS_ASSERT (log->m_count > 0);
+      log->m_count--;
+      if (log->m_count > 0)
+        {
+          return;
+        }
+      for (std::vector<struct PacketMetadata::Log *>::const_iterator i = log->m_appended.begin ();
+           i != log->m_appended.end (); ++i)
+        {
+          PacketMetadata::ReleaseLog (*i);
+        }
+      struct PacketMetadata::Log *parent = log->m_parent;
+      if (!m_enable || m_freeListsDestroyed || m_logFreeList.size () > 1000)
+        {
+          delete log;
+        }
+      else
+        {
+          log->m_entries.clear ();
+          log->m_appended.clear ();
+          m_logFreeList.push_back (log);
+        }
+      log = parent;
+    }
+}
+
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 {
@@ -668,16 +938,34 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-
+  uint16_t chunkUid = m_chunkUid;
+  m_chunkUid++;
+  if (m_log != 0)
+    {
+      Record (LOG_ADD_HEADER, uid, size, chunkUid);
+      return;
+    }
+  InsertItem (uid, size, chunkUid, true);
+}
+void
+PacketMetadata::InsertItem (uint32_t uid, uint32_t size, uint16_t chunkUid, bool atHead)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid << atHead);
   struct PacketMetadata::SmallItem item;
-  item.next = m_head;
-  item.prev = 0xffff;
+  item.next = atHead ? m_head : 0xffff;
+  item.prev = atHead ? 0xffff : m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
-  UpdateHead (written);
+  if (atHead)
+    {
+      UpdateHead (written);
+    }
+  else
+    {
+      UpdateTail (written);
+    }
 }
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
@@ -690,6 +978,20 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_log != 0)
+    {
+      if (!CancelLast (LOG_ADD_HEADER, uid, size))
+        {
+          Record (LOG_REMOVE_HEADER, uid, size, 0);
+        }
+      return;
+    }
+  DoRemoveHeader (uid, size);
+}
+void
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -738,15 +1040,14 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-  struct PacketMetadata::SmallItem item;
-  item.next = 0xffff;
-  item.prev = m_tail;
-  item.typeUid = uid;
-  item.size = size;
-  item.chunkUid = m_chunkUid;
+  uint16_t chunkUid = m_chunkUid;
   m_chunkUid++;
-  uint16_t written = AddSmall (&item);
-  UpdateTail (written);
+  if (m_log != 0)
+    {
+      Record (LOG_ADD_TRAILER, uid, size, chunkUid);
+      return;
+    }
+  InsertItem (uid, size, chunkUid, false);
   NS_ASSERT (IsStateOk ());
 }
 void 
@@ -760,6 +1061,20 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_log != 0)
+    {
+      if (!CancelLast (LOG_ADD_TRAILER, uid, size))
+        {
+          Record (LOG_REMOVE_TRAILER, uid, size, 0);
+        }
+      return;
+    }
+  DoRemoveTrailer (uid, size);
+}
+void
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -807,6 +1122,43 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  if (m_log != 0 && o.m_log != 0)
+    {
+      if (o.m_logSize == 0 && o.m_log->m_parent == 0)
+        {
+          // nothing to append.
+          return;
+        }
+      if (m_logSize == 0 && m_log->m_parent == 0)
+        {
+          // nothing recorded yet, like an empty item list.
+          *this = o;
+          return;
+        }
+      // take the reference first, o may be this.
+      struct PacketMetadata::Log *appended = o.m_log;
+      uint32_t appendedSize = o.m_logSize;
+      appended->m_count++;
+      PrepareLog ();
+      if (appended->m_seq >= m_log->m_seq)
+        {
+          ForkLog ();
+        }
+      struct PacketMetadata::LogEntry entry;
+      entry.value = m_log->m_appended.size ();
+      entry.size = appendedSize;
+      entry.chunkUid = 0;
+      entry.op = LOG_ADD_AT_END;
+      m_log->m_appended.push_back (appended);
+      m_log->m_entries.push_back (entry);
+      m_logSize++;
+      return;
+    }
+  if (m_log != 0)
+    {
+      DropLog ();
+    }
+  o.Materialize ();
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -895,6 +1247,14 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
+  if (m_log != 0)
+    {
+      if (start > 0)
+        {
+          Record (LOG_REMOVE_AT_START, 0, start, 0);
+        }
+      return;
+    }
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -921,7 +1281,8 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment;
+          fragment.m_packetUid = m_packetUid;
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -958,6 +1319,14 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
+  if (m_log != 0)
+    {
+      if (end > 0)
+        {
+          Record (LOG_REMOVE_AT_END, 0, end, 0);
+        }
+      return;
+    }
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -985,7 +1354,8 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment;
+          fragment.m_packetUid = m_packetUid;
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1046,6 +1416,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1145,6 +1516,7 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1179,6 +1551,7 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
   uint8_t* start = buffer;
+  Materialize ();
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
   if (buffer == 0) 
@@ -1279,6 +1652,10 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_log != 0)
+    {
+      *this = PacketMetadata ();
+    }
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
@@ -21,6 +21,7 @@
 #define PACKET_METADATA_H
 
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include <limits>
 #include "ns3/callback.h"
@@ -74,6 +75,15 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * When enabled with EnableLazy, the metadata is instead recorded as
+ * a log of the operations performed on the packet: a packet and its
+ * copies share the same log, which is forked only when two copies
+ * record different operations, in the same way as the item buffer
+ * is shared. The item list is reconstructed by replaying the log
+ * only when the items are iterated over or serialized, so that the
+ * metadata costs little more than a few bytes per operation for the
+ * packets which are never printed.
  */
 class PacketMetadata 
 {
@@ -158,8 +168,26 @@ private:
   static void Enable (void);
   /**
    * \brief Enable the packet metadata checking
+   *
+   * The checks are performed when the operations are applied, so this
+   * disables the lazy metadata.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata, recorded as an operation log
+   *
+   * The packets created after this call record their operations and
+   * reconstruct their items only when BeginItem is called.
+   */
+  static void EnableLazy (void);
+  /**
+   * \brief Record the metadata of the packets created after this call
+   * as an item list again.
+   *
+   * The packets which were created with a lazy metadata keep it, and
+   * can still be combined with the others.
+   */
+  static void DisableLazy (void);
 
   /**
    * \brief Constructor
@@ -504,9 +532,24 @@ public:
   };
 
   friend DataFreeList::~DataFreeList ();
+
+  struct Log;
+  /**
+   * \brief Class to hold the recycled logs
+   */
+  class LogFreeList : public std::vector<struct Log *>
+  {
+public:
+    ~LogFreeList ();
+  };
+
+  friend LogFreeList::~LogFreeList ();
   /// Friend class
   friend class ItemIterator;
 
+  /**
+   * \brief Create an empty item list, even if the metadata is lazy
+   */
   PacketMetadata ();
 
   /**
@@ -620,6 +663,26 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add an item at the head or at the tail of the item list
+   * \param uid the item uid
+   * \param size the item size
+   * \param chunkUid the item chunk uid
+   * \param atHead true to add a header, false to add a trailer
+   */
+  void InsertItem (uint32_t uid, uint32_t size, uint16_t chunkUid, bool atHead);
+  /**
+   * \brief Remove an header from the item list
+   * \param uid header's uid to remove
+   * \param size header serialized size
+   */
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove a trailer from the item list
+   * \param uid trailer's uid to remove
+   * \param size trailer serialized size
+   */
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -661,21 +724,145 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  /// Operations recorded in a Log
+  enum LogOp {
+    LOG_ADD_HEADER,      //!< InsertItem at head
+    LOG_ADD_TRAILER,     //!< InsertItem at tail
+    LOG_REMOVE_HEADER,   //!< DoRemoveHeader
+    LOG_REMOVE_TRAILER,  //!< DoRemoveTrailer
+    LOG_REMOVE_AT_START, //!< RemoveAtStart
+    LOG_REMOVE_AT_END,   //!< RemoveAtEnd
+    LOG_ADD_AT_END       //!< AddAtEnd
+  };
+
+  /**
+   * \brief An operation recorded in a Log
+   */
+  struct LogEntry {
+    /** the item uid, or the index of the appended log for LOG_ADD_AT_END */
+    uint32_t value;
+    /** the size of the item or of the removed area, or the size of
+       the appended log for LOG_ADD_AT_END */
+    uint32_t size;
+    /** the chunk uid of the added item */
+    uint16_t chunkUid;
+    /** the LogOp */
+    uint8_t op;
+  };
+
+  /**
+   * \brief A log of the operations performed on a packet.
+   *
+   * The operations of a PacketMetadata are the first m_logSize
+   * entries of its log, preceded by the first m_parentSize operations
+   * of the parent log, recursively. A log can be appended to by any
+   * of the PacketMetadata which use all of its entries; the others
+   * fork a new log. A log only references logs created before it,
+   * so that there is no reference cycle.
+   */
+  struct Log {
+    /** number of references to this log */
+    uint32_t m_count;
+    /** creation order, to avoid reference cycles */
+    uint64_t m_seq;
+    /** uid of the packet which created the first log of the chain */
+    uint64_t m_packetUid;
+    /** the log recording the operations performed before, or zero */
+    struct Log *m_parent;
+    /** the number of operations of the parent log which apply */
+    uint32_t m_parentSize;
+    /** the operations */
+    std::vector<struct LogEntry> m_entries;
+    /** the logs of the appended packets */
+    std::vector<struct Log *> m_appended;
+  };
+
+  /**
+   * \brief Get a log from the free list, or allocate one
+   * \returns an empty log with one reference
+   */
+  static struct Log * AllocateLog (void);
+  /**
+   * \brief Create a log for a new packet
+   * \param size the size of the initial payload
+   */
+  void CreateLog (uint32_t size);
+  /**
+   * \brief Start a new log, following the current one.
+   */
+  void ForkLog (void);
+  /**
+   * \brief Remove the last operation of the log if it added the item
+   * which is removed and if no other metadata uses it.
+   * \param op the operation which added the item
+   * \param uid the item uid
+   * \param size the item size
+   * \returns true if the operation was removed
+   */
+  bool CancelLast (enum LogOp op, uint32_t uid, uint32_t size);
+  /**
+   * \brief Get the log ready to record an operation: drop the
+   * reconstructed items and fork the log if needed.
+   */
+  void PrepareLog (void);
+  /**
+   * \brief Record an operation
+   * \param op the operation
+   * \param value the operation uid or index
+   * \param size the operation size
+   * \param chunkUid the operation chunk uid
+   */
+  void Record (enum LogOp op, uint32_t value, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Reconstruct the item list of a lazy metadata, if it is not
+   * already.
+   */
+  void Materialize (void) const;
+  /**
+   * \brief Turn a lazy metadata into an item list.
+   */
+  void DropLog (void);
+  /**
+   * \brief Reconstruct an item list
+   * \param log the log to replay
+   * \param size the number of operations of the log to replay
+   * \returns the metadata
+   */
+  static PacketMetadata Replay (const struct Log *log, uint32_t size);
+  /**
+   * \brief Release a reference to a log
+   * \param log the log, not zero
+   */
+  static void ReleaseLog (struct Log *log);
+
+  /*
+   * The free lists and the counters are per thread, so that the
+   * partitions of a MultithreadedSimulatorImpl can create packets
+   * concurrently.
+   */
+  static thread_local DataFreeList m_freeList; //!< the metadata data storage
+  static thread_local LogFreeList m_logFreeList; //!< the recycled logs
+  static thread_local bool m_freeListsDestroyed; //!< the free lists of the thread were destroyed
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_enableLazy; //!< Record the metadata as an operation log
+  static std::atomic<uint64_t> m_logSeq; //!< Sequence number of the next log
 
   /**
    * Set to true when adding metadata to a packet is skipped because
    * m_enable is false; used to detect enabling of metadata in the
    * middle of a simulation, which isn't allowed.
    */
-  static bool m_metadataSkipped;
+  static thread_local bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  static thread_local uint32_t m_maxSize; //!< maximum metadata size
+  static thread_local uint16_t m_chunkUid; //!< Chunk Uid
 
-  struct Data *m_data; //!< Metadata storage
+  /**
+   * Metadata storage; for a lazy metadata, zero until the items are
+   * reconstructed.
+   */
+  struct Data *m_data;
   /*
      head -(next)-> tail
        ^             |
@@ -685,6 +872,8 @@ public:
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
   uint64_t m_packetUid; //!< packet Uid
+  struct Log *m_log; //!< operation log, zero if the metadata is not lazy
+  uint32_t m_logSize; //!< number of entries of m_log in use
 };
 
 } // namespace ns3
@@ -692,12 +881,20 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_log (0),
+    m_logSize (0)
 {
+  if (m_enableLazy)
+    {
+      CreateLog (size);
+      return;
+    }
+  m_data = PacketMetadata::Create (10);
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
@@ -709,11 +906,20 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_log (o.m_log),
+    m_logSize (o.m_logSize)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  NS_ASSERT (m_data != 0 || m_log != 0);
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
+  if (m_log != 0)
+    {
+      m_log->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -721,29 +927,54 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
+    }
+  if (m_log != o.m_log)
+    {
+      if (o.m_log != 0)
+        {
+          o.m_log->m_count++;
+        }
+      if (m_log != 0)
+        {
+          PacketMetadata::ReleaseLog (m_log);
+        }
+      m_log = o.m_log;
     }
+  NS_ASSERT (m_data != 0 || m_log != 0);
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  m_logSize = o.m_logSize;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  NS_ASSERT (m_data != 0 || m_log != 0);
+  if (m_data != 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+    }
+  if (m_log != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      PacketMetadata::ReleaseLog (m_log);
     }
 }
 
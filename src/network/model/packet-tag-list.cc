@@ -34,6 +34,10 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+const uint32_t PacketTagList::INLINE_TAGS;
+const uint32_t PacketTagList::INLINE_TAG_SIZE;
+const uint32_t PacketTagList::INLINE_SLOT_WORDS;
+
 PacketTagList::TagData *
 PacketTagList::CreateTagData (size_t dataSize)
 {
@@ -51,6 +55,45 @@ PacketTagList::CreateTagData (size_t dataSize)
   return tag;
 }
 
+void
+PacketTagList::FreeTagData (struct TagData *tag)
+{
+  if (IsInline (tag))
+    {
+      uint32_t slot = (reinterpret_cast<uint64_t *> (tag) - &m_inline[0][0]) / INLINE_SLOT_WORDS;
+      m_inlineUsed &= ~(1 << slot);
+      tag->~TagData ();
+      return;
+    }
+  tag->~TagData ();
+  std::free (tag);
+}
+
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  NS_ASSERT (m_inlineUsed == 0);
+  m_inlineUsed = o.m_inlineUsed;
+  // the inline tags are at the head of the list
+  struct TagData **prevNext = &m_next;
+  const struct TagData *cur;
+  for (cur = o.m_next; cur != 0 && o.IsInline (cur); cur = cur->next)
+    {
+      uint32_t slot = (reinterpret_cast<const uint64_t *> (cur) - &o.m_inline[0][0]) / INLINE_SLOT_WORDS;
+      std::memcpy (m_inline[slot], o.m_inline[slot], sizeof (TagData) + cur->size - 1);
+      struct TagData *copy = reinterpret_cast<struct TagData *> (m_inline[slot]);
+      *prevNext = copy;
+      prevNext = &copy->next;
+    }
+  // join the tree after the inline tags
+  *prevNext = const_cast<struct TagData *> (cur);
+  if (cur != 0)
+    {
+      const_cast<struct TagData *> (cur)->count++;
+    }
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -194,8 +237,7 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
   if (preMerge)
     {
       // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      FreeTagData (cur);
     }
   else
     {
@@ -266,14 +308,37 @@ PacketTagList::Add (const Tag &tag) const
       NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
                      "Error: cannot add the same kind of tag twice.");
     }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  uint32_t size = tag.GetSerializedSize ();
+  struct TagData * head;
+  if (size <= INLINE_TAG_SIZE && m_inlineUsed != (1u << INLINE_TAGS) - 1)
+    {
+      uint32_t slot = 0;
+      while (m_inlineUsed & (1 << slot))
+        {
+          slot++;
+        }
+      self->m_inlineUsed |= 1 << slot;
+      head = new (self->m_inline[slot]) TagData;
+      head->size = size;
+      head->next = m_next;
+      self->m_next = head;
+    }
+  else
+    {
+      head = CreateTagData (size);
+      // keep the inline tags at the head of the list
+      struct TagData **prevNext = &self->m_next;
+      while (*prevNext != 0 && IsInline (*prevNext))
+        {
+          prevNext = &(*prevNext)->next;
+        }
+      head->next = *prevNext;
+      *prevNext = head;
+    }
   head->count = 1;
-  head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
   tag.Serialize (TagBuffer (head->data, head->data + head->size));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
 }
 
 bool
@@ -119,6 +119,18 @@ class Tag;
  *       The portion of the list between the first branch and the target is
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
+ *
+ * \par <b> Small tags </b>
+ *
+ *   - Most packets only carry a few small tags, so the first
+ *     INLINE_TAGS tags whose serialized size is at most
+ *     INLINE_TAG_SIZE bytes are stored in TagData structures inside
+ *     the PacketTagList itself, rather than allocated.
+ *
+ *   - These inline TagData are never shared: they are always at the
+ *     head of the list, before the allocated ones, and they are copied
+ *     by the copy constructor and the assignment, which then join the
+ *     tree after them.
  */
 class PacketTagList 
 {
@@ -156,8 +168,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This makes a light-weight copy by copying the inline tags, then
+   * pointing to the same allocated \ref TagData as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -166,8 +178,8 @@ public:
    * \param [in] o The PacketTagList to copy.
    * \returns the copied object
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This makes a light-weight copy by #RemoveAll, copying the inline
+   * tags, then pointing to the same allocated \ref TagData as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
@@ -228,6 +240,24 @@ private:
    */
   static
   TagData * CreateTagData (size_t dataSize);
+  /**
+   * Release a TagData which is not shared anymore.
+   *
+   * \param [in] tag The TagData.
+   */
+  void FreeTagData (struct TagData *tag);
+  /**
+   * \param [in] tag A TagData.
+   * \returns True if \pname{tag} is stored inside this list.
+   */
+  inline bool IsInline (const struct TagData *tag) const;
+  /**
+   * Copy the inline tags of another list, and join its tree after
+   * them.
+   *
+   * \param [in] o The PacketTagList to copy.
+   */
+  void CopyInline (PacketTagList const &o);
   
   /**
    * Typedef of method function pointer for copy-on-write operations
@@ -278,10 +308,21 @@ private:
   bool ReplaceWriter (Tag & tag, bool preMerge,
                       struct TagData * cur, struct TagData ** prevNext);
 
+  /** Maximum number of tags stored inside the list. */
+  static const uint32_t INLINE_TAGS = 4;
+  /** Maximum serialized size of a tag stored inside the list. */
+  static const uint32_t INLINE_TAG_SIZE = 16;
+  /** Size of the storage of an inline TagData, in 64-bit words. */
+  static const uint32_t INLINE_SLOT_WORDS = (sizeof (TagData) + INLINE_TAG_SIZE + 7) / 8;
+
   /**
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  /** Bitmap of the slots of #m_inline in use. */
+  uint32_t m_inlineUsed;
+  /** Storage of the inline TagData. */
+  uint64_t m_inline[INLINE_TAGS][INLINE_SLOT_WORDS];
 };
 
 } // namespace ns3
@@ -293,14 +334,20 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_inlineUsed (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_inlineUsed (0)
 {
-  if (m_next != 0)
+  if (o.m_inlineUsed != 0)
+    {
+      CopyInline (o);
+    }
+  else if (m_next != 0)
     {
       m_next->count++;
     }
@@ -310,11 +357,17 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o ||
+      (m_next == o.m_next && m_inlineUsed == 0 && o.m_inlineUsed == 0))
     {
       return *this;
     }
   RemoveAll ();
+  if (o.m_inlineUsed != 0)
+    {
+      CopyInline (o);
+      return *this;
+    }
   m_next = o.m_next;
   if (m_next != 0) 
     {
@@ -328,11 +381,31 @@ PacketTagList::~PacketTagList ()
   RemoveAll ();
 }
 
+bool
+PacketTagList::IsInline (const struct TagData *tag) const
+{
+  const uint8_t *p = reinterpret_cast<const uint8_t *> (tag);
+  const uint8_t *start = reinterpret_cast<const uint8_t *> (m_inline);
+  return p >= start && p < start + sizeof (m_inline);
+}
+
 void
 PacketTagList::RemoveAll (void)
 {
+  struct TagData *first = m_next;
+  if (m_inlineUsed != 0)
+    {
+      // skip the inline tags, which are not shared
+      while (first != 0 && IsInline (first))
+        {
+          struct TagData *next = first->next;
+          first->~TagData ();
+          first = next;
+        }
+      m_inlineUsed = 0;
+    }
   struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  for (struct TagData *cur = first; cur != 0; cur = cur->next)
     {
       cur->count--;
       if (cur->count > 0) 
@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -199,7 +200,9 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. Packet::EnableLazyPrinting provides the same
+ * output as Packet::EnablePrinting, but most of its cost is paid only
+ * by the packets which are actually printed.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -519,6 +522,20 @@ public:
    * simulation setup and before any packet is created.
    */
   static void EnablePrinting (void);
+  /**
+   * \brief Enable printing packets metadata, recorded as a log of the
+   * packet operations.
+   *
+   * The packets only record the operations performed on them, and the
+   * metadata is reconstructed from this log when a packet is printed
+   * or when BeginItem is called. This uses much less memory and time
+   * than EnablePrinting when few packets are printed, for example
+   * with filtered traces. Like EnablePrinting, this method must be
+   * called before any packet is created.
+   *
+   * \sa EnablePrinting
+   */
+  static void EnableLazyPrinting (void);
   /**
    * \brief Enable packets metadata checking.
    *
@@ -766,7 +783,11 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * Global counter of packets Uid, shared by the partitions of a
+   * MultithreadedSimulatorImpl.
+   */
+  static std::atomic<uint32_t> m_globalUid;
 };
 
 /**
@@ -23,6 +23,10 @@
 #include "ns3/double.h"
 #include "ns3/test.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -389,6 +393,235 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffers made of several fragments, checked against a plain byte
+ * array after random operations.
+ */
+class BufferFragmentsTest : public TestCase {
+public:
+  BufferFragmentsTest ();
+private:
+  virtual void DoRun (void);
+
+  /** The expected content of a buffer. */
+  typedef std::vector<uint8_t> Bytes;
+  /**
+   * Create a buffer with a zero area, and random bytes around it.
+   * \param expected the expected content of the buffer
+   * \returns the buffer
+   */
+  Buffer CreateBuffer (Bytes &expected);
+  /**
+   * Write random bytes in a buffer.
+   * \param i the start of the bytes to write
+   * \param expected the bytes to update in the expected content
+   * \param size the number of bytes to write
+   */
+  void WriteRandom (Buffer::Iterator i, Bytes::iterator expected, uint32_t size);
+  /**
+   * Check the content of a buffer.
+   * \param buffer the buffer
+   * \param expected the expected content
+   * \param step the step number, for the messages
+   */
+  void Check (const Buffer &buffer, const Bytes &expected, uint32_t step);
+
+  Ptr<UniformRandomVariable> m_rng; //!< random number generator
+};
+
+BufferFragmentsTest::BufferFragmentsTest ()
+  : TestCase ("Buffer fragments")
+{
+}
+
+Buffer
+BufferFragmentsTest::CreateBuffer (Bytes &expected)
+{
+  uint32_t zero = m_rng->GetInteger (0, 100);
+  uint32_t start = m_rng->GetInteger (0, 20);
+  uint32_t end = m_rng->GetInteger (0, 20);
+  Buffer buffer (zero);
+  buffer.AddAtStart (start);
+  buffer.AddAtEnd (end);
+  expected.assign (start + zero + end, 0);
+  WriteRandom (buffer.Begin (), expected.begin (), start);
+  Buffer::Iterator i = buffer.End ();
+  i.Prev (end);
+  WriteRandom (i, expected.end () - end, end);
+  return buffer;
+}
+
+void
+BufferFragmentsTest::WriteRandom (Buffer::Iterator i, Bytes::iterator expected, uint32_t size)
+{
+  while (size > 0)
+    {
+      // exercise the different write methods
+      if (size >= 4 && m_rng->GetValue () < 0.3)
+        {
+          uint32_t data = m_rng->GetInteger (0, 0xffffffff);
+          i.WriteHtonU32 (data);
+          *expected++ = data >> 24;
+          *expected++ = data >> 16;
+          *expected++ = data >> 8;
+          *expected++ = data;
+          size -= 4;
+        }
+      else if (size >= 2 && m_rng->GetValue () < 0.3)
+        {
+          uint16_t data = m_rng->GetInteger (0, 0xffff);
+          i.WriteHtonU16 (data);
+          *expected++ = data >> 8;
+          *expected++ = data;
+          size -= 2;
+        }
+      else
+        {
+          uint8_t data = m_rng->GetInteger (0, 0xff);
+          i.WriteU8 (data);
+          *expected++ = data;
+          size--;
+        }
+    }
+}
+
+void
+BufferFragmentsTest::Check (const Buffer &buffer, const Bytes &expected, uint32_t step)
+{
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), expected.size (), "Bad size at step " << step);
+  Bytes copy (expected.size ());
+  uint32_t copied = buffer.CopyData (copy.data (), copy.size ());
+  NS_TEST_ASSERT_MSG_EQ (copied, expected.size (), "Bad CopyData size at step " << step);
+  NS_TEST_ASSERT_MSG_EQ ((copy == expected), true, "Bad CopyData content at step " << step);
+
+  Buffer::Iterator i = buffer.Begin ();
+  NS_TEST_ASSERT_MSG_EQ (i.GetSize (), expected.size (), "Bad iterator size at step " << step);
+  for (uint32_t j = 0; j < expected.size (); j++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)i.ReadU8 (), (uint32_t)expected[j],
+                             "Bad byte " << j << " at step " << step);
+    }
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Iterator not at end at step " << step);
+  for (uint32_t j = 0; j + 4 <= expected.size (); j++)
+    {
+      i = buffer.Begin ();
+      i.Next (j);
+      uint32_t value = (expected[j] << 24) | (expected[j + 1] << 16) |
+        (expected[j + 2] << 8) | expected[j + 3];
+      NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU32 (), value, "Bad u32 " << j << " at step " << step);
+      i.Prev (4);
+      NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU16 (), (value >> 16), "Bad u16 " << j << " at step " << step);
+    }
+}
+
+void
+BufferFragmentsTest::DoRun (void)
+{
+  m_rng = CreateObject<UniformRandomVariable> ();
+
+  // concatenating buffers does not modify them
+  Bytes expectedA, expectedB;
+  Buffer a = CreateBuffer (expectedA);
+  Buffer b = CreateBuffer (expectedB);
+  Buffer c = a;
+  c.AddAtEnd (b);
+  c.AddAtEnd (c);
+  Bytes expectedC = expectedA;
+  expectedC.insert (expectedC.end (), expectedB.begin (), expectedB.end ());
+  Bytes expectedAB = expectedC;
+  expectedC.insert (expectedC.end (), expectedAB.begin (), expectedAB.end ());
+  Check (c, expectedC, 0);
+  c.AddAtStart (3);
+  WriteRandom (c.Begin (), expectedC.insert (expectedC.begin (), 3, 0), 3);
+  c.AddAtEnd (5);
+  Buffer::Iterator i = c.End ();
+  i.Prev (5);
+  WriteRandom (i, expectedC.insert (expectedC.end (), 5, 0), 5);
+  Check (c, expectedC, 0);
+  Check (a, expectedA, 0);
+  Check (b, expectedB, 0);
+
+  // copying from a fragmented buffer
+  Buffer flat;
+  flat.AddAtStart (c.GetSize ());
+  flat.Begin ().Write (c.Begin (), c.End ());
+  Check (flat, expectedC, 0);
+  NS_TEST_ASSERT_MSG_EQ (memcmp (c.PeekData (), expectedC.data (), expectedC.size ()), 0,
+                         "Bad PeekData content");
+  // serialized as by Packet::Serialize: the size of the buffer, which
+  // includes its own four bytes, followed by the buffer
+  uint32_t bufSize = c.GetSerializedSize () + 4;
+  std::vector<uint32_t> serialized (bufSize / 4);
+  serialized[0] = bufSize;
+  NS_TEST_ASSERT_MSG_EQ (c.Serialize (reinterpret_cast<uint8_t *> (&serialized[1]), bufSize - 4), 1,
+                         "Serialize failed");
+  Buffer deserialized (0, false);
+  NS_TEST_ASSERT_MSG_EQ (deserialized.Deserialize (reinterpret_cast<const uint8_t *> (&serialized[1]), serialized[0]), 1,
+                         "Deserialize failed");
+  Check (deserialized, expectedC, 0);
+
+  // random operations, checking that the snapshots are not modified
+  Buffer buffer = CreateBuffer (expectedA);
+  Bytes expected = expectedA;
+  std::vector<std::pair<Buffer, Bytes> > snapshots;
+  for (uint32_t step = 1; step <= 500; step++)
+    {
+      uint32_t op = m_rng->GetInteger (0, 6);
+      uint32_t n = m_rng->GetInteger (0, 30);
+      switch (op)
+        {
+        case 0:
+          buffer.AddAtStart (n);
+          WriteRandom (buffer.Begin (), expected.insert (expected.begin (), n, 0), n);
+          break;
+        case 1:
+          buffer.AddAtEnd (n);
+          i = buffer.End ();
+          i.Prev (n);
+          WriteRandom (i, expected.insert (expected.end (), n, 0), n);
+          break;
+        case 2:
+          n = std::min<uint32_t> (n, expected.size ());
+          buffer.RemoveAtStart (n);
+          expected.erase (expected.begin (), expected.begin () + n);
+          break;
+        case 3:
+          n = std::min<uint32_t> (n, expected.size ());
+          buffer.RemoveAtEnd (n);
+          expected.erase (expected.end () - n, expected.end ());
+          break;
+        case 4:
+        case 5:
+          {
+            Bytes other;
+            buffer.AddAtEnd (CreateBuffer (other));
+            expected.insert (expected.end (), other.begin (), other.end ());
+          }
+          break;
+        default:
+          {
+            uint32_t start = m_rng->GetInteger (0, expected.size ());
+            uint32_t length = m_rng->GetInteger (0, expected.size () - start);
+            buffer = buffer.CreateFragment (start, length);
+            expected = Bytes (expected.begin () + start, expected.begin () + start + length);
+          }
+          break;
+        }
+      Check (buffer, expected, step);
+      if (step % 25 == 0)
+        {
+          snapshots.push_back (std::make_pair (buffer, expected));
+        }
+    }
+  for (uint32_t j = 0; j < snapshots.size (); j++)
+    {
+      Check (snapshots[j].first, snapshots[j].second, j);
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -405,6 +638,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferFragmentsTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
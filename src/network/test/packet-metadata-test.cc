@@ -318,7 +318,11 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
  */
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  /**
+   * Constructor
+   * \param lazy true to record the metadata as an operation log
+   */
+  PacketMetadataTest (bool lazy);
   virtual ~PacketMetadataTest ();
   /**
    * Checks the packet header and trailer history
@@ -330,7 +334,9 @@ public:
    */
   void CheckHistory (Ptr<Packet> p, const char *file, int line, uint32_t n, ...);
   virtual void DoRun (void);
+  virtual void DoTeardown (void);
 private:
+  bool m_lazy; //!< true to record the metadata as an operation log
   /**
    * Adds an header to the packet
    * \param p The packet
@@ -339,8 +345,9 @@ private:
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (bool lazy)
+  : TestCase (lazy ? "Lazy packet metadata" : "Packet metadata"),
+    m_lazy (lazy)
 {
 }
 
@@ -474,10 +481,23 @@ PacketMetadataTest::DoAddHeader (Ptr<Packet> p)
   return p;
 }
 
+void
+PacketMetadataTest::DoTeardown (void)
+{
+  PacketMetadata::DisableLazy ();
+}
+
 void
 PacketMetadataTest::DoRun (void)
 {
-  PacketMetadata::Enable ();
+  if (m_lazy)
+    {
+      PacketMetadata::EnableLazy ();
+    }
+  else
+    {
+      PacketMetadata::Enable ();
+    }
 
   Ptr<Packet> p = Create<Packet> (0);
   Ptr<Packet> p1 = Create<Packet> (0);
@@ -918,7 +938,8 @@ public:
 PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
-  AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (false), TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (true), TestCase::QUICK);
 }
 
 static PacketMetadataTestSuite g_packetMetadataTest; //!< Static variable for test initialization
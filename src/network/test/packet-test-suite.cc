@@ -1035,6 +1035,158 @@ PacketTagListTest::DoRun (void)
     
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Packet Tag list small tag storage unit tests.
+ *
+ * Random operations on a set of lists sharing their tags, with small
+ * tags stored inside the lists and large ones allocated, are checked
+ * against a reference model.
+ */
+class PacketTagListInlineTest : public TestCase
+{
+public:
+  PacketTagListInlineTest ();
+private:
+  void DoRun (void);
+  /**
+   * Checks a list against its reference model
+   * \param ptl the list
+   * \param model the tag data expected for each tag, or -1 if missing
+   * \param msg Message
+   */
+  void Check (const PacketTagList &ptl, const std::vector<int> &model,
+              const std::string &msg);
+
+  /// The tags, small and large
+  std::vector<ATestTagBase *> m_tags;
+};
+
+PacketTagListInlineTest::PacketTagListInlineTest ()
+  : TestCase ("PacketTagList small tags")
+{
+}
+
+void
+PacketTagListInlineTest::Check (const PacketTagList &ptl,
+                                const std::vector<int> &model,
+                                const std::string &msg)
+{
+  for (uint32_t i = 0; i < m_tags.size (); i++)
+    {
+      m_tags[i]->m_data = 0;
+      m_tags[i]->m_error = false;
+      bool found = ptl.Peek (*m_tags[i]);
+      NS_TEST_EXPECT_MSG_EQ (found, (model[i] >= 0),
+                             msg << ": list contains "
+                             << m_tags[i]->GetInstanceTypeId ().GetName ());
+      if (found)
+        {
+          NS_TEST_EXPECT_MSG_EQ (m_tags[i]->GetData (), model[i],
+                                 msg << ": data of "
+                                 << m_tags[i]->GetInstanceTypeId ().GetName ());
+          NS_TEST_EXPECT_MSG_EQ (m_tags[i]->m_error, false,
+                                 msg << ": content of "
+                                 << m_tags[i]->GetInstanceTypeId ().GetName ());
+        }
+    }
+}
+
+void
+PacketTagListInlineTest::DoRun (void)
+{
+  // six small tags, more than the lists can store, and three large ones
+  ATestTag<1> t1;
+  ATestTag<3> t3;
+  ATestTag<7> t7;
+  ATestTag<11> t11;
+  ATestTag<14> t14;
+  ATestTag<15> t15;
+  ATestTag<16> t16;
+  ATestTag<20> t20;
+  ATestTag<40> t40;
+  m_tags.push_back (&t1);
+  m_tags.push_back (&t3);
+  m_tags.push_back (&t7);
+  m_tags.push_back (&t11);
+  m_tags.push_back (&t14);
+  m_tags.push_back (&t15);
+  m_tags.push_back (&t16);
+  m_tags.push_back (&t20);
+  m_tags.push_back (&t40);
+
+  const uint32_t nLists = 6;
+  std::vector<PacketTagList> lists (nLists);
+  std::vector<std::vector<int> > models (nLists, std::vector<int> (m_tags.size (), -1));
+
+  uint32_t seed = 1;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      seed = seed * 1103515245 + 12345;
+      uint32_t r = seed >> 8;
+      uint32_t l = r % nLists;
+      uint32_t t = (r / nLists) % m_tags.size ();
+      uint8_t data = (r >> 12) & 0x7f;
+      std::ostringstream oss;
+      oss << "step " << step;
+      switch ((r >> 20) % 6)
+        {
+        case 0:
+        case 1:
+          if (models[l][t] < 0)
+            {
+              m_tags[t]->m_data = data;
+              lists[l].Add (*m_tags[t]);
+              models[l][t] = data;
+            }
+          break;
+        case 2:
+          {
+            bool found = lists[l].Remove (*m_tags[t]);
+            NS_TEST_ASSERT_MSG_EQ (found, (models[l][t] >= 0), oss.str () << " remove");
+            models[l][t] = -1;
+          }
+          break;
+        case 3:
+          m_tags[t]->m_data = data;
+          lists[l].Replace (*m_tags[t]);
+          models[l][t] = data;
+          break;
+        case 4:
+          {
+            uint32_t from = (r >> 4) % nLists;
+            PacketTagList copy (lists[from]);
+            lists[l] = copy;
+            models[l] = models[from];
+          }
+          break;
+        default:
+          if ((r >> 4) % 8 == 0)
+            {
+              lists[l].RemoveAll ();
+              models[l].assign (m_tags.size (), -1);
+            }
+          else
+            {
+              lists[l] = lists[(r >> 4) % nLists];
+              models[l] = models[(r >> 4) % nLists];
+            }
+          break;
+        }
+      for (uint32_t i = 0; i < nLists; i++)
+        {
+          Check (lists[i], models[i], oss.str ());
+        }
+    }
+
+  // the self-assignment keeps the tags
+  PacketTagList &self = lists[0];
+  lists[0] = self;
+  Check (lists[0], models[0], "self assignment");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1052,6 +1204,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagListInlineTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
@@ -30,6 +30,7 @@
 #include "ns3/tag.h"
 #include "ns3/simulator.h"
 #include "ns3/queue.h"
+#include "tso-tag.h"
 
 namespace ns3 {
 
@@ -200,6 +201,12 @@ SimpleNetDevice::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&SimpleNetDevice::m_pointToPointMode),
                    MakeBooleanChecker ())
+    .AddAttribute ("SegmentationOffload",
+                   "The device accepts TCP super-segments larger than its MTU "
+                   "and transmits them as bursts of segments",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleNetDevice::m_segmentationOffload),
+                   MakeBooleanChecker ())
     .AddAttribute ("TxQueue",
                    "A queue to use as the transmit queue in the device.",
                    StringValue ("ns3::DropTailQueue<Packet>"),
@@ -428,7 +435,9 @@ bool
 SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address& dest, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << source << dest << protocolNumber);
-  if (p->GetSize () > GetMtu ())
+  TsoTag tsoTag;
+  if (p->GetSize () > GetMtu ()
+      && !(m_segmentationOffload && p->PeekPacketTag (tsoTag)))
     {
       return false;
     }
@@ -450,11 +459,7 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
         {
           p = m_queue->Dequeue ();
           p->RemovePacketTag (tag);
-          Time txTime = Time (0);
-          if (m_bps > DataRate (0))
-            {
-              txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
-            }
+          Time txTime = GetTxTime (packet);
           m_channel->Send (p, protocolNumber, to, from, this);
           TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
         }
@@ -490,17 +495,30 @@ SimpleNetDevice::TransmitComplete ()
 
   if (m_queue->GetNPackets ())
     {
-      Time txTime = Time (0);
-      if (m_bps > DataRate (0))
-        {
-          txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
-        }
+      Time txTime = GetTxTime (packet);
       TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
     }
 
   return;
 }
 
+Time
+SimpleNetDevice::GetTxTime (Ptr<const Packet> packet) const
+{
+  NS_LOG_FUNCTION (this << packet);
+  if (m_bps == DataRate (0))
+    {
+      return Time (0);
+    }
+  uint32_t txSize = packet->GetSize ();
+  TsoTag tsoTag;
+  if (m_segmentationOffload && packet->PeekPacketTag (tsoTag))
+    {
+      txSize = tsoTag.GetWireSize (txSize);
+    }
+  return m_bps.CalculateBytesTxTime (txSize);
+}
+
 Ptr<Node> 
 SimpleNetDevice::GetNode (void) const
 {
@@ -560,4 +578,14 @@ SimpleNetDevice::SupportsSendFrom (void) const
   return true;
 }
 
+bool
+SimpleNetDevice::SupportsSegmentationOffload (uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << size);
+  // Only a queue limited in bytes counts the super-segment as its segments
+  QueueSize maxSize = m_queue->GetMaxSize ();
+  return m_segmentationOffload && maxSize.GetUnit () == QueueSizeUnit::BYTES
+         && m_queue->GetNBytes () + size <= maxSize.GetValue ();
+}
+
 } // namespace ns3
@@ -134,6 +134,7 @@ public:
 
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
+  virtual bool SupportsSegmentationOffload (uint32_t size) const;
 
 protected:
   virtual void DoDispose (void);
@@ -164,6 +165,14 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Compute the transmission time of a packet
+   *
+   * \param packet the packet
+   * \returns the transmission time at the device data rate
+   */
+  Time GetTxTime (Ptr<const Packet> packet) const;
+
   bool m_linkUp; //!< Flag indicating whether or not the link is up
 
   /**
@@ -172,6 +181,12 @@ private:
    */
   bool m_pointToPointMode;
 
+  /**
+   * Flag indicating whether or not the NetDevice transmits the TCP
+   * super-segments as bursts of segments (see TsoTag).
+   */
+  bool m_segmentationOffload;
+
   Ptr<Queue<Packet> > m_queue; //!< The Queue for outgoing packets.
   DataRate m_bps; //!< The device nominal Data rate. Zero means infinite
   EventId TransmitCompleteEvent; //!< the Tx Complete event
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tso-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (TsoTag);
+
+TypeId
+TsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<TsoTag> ()
+  ;
+  return tid;
+}
+TypeId
+TsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+TsoTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 8;
+}
+void
+TsoTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU32 (m_segmentSize);
+  buf.WriteU32 (m_payloadSize);
+}
+void
+TsoTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_segmentSize = buf.ReadU32 ();
+  m_payloadSize = buf.ReadU32 ();
+}
+void
+TsoTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "SegmentSize=" << m_segmentSize << " PayloadSize=" << m_payloadSize;
+}
+TsoTag::TsoTag ()
+  : Tag (),
+    m_segmentSize (0),
+    m_payloadSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TsoTag::TsoTag (uint32_t segmentSize, uint32_t payloadSize)
+  : Tag (),
+    m_segmentSize (segmentSize),
+    m_payloadSize (payloadSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize << payloadSize);
+}
+
+void
+TsoTag::SetSegmentSize (uint32_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  m_segmentSize = segmentSize;
+}
+uint32_t
+TsoTag::GetSegmentSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segmentSize;
+}
+void
+TsoTag::SetPayloadSize (uint32_t payloadSize)
+{
+  NS_LOG_FUNCTION (this << payloadSize);
+  m_payloadSize = payloadSize;
+}
+uint32_t
+TsoTag::GetPayloadSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_payloadSize;
+}
+uint32_t
+TsoTag::GetSegments (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_segmentSize == 0 || m_payloadSize == 0)
+    {
+      return 1;
+    }
+  return (m_payloadSize + m_segmentSize - 1) / m_segmentSize;
+}
+uint32_t
+TsoTag::GetWireSize (uint32_t packetSize) const
+{
+  NS_LOG_FUNCTION (this << packetSize);
+  NS_ASSERT (packetSize >= m_payloadSize);
+  return packetSize + (GetSegments () - 1) * (packetSize - m_payloadSize);
+}
+
+} // namespace ns3
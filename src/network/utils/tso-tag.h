@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TSO_TAG_H
+#define TSO_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Marks a super-segment for TCP segmentation offload (TSO)
+ *
+ * A transport protocol which sends several segments at once as a
+ * single packet (a super-segment) adds this tag to it, with the size of
+ * the segments and the size of the payload.  A NetDevice which supports
+ * segmentation offload (see NetDevice::SupportsSegmentationOffload)
+ * transmits the super-segment as a burst of segments, each carrying the
+ * headers of the packet, and delivers it as a whole to the receiver, as
+ * generic receive offload (GRO) would.  Anywhere else, i.e. on a device
+ * without segmentation offload, in a queue disc or in a device queue
+ * without room for all of its segments, the IP layer splits the
+ * super-segment into real segments, so that queue drops and ECN marks
+ * apply to single segments.  The error model of a device receiving a
+ * super-segment still drops the whole burst.
+ */
+class TsoTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  TsoTag ();
+
+  /**
+   * Constructs a TsoTag
+   *
+   * \param segmentSize the size of the payload of each segment
+   * \param payloadSize the size of the payload of the super-segment
+   */
+  TsoTag (uint32_t segmentSize, uint32_t payloadSize);
+  /**
+   * \brief Set the size of the payload of each segment
+   * \param segmentSize the segment size, in bytes
+   */
+  void SetSegmentSize (uint32_t segmentSize);
+  /**
+   * \brief Get the size of the payload of each segment
+   * \returns the segment size, in bytes
+   */
+  uint32_t GetSegmentSize (void) const;
+  /**
+   * \brief Set the size of the payload of the super-segment
+   * \param payloadSize the payload size, in bytes
+   */
+  void SetPayloadSize (uint32_t payloadSize);
+  /**
+   * \brief Get the size of the payload of the super-segment
+   * \returns the payload size, in bytes
+   */
+  uint32_t GetPayloadSize (void) const;
+  /**
+   * \brief Get the number of segments in the super-segment
+   * \returns the number of segments (the last one may be smaller)
+   */
+  uint32_t GetSegments (void) const;
+  /**
+   * \brief Get the number of bytes sent on the wire for the super-segment
+   *
+   * Each segment carries the headers of the packet, i.e., everything
+   * but the payload of the super-segment.
+   *
+   * \param packetSize the size of the super-segment, headers included
+   * \returns the total size of the segments
+   */
+  uint32_t GetWireSize (uint32_t packetSize) const;
+
+private:
+  uint32_t m_segmentSize; //!< Size of the payload of each segment
+  uint32_t m_payloadSize; //!< Size of the payload of the super-segment
+};
+
+} // namespace ns3
+
+#endif /* TSO_TAG_H */
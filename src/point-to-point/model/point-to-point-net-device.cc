@@ -25,6 +25,8 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/tso-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -67,6 +69,12 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("SegmentationOffload",
+                   "Whether the device accepts TCP super-segments larger than its MTU "
+                   "and transmits them as bursts of segments (see ns3::TsoTag)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::m_segmentationOffload),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -175,6 +183,7 @@ PointToPointNetDevice::GetTypeId (void)
 PointToPointNetDevice::PointToPointNetDevice () 
   :
     m_txMachineState (READY),
+    m_fluidRate (0),
     m_channel (0),
     m_linkUp (false),
     m_currentPkt (0)
@@ -248,13 +257,35 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  uint32_t txSize = p->GetSize ();
+  TsoTag tsoTag;
+  if (m_segmentationOffload && p->PeekPacketTag (tsoTag))
+    {
+      // The segments of the super-segment are sent back to back; the
+      // peer receives them as a whole, at the end of the last one.
+      txSize = tsoTag.GetWireSize (txSize);
+    }
+  Time txTime = m_bps.CalculateBytesTxTime (txSize);
+  if (m_fluidRate.GetBitRate () > 0)
+    {
+      // The fluid flows take their share of the transmitter
+      DataRate residual (m_bps.GetBitRate () - m_fluidRate.GetBitRate ());
+      txTime = residual.CalculateBytesTxTime (txSize);
+    }
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
   Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
 
-  bool result = m_channel->TransmitStart (p, this, txTime);
+  //
+  // The packet waits behind the standing queue of the fluid flows, if
+  // any, before reaching the wire.  It is delivered that much later,
+  // but never before the packet sent ahead of it.
+  //
+  Time rxTime = Max (txTime + m_fluidQueueDelay, m_fluidLastRx - Simulator::Now ());
+  m_fluidLastRx = Simulator::Now () + rxTime;
+
+  bool result = m_channel->TransmitStart (p, this, rxTime);
   if (result == false)
     {
       m_phyTxDropTrace (p);
@@ -605,6 +636,44 @@ PointToPointNetDevice::SupportsSendFrom (void) const
   return false;
 }
 
+bool
+PointToPointNetDevice::SupportsSegmentationOffload (uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << size);
+  // Only a queue limited in bytes counts the super-segment as its segments
+  QueueSize maxSize = m_queue->GetMaxSize ();
+  return m_segmentationOffload && maxSize.GetUnit () == QueueSizeUnit::BYTES
+         && m_queue->GetNBytes () + size <= maxSize.GetValue ();
+}
+
+DataRate
+PointToPointNetDevice::GetFluidCapacity (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bps;
+}
+
+void
+PointToPointNetDevice::SetFluidLoad (DataRate rate, double queueFill)
+{
+  NS_LOG_FUNCTION (this << rate << queueFill);
+  NS_ASSERT_MSG (rate < m_bps, "The fluid flows leave no capacity to the packets");
+  NS_ASSERT (queueFill >= 0 && queueFill <= 1);
+  m_fluidRate = rate;
+  m_fluidQueueDelay = Seconds (0);
+  if (queueFill > 0)
+    {
+      QueueSize maxSize = m_queue->GetMaxSize ();
+      double bytes = maxSize.GetValue ();
+      if (maxSize.GetUnit () == QueueSizeUnit::PACKETS)
+        {
+          PppHeader ppp;
+          bytes *= m_mtu + ppp.GetSerializedSize ();
+        }
+      m_fluidQueueDelay = m_bps.CalculateBytesTxTime (static_cast<uint32_t> (bytes * queueFill));
+    }
+}
+
 void
 PointToPointNetDevice::DoMpiReceive (Ptr<Packet> p)
 {
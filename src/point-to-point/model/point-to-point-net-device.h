@@ -189,6 +189,9 @@ public:
 
   virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
   virtual bool SupportsSendFrom (void) const;
+  virtual bool SupportsSegmentationOffload (uint32_t size) const;
+  virtual DataRate GetFluidCapacity (void) const;
+  virtual void SetFluidLoad (DataRate rate, double queueFill);
 
 protected:
   /**
@@ -307,6 +310,28 @@ private:
    */
   Time           m_tInterframeGap;
 
+  /**
+   * Whether the device transmits the TCP super-segments as bursts of
+   * segments (see TsoTag)
+   */
+  bool           m_segmentationOffload;
+
+  /**
+   * The aggregate rate of the fluid flows sharing the transmitter
+   */
+  DataRate       m_fluidRate;
+
+  /**
+   * The queueing delay of the standing queue kept by the fluid flows
+   */
+  Time           m_fluidQueueDelay;
+
+  /**
+   * The time the last packet sent reaches the peer, which the packets
+   * sent later must not overtake when the fluid queue shrinks
+   */
+  Time           m_fluidLastRx;
+
   /**
    * The PointToPointChannel to which this PointToPointNetDevice has been
    * attached.
@@ -19,12 +19,23 @@
  */
 
 #include "ns3/test.h"
+#include "ns3/config.h"
+#include "ns3/data-rate.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -94,6 +105,193 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the PointToPoint model with the MultithreadedSimulatorImpl
+ *
+ * Several pairs of nodes exchange packets which shrink by one byte at
+ * each hop, and the receptions must be the same as with the
+ * DefaultSimulatorImpl.  The pairs are executed by several threads,
+ * unless an extra channel connects all of them.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   * \param connected whether a channel connects all the pairs
+   */
+  PointToPointMultithreadedTest (bool connected);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  virtual void DoTeardown (void);
+
+  /** A reception: time, node, size */
+  typedef std::vector<std::pair<int64_t, std::pair<uint32_t, uint32_t> > > Receptions;
+
+  /**
+   * \brief Build the topology, run the simulation and collect the receptions
+   * \param simulatorType the simulator implementation
+   * \param receptions the receptions, sorted
+   * \returns the number of threads which received packets
+   */
+  uint32_t RunOne (const std::string &simulatorType, Receptions &receptions);
+  /**
+   * \brief Create a pair of devices connected by a channel
+   * \param a the first node
+   * \param b the second node
+   */
+  void Connect (Ptr<Node> a, Ptr<Node> b);
+  /**
+   * \brief Send a packet
+   * \param device the sending device
+   * \param size the packet size
+   */
+  void Send (Ptr<NetDevice> device, uint32_t size);
+  /**
+   * \brief Record a reception, and send back a smaller copy
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  bool m_connected;                     //!< whether all the pairs are connected
+  std::map<uint32_t, Receptions> m_receptions; //!< receptions, by node
+  std::set<std::thread::id> m_threads;  //!< threads which received packets
+  std::mutex m_mutex;                   //!< protects m_receptions and m_threads
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest (bool connected)
+  : TestCase (connected ? "PointToPoint with a multithreaded simulator, connected pairs"
+              : "PointToPoint with a multithreaded simulator, separate pairs"),
+    m_connected (connected)
+{
+}
+
+void
+PointToPointMultithreadedTest::Connect (Ptr<Node> a, Ptr<Node> b)
+{
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", StringValue ("2ms"));
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+      device->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+      device->Attach (channel);
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+      nodes[i]->AddDevice (device);
+      device->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+    }
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<NetDevice> device, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_receptions[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (),
+                                                  std::make_pair (node, packet->GetSize ())));
+    m_threads.insert (std::this_thread::get_id ());
+  }
+  if (packet->GetSize () > 900)
+    {
+      Ptr<Packet> copy = packet->Copy ();
+      copy->RemoveAtEnd (1);
+      device->Send (copy, device->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+uint32_t
+PointToPointMultithreadedTest::RunOne (const std::string &simulatorType, Receptions &receptions)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  m_receptions.clear ();
+  m_threads.clear ();
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+      if (i % 2 == 1)
+        {
+          Connect (nodes[i - 1], nodes[i]);
+        }
+    }
+  if (m_connected)
+    {
+      for (uint32_t i = 2; i < nodes.size (); i += 2)
+        {
+          Connect (nodes[i - 1], nodes[i]);
+        }
+    }
+  for (uint32_t i = 0; i < nodes.size (); i++)
+    {
+      for (uint32_t j = 0; j < 20; j++)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (100 * j + 7 * i),
+                                          &PointToPointMultithreadedTest::Send, this,
+                                          nodes[i]->GetDevice (0), 1000 - j);
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  receptions.clear ();
+  for (std::map<uint32_t, Receptions>::const_iterator i = m_receptions.begin (); i != m_receptions.end (); i++)
+    {
+      receptions.insert (receptions.end (), i->second.begin (), i->second.end ());
+    }
+  std::sort (receptions.begin (), receptions.end ());
+  return m_threads.size ();
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Receptions expected;
+  Receptions receptions;
+  RunOne ("ns3::DefaultSimulatorImpl", expected);
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (4));
+  uint32_t threads = RunOne ("ns3::MultithreadedSimulatorImpl", receptions);
+
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 12 * 20, "Too few receptions");
+  NS_TEST_ASSERT_MSG_EQ (receptions.size (), expected.size (), "Different number of receptions");
+  NS_TEST_EXPECT_MSG_EQ ((receptions == expected), true, "Different receptions");
+  if (m_connected)
+    {
+      NS_TEST_EXPECT_MSG_EQ (threads, 1, "Connected pairs executed by several threads");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (threads, 1, "Separate pairs executed by a single thread");
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -110,6 +308,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest (false), TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest (true), TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
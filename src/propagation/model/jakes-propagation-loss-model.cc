@@ -20,6 +20,7 @@
 
 #include "jakes-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/log.h"
 
 namespace ns3
@@ -40,6 +41,14 @@ JakesPropagationLossModel::JakesPropagationLossModel()
 JakesPropagationLossModel::~JakesPropagationLossModel()
 {}
 
+void
+JakesPropagationLossModel::DoDispose (void)
+{
+  // the processes hold a reference to this model
+  m_propagationCache.Clear ();
+  PropagationLossModel::DoDispose ();
+}
+
 TypeId
 JakesPropagationLossModel::GetTypeId ()
 {
@@ -47,6 +56,32 @@ JakesPropagationLossModel::GetTypeId ()
     .SetParent<PropagationLossModel> ()
     .SetGroupName ("Propagation")
     .AddConstructor<JakesPropagationLossModel> ()
+    .AddAttribute ("CacheMaxSize",
+                   "The maximum number of paths for which a JakesProcess is kept, "
+                   "the least recently used path being evicted (0 for unbounded).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&JakesPropagationLossModel::SetCacheMaxSize,
+                                         &JakesPropagationLossModel::GetCacheMaxSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CacheMaxAge",
+                   "The time after which the JakesProcess of a path which is not "
+                   "used is evicted (zero for no expiry).",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&JakesPropagationLossModel::SetCacheMaxAge,
+                                     &JakesPropagationLossModel::GetCacheMaxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("CacheHits",
+                   "The number of times the JakesProcess of a path was found in the cache.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&JakesPropagationLossModel::GetCacheHits),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("CacheMisses",
+                   "The number of times the JakesProcess of a path had to be created.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&JakesPropagationLossModel::GetCacheMisses),
+                   MakeUintegerChecker<uint64_t> ())
   ;
   return tid;
 }
@@ -72,6 +107,48 @@ JakesPropagationLossModel::GetUniformRandomVariable () const
   return m_uniformVariable;
 }
 
+void
+JakesPropagationLossModel::SetCacheMaxSize (uint32_t maxSize)
+{
+  m_propagationCache.SetMaxSize (maxSize);
+}
+
+uint32_t
+JakesPropagationLossModel::GetCacheMaxSize (void) const
+{
+  return m_propagationCache.GetMaxSize ();
+}
+
+void
+JakesPropagationLossModel::SetCacheMaxAge (Time maxAge)
+{
+  m_propagationCache.SetMaxAge (maxAge);
+}
+
+Time
+JakesPropagationLossModel::GetCacheMaxAge (void) const
+{
+  return m_propagationCache.GetMaxAge ();
+}
+
+uint64_t
+JakesPropagationLossModel::GetCacheHits (void) const
+{
+  return m_propagationCache.GetHits ();
+}
+
+uint64_t
+JakesPropagationLossModel::GetCacheMisses (void) const
+{
+  return m_propagationCache.GetMisses ();
+}
+
+uint32_t
+JakesPropagationLossModel::GetCacheSize (void) const
+{
+  return m_propagationCache.GetSize ();
+}
+
 int64_t
 JakesPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -31,6 +31,9 @@ namespace ns3
  *
  * \brief a  Jakes narrowband propagation model.
  * Symmetrical cache for JakesProcess
+ *
+ * The cache of JakesProcess can be bounded with the CacheMaxSize and
+ * CacheMaxAge attributes, see PropagationCache.
  */
 
 class JakesPropagationLossModel : public PropagationLossModel
@@ -43,7 +46,15 @@ public:
   static TypeId GetTypeId ();
   JakesPropagationLossModel ();
   virtual ~JakesPropagationLossModel ();
-  
+
+  /**
+   * \return the number of paths in the cache of JakesProcess
+   */
+  uint32_t GetCacheSize (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
 private:
   friend class JakesProcess;
 
@@ -71,6 +82,31 @@ private:
    */
   Ptr<UniformRandomVariable> GetUniformRandomVariable () const;
 
+  /**
+   * \param maxSize the maximum number of paths in the cache
+   */
+  void SetCacheMaxSize (uint32_t maxSize);
+  /**
+   * \return the maximum number of paths in the cache
+   */
+  uint32_t GetCacheMaxSize (void) const;
+  /**
+   * \param maxAge the time after which an unused path is evicted
+   */
+  void SetCacheMaxAge (Time maxAge);
+  /**
+   * \return the time after which an unused path is evicted
+   */
+  Time GetCacheMaxAge (void) const;
+  /**
+   * \return the number of cache hits
+   */
+  uint64_t GetCacheHits (void) const;
+  /**
+   * \return the number of cache misses
+   */
+  uint64_t GetCacheMisses (void) const;
+
   Ptr<UniformRandomVariable> m_uniformVariable; //!< random stream
   mutable PropagationCache<JakesProcess> m_propagationCache; //!< Propagation cache
 };
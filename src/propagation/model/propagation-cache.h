@@ -21,23 +21,112 @@
 #define PROPAGATION_CACHE_H_
 
 #include "ns3/mobility-model.h"
-#include <map>
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include <functional>
+#include <list>
+#include <unordered_map>
 
 namespace ns3
 {
+/**
+ * \ingroup propagation
+ * Hash a propagation path, identified by two objects (e.g., the mobility
+ * models of its ends) and a group (e.g., a spectrum model UID).  The
+ * paths of PropagationCache and the rows of PropagationMatrix share this
+ * hash.
+ * \param a the first object
+ * \param b the second object, or zero
+ * \param group the group
+ * \returns the hash of the path
+ */
+inline std::size_t
+PropagationPathHashValue (const void *a, const void *b, uint32_t group)
+{
+  std::hash<const void *> hasher;
+  std::size_t h = hasher (a);
+  h ^= hasher (b) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= group + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 /**
  * \ingroup propagation
  * \brief Constructs a cache of objects, where each object is responsible for a single propagation path loss calculations.
- * Propagation path a-->b and b-->a is the same thing. Propagation path is identified by
+ * By default, propagation path a-->b and b-->a is the same thing. Propagation path is identified by
  * a couple of MobilityModels and a spectrum model UID
+ *
+ * The paths are kept in a hash table, and the cache can be bounded:
+ *  - with SetMaxSize, the least recently used path is evicted when
+ *    the cache holds too many paths,
+ *  - with SetMaxAge, the paths which were not used for some time are
+ *    evicted.
+ *
+ * An evicted path is simply created again by the owner of the cache
+ * the next time it is needed, so that a bounded cache trades the
+ * memory of the paths not used any more (e.g., between nodes which
+ * moved apart) for a new realization of the random processes of the
+ * paths which are used again.  By default, the cache is unbounded.
  */
 template<class T>
 class PropagationCache
 {
 public:
-  PropagationCache () {};
+  PropagationCache ()
+    : m_symmetric (true),
+      m_maxSize (0),
+      m_hits (0),
+      m_misses (0)
+  {};
   ~PropagationCache () {};
 
+  /**
+   * Set whether the paths a-->b and b-->a are the same path.  This
+   * must be set before the first path is added.
+   * \param symmetric true (the default) if the paths are symmetrical
+   */
+  void SetSymmetric (bool symmetric)
+  {
+    NS_ASSERT (m_pathCache.empty ());
+    m_symmetric = symmetric;
+  };
+
+  /**
+   * Set the maximum number of paths in the cache.
+   * \param maxSize the maximum number of paths, 0 for unbounded
+   */
+  void SetMaxSize (uint32_t maxSize)
+  {
+    m_maxSize = maxSize;
+    Evict ();
+  };
+
+  /**
+   * \return the maximum number of paths in the cache, 0 if unbounded
+   */
+  uint32_t GetMaxSize (void) const
+  {
+    return m_maxSize;
+  };
+
+  /**
+   * Set the time after which a path which is not used is evicted.
+   * \param maxAge the maximum age of the paths, zero for no expiry
+   */
+  void SetMaxAge (Time maxAge)
+  {
+    m_maxAge = maxAge;
+    Evict ();
+  };
+
+  /**
+   * \return the time after which a path which is not used is evicted
+   */
+  Time GetMaxAge (void) const
+  {
+    return m_maxAge;
+  };
+
   /**
    * Get the model associated with the path
    * \param a 1st node mobility model
@@ -47,13 +136,19 @@ public:
    */
   Ptr<T> GetPathData (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid)
   {
-    PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
+    Evict ();
+    PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid, m_symmetric);
     typename PathCache::iterator it = m_pathCache.find (key);
     if (it == m_pathCache.end ())
       {
+        m_misses++;
         return 0;
       }
-    return it->second;
+    m_hits++;
+    // move the path to the front of the usage list
+    m_usage.splice (m_usage.begin (), m_usage, it->second);
+    it->second->m_lastAccess = Now ();
+    return it->second->m_data;
   };
 
   /**
@@ -65,61 +160,147 @@ public:
    */
   void AddPathData (Ptr<T> data, Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid)
   {
-    PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
+    PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid, m_symmetric);
     NS_ASSERT (m_pathCache.find (key) == m_pathCache.end ());
-    m_pathCache.insert (std::make_pair (key, data)); 
+    Entry entry;
+    entry.m_key = key;
+    entry.m_data = data;
+    entry.m_lastAccess = Now ();
+    m_usage.push_front (entry);
+    m_pathCache.insert (std::make_pair (key, m_usage.begin ()));
+    Evict ();
+  };
+
+  /**
+   * \return the number of paths in the cache
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_pathCache.size ();
   };
+
+  /**
+   * \return the number of calls to GetPathData which found the path
+   */
+  uint64_t GetHits (void) const
+  {
+    return m_hits;
+  };
+
+  /**
+   * \return the number of calls to GetPathData which did not find the path
+   */
+  uint64_t GetMisses (void) const
+  {
+    return m_misses;
+  };
+
+  /**
+   * Remove all the paths.
+   */
+  void Clear (void)
+  {
+    m_pathCache.clear ();
+    m_usage.clear ();
+  };
+
 private:
   /// Each path is identified by
   struct PropagationPathIdentifier
   {
+    /// Default constructor
+    PropagationPathIdentifier ()
+      : m_spectrumModelUid (0)
+    {};
     /**
      * Constructor
      * @param a 1st node mobility model
      * @param b 2nd node mobility model
      * @param modelUid model UID
+     * @param symmetric whether the links are symmetrical
      */
-    PropagationPathIdentifier (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid) :
+    PropagationPathIdentifier (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid, bool symmetric) :
       m_srcMobility (a), m_dstMobility (b), m_spectrumModelUid (modelUid)
-    {};
+    {
+      /// Links are supposed to be symmetrical, unless told otherwise
+      if (symmetric && m_dstMobility < m_srcMobility)
+        {
+          std::swap (m_srcMobility, m_dstMobility);
+        }
+    };
     Ptr<const MobilityModel> m_srcMobility; //!< 1st node mobility model
     Ptr<const MobilityModel> m_dstMobility; //!< 2nd node mobility model
     uint32_t m_spectrumModelUid; //!< model UID
 
     /**
-     * Less-than operator.
-     *
-     * The goal of this operator is just to provide a stable comparison
-     * to be used in containers requiring a order (of any kind).
-     *
-     * If the models are different, the comparison is based on their Uid.
-     * Otherwise, the comparison is based on the pointers of the Mobility models.
+     * Equality operator.
      *
      * \param other Right value of the operator.
-     * \returns True if the Left value is less than the Right value.
+     * \returns True if the identifiers designate the same path.
      */
-    bool operator < (const PropagationPathIdentifier & other) const
+    bool operator == (const PropagationPathIdentifier & other) const
     {
-      if (m_spectrumModelUid != other.m_spectrumModelUid)
-        {
-          return m_spectrumModelUid < other.m_spectrumModelUid;
-        }
-      /// Links are supposed to be symmetrical!
-      if (std::min (m_dstMobility, m_srcMobility) != std::min (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::min (m_dstMobility, m_srcMobility) < std::min (other.m_dstMobility, other.m_srcMobility);
-        }
-      if (std::max (m_dstMobility, m_srcMobility) != std::max (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::max (m_dstMobility, m_srcMobility) < std::max (other.m_dstMobility, other.m_srcMobility);
-        }
-      return false;
+      return m_spectrumModelUid == other.m_spectrumModelUid
+             && m_srcMobility == other.m_srcMobility
+             && m_dstMobility == other.m_dstMobility;
     }
   };
 
-  /// Typedef: PropagationPathIdentifier, Ptr<T>
-  typedef std::map<PropagationPathIdentifier, Ptr<T> > PathCache;
-private:
+  /// Hash function of the path identifiers
+  struct PropagationPathHash
+  {
+    /**
+     * \param id the path identifier
+     * \returns the hash of the identifier
+     */
+    std::size_t operator () (const PropagationPathIdentifier & id) const
+    {
+      return PropagationPathHashValue (PeekPointer (id.m_srcMobility), PeekPointer (id.m_dstMobility),
+                                       id.m_spectrumModelUid);
+    }
+  };
+
+  /// A path in the usage list
+  struct Entry
+  {
+    PropagationPathIdentifier m_key; //!< The path
+    Ptr<T> m_data; //!< The data of the path
+    Time m_lastAccess; //!< The last time the path was used
+  };
+
+  /// The paths, by decreasing time of last use
+  typedef std::list<Entry> UsageList;
+  /// Typedef: PropagationPathIdentifier, position in the usage list
+  typedef std::unordered_map<PropagationPathIdentifier, typename UsageList::iterator, PropagationPathHash> PathCache;
+
+  /**
+   * Evict the least recently used paths beyond the maximum size, and
+   * the paths which were not used for longer than the maximum age.
+   */
+  void Evict (void)
+  {
+    while (m_maxSize > 0 && m_usage.size () > m_maxSize)
+      {
+        m_pathCache.erase (m_usage.back ().m_key);
+        m_usage.pop_back ();
+      }
+    if (m_maxAge.IsStrictlyPositive ())
+      {
+        Time limit = Now () - m_maxAge;
+        while (!m_usage.empty () && m_usage.back ().m_lastAccess < limit)
+          {
+            m_pathCache.erase (m_usage.back ().m_key);
+            m_usage.pop_back ();
+          }
+      }
+  };
+
+  bool m_symmetric; //!< whether the paths are symmetrical
+  uint32_t m_maxSize; //!< maximum number of paths, 0 if unbounded
+  Time m_maxAge; //!< maximum time a path is kept without being used
+  uint64_t m_hits; //!< number of paths found
+  uint64_t m_misses; //!< number of paths not found
+  UsageList m_usage; //!< paths, most recently used first
   PathCache m_pathCache; //!< Path cache
 };
 } // namespace ns3
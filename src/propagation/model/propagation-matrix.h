@@ -0,0 +1,248 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROPAGATION_MATRIX_H_
+#define PROPAGATION_MATRIX_H_
+
+#include "ns3/mobility-model.h"
+#include "ns3/callback.h"
+#include "ns3/abort.h"
+#include "propagation-cache.h"
+#include "propagation-loss-model.h"
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+/**
+ * \ingroup propagation
+ * \brief A matrix of the propagation from each transmitter to its
+ * receivers, for the channels whose nodes do not move.
+ *
+ * A channel computes once the propagation (e.g., the loss and the
+ * delay) from a transmitter to all its receivers, and stores it as a
+ * row of the matrix, identified by the transmitter and a group of
+ * receivers (e.g., a spectrum model UID).  A row only holds the links
+ * kept by the channel, e.g., the receivers within range, so that the
+ * matrix of a large network is sparse.
+ *
+ * The matrix watches the CourseChange trace source of the mobility
+ * models of the channel, and drops all its rows when one of them
+ * changes its position or velocity: the rows are then computed again
+ * as they are needed.  The rows are only valid as long as the models
+ * notify every move, so the channels should not store a row for a
+ * moving transmitter, nor a link to a moving receiver (see
+ * IsMotionless).
+ */
+template<class T>
+class PropagationMatrix
+{
+public:
+  /// A link from the transmitter of a row to a receiver
+  struct Link
+  {
+    uint32_t m_rx; //!< The receiver, identified by the channel
+    T m_data;      //!< The propagation to the receiver
+  };
+  /// The links of a transmitter
+  typedef std::vector<Link> Row;
+
+  PropagationMatrix ()
+    : m_hits (0),
+      m_misses (0)
+  {};
+  ~PropagationMatrix ()
+  {
+    Clear ();
+  };
+
+  /**
+   * Watch the course changes of a mobility model.
+   * \param mobility the model, or zero
+   */
+  void Watch (Ptr<MobilityModel> mobility)
+  {
+    if (mobility != 0 && m_watched.insert (mobility).second)
+      {
+        mobility->TraceConnectWithoutContext ("CourseChange",
+                                              MakeCallback (&PropagationMatrix<T>::CourseChanged, this));
+      }
+  };
+
+  /**
+   * \param mobility a mobility model, or zero
+   * \return true if the model has no velocity, or if there is no model
+   */
+  static bool IsMotionless (Ptr<const MobilityModel> mobility)
+  {
+    if (mobility == 0)
+      {
+        return true;
+      }
+    Vector velocity = mobility->GetVelocity ();
+    return velocity.x == 0 && velocity.y == 0 && velocity.z == 0;
+  };
+
+  /**
+   * Abort if a propagation loss model, or a model chained to it, draws
+   * random variables, since its gains could not be replayed.  The models
+   * are probed with AssignStreams, which only changes the streams of the
+   * random models.
+   * \param loss the model, or zero
+   */
+  static void CheckDeterministic (Ptr<PropagationLossModel> loss)
+  {
+    // the last model of the chain using streams from there on is random
+    Ptr<PropagationLossModel> random = 0;
+    for (Ptr<PropagationLossModel> model = loss; model != 0; model = model->GetNext ())
+      {
+        if (model->AssignStreams (0) != 0)
+          {
+            random = model;
+          }
+      }
+    NS_ABORT_MSG_IF (random != 0, "StaticTopology requires a deterministic propagation loss model, "
+                     << random->GetInstanceTypeId ().GetName () << " draws random variables");
+  };
+
+  /**
+   * Get a row of the matrix
+   * \param tx the transmitter
+   * \param group the group of receivers
+   * \return the row, or zero if it is not stored
+   */
+  const Row * GetRow (const void *tx, uint32_t group)
+  {
+    typename RowMap::const_iterator it = m_rows.find (RowKey (tx, group));
+    if (it == m_rows.end ())
+      {
+        m_misses++;
+        return 0;
+      }
+    m_hits++;
+    return &it->second;
+  };
+
+  /**
+   * Add an empty row to the matrix, to be filled by the caller
+   * \param tx the transmitter
+   * \param group the group of receivers
+   * \return the row
+   */
+  Row & AddRow (const void *tx, uint32_t group)
+  {
+    Row &row = m_rows[RowKey (tx, group)];
+    row.clear ();
+    return row;
+  };
+
+  /**
+   * \return the number of rows in the matrix
+   */
+  uint32_t GetNRows (void) const
+  {
+    return m_rows.size ();
+  };
+
+  /**
+   * \return the number of calls to GetRow which found the row
+   */
+  uint64_t GetHits (void) const
+  {
+    return m_hits;
+  };
+
+  /**
+   * \return the number of calls to GetRow which did not find the row
+   */
+  uint64_t GetMisses (void) const
+  {
+    return m_misses;
+  };
+
+  /**
+   * Remove all the rows, e.g., when a receiver is added to the channel.
+   */
+  void Invalidate (void)
+  {
+    m_rows.clear ();
+  };
+
+  /**
+   * Remove all the rows and stop watching the mobility models.
+   */
+  void Clear (void)
+  {
+    for (typename std::set<Ptr<MobilityModel> >::iterator it = m_watched.begin (); it != m_watched.end (); ++it)
+      {
+        (*it)->TraceDisconnectWithoutContext ("CourseChange",
+                                              MakeCallback (&PropagationMatrix<T>::CourseChanged, this));
+      }
+    m_watched.clear ();
+    m_rows.clear ();
+  };
+
+private:
+  /// A row is identified by its transmitter and group of receivers
+  typedef std::pair<const void *, uint32_t> RowKey;
+
+  /// Hash function of the row identifiers
+  struct RowHash
+  {
+    /**
+     * \param key the row identifier
+     * \returns the hash of the identifier
+     */
+    std::size_t operator () (const RowKey & key) const
+    {
+      return PropagationPathHashValue (key.first, 0, key.second);
+    }
+  };
+
+  /// The rows, by transmitter and group
+  typedef std::unordered_map<RowKey, Row, RowHash> RowMap;
+
+  /**
+   * Copy constructor, disabled: the matrix is connected to trace sources.
+   * \param o the matrix to copy
+   */
+  PropagationMatrix (const PropagationMatrix &o);
+  /**
+   * Assignment, disabled: the matrix is connected to trace sources.
+   * \param o the matrix to copy
+   * \returns this matrix
+   */
+  PropagationMatrix &operator = (const PropagationMatrix &o);
+
+  /**
+   * Drop the rows when a model changes its course.
+   * \param mobility the model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility)
+  {
+    m_rows.clear ();
+  };
+
+  std::set<Ptr<MobilityModel> > m_watched; //!< the models watched
+  RowMap m_rows; //!< the rows
+  uint64_t m_hits; //!< number of rows found
+  uint64_t m_misses; //!< number of rows not found
+};
+} // namespace ns3
+
+#endif // PROPAGATION_MATRIX_H_
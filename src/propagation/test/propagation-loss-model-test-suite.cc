@@ -22,7 +22,12 @@
 #include "ns3/config.h"
 #include "ns3/double.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-cache.h"
+#include "ns3/propagation-matrix.h"
+#include "ns3/jakes-propagation-loss-model.h"
+#include "ns3/uinteger.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/simulator.h"
 
 using namespace ns3;
@@ -436,6 +441,180 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class PropagationCacheTestCase : public TestCase
+{
+public:
+  PropagationCacheTestCase ();
+  virtual ~PropagationCacheTestCase ();
+
+private:
+  /// Some path data
+  class PathData : public SimpleRefCount<PathData>
+  {
+  };
+
+  virtual void DoRun (void);
+  /// Check the time based eviction, at 5 seconds
+  void CheckExpiry (void);
+
+  std::vector<Ptr<MobilityModel> > m_models;
+  std::vector<Ptr<PathData> > m_data;
+  PropagationCache<PathData> m_cache;
+};
+
+PropagationCacheTestCase::PropagationCacheTestCase ()
+  : TestCase ("Check the bounded propagation cache")
+{
+}
+
+PropagationCacheTestCase::~PropagationCacheTestCase ()
+{
+}
+
+void
+PropagationCacheTestCase::CheckExpiry (void)
+{
+  // the path 0-1 was last used at 1 s, and the path 0-2 at 4 s
+  m_cache.SetMaxAge (Seconds (3.5));
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetSize (), 1, "The old path should have expired");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[0], m_models[1], 0), 0, "Expired path");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[2], m_models[0], 0), m_data[1], "Recent path");
+}
+
+void
+PropagationCacheTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_models.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      m_data.push_back (Create<PathData> ());
+    }
+
+  // symmetric paths
+  m_cache.AddPathData (m_data[0], m_models[0], m_models[1], 0);
+  m_cache.AddPathData (m_data[1], m_models[0], m_models[2], 0);
+  m_cache.AddPathData (m_data[2], m_models[0], m_models[1], 1);
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[1], m_models[0], 0), m_data[0], "Symmetric path");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[0], m_models[1], 1), m_data[2], "Other spectrum model");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[1], m_models[2], 0), 0, "Unknown path");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetHits (), 2, "Hits");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetMisses (), 1, "Misses");
+
+  // least recently used eviction: the path 0-2 was never used
+  m_cache.SetMaxSize (2);
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetSize (), 2, "Size after eviction");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[0], m_models[2], 0), 0, "Evicted path");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[0], m_models[1], 0), m_data[0], "Kept path");
+  m_cache.AddPathData (m_data[3], m_models[2], m_models[3], 0);
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetSize (), 2, "Size after insertion");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[0], m_models[1], 1), 0, "Evicted path");
+  NS_TEST_EXPECT_MSG_EQ (m_cache.GetPathData (m_models[3], m_models[2], 0), m_data[3], "Kept path");
+
+  // asymmetric paths
+  PropagationCache<PathData> directed;
+  directed.SetSymmetric (false);
+  directed.AddPathData (m_data[0], m_models[0], m_models[1], 0);
+  directed.AddPathData (m_data[1], m_models[1], m_models[0], 0);
+  NS_TEST_EXPECT_MSG_EQ (directed.GetPathData (m_models[0], m_models[1], 0), m_data[0], "Forward path");
+  NS_TEST_EXPECT_MSG_EQ (directed.GetPathData (m_models[1], m_models[0], 0), m_data[1], "Reverse path");
+
+  // time based eviction
+  m_cache.Clear ();
+  m_cache.SetMaxSize (0);
+  Simulator::Schedule (Seconds (1), &PropagationCache<PathData>::AddPathData, &m_cache,
+                       m_data[0], m_models[0], m_models[1], 0);
+  Simulator::Schedule (Seconds (2), &PropagationCache<PathData>::AddPathData, &m_cache,
+                       m_data[1], m_models[0], m_models[2], 0);
+  Simulator::Schedule (Seconds (4), &PropagationCache<PathData>::GetPathData, &m_cache,
+                       m_models[2], m_models[0], 0);
+  Simulator::Schedule (Seconds (5), &PropagationCacheTestCase::CheckExpiry, this);
+  Simulator::Run ();
+
+  // the counters of the models
+  Ptr<JakesPropagationLossModel> jakes = CreateObject<JakesPropagationLossModel> ();
+  jakes->CalcRxPower (0, m_models[0], m_models[1]);
+  jakes->CalcRxPower (0, m_models[1], m_models[0]);
+  jakes->CalcRxPower (0, m_models[1], m_models[2]);
+  UintegerValue hits, misses;
+  jakes->GetAttribute ("CacheHits", hits);
+  jakes->GetAttribute ("CacheMisses", misses);
+  NS_TEST_EXPECT_MSG_EQ (hits.Get (), 1, "Jakes cache hits");
+  NS_TEST_EXPECT_MSG_EQ (misses.Get (), 2, "Jakes cache misses");
+  jakes->SetAttribute ("CacheMaxSize", UintegerValue (1));
+  NS_TEST_EXPECT_MSG_EQ (jakes->GetCacheSize (), 1, "Bounded Jakes cache");
+  jakes->Dispose ();
+
+  m_cache.Clear ();
+  Simulator::Destroy ();
+}
+
+class PropagationMatrixTestCase : public TestCase
+{
+public:
+  PropagationMatrixTestCase ();
+  virtual ~PropagationMatrixTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PropagationMatrixTestCase::PropagationMatrixTestCase ()
+  : TestCase ("Check the invalidation of the propagation matrix")
+{
+}
+
+PropagationMatrixTestCase::~PropagationMatrixTestCase ()
+{
+}
+
+void
+PropagationMatrixTestCase::DoRun (void)
+{
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantVelocityMobilityModel> c = CreateObject<ConstantVelocityMobilityModel> ();
+  NS_TEST_EXPECT_MSG_EQ (PropagationMatrix<double>::IsMotionless (a), true, "Constant position");
+  NS_TEST_EXPECT_MSG_EQ (PropagationMatrix<double>::IsMotionless (0), true, "No mobility model");
+  NS_TEST_EXPECT_MSG_EQ (PropagationMatrix<double>::IsMotionless (c), true, "No velocity yet");
+  c->SetVelocity (Vector (1, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (PropagationMatrix<double>::IsMotionless (c), false, "Moving model");
+
+  PropagationMatrix<double> matrix;
+  matrix.Watch (a);
+  matrix.Watch (b);
+  matrix.Watch (b);
+  PropagationMatrix<double>::Link link;
+  link.m_rx = 1;
+  link.m_data = -60;
+  matrix.AddRow (PeekPointer (a), 0).push_back (link);
+  matrix.AddRow (PeekPointer (a), 1);
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetNRows (), 2, "Rows by transmitter and group");
+  const PropagationMatrix<double>::Row *row = matrix.GetRow (PeekPointer (a), 0);
+  NS_TEST_ASSERT_MSG_NE (row, 0, "Stored row");
+  NS_TEST_EXPECT_MSG_EQ (row->size (), 1, "Links of the row");
+  NS_TEST_EXPECT_MSG_EQ ((*row)[0].m_data, -60, "Data of the link");
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetRow (PeekPointer (b), 0), 0, "Unknown row");
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetHits (), 1, "Hits");
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetMisses (), 1, "Misses");
+
+  // an unwatched model does not invalidate the matrix
+  c->SetPosition (Vector (10, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetNRows (), 2, "Rows kept");
+  // a watched one does
+  b->SetPosition (Vector (10, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetNRows (), 0, "Rows dropped on course change");
+
+  matrix.AddRow (PeekPointer (a), 0);
+  matrix.Invalidate ();
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetNRows (), 0, "Rows dropped on invalidation");
+
+  // once cleared, the models are not watched any more
+  matrix.Clear ();
+  matrix.AddRow (PeekPointer (a), 0);
+  a->SetPosition (Vector (5, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (matrix.GetNRows (), 1, "Models not watched after Clear");
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +629,8 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new PropagationCacheTestCase, TestCase::QUICK);
+  AddTestCase (new PropagationMatrixTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
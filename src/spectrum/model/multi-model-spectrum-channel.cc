@@ -29,6 +29,7 @@
 #include <ns3/net-device.h>
 #include <ns3/node.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
 #include <ns3/mobility-model.h>
 #include <ns3/spectrum-phy.h>
 #include <ns3/spectrum-converter.h>
@@ -79,7 +80,9 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
-  : m_numDevices {0}
+  : m_numDevices {0},
+    m_maxRange (0),
+    m_staticTopology (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -90,6 +93,8 @@ MultiModelSpectrumChannel::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_rxIndexes.clear ();
+  m_matrix.Clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -100,7 +105,30 @@ MultiModelSpectrumChannel::GetTypeId (void)
     .SetParent<SpectrumChannel> ()
     .SetGroupName ("Spectrum")
     .AddConstructor<MultiModelSpectrumChannel> ()
-
+    .AddAttribute ("MaxRange",
+                   "The distance (m) beyond which the received power is "
+                   "assumed to be below the noise floor of any receiver. "
+                   "If positive, the channel only delivers a signal to the "
+                   "receivers within this distance of the transmitter, "
+                   "found with a spatial index of the receivers, and the "
+                   "loss to the other ones is not computed (nor reported "
+                   "by the Gain and PathLoss traces). Receivers without "
+                   "mobility model always get the signal. Zero disables "
+                   "the index.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("StaticTopology",
+                   "If true, the antenna gains, propagation loss and delay "
+                   "from a motionless transmitter to the motionless receivers "
+                   "are computed the first time it transmits, and kept until "
+                   "a mobility model of the receivers reports a course change. "
+                   "The propagation loss model must be deterministic: one "
+                   "which draws random variables aborts the simulation at the "
+                   "first transmission.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultiModelSpectrumChannel::m_staticTopology),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -116,6 +144,9 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
 
   SpectrumModelUid_t rxSpectrumModelUid = rxSpectrumModel->GetUid ();
 
+  // the rows of the matrix lack the new receiver
+  m_matrix.Invalidate ();
+
   // remove a previous entry of this phy if it exists
   // we need to scan for all rxSpectrumModel values since we don't
   // know which spectrum model the phy had when it was previously added
@@ -128,6 +159,8 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       if (phyIt != rxInfoIterator->second.m_rxPhys.end ())
         {
           rxInfoIterator->second.m_rxPhys.erase (phyIt);
+          // the positions of the following receivers changed
+          m_rxIndexes.erase (rxInfoIterator->first);
           --m_numDevices;
           break; // there should be at most one entry
         }       
@@ -260,10 +293,42 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
           convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
         }
 
-      for (auto rxPhyIterator = rxInfoIterator->second.m_rxPhys.begin ();
-           rxPhyIterator != rxInfoIterator->second.m_rxPhys.end ();
-           ++rxPhyIterator)
+      const std::vector<Ptr<SpectrumPhy> > &rxPhys = rxInfoIterator->second.m_rxPhys;
+      std::vector<uint32_t> inRange;
+      bool useIndex = m_maxRange > 0 && txMobility;
+      if (useIndex)
+        {
+          SpatialGridIndex &index = m_rxIndexes[rxSpectrumModelUid];
+          index.SetCellSize (m_maxRange);
+          while (index.GetN () < rxPhys.size ())
+            {
+              index.Add (rxPhys[index.GetN ()]->GetMobility ());
+            }
+          // sorted, to keep the order of rxPhys
+          index.GetInRange (txMobility->GetPosition (), m_maxRange, inRange);
+        }
+      const Matrix::Row *row = 0;
+      if (m_staticTopology && txMobility && Matrix::IsMotionless (txMobility))
+        {
+          row = m_matrix.GetRow (PeekPointer (txParams->txPhy), rxSpectrumModelUid);
+          if (row == 0)
+            {
+              if (!useIndex)
+                {
+                  for (uint32_t k = 0; k < rxPhys.size (); ++k)
+                    {
+                      inRange.push_back (k);
+                    }
+                }
+              row = &AddRow (txParams, txMobility, rxSpectrumModelUid, rxPhys, inRange);
+            }
+        }
+
+      std::size_t nRx = row ? row->size () : (useIndex ? inRange.size () : rxPhys.size ());
+      for (std::size_t k = 0; k < nRx; ++k)
         {
+          std::size_t rxIndex = row ? (*row)[k].m_rx : (useIndex ? inRange[k] : k);
+          std::vector<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxPhys.begin () + rxIndex;
           NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
                          "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
 
@@ -278,34 +343,20 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
               if (txMobility && receiverMobility)
                 {
-                  double txAntennaGain = 0;
-                  double rxAntennaGain = 0;
-                  double propagationGainDb = 0;
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
+                  Propagation propagation;
+                  if (row && (*row)[k].m_data.motionless)
                     {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
+                      propagation = (*row)[k].m_data;
                     }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
+                  else
                     {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
+                      propagation = CalcPropagation (rxParams, txMobility, receiverMobility, *rxPhyIterator);
                     }
-                  if (m_propagationLoss)
-                    {
-                      propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
+                  double pathLossDb = -propagation.txAntennaGain - propagation.rxAntennaGain - propagation.propagationGainDb;
                   NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
                   // Gain trace
-                  m_gainTrace (txMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
+                  m_gainTrace (txMobility, receiverMobility, propagation.txAntennaGain, propagation.rxAntennaGain,
+                               propagation.propagationGainDb, pathLossDb);
                   // Pathloss trace
                   m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
                   if (pathLossDb > m_maxLossDb)
@@ -321,10 +372,7 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                       rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
                     }
 
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
+                  delay = propagation.delay;
                 }
 
               Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
@@ -348,6 +396,81 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
 }
 
+MultiModelSpectrumChannel::Propagation
+MultiModelSpectrumChannel::CalcPropagation (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                            Ptr<MobilityModel> receiverMobility, Ptr<SpectrumPhy> receiver) const
+{
+  Propagation propagation;
+  propagation.txAntennaGain = 0;
+  propagation.rxAntennaGain = 0;
+  propagation.propagationGainDb = 0;
+  propagation.delay = MicroSeconds (0);
+  propagation.motionless = Matrix::IsMotionless (receiverMobility);
+  if (txParams->txAntenna != 0)
+    {
+      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+      propagation.txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
+      NS_LOG_LOGIC ("txAntennaGain = " << propagation.txAntennaGain << " dB");
+    }
+  Ptr<AntennaModel> rxAntenna = receiver->GetRxAntenna ();
+  if (rxAntenna != 0)
+    {
+      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+      propagation.rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+      NS_LOG_LOGIC ("rxAntennaGain = " << propagation.rxAntennaGain << " dB");
+    }
+  if (m_propagationLoss)
+    {
+      propagation.propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+      NS_LOG_LOGIC ("propagationGainDb = " << propagation.propagationGainDb << " dB");
+    }
+  if (m_propagationDelay)
+    {
+      propagation.delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+    }
+  return propagation;
+}
+
+const MultiModelSpectrumChannel::Matrix::Row &
+MultiModelSpectrumChannel::AddRow (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                   SpectrumModelUid_t rxSpectrumModelUid, const std::vector<Ptr<SpectrumPhy> > &rxPhys,
+                                   const std::vector<uint32_t> &candidates)
+{
+  NS_LOG_FUNCTION (this << txParams->txPhy << rxSpectrumModelUid);
+  Matrix::CheckDeterministic (m_propagationLoss);
+  // a receiver moving into the range of the transmitter also changes its row
+  m_matrix.Watch (txMobility);
+  for (std::vector<Ptr<SpectrumPhy> >::const_iterator it = rxPhys.begin (); it != rxPhys.end (); ++it)
+    {
+      m_matrix.Watch ((*it)->GetMobility ());
+    }
+
+  Matrix::Row &row = m_matrix.AddRow (PeekPointer (txParams->txPhy), rxSpectrumModelUid);
+  for (std::vector<uint32_t>::const_iterator it = candidates.begin (); it != candidates.end (); ++it)
+    {
+      Ptr<SpectrumPhy> receiver = rxPhys[*it];
+      if (receiver == txParams->txPhy)
+        {
+          continue;
+        }
+      Matrix::Link link;
+      link.m_rx = *it;
+      link.m_data.motionless = false;
+      Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+      if (receiverMobility && Matrix::IsMotionless (receiverMobility))
+        {
+          link.m_data = CalcPropagation (txParams, txMobility, receiverMobility, receiver);
+          if (-link.m_data.txAntennaGain - link.m_data.rxAntennaGain - link.m_data.propagationGainDb > m_maxLossDb)
+            {
+              continue;
+            }
+        }
+      row.push_back (link);
+    }
+  NS_LOG_DEBUG ("transmitter " << txParams->txPhy << " reaches " << row.size () << " receivers");
+  return row;
+}
+
 void
 MultiModelSpectrumChannel::StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
 {
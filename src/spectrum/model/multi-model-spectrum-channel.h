@@ -27,6 +27,9 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/spatial-grid-index.h>
+#include <ns3/propagation-matrix.h>
+#include <ns3/nstime.h>
 #include <map>
 #include <set>
 
@@ -102,6 +105,23 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * If the MaxRange attribute is set, the channel indexes the receivers
+ * of each RX SpectrumModel by position (see ns3::SpatialGridIndex) and
+ * only delivers a signal to the receivers within MaxRange of the
+ * transmitter, without computing the loss to the others.
+ *
+ * If the StaticTopology attribute is set, the antenna gains, the
+ * propagation loss and the propagation delay from a motionless
+ * transmitter to the motionless receivers are computed the first time
+ * it transmits, and kept in a PropagationMatrix until a mobility model
+ * of the receivers reports a course change or a receiver is added.  The
+ * receivers beyond MaxLossDb are left out of the matrix, and the Gain
+ * and PathLoss traces report the stored values.  The propagation loss
+ * model must then be deterministic (the models which draw random
+ * variables are rejected when the first row is computed), and the
+ * antennas must not be reoriented; the SpectrumPropagationLossModel is still computed for
+ * each signal.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -149,6 +169,45 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /// The propagation from a transmitter to a receiver
+  struct Propagation
+  {
+    double txAntennaGain;     //!< Gain of the transmit antenna, in dB
+    double rxAntennaGain;     //!< Gain of the receive antenna, in dB
+    double propagationGainDb; //!< Gain of the propagation loss model, in dB
+    Time delay;               //!< Propagation delay
+    bool motionless;          //!< False if the receiver moves: the propagation is not stored
+  };
+  /// The propagation from the motionless transmitters to their receivers
+  typedef PropagationMatrix<Propagation> Matrix;
+
+  /**
+   * Compute the propagation from a transmitter to a receiver.
+   *
+   * \param txParams the signal parameters
+   * \param txMobility the mobility model of the transmitter
+   * \param receiverMobility the mobility model of the receiver
+   * \param receiver the receiver
+   * \return the propagation
+   */
+  Propagation CalcPropagation (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                               Ptr<MobilityModel> receiverMobility, Ptr<SpectrumPhy> receiver) const;
+
+  /**
+   * Compute the row of the propagation matrix of a transmitter, for the
+   * receivers of an RX SpectrumModel.
+   *
+   * \param txParams the signal parameters
+   * \param txMobility the mobility model of the transmitter
+   * \param rxSpectrumModelUid the UID of the RX SpectrumModel
+   * \param rxPhys the receivers of the RX SpectrumModel
+   * \param candidates the indexes of the receivers to consider in \p rxPhys
+   * \return the row
+   */
+  const Matrix::Row & AddRow (Ptr<const SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                              SpectrumModelUid_t rxSpectrumModelUid, const std::vector<Ptr<SpectrumPhy> > &rxPhys,
+                              const std::vector<uint32_t> &candidates);
+
   /**
    * Data structure holding, for each TX SpectrumModel,  all the
    * converters to any RX SpectrumModel, and all the corresponding
@@ -169,6 +228,31 @@ private:
    */
   std::size_t m_numDevices;
 
+  /**
+   * Distance beyond which the receivers are not reached, or zero.
+   */
+  double m_maxRange;
+
+  /**
+   * For each RX SpectrumModel, the positions of the receivers, by index
+   * in RxSpectrumModelInfo::m_rxPhys.  The receivers are added lazily
+   * by StartTx, and the index is rebuilt when a receiver is removed.
+   */
+  std::map<SpectrumModelUid_t, SpatialGridIndex> m_rxIndexes;
+
+  /**
+   * Whether the propagation from the motionless transmitters is stored
+   * in m_matrix.
+   */
+  bool m_staticTopology;
+
+  /**
+   * The propagation from the transmitters, by transmitting SpectrumPhy
+   * and RX SpectrumModel, to the receivers, by index in
+   * RxSpectrumModelInfo::m_rxPhys.
+   */
+  Matrix m_matrix;
+
 };
 
 
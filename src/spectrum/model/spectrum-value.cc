@@ -23,10 +23,170 @@
 #include <ns3/math.h>
 #include <ns3/log.h>
 
+#if defined (__SSE2__) || defined (__AVX__)
+#include <immintrin.h>
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("SpectrumValue");
 
+namespace {
+
+/*
+ * Element-wise kernels on the value arrays.  Every component is
+ * computed with a single IEEE operation, so the SSE2 (always available
+ * on x86-64) and AVX (when enabled by the compiler flags) versions give
+ * exactly the same results as the scalar loops, which handle the other
+ * architectures and the last components.
+ */
+
+/// Addition
+struct AddOp
+{
+  static double Apply (double a, double b)
+  {
+    return a + b;
+  }
+#ifdef __SSE2__
+  static __m128d Apply (__m128d a, __m128d b)
+  {
+    return _mm_add_pd (a, b);
+  }
+#endif
+#ifdef __AVX__
+  static __m256d Apply (__m256d a, __m256d b)
+  {
+    return _mm256_add_pd (a, b);
+  }
+#endif
+};
+
+/// Subtraction
+struct SubtractOp
+{
+  static double Apply (double a, double b)
+  {
+    return a - b;
+  }
+#ifdef __SSE2__
+  static __m128d Apply (__m128d a, __m128d b)
+  {
+    return _mm_sub_pd (a, b);
+  }
+#endif
+#ifdef __AVX__
+  static __m256d Apply (__m256d a, __m256d b)
+  {
+    return _mm256_sub_pd (a, b);
+  }
+#endif
+};
+
+/// Multiplication
+struct MultiplyOp
+{
+  static double Apply (double a, double b)
+  {
+    return a * b;
+  }
+#ifdef __SSE2__
+  static __m128d Apply (__m128d a, __m128d b)
+  {
+    return _mm_mul_pd (a, b);
+  }
+#endif
+#ifdef __AVX__
+  static __m256d Apply (__m256d a, __m256d b)
+  {
+    return _mm256_mul_pd (a, b);
+  }
+#endif
+};
+
+/// Division
+struct DivideOp
+{
+  static double Apply (double a, double b)
+  {
+    return a / b;
+  }
+#ifdef __SSE2__
+  static __m128d Apply (__m128d a, __m128d b)
+  {
+    return _mm_div_pd (a, b);
+  }
+#endif
+#ifdef __AVX__
+  static __m256d Apply (__m256d a, __m256d b)
+  {
+    return _mm256_div_pd (a, b);
+  }
+#endif
+};
+
+/**
+ * x[i] = x[i] OP y[i]
+ * \param x the left operand and result
+ * \param y the right operand
+ * \param n the number of components
+ */
+template <class OP>
+void
+ApplyKernel (double *x, const double *y, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __AVX__
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (x + i, OP::Apply (_mm256_loadu_pd (x + i), _mm256_loadu_pd (y + i)));
+    }
+#endif
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (x + i, OP::Apply (_mm_loadu_pd (x + i), _mm_loadu_pd (y + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      x[i] = OP::Apply (x[i], y[i]);
+    }
+}
+
+/**
+ * x[i] = x[i] OP s
+ * \param x the left operand and result
+ * \param s the right operand
+ * \param n the number of components
+ */
+template <class OP>
+void
+ApplyKernel (double *x, double s, std::size_t n)
+{
+  std::size_t i = 0;
+#ifdef __AVX__
+  __m256d s4 = _mm256_set1_pd (s);
+  for (; i + 4 <= n; i += 4)
+    {
+      _mm256_storeu_pd (x + i, OP::Apply (_mm256_loadu_pd (x + i), s4));
+    }
+#endif
+#ifdef __SSE2__
+  __m128d s2 = _mm_set1_pd (s);
+  for (; i + 2 <= n; i += 2)
+    {
+      _mm_storeu_pd (x + i, OP::Apply (_mm_loadu_pd (x + i), s2));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      x[i] = OP::Apply (x[i], s);
+    }
+}
+
+} // anonymous namespace
+
 SpectrumValue::SpectrumValue ()
 {
 }
@@ -106,31 +266,16 @@ SpectrumValue::ConstBandsEnd () const
 void
 SpectrumValue::Add (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 += *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () <= x.m_values.size ());
+  ApplyKernel<AddOp> (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
 void
 SpectrumValue::Add (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 += s;
-      ++it1;
-    }
+  ApplyKernel<AddOp> (m_values.data (), s, m_values.size ());
 }
 
 
@@ -138,18 +283,9 @@ SpectrumValue::Add (double s)
 void
 SpectrumValue::Subtract (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 -= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () <= x.m_values.size ());
+  ApplyKernel<SubtractOp> (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
@@ -164,31 +300,16 @@ SpectrumValue::Subtract (double s)
 void
 SpectrumValue::Multiply (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 *= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () <= x.m_values.size ());
+  ApplyKernel<MultiplyOp> (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
 void
 SpectrumValue::Multiply (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 *= s;
-      ++it1;
-    }
+  ApplyKernel<MultiplyOp> (m_values.data (), s, m_values.size ());
 }
 
 
@@ -197,18 +318,9 @@ SpectrumValue::Multiply (double s)
 void
 SpectrumValue::Divide (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 /= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () <= x.m_values.size ());
+  ApplyKernel<DivideOp> (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
@@ -216,13 +328,7 @@ void
 SpectrumValue::Divide (double s)
 {
   NS_LOG_FUNCTION (this << s);
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 /= s;
-      ++it1;
-    }
+  ApplyKernel<DivideOp> (m_values.data (), s, m_values.size ());
 }
 
 
@@ -403,6 +509,57 @@ Integral (const SpectrumValue& arg)
   return i;
 }
 
+void
+ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals,
+             const SpectrumValue& noise, SpectrumValue& interference,
+             SpectrumValue& sinr)
+{
+  NS_ASSERT (signal.m_spectrumModel == allSignals.m_spectrumModel);
+  NS_ASSERT (signal.m_spectrumModel == noise.m_spectrumModel);
+  std::size_t n = signal.m_values.size ();
+  NS_ASSERT (allSignals.m_values.size () == n && noise.m_values.size () == n);
+  if (interference.m_spectrumModel != signal.m_spectrumModel)
+    {
+      interference.m_spectrumModel = signal.m_spectrumModel;
+      interference.m_values.resize (n);
+    }
+  if (sinr.m_spectrumModel != signal.m_spectrumModel)
+    {
+      sinr.m_spectrumModel = signal.m_spectrumModel;
+      sinr.m_values.resize (n);
+    }
+  const double *s = signal.m_values.data ();
+  const double *a = allSignals.m_values.data ();
+  const double *w = noise.m_values.data ();
+  double *in = interference.m_values.data ();
+  double *out = sinr.m_values.data ();
+  // same operation order as (allSignals - signal + noise)
+  std::size_t i = 0;
+#ifdef __AVX__
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256d s4 = _mm256_loadu_pd (s + i);
+      __m256d i4 = _mm256_add_pd (_mm256_sub_pd (_mm256_loadu_pd (a + i), s4), _mm256_loadu_pd (w + i));
+      _mm256_storeu_pd (in + i, i4);
+      _mm256_storeu_pd (out + i, _mm256_div_pd (s4, i4));
+    }
+#endif
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d s2 = _mm_loadu_pd (s + i);
+      __m128d i2 = _mm_add_pd (_mm_sub_pd (_mm_loadu_pd (a + i), s2), _mm_loadu_pd (w + i));
+      _mm_storeu_pd (in + i, i2);
+      _mm_storeu_pd (out + i, _mm_div_pd (s2, i2));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      in[i] = a[i] - s[i] + w[i];
+      out[i] = s[i] / in[i];
+    }
+}
+
 
 
 Ptr<SpectrumValue>
@@ -467,9 +624,8 @@ operator+ (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator- (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.ChangeSign ();
-  res.Add (lhs);
+  SpectrumValue res = lhs;
+  res.Subtract (rhs);
   return res;
 }
 
@@ -508,6 +508,25 @@ public:
    */
   friend double Integral (const SpectrumValue&  arg);
 
+  /**
+   * Compute, in a single pass and without temporary SpectrumValue,
+   * the interference plus noise and the SINR of a signal:
+   * \f$ I = A - S + N \f$ and \f$ SINR = S / I \f$, component by
+   * component.  The results are the same as with the arithmetic
+   * operators.  The outputs are given the SpectrumModel of the signal
+   * if they do not have it already, so that reusing them across calls
+   * does not allocate memory.
+   *
+   * @param signal the signal S
+   * @param allSignals the sum A of all the signals, including S
+   * @param noise the noise N
+   * @param interference the interference plus noise I
+   * @param sinr the SINR
+   */
+  friend void ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals,
+                           const SpectrumValue& noise, SpectrumValue& interference,
+                           SpectrumValue& sinr);
+
   /**
    *
    * @return a Ptr to a copy of this instance
@@ -630,6 +649,9 @@ SpectrumValue Log10 (const SpectrumValue& arg);
 SpectrumValue Log2 (const SpectrumValue& arg);
 SpectrumValue Log (const SpectrumValue& arg);
 double Integral (const SpectrumValue& arg);
+void ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals,
+                  const SpectrumValue& noise, SpectrumValue& interference,
+                  SpectrumValue& sinr);
 
 
 } // namespace ns3
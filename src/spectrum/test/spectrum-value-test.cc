@@ -82,6 +82,73 @@ SpectrumValueTestCase::DoRun (void)
 
 
 
+// Check the arithmetic kernels and ComputeSinr against component by
+// component computations, for sizes covering the vectorized parts and
+// the remaining components.
+class SpectrumValueKernelTestCase : public TestCase
+{
+public:
+  SpectrumValueKernelTestCase ();
+  virtual void DoRun (void);
+};
+
+SpectrumValueKernelTestCase::SpectrumValueKernelTestCase ()
+  : TestCase ("SpectrumValue kernels")
+{
+}
+
+void
+SpectrumValueKernelTestCase::DoRun (void)
+{
+  for (uint32_t n = 1; n <= 19; n++)
+    {
+      std::vector<double> freqs;
+      for (uint32_t i = 0; i <= n; i++)
+        {
+          freqs.push_back (1e9 + i * 1e6);
+        }
+      Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+      SpectrumValue a (model), b (model), noise (model);
+      for (uint32_t i = 0; i < a.GetValuesN (); i++)
+        {
+          a[i] = 1e-12 * (i + 1) + 3e-13 * (i % 3);
+          b[i] = 2e-13 * (n - i) + 1e-14;
+          noise[i] = 4e-15 * (i + 7);
+        }
+      uint32_t size = a.GetValuesN ();
+
+      SpectrumValue sum = a + b, diff = a - b, prod = a * b, quot = a / b;
+      SpectrumValue sumS = a + 0.7, prodS = a * 0.7, quotS = a / 0.7;
+      SpectrumValue all = a + b;
+      SpectrumValue interference, sinr;
+      ComputeSinr (a, all, noise, interference, sinr);
+      NS_TEST_ASSERT_MSG_EQ (sinr.GetValuesN (), size, "SINR size");
+      NS_TEST_ASSERT_MSG_EQ (interference.GetValuesN (), size, "interference size");
+      NS_TEST_ASSERT_MSG_EQ (sinr.GetSpectrumModelUid (), model->GetUid (), "SINR model");
+      SpectrumValue expectedSinr = a / (all - a + noise);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          // the kernels must give the same results as scalar operations
+          NS_TEST_ASSERT_MSG_EQ (sum[i], a[i] + b[i], "sum, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (diff[i], a[i] - b[i], "difference, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (prod[i], a[i] * b[i], "product, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (quot[i], a[i] / b[i], "quotient, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (sumS[i], a[i] + 0.7, "scalar sum, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (prodS[i], a[i] * 0.7, "scalar product, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (quotS[i], a[i] / 0.7, "scalar quotient, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (interference[i], all[i] - a[i] + noise[i], "interference, component " << i << " of " << size);
+          NS_TEST_ASSERT_MSG_EQ (sinr[i], expectedSinr[i], "SINR, component " << i << " of " << size);
+        }
+
+      // the outputs are reused without reallocation
+      const double *sinrData = &sinr[0];
+      ComputeSinr (b, all, noise, interference, sinr);
+      NS_TEST_ASSERT_MSG_EQ ((&sinr[0] == sinrData), true, "SINR storage reused");
+      NS_TEST_ASSERT_MSG_EQ (sinr[size - 1], b[size - 1] / (all[size - 1] - b[size - 1] + noise[size - 1]), "SINR of b");
+    }
+}
+
+
 class SpectrumValueTestSuite : public TestSuite
 {
 public:
@@ -241,6 +308,8 @@ SpectrumValueTestSuite::SpectrumValueTestSuite ()
   tv1rs3 = v1 >> 3;
   AddTestCase (new SpectrumValueTestCase (tv1rs3, v1rs3, "tv1rs3 = v1 >> 3"), TestCase::QUICK);
 
+  AddTestCase (new SpectrumValueKernelTestCase, TestCase::QUICK);
+
 
 }
 
@@ -0,0 +1,321 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/fluid-bulk-send-helper.h"
+#include "ns3/fluid-bulk-send-application.h"
+#include "ns3/fluid-flow-manager.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Dumbbell topology for the fluid flow tests
+ *
+ * Nodes 0 and 1 reach node 3 through node 2, on 100 Mbps access links
+ * and a 10 Mbps bottleneck, all with a delay of 1 ms.
+ */
+class FluidFlowTopology
+{
+public:
+  FluidFlowTopology ();
+
+  NodeContainer nodes;                //!< The nodes
+  Ptr<NetDevice> bottleneck;          //!< The device of node 2 towards node 3
+  Ipv4Address sink;                   //!< The address of node 3
+};
+
+FluidFlowTopology::FluidFlowTopology ()
+{
+  nodes.Create (4);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  Ipv4AddressHelper address ("10.1.1.0", "255.255.255.0");
+
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  address.Assign (p2p.Install (nodes.Get (0), nodes.Get (2)));
+  address.NewNetwork ();
+  address.Assign (p2p.Install (nodes.Get (1), nodes.Get (2)));
+  address.NewNetwork ();
+
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  NetDeviceContainer devices = p2p.Install (nodes.Get (2), nodes.Get (3));
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  bottleneck = devices.Get (0);
+  sink = interfaces.GetAddress (1);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+}
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Check the max-min fair rates of the fluid flows
+ */
+class FluidFlowRateTestCase : public TestCase
+{
+public:
+  FluidFlowRateTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Check the rates of the flows and the load of the bottleneck
+   * \param expectedA the expected rate of the first flow, in bit/s
+   * \param expectedB the expected rate of the second flow, in bit/s
+   */
+  void CheckRates (double expectedA, double expectedB);
+
+  Ptr<FluidBulkSendApplication> m_flowA; //!< Unlimited flow from node 0
+  Ptr<FluidBulkSendApplication> m_flowB; //!< Flow from node 1, limited to 1 Mbps
+  Ptr<NetDevice> m_bottleneck;           //!< The bottleneck device
+};
+
+FluidFlowRateTestCase::FluidFlowRateTestCase ()
+  : TestCase ("Max-min fair rates of the fluid flows")
+{
+}
+
+void
+FluidFlowRateTestCase::CheckRates (double expectedA, double expectedB)
+{
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_flowA->GetRate ().GetBitRate (), expectedA, 1,
+                             "Wrong rate of the unlimited flow");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_flowB->GetRate ().GetBitRate (), expectedB, 1,
+                             "Wrong rate of the limited flow");
+  NS_TEST_ASSERT_MSG_EQ_TOL (FluidFlowManager::GetLoad (m_bottleneck).GetBitRate (), expectedA + expectedB, 2,
+                             "Wrong load of the bottleneck");
+}
+
+void
+FluidFlowRateTestCase::DoRun (void)
+{
+  FluidFlowTopology topology;
+  m_bottleneck = topology.bottleneck;
+
+  FluidBulkSendHelper fluid (InetSocketAddress (topology.sink, 9));
+  m_flowA = DynamicCast<FluidBulkSendApplication> (fluid.Install (topology.nodes.Get (0)).Get (0));
+  fluid.SetAttribute ("MaxRate", DataRateValue (DataRate ("1Mbps")));
+  ApplicationContainer flowB = fluid.Install (topology.nodes.Get (1));
+  m_flowB = DynamicCast<FluidBulkSendApplication> (flowB.Get (0));
+  flowB.Stop (Seconds (2));
+
+  // The packet traffic of the bottleneck keeps one share of 10 Mbps;
+  // the limited flow gets 1 Mbps and the unlimited one half of the rest.
+  Simulator::Schedule (Seconds (1), &FluidFlowRateTestCase::CheckRates, this, 4.5e6, 1e6);
+  // Alone, the unlimited flow shares the bottleneck with the packets
+  Simulator::Schedule (Seconds (3), &FluidFlowRateTestCase::CheckRates, this, 5e6, 0);
+
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_flowB->GetTotalBytes (), 2 * 1e6 / 8, 1, "Wrong number of bytes sent");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Check that a fluid flow stops after MaxBytes
+ */
+class FluidFlowMaxBytesTestCase : public TestCase
+{
+public:
+  FluidFlowMaxBytesTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Trace the rate changes of the flow
+   * \param oldRate the previous rate
+   * \param newRate the new rate
+   */
+  void RateChange (DataRate oldRate, DataRate newRate);
+
+  Time m_finish; //!< Time the flow stopped
+};
+
+FluidFlowMaxBytesTestCase::FluidFlowMaxBytesTestCase ()
+  : TestCase ("Fluid flow stopping after MaxBytes")
+{
+}
+
+void
+FluidFlowMaxBytesTestCase::RateChange (DataRate oldRate, DataRate newRate)
+{
+  if (newRate.GetBitRate () == 0)
+    {
+      m_finish = Simulator::Now ();
+    }
+}
+
+void
+FluidFlowMaxBytesTestCase::DoRun (void)
+{
+  FluidFlowTopology topology;
+
+  FluidBulkSendHelper fluid (InetSocketAddress (topology.sink, 9));
+  fluid.SetAttribute ("MaxBytes", UintegerValue (1000000));
+  ApplicationContainer apps = fluid.Install (topology.nodes.Get (0));
+  apps.Start (Seconds (1));
+  Ptr<FluidBulkSendApplication> flow = DynamicCast<FluidBulkSendApplication> (apps.Get (0));
+  flow->TraceConnectWithoutContext ("Rate", MakeCallback (&FluidFlowMaxBytesTestCase::RateChange, this));
+
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  // 1 MB at 5 Mbps takes 1.6 s
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_finish.GetSeconds (), 2.6, 1e-6, "Wrong completion time");
+  NS_TEST_ASSERT_MSG_EQ (flow->GetTotalBytes (), 1000000, "Wrong number of bytes sent");
+  NS_TEST_ASSERT_MSG_EQ (FluidFlowManager::GetLoad (topology.bottleneck).GetBitRate (), 0,
+                         "The bottleneck is still loaded");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Check the delay of the packets crossing a fluid flow
+ */
+class FluidFlowPacketDelayTestCase : public TestCase
+{
+public:
+  FluidFlowPacketDelayTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Measure the one-way delay of a packet from node 1 to node 3
+   * \param fluidFlow whether a fluid flow crosses the bottleneck
+   * \return the delay of the packet
+   */
+  Time MeasureDelay (bool fluidFlow);
+  /**
+   * \brief Send the packet
+   * \param socket the sending socket
+   */
+  void Send (Ptr<Socket> socket);
+  /**
+   * \brief Receive the packet
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  Time m_received; //!< Time the packet was received
+};
+
+FluidFlowPacketDelayTestCase::FluidFlowPacketDelayTestCase ()
+  : TestCase ("Packet delay with fluid flows")
+{
+}
+
+void
+FluidFlowPacketDelayTestCase::Send (Ptr<Socket> socket)
+{
+  socket->Send (Create<Packet> (1000));
+}
+
+void
+FluidFlowPacketDelayTestCase::Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      m_received = Simulator::Now ();
+    }
+}
+
+Time
+FluidFlowPacketDelayTestCase::MeasureDelay (bool fluidFlow)
+{
+  FluidFlowTopology topology;
+
+  if (fluidFlow)
+    {
+      FluidBulkSendHelper fluid (InetSocketAddress (topology.sink, 9));
+      fluid.Install (topology.nodes.Get (0));
+    }
+
+  Ptr<Socket> sink = Socket::CreateSocket (topology.nodes.Get (3), UdpSocketFactory::GetTypeId ());
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 10));
+  sink->SetRecvCallback (MakeCallback (&FluidFlowPacketDelayTestCase::Receive, this));
+  Ptr<Socket> source = Socket::CreateSocket (topology.nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  source->Connect (InetSocketAddress (topology.sink, 10));
+  Simulator::Schedule (Seconds (1), &FluidFlowPacketDelayTestCase::Send, this, source);
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_received - Seconds (1);
+}
+
+void
+FluidFlowPacketDelayTestCase::DoRun (void)
+{
+  Time reference = MeasureDelay (false);
+  Time delay = MeasureDelay (true);
+
+  // The fluid flow keeps half of the 100 packets queue of the bottleneck
+  // occupied, and leaves it half of its 10 Mbps.  The 1030 bytes packet
+  // waits behind the queue and takes twice as long to transmit.
+  double queueDelay = 0.5 * 100 * (1500 + 2) * 8 / 10e6;
+  double txDelay = 1030 * 8 / 5e6 - 1030 * 8 / 10e6;
+  NS_TEST_ASSERT_MSG_EQ_TOL ((delay - reference).GetSeconds (), queueDelay + txDelay, 1e-6,
+                             "Wrong delay induced by the fluid flow");
+}
+
+/**
+ * \ingroup system-tests-fluid
+ *
+ * \brief Fluid flow TestSuite
+ */
+class FluidFlowSystemTestSuite : public TestSuite
+{
+public:
+  FluidFlowSystemTestSuite ();
+};
+
+FluidFlowSystemTestSuite::FluidFlowSystemTestSuite ()
+  : TestSuite ("fluid-flow-system", SYSTEM)
+{
+  AddTestCase (new FluidFlowRateTestCase, TestCase::QUICK);
+  AddTestCase (new FluidFlowMaxBytesTestCase, TestCase::QUICK);
+  AddTestCase (new FluidFlowPacketDelayTestCase, TestCase::QUICK);
+}
+
+static FluidFlowSystemTestSuite g_fluidFlowSystemTestSuite; //!< Static variable for test initialization
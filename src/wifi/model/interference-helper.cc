@@ -199,6 +199,10 @@ void
 InterferenceHelper::AppendEvent (Ptr<Event> event)
 {
   NS_LOG_FUNCTION (this);
+  m_eventEnds.insert (std::make_pair (event->GetEndTime (), event->GetStartTime ()));
+  m_eventStarts.insert (event->GetStartTime ());
+  EraseExpiredNiChanges ();
+
   double previousPowerStart = 0;
   double previousPowerEnd = 0;
   previousPowerStart = GetPreviousPosition (event->GetStartTime ())->second.GetPower ();
@@ -235,22 +239,28 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint1
 }
 
 double
-InterferenceHelper::CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNoiseInterferenceW (Ptr<Event> event, NiChangesRange *ni) const
 {
   double noiseInterferenceW = m_firstPower;
-  auto it = m_niChanges.find (event->GetStartTime ());
-  for (; it != m_niChanges.end () && it->first < Simulator::Now (); ++it)
+  // The last change before now, unless it is before the start of the
+  // event, gives the power of the noise and interference now
+  auto it = m_niChanges.lower_bound (Simulator::Now ());
+  if (it != m_niChanges.begin () && (--it)->first >= event->GetStartTime ())
     {
       noiseInterferenceW = it->second.GetPower () - event->GetRxPowerW ();
     }
-  it = m_niChanges.find (event->GetStartTime ());
-  for (; it != m_niChanges.end () && it->second.GetEvent () != event; ++it);
-  ni->emplace (event->GetStartTime (), NiChange (0, event));
-  while (++it != m_niChanges.end () && it->second.GetEvent () != event)
+  auto first = m_niChanges.find (event->GetStartTime ());
+  for (; first != m_niChanges.end () && first->second.GetEvent () != event; ++first);
+  NS_ASSERT_MSG (first != m_niChanges.end (), "No NI change at the start of the event");
+  auto last = std::next (first);
+  if (last != m_niChanges.end () && last->first < event->GetEndTime ())
     {
-      ni->insert (*it);
+      last = m_niChanges.lower_bound (event->GetEndTime ());
     }
-  ni->emplace (event->GetEndTime (), NiChange (0, event));
+  for (; last != m_niChanges.end () && last->second.GetEvent () != event; ++last);
+  NS_ASSERT_MSG (last != m_niChanges.end (), "No NI change at the end of the event");
+  ni->first = first;
+  ni->second = ++last;
   NS_ASSERT_MSG (noiseInterferenceW >= 0, "CalculateNoiseInterferenceW returns negative value " << noiseInterferenceW);
   return noiseInterferenceW;
 }
@@ -278,12 +288,12 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
 }
 
 double
-InterferenceHelper::CalculatePayloadPer (Ptr<const Event> event, NiChanges *ni, std::pair<Time, Time> window) const
+InterferenceHelper::CalculatePayloadPer (Ptr<const Event> event, const NiChangesRange &ni, std::pair<Time, Time> window) const
 {
   NS_LOG_FUNCTION (this << window.first << window.second);
   const WifiTxVector txVector = event->GetTxVector ();
   double psr = 1.0; /* Packet Success Rate */
-  auto j = ni->begin ();
+  auto j = ni.first;
   Time previous = j->first;
   WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = txVector.GetPreambleType ();
@@ -295,7 +305,7 @@ InterferenceHelper::CalculatePayloadPer (Ptr<const Event> event, NiChanges *ni,
   Time windowEnd = plcpPayloadStart + window.second;
   double noiseInterferenceW = m_firstPower;
   double powerW = event->GetRxPowerW ();
-  while (++j != ni->end ())
+  while (++j != ni.second)
     {
       Time current = j->first;
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
@@ -334,12 +344,12 @@ InterferenceHelper::CalculatePayloadPer (Ptr<const Event> event, NiChanges *ni,
 }
 
 double
-InterferenceHelper::CalculateLegacyPhyHeaderPer (Ptr<const Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateLegacyPhyHeaderPer (Ptr<const Event> event, const NiChangesRange &ni) const
 {
   NS_LOG_FUNCTION (this);
   const WifiTxVector txVector = event->GetTxVector ();
   double psr = 1.0; /* Packet Success Rate */
-  auto j = ni->begin ();
+  auto j = ni.first;
   Time previous = j->first;
   WifiPreamble preamble = txVector.GetPreambleType ();
   WifiMode headerMode = WifiPhy::GetPlcpHeaderMode (txVector);
@@ -349,7 +359,7 @@ InterferenceHelper::CalculateLegacyPhyHeaderPer (Ptr<const Event> event, NiChang
   Time plcpPayloadStart = plcpTrainingSymbolsStart + WifiPhy::GetPlcpTrainingSymbolDuration (txVector) + WifiPhy::GetPlcpSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or SIG-A + Training + SIG-B
   double noiseInterferenceW = m_firstPower;
   double powerW = event->GetRxPowerW ();
-  while (++j != ni->end ())
+  while (++j != ni.second)
     {
       Time current = j->first;
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
@@ -478,12 +488,12 @@ InterferenceHelper::CalculateLegacyPhyHeaderPer (Ptr<const Event> event, NiChang
 }
 
 double
-InterferenceHelper::CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, const NiChangesRange &ni) const
 {
   NS_LOG_FUNCTION (this);
   const WifiTxVector txVector = event->GetTxVector ();
   double psr = 1.0; /* Packet Success Rate */
-  auto j = ni->begin ();
+  auto j = ni.first;
   Time previous = j->first;
   WifiPreamble preamble = txVector.GetPreambleType ();
   WifiMode mcsHeaderMode;
@@ -509,7 +519,7 @@ InterferenceHelper::CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, NiCh
   Time plcpPayloadStart = plcpTrainingSymbolsStart + WifiPhy::GetPlcpTrainingSymbolDuration (txVector) + WifiPhy::GetPlcpSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or SIG-A + Training + SIG-B
   double noiseInterferenceW = m_firstPower;
   double powerW = event->GetRxPowerW ();
-  while (++j != ni->end ())
+  while (++j != ni.second)
     {
       Time current = j->first;
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
@@ -849,7 +859,7 @@ InterferenceHelper::CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, NiCh
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Time> relativeMpduStartStop) const
 {
-  NiChanges ni;
+  NiChangesRange ni;
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
@@ -858,7 +868,7 @@ InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Ti
   /* calculate the SNIR at the start of the MPDU (located through windowing) and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculatePayloadPer (event, &ni, relativeMpduStartStop);
+  double per = CalculatePayloadPer (event, ni, relativeMpduStartStop);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -869,7 +879,7 @@ InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Ti
 double
 InterferenceHelper::CalculateSnr (Ptr<Event> event) const
 {
-  NiChanges ni;
+  NiChangesRange ni;
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
@@ -880,7 +890,7 @@ InterferenceHelper::CalculateSnr (Ptr<Event> event) const
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateLegacyPhyHeaderSnrPer (Ptr<Event> event) const
 {
-  NiChanges ni;
+  NiChangesRange ni;
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
@@ -889,7 +899,7 @@ InterferenceHelper::CalculateLegacyPhyHeaderSnrPer (Ptr<Event> event) const
   /* calculate the SNIR at the start of the plcp header and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculateLegacyPhyHeaderPer (event, &ni);
+  double per = CalculateLegacyPhyHeaderPer (event, ni);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -900,7 +910,7 @@ InterferenceHelper::CalculateLegacyPhyHeaderSnrPer (Ptr<Event> event) const
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateNonLegacyPhyHeaderSnrPer (Ptr<Event> event) const
 {
-  NiChanges ni;
+  NiChangesRange ni;
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
@@ -909,7 +919,7 @@ InterferenceHelper::CalculateNonLegacyPhyHeaderSnrPer (Ptr<Event> event) const
   /* calculate the SNIR at the start of the plcp header and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculateNonLegacyPhyHeaderPer (event, &ni);
+  double per = CalculateNonLegacyPhyHeaderPer (event, ni);
   
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -921,6 +931,8 @@ void
 InterferenceHelper::EraseEvents (void)
 {
   m_niChanges.clear ();
+  m_eventEnds.clear ();
+  m_eventStarts.clear ();
   // Always have a zero power noise event in the list
   AddNiChangeEvent (Time (0), NiChange (0.0, 0));
   m_rxing = false;
@@ -949,6 +961,25 @@ InterferenceHelper::AddNiChangeEvent (Time moment, NiChange change)
   return m_niChanges.insert (GetNextPosition (moment), std::make_pair (moment, change));
 }
 
+void
+InterferenceHelper::EraseExpiredNiChanges (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  while (!m_eventEnds.empty () && m_eventEnds.begin ()->first < now)
+    {
+      m_eventStarts.erase (m_eventStarts.find (m_eventEnds.begin ()->second));
+      m_eventEnds.erase (m_eventEnds.begin ());
+    }
+  Time horizon = m_eventStarts.empty () ? now : *m_eventStarts.begin ();
+  auto last = m_niChanges.lower_bound (horizon);
+  if (last != m_niChanges.begin () && --last != m_niChanges.begin ())
+    {
+      // Always leave the first zero power noise event in the list
+      m_niChanges.erase (std::next (m_niChanges.begin ()), last);
+    }
+}
+
 void
 InterferenceHelper::NotifyRxStart ()
 {
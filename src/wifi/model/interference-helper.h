@@ -24,6 +24,9 @@
 #include "ns3/nstime.h"
 #include "wifi-tx-vector.h"
 #include <map>
+#include <set>
+
+class TestNiChangesErasure;
 
 namespace ns3 {
 
@@ -101,6 +104,9 @@ private:
 class InterferenceHelper
 {
 public:
+  /// Allow test cases to access private members
+  friend class ::TestNiChangesErasure;
+
   /**
    * Signal event for a packet.
    */
@@ -268,6 +274,11 @@ private:
    * typedef for a multimap of NiChanges
    */
   typedef std::multimap<Time, NiChange> NiChanges;
+  /**
+   * typedef for the range of the NiChanges of an event, from the one of
+   * its start to past the one of its end
+   */
+  typedef std::pair<NiChanges::const_iterator, NiChanges::const_iterator> NiChangesRange;
 
   /**
    * Append the given Event.
@@ -279,11 +290,11 @@ private:
    * Calculate noise and interference power in W.
    *
    * \param event
-   * \param ni
+   * \param ni the range of the NiChanges of the event
    *
    * \return noise and interference power
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChangesRange *ni) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    *
@@ -317,7 +328,7 @@ private:
    *
    * \return the error rate of the payload
    */
-  double CalculatePayloadPer (Ptr<const Event> event, NiChanges *ni, std::pair<Time, Time> window) const;
+  double CalculatePayloadPer (Ptr<const Event> event, const NiChangesRange &ni, std::pair<Time, Time> window) const;
   /**
    * Calculate the error rate of the legacy PHY header. The legacy PHY header
    * can be divided into multiple chunks (e.g. due to interference from other transmissions).
@@ -327,7 +338,7 @@ private:
    *
    * \return the error rate of the legacy PHY header
    */
-  double CalculateLegacyPhyHeaderPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculateLegacyPhyHeaderPer (Ptr<const Event> event, const NiChangesRange &ni) const;
   /**
    * Calculate the error rate of the non-legacy PHY header. The non-legacy PHY header
    * can be divided into multiple chunks (e.g. due to interference from other transmissions).
@@ -337,7 +348,7 @@ private:
    *
    * \return the error rate of the non-legacy PHY header
    */
-  double CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, const NiChangesRange &ni) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel; ///< error rate model
@@ -345,6 +356,8 @@ private:
   /// Experimental: needed for energy duration calculation
   NiChanges m_niChanges;
   double m_firstPower; ///< first power
+  std::multimap<Time, Time> m_eventEnds; ///< start times of the events in the air, by end time
+  std::multiset<Time> m_eventStarts; ///< start times of the events in the air
   bool m_rxing; ///< flag whether it is in receiving state
 
   /**
@@ -378,6 +391,12 @@ private:
    * \returns the iterator of the new event
    */
   NiChanges::iterator AddNiChangeEvent (Time moment, NiChange change);
+  /**
+   * Erase the NiChanges no event in the air can need any longer, i.e.,
+   * those before the start of the earliest event which has not ended.
+   * The last of them is kept, as it gives the power at that start.
+   */
+  void EraseExpiredNiChanges (void);
 };
 
 } //namespace ns3
@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/object-factory.h"
+#include "tabulated-error-rate-model.h"
+#include "nist-error-rate-model.h"
+#include "wifi-tx-vector.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/// Number of chunk sizes of the grid, the powers of two from 1 to 2^23 bits
+static const uint32_t N_SIZES = 24;
+
+/// Lowest log of a success rate, for the chunks which are never received
+static const double LOG_FLOOR = std::log (std::numeric_limits<double>::min ());
+
+/**
+ * Return the index of the largest chunk size of the grid not above nbits
+ *
+ * \param nbits the number of bits of the chunk
+ *
+ * \return the log2 of the chunk size
+ */
+static uint32_t
+GetSizeIndex (uint64_t nbits)
+{
+  uint32_t k = 0;
+  while ((nbits >> (k + 1)) != 0)
+    {
+      k++;
+    }
+  return k;
+}
+
+/**
+ * Return the TypeId and the attribute values of an object
+ *
+ * \param object the object
+ *
+ * \return the configuration of the object
+ */
+static std::string
+GetConfiguration (Ptr<const Object> object)
+{
+  std::ostringstream oss;
+  TypeId tid = object->GetInstanceTypeId ();
+  oss << tid.GetName ();
+  for (TypeId t = tid; ; t = t.GetParent ())
+    {
+      for (std::size_t i = 0; i < t.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = t.GetAttribute (i);
+          if ((info.flags & TypeId::ATTR_GET) && info.accessor->HasGetter ())
+            {
+              Ptr<AttributeValue> value = info.checker->Create ();
+              object->GetAttribute (info.name, *value);
+              oss << " " << info.name << "=" << value->SerializeToString (info.checker);
+            }
+        }
+      if (!t.HasParent ())
+        {
+          break;
+        }
+    }
+  return oss.str ();
+}
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("Model",
+                   "The analytical error rate model to tabulate.",
+                   TypeIdValue (NistErrorRateModel::GetTypeId ()),
+                   MakeTypeIdAccessor (&TabulatedErrorRateModel::m_modelTypeId),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("MinSnr",
+                   "The lowest SNR of the tables (dB).",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest SNR of the tables (dB).",
+                   DoubleValue (60.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrResolution",
+                   "The spacing of the SNR values of the tables (dB). "
+                   "The smaller the spacing, the closer the success rates "
+                   "are to the ones of the analytical model.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_snrResolution),
+                   MakeDoubleChecker<double> (0.001))
+    .AddAttribute ("Tolerance",
+                   "The highest difference between an interpolated success "
+                   "rate and the one of the analytical model, checked in the "
+                   "middle of the SNR intervals. Beyond it, the analytical "
+                   "model is used.",
+                   DoubleValue (1e-3),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_tolerance),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::Table::~Table ()
+{
+  GetSharedTables ().erase (key);
+}
+
+std::map<TabulatedErrorRateModel::TableKey, TabulatedErrorRateModel::Table *> &
+TabulatedErrorRateModel::GetSharedTables (void)
+{
+  static std::map<TableKey, Table *> tables;
+  return tables;
+}
+
+void
+TabulatedErrorRateModel::UpdateModel (void) const
+{
+  if (m_model == 0 || m_model->GetInstanceTypeId () != m_modelTypeId)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_modelTypeId);
+      m_model = factory.Create<ErrorRateModel> ();
+      m_modelConfiguration = GetConfiguration (m_model);
+      m_tables.clear ();
+    }
+}
+
+const TabulatedErrorRateModel::Table &
+TabulatedErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  TxKey txKey (mode.GetUid (), txVector.GetPreambleType (), txVector.GetChannelWidth (),
+               txVector.GetGuardInterval (), txVector.GetNTx (), txVector.GetNss (),
+               txVector.GetNess (), txVector.IsAggregation (), txVector.IsStbc ());
+  std::map<TxKey, Ptr<const Table> >::const_iterator it = m_tables.find (txKey);
+  if (it != m_tables.end ()
+      && std::get<1> (it->second->key) == m_minSnr
+      && std::get<2> (it->second->key) == m_maxSnr
+      && std::get<3> (it->second->key) == m_snrResolution
+      && std::get<4> (it->second->key) == m_tolerance)
+    {
+      return *it->second;
+    }
+
+  NS_ASSERT_MSG (m_maxSnr > m_minSnr, "MaxSnr must be higher than MinSnr");
+  TableKey key (m_modelConfiguration, m_minSnr, m_maxSnr, m_snrResolution, m_tolerance, txKey);
+  std::map<TableKey, Table *>::const_iterator shared = GetSharedTables ().find (key);
+  if (shared != GetSharedTables ().end ())
+    {
+      m_tables[txKey] = shared->second;
+      return *shared->second;
+    }
+
+  NS_LOG_DEBUG ("Tabulating " << m_modelConfiguration << " for " << txVector);
+  Ptr<Table> table = Create<Table> ();
+  table->key = key;
+  table->nSnr = static_cast<uint32_t> (std::floor ((m_maxSnr - m_minSnr) / m_snrResolution + 1e-9)) + 1;
+  for (uint32_t i = 0; i < table->nSnr; i++)
+    {
+      double snr = std::pow (10.0, (m_minSnr + i * m_snrResolution) / 10.0);
+      for (uint32_t k = 0; k < N_SIZES; k++)
+        {
+          double ps = m_model->GetChunkSuccessRate (mode, txVector, snr, static_cast<uint64_t> (1) << k);
+          table->logSuccessRate.push_back (ps > 0 ? std::max (std::log (ps), LOG_FLOOR) : LOG_FLOOR);
+        }
+    }
+  table->inexact.resize (table->logSuccessRate.size (), false);
+  uint32_t nInexact = 0;
+  for (uint32_t i = 0; i + 1 < table->nSnr; i++)
+    {
+      double snr = std::pow (10.0, (m_minSnr + (i + 0.5) * m_snrResolution) / 10.0);
+      for (uint32_t k = 0; k < N_SIZES; k++)
+        {
+          double low = table->logSuccessRate[i * N_SIZES + k];
+          double high = table->logSuccessRate[(i + 1) * N_SIZES + k];
+          double ps = m_model->GetChunkSuccessRate (mode, txVector, snr, static_cast<uint64_t> (1) << k);
+          if (std::abs (std::exp ((low + high) / 2) - ps) > m_tolerance)
+            {
+              table->inexact[i * N_SIZES + k] = true;
+              nInexact++;
+            }
+        }
+    }
+  NS_LOG_DEBUG (nInexact << " inexact intervals out of " << table->logSuccessRate.size ());
+  GetSharedTables ()[key] = PeekPointer (table);
+  m_tables[txKey] = table;
+  return *table;
+}
+
+double
+TabulatedErrorRateModel::GetLogSuccessRate (const Table &table, uint32_t snrIndex, uint64_t nbits) const
+{
+  uint32_t k = GetSizeIndex (nbits);
+  const double *row = &table.logSuccessRate[snrIndex * N_SIZES];
+  uint64_t low = static_cast<uint64_t> (1) << k;
+  if (nbits == low)
+    {
+      return row[k];
+    }
+  double fraction = static_cast<double> (nbits - low) / low;
+  return (1 - fraction) * row[k] + fraction * row[k + 1];
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << txVector.GetMode () << snr << nbits);
+  UpdateModel ();
+  if (nbits == 0 || nbits >= (static_cast<uint64_t> (1) << (N_SIZES - 1)))
+    {
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+
+  const Table &table = GetTable (mode, txVector);
+  double position = (10.0 * std::log10 (snr) - m_minSnr) / m_snrResolution;
+  if (!(position >= 0))
+    {
+      if (GetLogSuccessRate (table, 0, nbits) <= LOG_FLOOR)
+        {
+          return 0;
+        }
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  if (position >= table.nSnr - 1)
+    {
+      if (GetLogSuccessRate (table, table.nSnr - 1, nbits) == 0)
+        {
+          return 1;
+        }
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint32_t index = static_cast<uint32_t> (position);
+  double fraction = position - index;
+  double low = GetLogSuccessRate (table, index, nbits);
+  double high = GetLogSuccessRate (table, index + 1, nbits);
+  if (high <= LOG_FLOOR)
+    {
+      return 0;
+    }
+  uint32_t k = GetSizeIndex (nbits);
+  if (low <= LOG_FLOOR
+      || table.inexact[index * N_SIZES + k]
+      || (nbits != (static_cast<uint64_t> (1) << k) && table.inexact[index * N_SIZES + k + 1]))
+    {
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  return std::exp ((1 - fraction) * low + fraction * high);
+}
+
+} //namespace ns3
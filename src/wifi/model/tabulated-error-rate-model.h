@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "ns3/type-id.h"
+#include "ns3/simple-ref-count.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * \brief An error rate model interpolating the tables of another model
+ *
+ * The chunk success rates of an analytical model (by default, the
+ * NistErrorRateModel) are computed, the first time a mode is used, on a
+ * grid of SNR values, spaced by SnrResolution dB between MinSnr and
+ * MaxSnr, and of chunk sizes, the powers of two up to 2^23 bits.  The
+ * success rate of a chunk is then interpolated linearly, in the log
+ * domain, between the four closest points of the grid.  Since the log of
+ * the success rate of the Nist, Yans and Dsss models is proportional to
+ * the chunk size, only the SNR interpolation introduces an error, which
+ * decreases with SnrResolution.
+ *
+ * The interpolation is checked, when the tables are computed, in the
+ * middle of each SNR interval of the grid: where it is farther than
+ * Tolerance from the analytical model, e.g., around the SNR where the
+ * bound of the coded BER of the Nist model saturates, the success rates
+ * are computed by the analytical model instead.
+ *
+ * The success rate is assumed to increase with the SNR: beyond MaxSnr,
+ * a chunk which would be received on the grid is received; below
+ * MinSnr, a chunk which would be lost on the grid is lost.  The other
+ * values outside of the grid are computed by the analytical model.
+ *
+ * A table is computed for each mode and TXVECTOR used (all its fields
+ * but the power level, since the analytical models may use e.g. the
+ * channel width), and is shared by all the instances with the same
+ * attributes and the same analytical model configuration (its TypeId
+ * and attribute values, e.g., set by Config::SetDefault).  The tables
+ * are freed with the last instance using them, and are recomputed if
+ * the attributes change.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const;
+
+
+private:
+  /// The mode UID and the TXVECTOR fields but the power level
+  typedef std::tuple<uint32_t, uint8_t, uint16_t, uint16_t, uint8_t, uint8_t, uint8_t, bool, bool> TxKey;
+  /// The analytical model configuration, MinSnr, MaxSnr, SnrResolution, Tolerance and TXVECTOR
+  typedef std::tuple<std::string, double, double, double, double, TxKey> TableKey;
+
+  /// The table of a mode and TXVECTOR, removed from the shared tables when freed
+  struct Table : public SimpleRefCount<Table>
+  {
+    ~Table ();
+    TableKey key;                       //!< Key of the table in the shared tables
+    uint32_t nSnr;                      //!< Number of SNR values of the grid
+    std::vector<double> logSuccessRate; //!< Log of the success rates, by SNR and then by chunk size
+    std::vector<bool> inexact;          //!< True if the interpolation above a point is not accurate
+  };
+
+  /**
+   * \return the tables shared by all the instances, by key
+   */
+  static std::map<TableKey, Table *> & GetSharedTables (void);
+
+  /**
+   * Return the table of a mode and TXVECTOR, computing it if needed.
+   *
+   * \param mode the Wi-Fi mode
+   * \param txVector the TXVECTOR passed to the analytical model
+   *
+   * \return the table
+   */
+  const Table & GetTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * Create the analytical model if needed, or if its TypeId changed.
+   */
+  void UpdateModel (void) const;
+  /**
+   * Return the interpolated log of the success rate at a point of the
+   * SNR grid.
+   *
+   * \param table the table of the mode
+   * \param snrIndex the index of the SNR in the grid
+   * \param nbits the number of bits of the chunk
+   *
+   * \return the log of the success rate
+   */
+  double GetLogSuccessRate (const Table &table, uint32_t snrIndex, uint64_t nbits) const;
+
+  TypeId m_modelTypeId;                                   //!< TypeId of the analytical model
+  mutable Ptr<ErrorRateModel> m_model;                    //!< The analytical model
+  mutable std::string m_modelConfiguration;               //!< TypeId and attribute values of the analytical model
+  double m_minSnr;                                        //!< Lowest SNR of the grid, in dB
+  double m_maxSnr;                                        //!< Highest SNR of the grid, in dB
+  double m_snrResolution;                                 //!< Spacing of the SNR grid, in dB
+  double m_tolerance;                                     //!< Highest interpolation error
+  mutable std::map<TxKey, Ptr<const Table> > m_tables;   //!< Tables used by this instance
+};
+
+} //namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
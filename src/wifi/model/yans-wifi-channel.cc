@@ -22,6 +22,8 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/propagation-loss-model.h"
@@ -52,11 +54,41 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "The distance (m) beyond which the received power is "
+                   "assumed to be below the noise floor of any PHY. "
+                   "If positive, the channel only computes the propagation "
+                   "loss and delay to the PHYs within this distance of the "
+                   "sender, found with a spatial index of the PHYs. "
+                   "Zero disables the index: every PHY on the channel "
+                   "receives the signal.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxLossDb",
+                   "The propagation loss (dB) beyond which the signal is not "
+                   "delivered to a PHY.",
+                   DoubleValue (1.0e9),
+                   MakeDoubleAccessor (&YansWifiChannel::m_maxLossDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("StaticTopology",
+                   "If true, the propagation loss and delay from a motionless "
+                   "sender to the motionless PHYs are computed the first time "
+                   "it sends, and kept until a mobility model of the channel "
+                   "reports a course change. The propagation loss model must "
+                   "be deterministic: one which draws random variables aborts "
+                   "the simulation at the first transmission.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_staticTopology),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_maxRange (0),
+    m_maxLossDb (1.0e9),
+    m_staticTopology (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -64,6 +96,8 @@ YansWifiChannel::YansWifiChannel ()
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION (this);
+  m_index.Clear ();
+  m_matrix.Clear ();
   m_phyList.clear ();
 }
 
@@ -87,38 +121,149 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  if (m_staticTopology && Matrix::IsMotionless (senderMobility))
     {
-      if (sender != (*i))
+      const Matrix::Row *row = m_matrix.GetRow (PeekPointer (sender), 0);
+      if (row == 0)
+        {
+          row = &AddRow (sender, senderMobility, txPowerDbm);
+        }
+      for (Matrix::Row::const_iterator i = row->begin (); i != row->end (); i++)
         {
-          //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          Ptr<YansWifiPhy> receiver = m_phyList[i->m_rx];
+          if (!i->m_data.motionless)
             {
-              continue;
+              SendTo (sender, senderMobility, receiver, packet, txPowerDbm, duration);
             }
-
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+          else if (receiver->GetChannelNumber () == sender->GetChannelNumber ())
             {
-              dstNode = 0xffffffff;
+              Deliver (receiver, packet, txPowerDbm + i->m_data.gainDb, i->m_data.delay, duration);
             }
-          else
+        }
+      return;
+    }
+  if (m_maxRange > 0)
+    {
+      m_index.SetCellSize (m_maxRange);
+      while (m_index.GetN () < m_phyList.size ())
+        {
+          m_index.Add (m_phyList[m_index.GetN ()]->GetMobility ());
+        }
+      // the indexes are sorted, so the receptions are scheduled in the
+      // same order as without the index
+      m_index.GetInRange (senderMobility->GetPosition (), m_maxRange, m_inRange);
+      for (std::vector<uint32_t>::const_iterator i = m_inRange.begin (); i != m_inRange.end (); i++)
+        {
+          SendTo (sender, senderMobility, m_phyList[*i], packet, txPowerDbm, duration);
+        }
+      return;
+    }
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      SendTo (sender, senderMobility, *i, packet, txPowerDbm, duration);
+    }
+}
+
+void
+YansWifiChannel::SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+                         Ptr<const Packet> packet, double txPowerDbm, Time duration) const
+{
+  if (sender == receiver)
+    {
+      return;
+    }
+  //For now don't account for inter channel interference nor channel bonding
+  if (receiver->GetChannelNumber () != sender->GetChannelNumber ())
+    {
+      return;
+    }
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  if (txPowerDbm - rxPowerDbm > m_maxLossDb)
+    {
+      return;
+    }
+  Deliver (receiver, packet, rxPowerDbm, delay, duration);
+}
+
+void
+YansWifiChannel::Deliver (Ptr<YansWifiPhy> receiver, Ptr<const Packet> packet, double rxPowerDbm, Time delay, Time duration) const
+{
+  Ptr<Packet> copy = packet->Copy ();
+  Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive,
+                                  receiver, copy, rxPowerDbm, duration);
+}
+
+const YansWifiChannel::Matrix::Row &
+YansWifiChannel::AddRow (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, double txPowerDbm) const
+{
+  NS_LOG_FUNCTION (this << sender << txPowerDbm);
+  Matrix::CheckDeterministic (m_loss);
+  // a PHY moving into the range of the sender also changes its row
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      m_matrix.Watch ((*i)->GetMobility ());
+    }
+  std::vector<uint32_t> candidates;
+  if (m_maxRange > 0)
+    {
+      m_index.SetCellSize (m_maxRange);
+      while (m_index.GetN () < m_phyList.size ())
+        {
+          m_index.Add (m_phyList[m_index.GetN ()]->GetMobility ());
+        }
+      m_index.GetInRange (senderMobility->GetPosition (), m_maxRange, candidates);
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_phyList.size (); i++)
+        {
+          candidates.push_back (i);
+        }
+    }
+
+  Matrix::Row &row = m_matrix.AddRow (PeekPointer (sender), 0);
+  for (std::vector<uint32_t>::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ptr<YansWifiPhy> receiver = m_phyList[*i];
+      if (receiver == sender)
+        {
+          continue;
+        }
+      Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+      Matrix::Link link;
+      link.m_rx = *i;
+      link.m_data.motionless = Matrix::IsMotionless (receiverMobility);
+      link.m_data.gainDb = 0;
+      if (link.m_data.motionless)
+        {
+          link.m_data.delay = m_delay->GetDelay (senderMobility, receiverMobility);
+          link.m_data.gainDb = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility) - txPowerDbm;
+          if (-link.m_data.gainDb > m_maxLossDb)
             {
-              dstNode = dstNetDevice->GetNode ()->GetId ();
+              continue;
             }
-
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive,
-                                          (*i), copy, rxPowerDbm, duration);
         }
+      row.push_back (link);
     }
+  NS_LOG_DEBUG ("sender " << sender << " reaches " << row.size () << " PHYs");
+  return row;
 }
 
 void
@@ -152,6 +297,7 @@ YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
   m_phyList.push_back (phy);
+  m_matrix.Invalidate ();
 }
 
 int64_t
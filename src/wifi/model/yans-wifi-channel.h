@@ -22,6 +22,9 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include "ns3/channel.h"
+#include "ns3/spatial-grid-index.h"
+#include "ns3/propagation-matrix.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -31,6 +34,7 @@ class PropagationDelayModel;
 class YansWifiPhy;
 class Packet;
 class Time;
+class MobilityModel;
 
 /**
  * \brief a channel to interconnect ns3::YansWifiPhy objects.
@@ -40,6 +44,24 @@ class Time;
  * class and supports an ns3::PropagationLossModel and an
  * ns3::PropagationDelayModel.  By default, no propagation models are set;
  * it is the caller's responsibility to set them before using the channel.
+ *
+ * In large networks, most pairs of PHYs are too far apart to hear each
+ * other.  If the MaxRange attribute is set, the channel indexes the
+ * PHYs by position (see ns3::SpatialGridIndex) and only computes the
+ * propagation loss and delay to the PHYs within MaxRange of the
+ * sender; the others are assumed to receive the signal below their
+ * noise floor and are skipped.
+ *
+ * In networks whose nodes do not move, the propagation loss and delay
+ * between two PHYs are the same for every frame.  If the StaticTopology
+ * attribute is set, the channel computes them once per sender, the
+ * first time it transmits, and keeps them in a PropagationMatrix, which
+ * is invalidated when a mobility model of the channel reports a course
+ * change.  The receivers beyond MaxLossDb are left out of the matrix.
+ * The propagation loss model must then be deterministic and linear in
+ * the transmission power (as are the path loss models, but not the
+ * fading ones); the models which draw random variables are rejected when
+ * the first row is computed.
  */
 class YansWifiChannel : public Channel
 {
@@ -115,10 +137,63 @@ private:
    * \param duration the transmission duration associated with the packet being sent
    */
   static void Receive (Ptr<YansWifiPhy> receiver, Ptr<Packet> packet, double txPowerDbm, Time duration);
+  /**
+   * Compute the propagation to one receiver, and schedule the reception.
+   *
+   * \param sender the PHY object from which the packet is originating
+   * \param senderMobility the mobility model of the sender
+   * \param receiver the PHY object to which the packet is sent
+   * \param packet the packet to send
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \param duration the transmission duration associated with the packet
+   */
+  void SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+               Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
+  /**
+   * Schedule the reception of a packet by a PHY.
+   *
+   * \param receiver the PHY object to which the packet is sent
+   * \param packet the packet to send
+   * \param rxPowerDbm the received power, in dBm
+   * \param delay the propagation delay
+   * \param duration the transmission duration associated with the packet
+   */
+  void Deliver (Ptr<YansWifiPhy> receiver, Ptr<const Packet> packet, double rxPowerDbm, Time delay, Time duration) const;
+
+  /// The propagation from a sender to a receiver
+  struct Propagation
+  {
+    double gainDb;   //!< Gain of the propagation loss model, in dB
+    Time delay;      //!< Propagation delay
+    bool motionless; //!< False if the receiver moves: the propagation is not stored
+  };
+  /// The propagation from the motionless senders to their receivers
+  typedef PropagationMatrix<Propagation> Matrix;
+
+  /**
+   * Compute the row of the propagation matrix of a sender.
+   *
+   * \param sender the PHY object from which the packet is originating
+   * \param senderMobility the mobility model of the sender
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \return the row
+   */
+  const Matrix::Row & AddRow (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, double txPowerDbm) const;
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_maxRange;                   //!< Distance beyond which the PHYs are not reached, or zero
+  double m_maxLossDb;                  //!< Loss beyond which the PHYs are not reached
+  bool m_staticTopology;               //!< Whether the propagation is stored in m_matrix
+  /**
+   * Index of the positions of the PHYs, by index in m_phyList, updated
+   * lazily by Send since the PHYs are usually not placed yet when they
+   * are added.
+   */
+  mutable SpatialGridIndex m_index;
+  mutable std::vector<uint32_t> m_inRange; //!< PHYs within range of the current sender
+  mutable Matrix m_matrix;                 //!< Propagation from the senders, by index in m_phyList
 };
 
 } //namespace ns3
@@ -22,6 +22,11 @@
 #include "ns3/test.h"
 #include "ns3/nist-error-rate-model.h"
 #include "ns3/dsss-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
 #include "ns3/wifi-tx-vector.h"
 
 using namespace ns3;
@@ -291,6 +296,91 @@ WifiErrorRateModelsTestCaseNist::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (ps, 0.999, 0.001, "Not equal within tolerance");
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Wifi Error Rate Models Test Case Tabulated
+ */
+class WifiErrorRateModelsTestCaseTabulated : public TestCase
+{
+public:
+  WifiErrorRateModelsTestCaseTabulated ();
+  virtual ~WifiErrorRateModelsTestCaseTabulated ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Configure a tabulated model and check its success rates against the
+   * analytical ones
+   *
+   * \param table the tabulated model
+   * \param modelName the TypeId name of the analytical model
+   * \param resolution the SnrResolution of the tables (dB)
+   * \param tolerance the highest difference between the success rates
+   */
+  void CheckModel (Ptr<TabulatedErrorRateModel> table, std::string modelName, double resolution, double tolerance);
+};
+
+WifiErrorRateModelsTestCaseTabulated::WifiErrorRateModelsTestCaseTabulated ()
+  : TestCase ("WifiErrorRateModel test case Tabulated")
+{
+}
+
+WifiErrorRateModelsTestCaseTabulated::~WifiErrorRateModelsTestCaseTabulated ()
+{
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::CheckModel (Ptr<TabulatedErrorRateModel> table, std::string modelName,
+                                                  double resolution, double tolerance)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (modelName);
+  Ptr<ErrorRateModel> model = factory.Create<ErrorRateModel> ();
+  table->SetAttribute ("Model", StringValue (modelName));
+  table->SetAttribute ("SnrResolution", DoubleValue (resolution));
+  table->SetAttribute ("Tolerance", DoubleValue (tolerance));
+
+  const char *modes[] = {"DsssRate1Mbps", "DsssRate11Mbps", "OfdmRate6Mbps", "OfdmRate18Mbps",
+                         "OfdmRate54Mbps", "HtMcs0", "HtMcs7", "VhtMcs8", "HeMcs11"};
+  uint64_t sizes[] = {1, 24, 100, 1000, 8 * 1500, 8 * 65535, 8 * 1000000};
+  // the Yans model depends on the channel width of the TXVECTOR
+  uint16_t widths[] = {20, 40};
+  for (uint32_t w = 0; w < sizeof (widths) / sizeof (widths[0]); w++)
+    {
+      WifiTxVector txVector;
+      txVector.SetChannelWidth (widths[w]);
+      for (uint32_t i = 0; i < sizeof (modes) / sizeof (modes[0]); i++)
+        {
+          WifiMode mode (modes[i]);
+          for (double snr = -20.0; snr <= 70.0; snr += 0.37)
+            {
+              double snrRatio = std::pow (10.0, snr / 10.0);
+              for (uint32_t j = 0; j < sizeof (sizes) / sizeof (sizes[0]); j++)
+                {
+                  double expected = model->GetChunkSuccessRate (mode, txVector, snrRatio, sizes[j]);
+                  double ps = table->GetChunkSuccessRate (mode, txVector, snrRatio, sizes[j]);
+                  NS_TEST_ASSERT_MSG_EQ_TOL (ps, expected, tolerance, modelName << " " << mode << " "
+                                             << widths[w] << " MHz at " << snr << " dB for "
+                                             << sizes[j] << " bits");
+                }
+            }
+        }
+    }
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::DoRun (void)
+{
+  // the same instance is reconfigured after each use
+  Ptr<TabulatedErrorRateModel> table = CreateObject<TabulatedErrorRateModel> ();
+  CheckModel (table, "ns3::NistErrorRateModel", 0.05, 1e-3);
+  CheckModel (table, "ns3::YansErrorRateModel", 0.05, 1e-3);
+  CheckModel (table, "ns3::NistErrorRateModel", 0.2, 1e-4);
+  CheckModel (table, "ns3::YansErrorRateModel", 0.2, 1e-4);
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -308,6 +398,7 @@ WifiErrorRateModelsTestSuite::WifiErrorRateModelsTestSuite ()
 {
   AddTestCase (new WifiErrorRateModelsTestCaseDsss, TestCase::QUICK);
   AddTestCase (new WifiErrorRateModelsTestCaseNist, TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTabulated, TestCase::QUICK);
 }
 
 static WifiErrorRateModelsTestSuite wifiErrorRateModelsTestSuite; ///< the test suite
@@ -38,6 +38,7 @@
 #include "ns3/wifi-psdu.h"
 #include "ns3/wifi-mac-queue-item.h"
 #include "ns3/mpdu-aggregator.h"
+#include "ns3/interference-helper.h"
 
 using namespace ns3;
 
@@ -1590,6 +1591,175 @@ TestAmpduReception::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Erasure of the expired NI changes
+ *
+ * The InterferenceHelper keeps recording the events while it is notified
+ * of a reception, e.g., after a failed preamble detection, and erases the
+ * changes which are older than the events still in the air.  A first
+ * helper records an event which ends before a reception, one which ends
+ * during it and one which ends after it; a second one records the same
+ * events, except the first.  Both must hold the same changes once the
+ * first events expired, and give the same SINR and PER to the reception.
+ */
+class TestNiChangesErasure : public TestCase
+{
+public:
+  TestNiChangesErasure ();
+  virtual ~TestNiChangesErasure ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Add an event to the helpers
+   * \param both whether to add the event to both helpers, or only to the first one
+   * \param powerW the receive power in watts
+   * \param duration the duration of the event
+   */
+  void AddEvent (bool both, double powerW, Time duration);
+  /**
+   * Add the reception to the helpers
+   */
+  void AddReception (void);
+  /**
+   * Check the number of NI changes of the helpers
+   * \param expected the expected number of NI changes of the first helper
+   * \param same whether the second helper must hold the same NI changes
+   */
+  void CheckNiChanges (std::size_t expected, bool same);
+  /**
+   * Check the SINR of the reception during the event which ends during it
+   */
+  void CheckSnr (void);
+  /**
+   * Check the SINR and the PER of the PHY header and of the payload of the
+   * reception, at its end
+   */
+  void CheckSnrPer (void);
+
+  InterferenceHelper m_helper;          ///< the helper of all the events
+  InterferenceHelper m_reference;       ///< the helper of the events overlapping the reception
+  Ptr<Event> m_event;                   ///< the reception, in the first helper
+  Ptr<Event> m_referenceEvent;          ///< the reception, in the second helper
+  WifiTxVector m_txVector;              ///< the TXVECTOR of the reception
+  double m_rxPowerW;                    ///< the receive power of the reception
+  double m_interferenceW;               ///< the receive power of the interfering events
+};
+
+TestNiChangesErasure::TestNiChangesErasure ()
+  : TestCase ("Erasure of the expired NI changes"),
+    m_txVector (WifiPhy::GetOfdmRate12Mbps (), 0, WIFI_PREAMBLE_LONG, 800, 1, 1, 0, 20, false, false),
+    m_rxPowerW (DbmToW (-81)),
+    m_interferenceW (DbmToW (-92))
+{
+}
+
+TestNiChangesErasure::~TestNiChangesErasure ()
+{
+}
+
+void
+TestNiChangesErasure::AddEvent (bool both, double powerW, Time duration)
+{
+  m_helper.AddForeignSignal (duration, powerW);
+  if (both)
+    {
+      m_reference.AddForeignSignal (duration, powerW);
+    }
+}
+
+void
+TestNiChangesErasure::AddReception (void)
+{
+  Ptr<Packet> packet = Create<Packet> (450);
+  m_event = m_helper.Add (packet, m_txVector, MicroSeconds (300), m_rxPowerW);
+  m_referenceEvent = m_reference.Add (packet, m_txVector, MicroSeconds (300), m_rxPowerW);
+}
+
+void
+TestNiChangesErasure::CheckNiChanges (std::size_t expected, bool same)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_helper.m_niChanges.size (), expected, "Unexpected number of NI changes at " << Simulator::Now ().As (Time::US));
+  if (!same)
+    {
+      return;
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_reference.m_niChanges.size (), expected, "Unexpected number of reference NI changes at " << Simulator::Now ().As (Time::US));
+  for (auto i = m_helper.m_niChanges.begin (), j = m_reference.m_niChanges.begin ();
+       i != m_helper.m_niChanges.end () && j != m_reference.m_niChanges.end (); ++i, ++j)
+    {
+      NS_TEST_EXPECT_MSG_EQ (i->first, j->first, "The NI changes are at different times");
+      NS_TEST_EXPECT_MSG_EQ_TOL (i->second.GetPower (), j->second.GetPower (), 1e-20, "The NI changes have different powers at " << i->first.As (Time::US));
+    }
+}
+
+void
+TestNiChangesErasure::CheckSnr (void)
+{
+  // The noise floor of InterferenceHelper::CalculateSnr, with a noise figure of 7 dB
+  double noiseW = DbToRatio (7) * 1.3803e-23 * 290 * 20e6;
+  double expected = m_rxPowerW / (noiseW + m_interferenceW);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_helper.CalculateSnr (m_event), expected, expected * 1e-9, "Unexpected SINR during the interference");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_reference.CalculateSnr (m_referenceEvent), expected, expected * 1e-9, "Unexpected reference SINR during the interference");
+}
+
+void
+TestNiChangesErasure::CheckSnrPer (void)
+{
+  InterferenceHelper::SnrPer header = m_helper.CalculateLegacyPhyHeaderSnrPer (m_event);
+  InterferenceHelper::SnrPer referenceHeader = m_reference.CalculateLegacyPhyHeaderSnrPer (m_referenceEvent);
+  NS_TEST_ASSERT_MSG_EQ_TOL (header.snr, referenceHeader.snr, referenceHeader.snr * 1e-9, "The PHY header SINR changed");
+  NS_TEST_ASSERT_MSG_EQ_TOL (header.per, referenceHeader.per, 1e-9, "The PHY header PER changed");
+
+  std::pair<Time, Time> payload = std::make_pair (Time (0), MicroSeconds (280));
+  InterferenceHelper::SnrPer data = m_helper.CalculatePayloadSnrPer (m_event, payload);
+  InterferenceHelper::SnrPer referenceData = m_reference.CalculatePayloadSnrPer (m_referenceEvent, payload);
+  NS_TEST_ASSERT_MSG_EQ_TOL (data.snr, referenceData.snr, referenceData.snr * 1e-9, "The payload SINR changed");
+  NS_TEST_ASSERT_MSG_EQ_TOL (data.per, referenceData.per, 1e-9, "The payload PER changed");
+  // the interference must still be accounted for
+  NS_TEST_ASSERT_MSG_GT (data.per, 0.01, "The payload PER ignores the interference");
+  NS_TEST_ASSERT_MSG_LT (data.per, 0.99, "The payload PER is too high to be checked");
+}
+
+void
+TestNiChangesErasure::DoRun (void)
+{
+  for (InterferenceHelper *helper : {&m_helper, &m_reference})
+    {
+      helper->SetNoiseFigure (DbToRatio (7));
+      helper->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+      helper->SetNumberOfReceiveAntennas (1);
+      // the helpers record the events from the start, as when a preamble
+      // detection failed
+      helper->NotifyRxStart ();
+    }
+
+  // 0-100 us: ends before the reception, which only the first helper knows
+  Simulator::Schedule (MicroSeconds (0), &TestNiChangesErasure::AddEvent, this, false, m_interferenceW, MicroSeconds (100));
+  Simulator::Schedule (MicroSeconds (0), &TestNiChangesErasure::CheckNiChanges, this, 3, false);
+  // 150-350 us: ends during the reception; the start of the first event is erased
+  Simulator::Schedule (MicroSeconds (150), &TestNiChangesErasure::AddEvent, this, true, m_interferenceW, MicroSeconds (200));
+  Simulator::Schedule (MicroSeconds (150), &TestNiChangesErasure::CheckNiChanges, this, 4, false);
+  // 200-500 us: the reception
+  Simulator::Schedule (MicroSeconds (200), &TestNiChangesErasure::AddReception, this);
+  Simulator::Schedule (MicroSeconds (200), &TestNiChangesErasure::CheckNiChanges, this, 6, false);
+  Simulator::Schedule (MicroSeconds (250), &TestNiChangesErasure::CheckSnr, this);
+  // 400-700 us: ends after the reception; the first event is wholly erased,
+  // and the changes of the reception are kept
+  Simulator::Schedule (MicroSeconds (400), &TestNiChangesErasure::AddEvent, this, true, 2 * m_interferenceW, MicroSeconds (300));
+  Simulator::Schedule (MicroSeconds (400), &TestNiChangesErasure::CheckNiChanges, this, 7, true);
+  Simulator::Schedule (MicroSeconds (500), &TestNiChangesErasure::CheckSnrPer, this);
+  // 800-900 us: all the events before expired, only the last change remains
+  Simulator::Schedule (MicroSeconds (800), &TestNiChangesErasure::AddEvent, this, true, m_interferenceW, MicroSeconds (100));
+  Simulator::Schedule (MicroSeconds (800), &TestNiChangesErasure::CheckNiChanges, this, 4, true);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -1609,6 +1779,7 @@ WifiPhyReceptionTestSuite::WifiPhyReceptionTestSuite ()
   AddTestCase (new TestThresholdPreambleDetectionWithFrameCapture, TestCase::QUICK);
   AddTestCase (new TestSimpleFrameCaptureModel, TestCase::QUICK);
   AddTestCase (new TestAmpduReception, TestCase::QUICK);
+  AddTestCase (new TestNiChangesErasure, TestCase::QUICK);
 }
 
 static WifiPhyReceptionTestSuite wifiPhyReceptionTestSuite; ///< the test suite
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/**
+ * \file
+ * Benchmark the creation, scheduling, execution and release of events.
+ *
+ * Each event reschedules another one, with a mix of bound argument
+ * counts and types representative of the models (none, integers,
+ * a Ptr), and a constant event population (hold model).  Compare the
+ * event rate with --EventPool=true (the default) and --EventPool=false.
+ */
+
+#define LOG(x)   std::cout << x << std::endl
+
+/** A reference counted argument, like a Packet. */
+class Payload : public SimpleRefCount<Payload>
+{
+public:
+  uint32_t m_value; //!< Some data.
+};
+
+/// Bench class
+class Bench
+{
+public:
+  /**
+   * Constructor
+   * \param population the event population
+   * \param total the number of events to execute
+   */
+  Bench (uint32_t population, uint32_t total)
+    : m_population (population),
+      m_total (total),
+      m_count (0),
+      m_sum (0)
+  {
+  }
+
+  /**
+   * Run the benchmark once.
+   * \returns the event rate, in events per second
+   */
+  double RunBench (void);
+
+private:
+  /** Schedule the next event, with a varying signature. */
+  void Next (void);
+  /** Event without argument. */
+  void Cb0 (void);
+  /**
+   * Event with one argument.
+   * \param a an integer
+   */
+  void Cb1 (uint32_t a);
+  /**
+   * Event with two arguments.
+   * \param a an integer
+   * \param p a payload
+   */
+  void Cb2 (uint32_t a, Ptr<Payload> p);
+  /**
+   * Event with three arguments.
+   * \param a an integer
+   * \param b an integer
+   * \param t a time
+   */
+  void Cb3 (uint64_t a, uint64_t b, Time t);
+
+  uint32_t m_population; ///< event population
+  uint32_t m_total;      ///< number of events to execute
+  uint32_t m_count;      ///< number of executed events
+  uint64_t m_sum;        ///< sink for the arguments
+};
+
+double
+Bench::RunBench (void)
+{
+  m_count = 0;
+  for (uint32_t i = 0; i < m_population; ++i)
+    {
+      Next ();
+    }
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  double simu = time.End () / 1000.0;
+  return m_count / simu;
+}
+
+void
+Bench::Next (void)
+{
+  if (m_count >= m_total)
+    {
+      return;
+    }
+  ++m_count;
+  // spread the events without relying on a random variable, whose cost
+  // would dominate
+  Time delay = NanoSeconds (1 + (m_count * 2654435761u) % 1000);
+  switch (m_count % 4)
+    {
+    case 0:
+      Simulator::Schedule (delay, &Bench::Cb0, this);
+      break;
+    case 1:
+      Simulator::Schedule (delay, &Bench::Cb1, this, m_count);
+      break;
+    case 2:
+      {
+        Ptr<Payload> p = Create<Payload> ();
+        p->m_value = m_count;
+        Simulator::Schedule (delay, &Bench::Cb2, this, m_count, p);
+      }
+      break;
+    default:
+      Simulator::Schedule (delay, &Bench::Cb3, this, m_sum, m_count, delay);
+      break;
+    }
+}
+
+void
+Bench::Cb0 (void)
+{
+  Next ();
+}
+
+void
+Bench::Cb1 (uint32_t a)
+{
+  m_sum += a;
+  Next ();
+}
+
+void
+Bench::Cb2 (uint32_t a, Ptr<Payload> p)
+{
+  m_sum += a + p->m_value;
+  Next ();
+}
+
+void
+Bench::Cb3 (uint64_t a, uint64_t b, Time t)
+{
+  m_sum += a + b + t.GetTimeStep ();
+  Next ();
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t pop   =  10000;
+  uint32_t total = 5000000;
+  uint32_t runs  =       3;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the allocation and execution of events.\n"
+             "\n"
+             "Use --EventPool=false to disable the event pools.");
+  cmd.AddValue ("pop",   "event population size (default 1E4)",         pop);
+  cmd.AddValue ("total", "total number of events to run (default 5E6)", total);
+  cmd.AddValue ("runs",  "number of runs (default 3)",    runs);
+  cmd.Parse (argc, argv);
+
+  BooleanValue pool;
+  GlobalValue::GetValueByName ("EventPool", pool);
+  LOG ("event pool: " << (pool.Get () ? "enabled" : "disabled"));
+  LOG ("population: " << pop);
+  LOG ("total events: " << total);
+
+  Bench bench (pop, total);
+  // prime the allocators
+  bench.RunBench ();
+  double best = 0;
+  for (uint32_t i = 0; i < runs; i++)
+    {
+      double rate = bench.RunBench ();
+      LOG ("run " << i << ": " << std::fixed << std::setprecision (0) << rate << " events/s");
+      best = std::max (best, rate);
+    }
+  LOG ("best: " << std::fixed << std::setprecision (0) << best << " events/s");
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -35,6 +35,25 @@
 
 using namespace ns3;
 
+#ifdef __GLIBC__
+/// The glibc allocator, called by our malloc
+extern "C" void *__libc_malloc (size_t size);
+/// Number of heap allocations, including those made with operator new
+static uint64_t g_allocations = 0;
+
+/**
+ * Count the heap allocations.
+ * \param size the allocation size
+ * \returns the allocated memory
+ */
+extern "C" void *
+malloc (size_t size)
+{
+  g_allocations++;
+  return __libc_malloc (size);
+}
+#endif /* __GLIBC__ */
+
 /// BenchHeader class used for benchmarking packet serialization/deserialization
 template <int N>
 class BenchHeader : public Header
@@ -310,6 +329,36 @@ benchFragment (uint32_t n)
   }
 }
 
+static void
+benchSmallTags (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchTag<4> flowId;
+  BenchTag<5> bearer;
+  BenchTag<8> snr;
+  BenchTag<2> byteTag;
+
+  // Like on a wireless channel: a few small packet tags, and each
+  // packet is copied for several receivers which add their own tag.
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddByteTag (byteTag);
+      p->AddPacketTag (flowId);
+      p->AddHeader (ipv4);
+      p->AddPacketTag (bearer);
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          Ptr<Packet> copy = p->Copy ();
+          copy->AddPacketTag (snr);
+          copy->PeekPacketTag (flowId);
+          copy->RemovePacketTag (snr);
+          copy->RemovePacketTag (bearer);
+          copy->RemoveHeader (ipv4);
+        }
+    }
+}
+
 static void
 benchByteTags (uint32_t n)
 {
@@ -343,6 +392,9 @@ static void
 runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
 {
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+#ifdef __GLIBC__
+  uint64_t allocations = g_allocations;
+#endif
   for (uint32_t i = 0; i < minIterations; i++)
     {
       uint64_t delay = runBenchOneIteration(bench, n);
@@ -352,7 +404,12 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
   ps *= 1000;
   ps /= minDelay;
   std::cout << ps << " packets/s"
-            << " (" << minDelay << " ms elapsed)\t"
+            << " (" << minDelay << " ms elapsed";
+#ifdef __GLIBC__
+  std::cout << ", " << (double)(g_allocations - allocations) / minIterations / n
+            << " allocations/packet";
+#endif
+  std::cout << ")\t"
             << name
             << std::endl;
 }
@@ -362,14 +419,25 @@ int main (int argc, char *argv[])
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  bool lazyPrinting = false;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("lazy-printing", "enable lazy packet printing", lazyPrinting);
   cmd.Parse (argc, argv);
 
+  if (lazyPrinting)
+    {
+      Packet::EnableLazyPrinting ();
+    }
+  else if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+
   if (n == 0)
     {
       std::cerr << "Error-- number of packets must be specified " <<
@@ -385,6 +453,7 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchSmallTags, n, minIterations, "Small packet and byte tags");
 
   return 0;
 }
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the forwarding decisions of Ipv4StaticRouting
+// and Ipv4GlobalRouting, for a router holding many host routes and a
+// few network routes, as in a large data center topology.
+// Sample usage:  ./waf --run 'bench-routing --routes=10000'
+//
+// With --walk, a route with a non contiguous mask is added, which makes
+// the routing protocols walk all their routes instead of using their
+// forwarding tables.
+
+#include "ns3/core-module.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/internet-stack-helper.h"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Time the route lookups of a routing protocol.
+ * \param routing the routing protocol
+ * \param destinations the destinations to look up
+ * \param lookups the number of lookups
+ * \returns the lookup rate, in lookups per second
+ */
+static double
+RunBench (Ptr<Ipv4RoutingProtocol> routing, const std::vector<Ipv4Address> &destinations, uint32_t lookups)
+{
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  uint32_t found = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      header.SetDestination (destinations[i % destinations.size ()]);
+      if (routing->RouteOutput (0, header, 0, err) != 0)
+        {
+          found++;
+        }
+    }
+  double elapsed = time.End () / 1000.0;
+  NS_ABORT_MSG_UNLESS (found == lookups, "Some destinations have no route");
+  return lookups / elapsed;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t routes = 10000;
+  uint32_t lookups = 1000000;
+  bool walk = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("routes",  "number of host routes (default 1E4)", routes);
+  cmd.AddValue ("lookups", "number of route lookups (default 1E6)", lookups);
+  cmd.AddValue ("walk",    "walk the routes instead of using the forwarding tables", walk);
+  cmd.Parse (argc, argv);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  const uint32_t nInterfaces = 8;
+  for (uint32_t i = 0; i < nInterfaces; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (0x0a000001 + (i << 8)), Ipv4Mask ("/24")));
+      ipv4->SetUp (interface);
+    }
+
+  Ptr<Ipv4StaticRouting> staticRouting = CreateObject<Ipv4StaticRouting> ();
+  Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting> ();
+  staticRouting->SetIpv4 (ipv4);
+  globalRouting->SetIpv4 (ipv4);
+
+  // one host route per server, spread over the uplinks
+  std::vector<Ipv4Address> destinations;
+  for (uint32_t i = 0; i < routes; i++)
+    {
+      Ipv4Address dest (0xac100000 + i);
+      uint32_t interface = 1 + i % nInterfaces;
+      Ipv4Address gateway (0x0a000002 + ((interface - 1) << 8));
+      staticRouting->AddHostRouteTo (dest, gateway, interface);
+      globalRouting->AddHostRouteTo (dest, gateway, interface);
+      destinations.push_back (dest);
+    }
+  // and a default route, for the destinations outside of the data center
+  staticRouting->SetDefaultRoute (Ipv4Address ("10.0.0.2"), 1);
+  globalRouting->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), Ipv4Address ("10.0.0.2"), 1);
+  for (uint32_t i = 0; i < routes / 10; i++)
+    {
+      destinations.push_back (Ipv4Address (0xc0a80000 + i));
+    }
+  if (walk)
+    {
+      staticRouting->AddNetworkRouteTo (Ipv4Address ("1.0.1.0"), Ipv4Mask ("255.0.255.0"), 1);
+      globalRouting->AddNetworkRouteTo (Ipv4Address ("1.0.1.0"), Ipv4Mask ("255.0.255.0"), 1);
+    }
+
+  // visit the destinations in a shuffled order
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = destinations.size () - 1; i > 0; i--)
+    {
+      std::swap (destinations[i], destinations[rand->GetInteger (0, i)]);
+    }
+
+  LOG ("routes: " << routes << (walk ? " (walk)" : " (forwarding tables)"));
+  LOG ("lookups: " << lookups);
+  // prime the tables
+  RunBench (staticRouting, destinations, 1000);
+  RunBench (globalRouting, destinations, 1000);
+  LOG ("Ipv4StaticRouting: " << std::fixed << std::setprecision (0)
+       << RunBench (staticRouting, destinations, lookups) << " lookups/s");
+  LOG ("Ipv4GlobalRouting: " << std::fixed << std::setprecision (0)
+       << RunBench (globalRouting, destinations, lookups) << " lookups/s");
+
+  staticRouting->Dispose ();
+  globalRouting->Dispose ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,581 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/**
+ * \file
+ * Benchmark every Scheduler implementation against several event time
+ * distributions.
+ *
+ * Unlike bench-simulator, the schedulers are driven directly, without
+ * creating or executing events, so that only the cost of the priority
+ * queue is measured.  Each workload runs in three phases:
+ *  - insert: the initial population is inserted,
+ *  - mixed: the steady state, where the earliest event is removed and
+ *    new events are inserted,
+ *  - remove: the remaining events are removed.
+ *
+ * The synthetic workloads follow the hold model: each removed event is
+ * replaced by one event, at a time drawn from the workload distribution.
+ * The trace workload replays the insertions recorded by DesMetrics,
+ * removing the events which were due before each insertion.
+ *
+ * For each scheduler and workload, the benchmark reports the time per
+ * operation of each phase, the peak heap memory used by the scheduler,
+ * and, on Linux when performance counters are available, the number of
+ * cache misses per operation.
+ */
+
+#define LOG(x)   std::cout << x << std::endl
+
+/** \name Heap accounting, to report the peak memory of the schedulers */
+//@{
+static std::size_t g_liveBytes = 0;  //!< Currently allocated bytes.
+static std::size_t g_peakBytes = 0;  //!< Peak of g_liveBytes.
+/** Room reserved before each block to remember its size. */
+static const std::size_t HEADER_SIZE = 16;
+//@}
+
+void *
+operator new (std::size_t size)
+{
+  char *p = static_cast<char *> (std::malloc (size + HEADER_SIZE));
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  *reinterpret_cast<std::size_t *> (p) = size;
+  g_liveBytes += size;
+  if (g_liveBytes > g_peakBytes)
+    {
+      g_peakBytes = g_liveBytes;
+    }
+  return p + HEADER_SIZE;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  if (p == 0)
+    {
+      return;
+    }
+  char *block = static_cast<char *> (p) - HEADER_SIZE;
+  g_liveBytes -= *reinterpret_cast<std::size_t *> (block);
+  std::free (block);
+}
+
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  operator delete (p);
+}
+
+
+/** Hardware cache miss counter, if the platform provides one. */
+class CacheMissCounter
+{
+public:
+  CacheMissCounter ();
+  ~CacheMissCounter ();
+  /** \returns \c true if the counter can be used. */
+  bool IsAvailable (void) const;
+  /** Reset and start the counter. */
+  void Start (void);
+  /** \returns the number of misses since Start. */
+  uint64_t Stop (void);
+
+private:
+  int m_fd; //!< The perf event file descriptor, or -1.
+};
+
+CacheMissCounter::CacheMissCounter ()
+  : m_fd (-1)
+{
+#ifdef __linux__
+  struct perf_event_attr attr;
+  std::memset (&attr, 0, sizeof (attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof (attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  m_fd = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter ()
+{
+#ifdef __linux__
+  if (m_fd >= 0)
+    {
+      close (m_fd);
+    }
+#endif
+}
+
+bool
+CacheMissCounter::IsAvailable (void) const
+{
+  return m_fd >= 0;
+}
+
+void
+CacheMissCounter::Start (void)
+{
+#ifdef __linux__
+  if (m_fd >= 0)
+    {
+      ioctl (m_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl (m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+uint64_t
+CacheMissCounter::Stop (void)
+{
+  uint64_t count = 0;
+#ifdef __linux__
+  if (m_fd >= 0)
+    {
+      ioctl (m_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read (m_fd, &count, sizeof (count)) != sizeof (count))
+        {
+          count = 0;
+        }
+    }
+#endif
+  return count;
+}
+
+
+/** An event which is never executed: schedulers only look at the keys. */
+class NoopEvent : public EventImpl
+{
+private:
+  virtual void Notify (void)
+  {
+  }
+};
+
+/** The operations of a workload. */
+struct Workload
+{
+  /** The workload name. */
+  std::string name;
+  /**
+   * Synthetic workloads: the timestamps of the initial population.
+   * Trace workloads: the timestamps of the events, in insertion order.
+   */
+  std::vector<uint64_t> timestamps;
+  /**
+   * Synthetic workloads: one value per replaced event; the new event
+   * time is <tt>(now / slot + value) * slot</tt>.
+   * Trace workloads: the time of each insertion.
+   */
+  std::vector<uint64_t> values;
+  /** Time slot of the synthetic workloads, zero for traces. */
+  uint64_t slot;
+};
+
+/** Measurements of one run. */
+struct Result
+{
+  double insertNs;    //!< Time per insertion in the insert phase.
+  double mixedNs;     //!< Time per operation in the mixed phase.
+  double removeNs;    //!< Time per removal in the remove phase.
+  std::size_t peakKib;  //!< Peak heap memory used by the scheduler.
+  double missesPerOp; //!< Cache misses per operation, all phases.
+  uint64_t ops;       //!< Number of operations.
+};
+
+/** Clock used for the measurements. */
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Compute the time per operation.
+ * \param start the phase start
+ * \param ops the number of operations
+ * \returns the time per operation, in ns
+ */
+static double
+NsPerOp (Clock::time_point start, uint64_t ops)
+{
+  std::chrono::duration<double, std::nano> elapsed = Clock::now () - start;
+  return ops == 0 ? 0 : elapsed.count () / ops;
+}
+
+/**
+ * Run one workload against one scheduler.
+ * \param tid the scheduler type
+ * \param workload the workload
+ * \param counter the cache miss counter
+ * \returns the measurements
+ */
+static Result
+RunWorkload (TypeId tid, const Workload &workload, CacheMissCounter &counter)
+{
+  Result result;
+  EventImpl *impl = new NoopEvent ();
+  std::size_t baseline = g_liveBytes;
+  g_peakBytes = g_liveBytes;
+
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+
+  Scheduler::Event ev;
+  ev.impl = impl;
+  ev.key.m_uid = 0;
+  ev.key.m_context = 0;
+  uint64_t now = 0;
+  uint64_t inserts = 0;
+  uint64_t mixedOps = 0;
+  uint64_t removes = 0;
+
+  counter.Start ();
+  Clock::time_point start = Clock::now ();
+  if (workload.slot != 0)
+    {
+      for (std::vector<uint64_t>::const_iterator i = workload.timestamps.begin ();
+           i != workload.timestamps.end (); ++i)
+        {
+          ev.key.m_ts = *i;
+          ev.key.m_uid++;
+          scheduler->Insert (ev);
+        }
+      inserts = workload.timestamps.size ();
+      result.insertNs = NsPerOp (start, inserts);
+
+      start = Clock::now ();
+      uint64_t slot = workload.slot;
+      for (std::vector<uint64_t>::const_iterator i = workload.values.begin ();
+           i != workload.values.end (); ++i)
+        {
+          now = scheduler->RemoveNext ().key.m_ts;
+          ev.key.m_ts = (now / slot + *i) * slot;
+          ev.key.m_uid++;
+          scheduler->Insert (ev);
+        }
+      mixedOps = 2 * workload.values.size ();
+      result.mixedNs = NsPerOp (start, mixedOps);
+    }
+  else
+    {
+      // insert phase: the events scheduled before the first one is due
+      std::size_t n = workload.timestamps.size ();
+      std::size_t i = 0;
+      uint64_t first = UINT64_MAX;
+      for (; i < n; ++i)
+        {
+          if (workload.values[i] >= first)
+            {
+              break;
+            }
+          ev.key.m_ts = workload.timestamps[i];
+          ev.key.m_uid++;
+          scheduler->Insert (ev);
+          first = std::min (first, ev.key.m_ts);
+        }
+      inserts = i;
+      result.insertNs = NsPerOp (start, inserts);
+
+      start = Clock::now ();
+      for (; i < n; ++i)
+        {
+          uint64_t at = workload.values[i];
+          while (!scheduler->IsEmpty () && scheduler->PeekNext ().key.m_ts <= at)
+            {
+              now = scheduler->RemoveNext ().key.m_ts;
+              mixedOps++;
+            }
+          // events scheduled by other threads may appear out of order
+          ev.key.m_ts = std::max (workload.timestamps[i], now);
+          ev.key.m_uid++;
+          scheduler->Insert (ev);
+          mixedOps++;
+        }
+      result.mixedNs = NsPerOp (start, mixedOps);
+    }
+
+  start = Clock::now ();
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+      removes++;
+    }
+  result.removeNs = NsPerOp (start, removes);
+  uint64_t misses = counter.Stop ();
+
+  result.ops = inserts + mixedOps + removes;
+  result.missesPerOp = result.ops == 0 ? 0 : (double) misses / result.ops;
+  scheduler = 0;
+  result.peakKib = (g_peakBytes - baseline) / 1024;
+  delete impl;
+  return result;
+}
+
+/**
+ * Create a synthetic hold model workload.
+ * \param name the workload name
+ * \param pop the event population
+ * \param total the number of replaced events
+ * \returns the workload
+ */
+static Workload
+CreateSyntheticWorkload (const std::string &name, uint32_t pop, uint32_t total)
+{
+  Workload workload;
+  workload.name = name;
+  workload.slot = 1;
+
+  Ptr<ExponentialRandomVariable> exponential = CreateObject<ExponentialRandomVariable> ();
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  std::vector<uint64_t> delays;
+  for (uint32_t i = 0; i < pop + total; ++i)
+    {
+      uint64_t delay;
+      if (name == "hold")
+        {
+          // the classic hold model, as in bench-simulator
+          delay = exponential->GetValue (100, 0);
+        }
+      else if (name == "bursty")
+        {
+          // most events are due at the next boundaries of 1us slots, as
+          // with periodic transmission opportunities, giving many
+          // simultaneous events
+          workload.slot = 1000;
+          delay = 1 + exponential->GetValue (0.5, 0);
+        }
+      else
+        {
+          NS_ASSERT (name == "bimodal");
+          // mostly short timers, and a few long ones such as
+          // retransmission timeouts
+          if (uniform->GetValue () < 0.9)
+            {
+              delay = exponential->GetValue (10, 0);
+            }
+          else
+            {
+              delay = exponential->GetValue (100000, 0);
+            }
+        }
+      delays.push_back (delay);
+    }
+  for (uint32_t i = 0; i < pop; ++i)
+    {
+      workload.timestamps.push_back (delays[i] * workload.slot);
+    }
+  workload.values.assign (delays.begin () + pop, delays.end ());
+  return workload;
+}
+
+/**
+ * Load a workload recorded by DesMetrics.
+ * \param filename the DesMetrics json file
+ * \returns the workload
+ */
+static Workload
+LoadTraceWorkload (const std::string &filename)
+{
+  Workload workload;
+  workload.name = "trace";
+  workload.slot = 0;
+
+  std::ifstream input (filename.c_str ());
+  if (!input)
+    {
+      NS_FATAL_ERROR ("Can not open " << filename);
+    }
+  // each event is recorded on its own line as
+  //   ["send context","now","receive context","event time"]
+  std::string line;
+  while (std::getline (input, line))
+    {
+      int32_t send, receive;
+      unsigned long long now, ts;
+      std::size_t start = line.find ('[');
+      if (start != std::string::npos
+          && std::sscanf (line.c_str () + start, "[\"%d\",\"%llu\",\"%d\",\"%llu\"]",
+                          &send, &now, &receive, &ts) == 4)
+        {
+          workload.values.push_back (now);
+          workload.timestamps.push_back (ts);
+        }
+    }
+  LOG ("trace " << filename << ": " << workload.timestamps.size () << " events");
+  return workload;
+}
+
+/**
+ * Split a comma separated list.
+ * \param list the list
+ * \returns the items
+ */
+static std::vector<std::string>
+Split (const std::string &list)
+{
+  std::vector<std::string> items;
+  std::istringstream iss (list);
+  std::string item;
+  while (std::getline (iss, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
+    }
+  return items;
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t pop   =   10000;
+  uint32_t total =  200000;
+  uint32_t runs  =       1;
+  std::string schedulers = "";
+  std::string workloads = "hold,bursty,bimodal";
+  std::string trace = "";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark every scheduler against several event time distributions.\n"
+             "\n"
+             "The synthetic workloads follow the hold model:\n"
+             "  hold:    exponential delays, with mean 100 ns,\n"
+             "  bursty:  events aligned on 1 us slots, mostly the next one,\n"
+             "  bimodal: 90% short delays (mean 10 ns), 10% long ones (mean 100 us).\n"
+             "A trace recorded by DesMetrics (configure with --enable-des-metrics)\n"
+             "can be replayed with --trace=<file.json>.");
+  cmd.AddValue ("pop",   "event population size (default 1E4)",         pop);
+  cmd.AddValue ("total", "number of events replaced in the hold model (default 2E5)", total);
+  cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
+  cmd.AddValue ("schedulers", "comma separated list of schedulers (default all)", schedulers);
+  cmd.AddValue ("workloads", "comma separated list of synthetic workloads, or none", workloads);
+  cmd.AddValue ("trace", "DesMetrics trace file to replay", trace);
+  cmd.Parse (argc, argv);
+
+  std::vector<TypeId> tids;
+  if (schedulers.empty ())
+    {
+      for (uint16_t i = 0; i < TypeId::GetRegisteredN (); ++i)
+        {
+          TypeId tid = TypeId::GetRegistered (i);
+          if (tid.IsChildOf (Scheduler::GetTypeId ()) && tid.HasConstructor ())
+            {
+              tids.push_back (tid);
+            }
+        }
+    }
+  else
+    {
+      std::vector<std::string> names = Split (schedulers);
+      for (std::vector<std::string>::const_iterator i = names.begin (); i != names.end (); ++i)
+        {
+          tids.push_back (TypeId::LookupByName (*i));
+        }
+    }
+
+  std::vector<Workload> all;
+  std::vector<std::string> names = Split (workloads);
+  for (std::vector<std::string>::const_iterator i = names.begin (); i != names.end (); ++i)
+    {
+      if (*i == "none")
+        {
+          continue;
+        }
+      if (*i != "hold" && *i != "bursty" && *i != "bimodal")
+        {
+          NS_FATAL_ERROR ("Unknown workload " << *i);
+        }
+      all.push_back (CreateSyntheticWorkload (*i, pop, total));
+    }
+  if (!trace.empty ())
+    {
+      all.push_back (LoadTraceWorkload (trace));
+    }
+
+  CacheMissCounter counter;
+  LOG ("population: " << pop);
+  LOG ("replaced events: " << total);
+  if (!counter.IsAvailable ())
+    {
+      LOG ("cache miss counter not available");
+    }
+  LOG ("");
+  LOG (std::left << std::setw (24) << "Scheduler" <<
+       std::setw (9) << "Workload" <<
+       std::right << std::setw (12) << "Insert ns" <<
+       std::setw (12) << "Mixed ns" <<
+       std::setw (12) << "Remove ns" <<
+       std::setw (12) << "Peak KiB" <<
+       std::setw (12) << "Misses/op");
+
+  for (std::vector<Workload>::const_iterator w = all.begin (); w != all.end (); ++w)
+    {
+      for (std::vector<TypeId>::const_iterator t = tids.begin (); t != tids.end (); ++t)
+        {
+          for (uint32_t run = 0; run < runs; ++run)
+            {
+              Result r = RunWorkload (*t, *w, counter);
+              std::ostringstream misses;
+              if (counter.IsAvailable ())
+                {
+                  misses << std::fixed << std::setprecision (2) << r.missesPerOp;
+                }
+              else
+                {
+                  misses << "-";
+                }
+              LOG (std::left << std::setw (24) << t->GetName () <<
+                   std::setw (9) << w->name <<
+                   std::right << std::fixed << std::setprecision (1) <<
+                   std::setw (12) << r.insertNs <<
+                   std::setw (12) << r.mixedNs <<
+                   std::setw (12) << r.removeNs <<
+                   std::setw (12) << r.peakKib <<
+                   std::setw (12) << misses.str ());
+            }
+        }
+    }
+  return 0;
+}